@@ -18,6 +18,9 @@ int main() {
 #include <stdio.h>
 #include <sys/types.h>
 
+#include <string>
+#include <vector>
+
 #include "port/port.h"
 #include "rocksdb/cache.h"
 #include "rocksdb/db.h"
@@ -26,6 +29,7 @@ int main() {
 #include "util/gflags_compat.h"
 #include "util/mutexlock.h"
 #include "util/random.h"
+#include "util/string_util.h"
 
 using GFLAGS_NAMESPACE::ParseCommandLineFlags;
 
@@ -48,6 +52,10 @@ DEFINE_int32(erase_percent, 10,
              "Ratio of erase to total workload (expressed as a percentage)");
 
 DEFINE_bool(use_clock_cache, false, "");
+DEFINE_string(cache_type, "lru_cache",
+              "Type of cache: lru_cache, clock_cache, lirs_cache or "
+              "buffered_lirs_cache. A comma separated list runs the same "
+              "workload against each of them.");
 
 namespace TERARKDB_NAMESPACE {
 
@@ -66,6 +74,8 @@ class SharedState {
         num_initialized_(0),
         start_(false),
         num_done_(0),
+        num_lookups_(0),
+        num_hits_(0),
         cache_bench_(cache_bench) {}
 
   ~SharedState() {}
@@ -80,6 +90,15 @@ class SharedState {
 
   void IncDone() { num_done_++; }
 
+  void AddLookups(uint64_t lookups, uint64_t hits) {
+    num_lookups_ += lookups;
+    num_hits_ += hits;
+  }
+
+  uint64_t GetLookups() const { return num_lookups_; }
+
+  uint64_t GetHits() const { return num_hits_; }
+
   bool AllInitialized() const { return num_initialized_ >= num_threads_; }
 
   bool AllDone() const { return num_done_ >= num_threads_; }
@@ -96,6 +115,8 @@ class SharedState {
   uint64_t num_initialized_;
   bool start_;
   uint64_t num_done_;
+  uint64_t num_lookups_;
+  uint64_t num_hits_;
 
   CacheBench* cache_bench_;
 };
@@ -105,23 +126,36 @@ struct ThreadState {
   uint32_t tid;
   Random rnd;
   SharedState* shared;
+  uint64_t lookups;
+  uint64_t hits;
 
   ThreadState(uint32_t index, SharedState* _shared)
-      : tid(index), rnd(1000 + index), shared(_shared) {}
+      : tid(index), rnd(1000 + index), shared(_shared), lookups(0), hits(0) {}
 };
 }  // namespace
 
 class CacheBench {
  public:
-  CacheBench() : num_threads_(FLAGS_threads) {
-    if (FLAGS_use_clock_cache) {
+  explicit CacheBench(const std::string& cache_type)
+      : cache_type_(cache_type), num_threads_(FLAGS_threads) {
+    if (cache_type == "clock_cache") {
       cache_ = NewClockCache(FLAGS_cache_size, FLAGS_num_shard_bits);
       if (!cache_) {
         fprintf(stderr, "Clock cache not supported.\n");
         exit(1);
       }
-    } else {
+    } else if (cache_type == "lirs_cache" ||
+               cache_type == "buffered_lirs_cache") {
+      LIRSCacheOptions opts;
+      opts.capacity = FLAGS_cache_size;
+      opts.num_shard_bits = FLAGS_num_shard_bits;
+      opts.buffered_access = cache_type == "buffered_lirs_cache";
+      cache_ = NewLIRSCache(opts);
+    } else if (cache_type == "lru_cache") {
       cache_ = NewLRUCache(FLAGS_cache_size, FLAGS_num_shard_bits);
+    } else {
+      fprintf(stderr, "Unknown cache type: %s\n", cache_type.c_str());
+      exit(1);
     }
   }
 
@@ -170,12 +204,20 @@ class CacheBench {
       double elapsed = static_cast<double>(end_time - start_time) * 1e-6;
       uint32_t qps = static_cast<uint32_t>(
           static_cast<double>(FLAGS_threads * FLAGS_ops_per_thread) / elapsed);
-      fprintf(stdout, "Complete in %.3f s; QPS = %u\n", elapsed, qps);
+      uint64_t lookups = shared.GetLookups();
+      fprintf(stdout,
+              "%-20s: Complete in %.3f s; QPS = %u; hit ratio = %.2f%%\n",
+              cache_type_.c_str(), elapsed, qps,
+              lookups == 0 ? 0.0 : 100.0 * shared.GetHits() / lookups);
+    }
+    for (auto t : threads) {
+      delete t;
     }
     return true;
   }
 
  private:
+  std::string cache_type_;
   std::shared_ptr<Cache> cache_;
   uint32_t num_threads_;
 
@@ -197,6 +239,7 @@ class CacheBench {
 
     {
       MutexLock l(shared->GetMutex());
+      shared->AddLookups(thread->lookups, thread->hits);
       shared->IncDone();
       if (shared->AllDone()) {
         shared->GetCondVar()->SignalAll();
@@ -217,7 +260,9 @@ class CacheBench {
                  FLAGS_insert_percent && prob_op < FLAGS_lookup_percent) {
         // do lookup
         auto handle = cache_->Lookup(key);
+        thread->lookups++;
         if (handle) {
+          thread->hits++;
           cache_->Release(handle);
         }
       } else if (prob_op -=
@@ -239,6 +284,7 @@ class CacheBench {
     printf("Insert percentage   : %d%%\n", FLAGS_insert_percent);
     printf("Lookup percentage   : %d%%\n", FLAGS_lookup_percent);
     printf("Erase percentage    : %d%%\n", FLAGS_erase_percent);
+    printf("Cache type          : %s\n", cache_type_.c_str());
     printf("----------------------------\n");
   }
 };
@@ -252,15 +298,20 @@ int main(int argc, char** argv) {
     exit(1);
   }
 
-  TERARKDB_NAMESPACE::CacheBench bench;
-  if (FLAGS_populate_cache) {
-    bench.PopulateCache();
+  std::string cache_types = FLAGS_cache_type;
+  if (FLAGS_use_clock_cache) {
+    cache_types = "clock_cache";
   }
-  if (bench.Run()) {
-    return 0;
-  } else {
-    return 1;
+  for (auto& cache_type : TERARKDB_NAMESPACE::StringSplit(cache_types, ',')) {
+    TERARKDB_NAMESPACE::CacheBench bench(cache_type);
+    if (FLAGS_populate_cache) {
+      bench.PopulateCache();
+    }
+    if (!bench.Run()) {
+      return 1;
+    }
   }
+  return 0;
 }
 
 #endif  // GFLAGS
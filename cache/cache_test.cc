@@ -19,6 +19,7 @@
 #include "cache/lru_cache.h"
 #include "rocksdb/terark_namespace.h"
 #include "util/coding.h"
+#include "util/random.h"
 #include "util/string_util.h"
 #include "util/testharness.h"
 
@@ -687,6 +688,111 @@ INSTANTIATE_TEST_CASE_P(CacheTestInstance, CacheTest,
 INSTANTIATE_TEST_CASE_P(CacheTestInstance, CacheTest, testing::Values(kLRU));
 #endif  // SUPPORT_CLOCK_CACHE
 
+// Parameter: whether lookups are buffered
+class LIRSCacheTest : public testing::TestWithParam<bool> {
+ public:
+  static void Deleter(const Slice& /*key*/, void* /*value*/) {}
+
+  std::shared_ptr<Cache> NewCache(size_t capacity, int num_shard_bits = 0) {
+    LIRSCacheOptions opts;
+    opts.capacity = capacity;
+    opts.num_shard_bits = num_shard_bits;
+    opts.buffered_access = GetParam();
+    return NewLIRSCache(opts);
+  }
+
+  void Insert(Cache* cache, int key) {
+    ASSERT_OK(cache->Insert(EncodeKey(key), EncodeValue(key), 1, &Deleter));
+  }
+
+  bool Hit(Cache* cache, int key) {
+    Cache::Handle* handle = cache->Lookup(EncodeKey(key));
+    if (handle == nullptr) {
+      return false;
+    }
+    EXPECT_EQ(key, DecodeValue(cache->Value(handle)));
+    cache->Release(handle);
+    return true;
+  }
+};
+
+TEST_P(LIRSCacheTest, ScanResistant) {
+  auto cache = NewCache(100);
+  for (int i = 0; i < 50; i++) {
+    Insert(cache.get(), i);
+  }
+  for (int round = 0; round < 3; round++) {
+    for (int i = 0; i < 50; i++) {
+      ASSERT_TRUE(Hit(cache.get(), i));
+    }
+  }
+  // A one-pass scan over keys much more than the capacity only churns the
+  // HIR entries
+  for (int i = 1000; i < 2000; i++) {
+    Insert(cache.get(), i);
+  }
+  for (int i = 0; i < 50; i++) {
+    ASSERT_TRUE(Hit(cache.get(), i));
+  }
+  ASSERT_EQ(100, cache->GetUsage());
+  ASSERT_EQ(0, cache->GetPinnedUsage());
+}
+
+TEST_P(LIRSCacheTest, PinnedEntriesAreNotEvicted) {
+  auto cache = NewCache(10);
+  Cache::Handle* handle = nullptr;
+  ASSERT_OK(cache->Insert(EncodeKey(100), EncodeValue(100), 1, &Deleter,
+                          &handle));
+  Cache::Handle* lookup = cache->Lookup(EncodeKey(100));
+  ASSERT_EQ(handle, lookup);
+  ASSERT_EQ(1, cache->GetPinnedUsage());
+  for (int i = 0; i < 100; i++) {
+    Insert(cache.get(), i);
+  }
+  ASSERT_TRUE(Hit(cache.get(), 100));
+  cache->Release(lookup);
+  cache->Release(handle);
+  ASSERT_EQ(0, cache->GetPinnedUsage());
+  ASSERT_LE(cache->GetUsage(), 10U);
+
+  cache->Erase(EncodeKey(100));
+  ASSERT_FALSE(Hit(cache.get(), 100));
+  cache->EraseUnRefEntries();
+  ASSERT_EQ(0, cache->GetUsage());
+}
+
+TEST_P(LIRSCacheTest, ConcurrentAccess) {
+  const int kNumThreads = 8;
+  const int kNumKeys = 4000;
+  auto cache = NewCache(1000, 2);
+  std::vector<port::Thread> threads;
+  for (int t = 0; t < kNumThreads; t++) {
+    threads.emplace_back([&, t]() {
+      Random rnd(301 + t);
+      for (int i = 0; i < 20000; i++) {
+        int key = static_cast<int>(rnd.Skewed(12)) % kNumKeys;
+        Cache::Handle* handle = cache->Lookup(EncodeKey(key));
+        if (handle == nullptr) {
+          cache->Insert(EncodeKey(key), EncodeValue(key), 1, &Deleter);
+        } else {
+          ASSERT_EQ(key, DecodeValue(cache->Value(handle)));
+          cache->Release(handle, rnd.OneIn(100));
+        }
+        if (rnd.OneIn(1000)) {
+          cache->Erase(EncodeKey(key));
+        }
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  ASSERT_EQ(0, cache->GetPinnedUsage());
+  ASSERT_LE(cache->GetUsage(), 1000U);
+}
+
+INSTANTIATE_TEST_CASE_P(LIRSCacheTest, LIRSCacheTest, testing::Bool());
+
 }  // namespace TERARKDB_NAMESPACE
 
 int main(int argc, char** argv) {
@@ -11,13 +11,30 @@
 
 namespace TERARKDB_NAMESPACE {
 
+LIRSHandle* LIRSHandle::Create(const Slice& key, uint32_t hash) {
+  char* mem = new char[sizeof(LIRSHandle) - 1 + key.size()];
+  LIRSHandle* h = new (mem) LIRSHandle;
+  h->value = nullptr;
+  h->deleter = nullptr;
+  h->next_hash = nullptr;
+  h->next_stack = h->prev_stack = h->next_queue = h->prev_queue = nullptr;
+  h->charge = 0;
+  h->key_length = key.size();
+  h->refs.store(kInCache, std::memory_order_relaxed);
+  h->hash = hash;
+  h->ghost = false;
+  h->state = kHIR;
+  memcpy(h->key_data, key.data(), key.size());
+  return h;
+}
+
 LIRSHandleTable::LIRSHandleTable() : list_(nullptr), length_(0), elems_(0) {
   Resize();
 }
 
 LIRSHandleTable::~LIRSHandleTable() {
   ApplyToAllCacheEntries([](LIRSHandle* h) {
-    if (h->refs == 1) {
+    if (h->refs.load(std::memory_order_relaxed) == LIRSHandle::kInCache) {
       h->Free();
     }
   });
@@ -28,6 +45,14 @@ LIRSHandle* LIRSHandleTable::Lookup(const Slice& key, uint32_t hash) {
   return *FindPointer(key, hash);
 }
 
+LIRSHandle* LIRSHandleTable::LookupResident(uint32_t hash) {
+  LIRSHandle* h = list_[hash & (length_ - 1)];
+  while (h != nullptr && (h->hash != hash || h->ghost)) {
+    h = h->next_hash;
+  }
+  return h;
+}
+
 LIRSHandle* LIRSHandleTable::Insert(LIRSHandle* h) {
   LIRSHandle** ptr = FindPointer(h->key(), h->hash);
   LIRSHandle* old = *ptr;
@@ -87,24 +112,43 @@ void LIRSHandleTable::Resize() {
 }
 
 LIRSCacheShard::LIRSCacheShard(size_t capacity, bool strict_capacity_limit,
-                               double irr_ratio)
-    : capacity_(capacity),
+                               double irr_ratio, bool buffered_access)
+    : capacity_(0),
+      lir_capacity_(0),
       usage_(0),
-      stack_usage_(0),
+      pinned_usage_(0),
+      lir_usage_(0),
+      num_entries_(0),
+      num_ghosts_(0),
       irr_ratio_(irr_ratio),
-      strict_capacity_limit_(strict_capacity_limit) {
-  cache_.next_stack = cache_.prev_stack = cache_.next_queue =
-      cache_.prev_queue = &cache_;
+      strict_capacity_limit_(strict_capacity_limit),
+      buffered_access_(buffered_access),
+      num_stripes_(buffered_access ? size_t(1) << kNumStripeBits : 1) {
+  stack_.next_stack = stack_.prev_stack = &stack_;
+  queue_.next_queue = queue_.prev_queue = &queue_;
+  ghosts_.next_queue = ghosts_.prev_queue = &ghosts_;
+  stripes_ = reinterpret_cast<Stripe*>(
+      port::cacheline_aligned_alloc(sizeof(Stripe) * num_stripes_));
+  for (size_t i = 0; i < num_stripes_; i++) {
+    new (&stripes_[i]) Stripe();
+  }
   SetCapacity(capacity);
 }
 
-LIRSCacheShard::~LIRSCacheShard() {}
+LIRSCacheShard::~LIRSCacheShard() {
+  for (size_t i = 0; i < num_stripes_; i++) {
+    stripes_[i].~Stripe();
+  }
+  port::cacheline_aligned_free(stripes_);
+}
 
-void LIRSCacheShard::PushToQueue(LIRSHandle* h) {
-  cache_.next_queue->prev_queue = h;
-  h->next_queue = cache_.next_queue;
-  cache_.next_queue = h;
-  h->prev_queue = &cache_;
+// Queues are ordered from the newest (list->next_queue) to the oldest
+// (list->prev_queue)
+void LIRSCacheShard::PushToQueue(LIRSHandle* list, LIRSHandle* h) {
+  list->next_queue->prev_queue = h;
+  h->next_queue = list->next_queue;
+  list->next_queue = h;
+  h->prev_queue = list;
 }
 
 void LIRSCacheShard::RemoveFromQueue(LIRSHandle* h) {
@@ -114,33 +158,12 @@ void LIRSCacheShard::RemoveFromQueue(LIRSHandle* h) {
   h->prev_queue = nullptr;
 }
 
-void LIRSCacheShard::AdjustToQueueTail(LIRSHandle* h) {
-  h->next_queue->prev_queue = h->prev_queue;
-  h->prev_queue->next_queue = h->next_queue;
-  cache_.next_queue->prev_queue = h;
-  h->next_queue = cache_.next_queue;
-  cache_.next_queue = h;
-  h->prev_queue = &cache_;
-}
-
-void LIRSCacheShard::ShiftQueueHead() {
-  if (cache_.prev_queue == &cache_) {
-    return;
-  }
-  auto head = cache_.prev_queue;
-  RemoveFromQueue(head);
-  if (head->next_stack != nullptr) {
-    head->SetNHIR();
-  } else {
-    LIRS_Remove(head);
-  }
-}
-
+// The stack top is stack_.next_stack, the bottom is stack_.prev_stack
 void LIRSCacheShard::PushToStack(LIRSHandle* h) {
-  cache_.next_stack->prev_stack = h;
-  h->next_stack = cache_.next_stack;
-  cache_.next_stack = h;
-  h->prev_stack = &cache_;
+  stack_.next_stack->prev_stack = h;
+  h->next_stack = stack_.next_stack;
+  stack_.next_stack = h;
+  h->prev_stack = &stack_;
 }
 
 void LIRSCacheShard::RemoveFromStack(LIRSHandle* h) {
@@ -151,170 +174,331 @@ void LIRSCacheShard::RemoveFromStack(LIRSHandle* h) {
 }
 
 void LIRSCacheShard::AdjustToStackTop(LIRSHandle* h) {
-  h->next_stack->prev_stack = h->prev_stack;
-  h->prev_stack->next_stack = h->next_stack;
-  cache_.next_stack->prev_stack = h;
-  h->next_stack = cache_.next_stack;
-  cache_.next_stack = h;
-  h->prev_stack = &cache_;
+  RemoveFromStack(h);
+  PushToStack(h);
 }
 
-void LIRSCacheShard::AdjustStackBottom() {
-  if (cache_.prev_stack == &cache_) {
-    return;
-  }
-  auto bottom = cache_.prev_stack;
-  if (bottom->LIR()) {
-    bottom->SetHIR();
-    if (bottom->next_queue != nullptr) {
-      RemoveFromQueue(bottom);
+// Keep a LIR entry at the stack bottom, so that the stack only covers the
+// recency of the LIR set
+void LIRSCacheShard::StackPruning() {
+  while (stack_.prev_stack != &stack_ && !stack_.prev_stack->LIR()) {
+    LIRSHandle* bottom = stack_.prev_stack;
+    if (bottom->ghost) {
+      RemoveGhost(bottom);
+    } else {
+      // Resident HIR entry, it stays in the queue
+      RemoveFromStack(bottom);
     }
-    PushToQueue(bottom);
   }
 }
 
-void LIRSCacheShard::StackPruning() {
-  while (cache_.prev_stack != &cache_ && !cache_.prev_stack->LIR()) {
-    auto bottom = cache_.prev_stack;
-    RemoveFromStack(bottom);
-    PushToQueue(bottom);
+bool LIRSCacheShard::DemoteStackBottom() {
+  StackPruning();
+  LIRSHandle* bottom = stack_.prev_stack;
+  if (bottom == &stack_) {
+    return false;
   }
+  assert(bottom->LIR());
+  bottom->state = LIRSHandle::kHIR;
+  lir_usage_ -= bottom->charge;
+  RemoveFromStack(bottom);
+  PushToQueue(&queue_, bottom);
+  StackPruning();
+  return true;
 }
 
-bool LIRSCacheShard::Unref(LIRSHandle* h) {
-  assert(h->refs > 0);
-  h->refs--;
-  return h->refs == 0;
+void LIRSCacheShard::Access(LIRSHandle* h) {
+  assert(!h->ghost);
+  if (h->LIR()) {
+    bool bottom = stack_.prev_stack == h;
+    AdjustToStackTop(h);
+    if (bottom) {
+      StackPruning();
+    }
+  } else if (h->InStack()) {
+    // HIR entry re-referenced within the recency of the LIR set
+    RemoveFromQueue(h);
+    h->state = LIRSHandle::kLIR;
+    lir_usage_ += h->charge;
+    AdjustToStackTop(h);
+    while (lir_usage_ > lir_capacity_ && stack_.prev_stack != h) {
+      DemoteStackBottom();
+    }
+  } else {
+    PushToStack(h);
+    RemoveFromQueue(h);
+    PushToQueue(&queue_, h);
+  }
 }
 
-void LIRSCacheShard::EraseUnRefEntries() {
-  autovector<LIRSHandle*> last_reference_list;
+void LIRSCacheShard::DrainAccesses(Stripe* stripe) {
+  mutex_.AssertHeld();
+  LIRSHandle* hits[kAccessBufferSize];
+  uint32_t n = 0;
   {
-    MutexLock l(&mutex_);
-    while (cache_.prev_queue != &cache_) {
-      LIRSHandle* old = cache_.prev_queue;
-      LIRS_Remove(old);
-      table_.Remove(old->key(), old->hash);
-      old->SetInvalid();
-      Unref(old);
-      usage_ -= old->charge;
-      last_reference_list.push_back(old);
+    MutexLock l(&stripe->mutex);
+    for (uint32_t i = 0; i < stripe->num_accesses; ++i) {
+      LIRSHandle* h = stripe->table.LookupResident(stripe->accesses[i]);
+      if (h != nullptr) {
+        hits[n++] = h;
+      }
     }
+    stripe->num_accesses = 0;
   }
+  // Resident entries are only removed under mutex_, so the handles stay
+  // valid after the stripe is unlocked
+  for (uint32_t i = 0; i < n; ++i) {
+    Access(hits[i]);
+  }
+}
 
-  for (auto entry : last_reference_list) {
-    entry->Free();
+void LIRSCacheShard::DrainAccesses() {
+  if (buffered_access_) {
+    for (size_t i = 0; i < num_stripes_; i++) {
+      DrainAccesses(&stripes_[i]);
+    }
   }
 }
 
-void LIRSCacheShard::ApplyToAllCacheEntries(void (*callback)(void*, size_t),
-                                            bool thread_safe) {
-  if (thread_safe) {
-    mutex_.Lock();
+// Unlink h from the stack and queues. The caller has removed it from the
+// hash table.
+void LIRSCacheShard::RemoveEntry(LIRSHandle* h) {
+  if (h->InQueue()) {
+    RemoveFromQueue(h);
   }
-  table_.ApplyToAllCacheEntries(
-      [callback](LIRSHandle* h) { callback(h->value, h->charge); });
-  if (thread_safe) {
-    mutex_.Unlock();
+  if (h->InStack()) {
+    RemoveFromStack(h);
   }
+  if (h->ghost) {
+    --num_ghosts_;
+  } else {
+    if (h->LIR()) {
+      lir_usage_ -= h->charge;
+    }
+    --num_entries_;
+  }
+  StackPruning();
 }
 
-void LIRSCacheShard::LIRS_Remove(LIRSHandle* e) {
-  if (e->next_queue != nullptr) {
-    RemoveFromQueue(e);
+void LIRSCacheShard::RemoveGhost(LIRSHandle* h) {
+  assert(h->ghost);
+  {
+    MutexLock l(&GetStripe(h->hash)->mutex);
+    LIRSHandle* e = GetStripe(h->hash)->table.Remove(h->key(), h->hash);
+    assert(e == h);
+    (void)e;
   }
-  if (e->next_stack != nullptr) {
-    RemoveFromStack(e);
-    stack_usage_ -= e->charge;
+  RemoveFromQueue(h);
+  if (h->InStack()) {
+    RemoveFromStack(h);
   }
+  --num_ghosts_;
+  h->Free();
 }
 
-void LIRSCacheShard::LIRS_Insert(LIRSHandle* e) {
-  if (stack_usage_ + e->charge <= stack_capacity_) {
-    PushToStack(e);
-    e->SetLIR();
-    stack_usage_ += e->charge;
-  } else {
-    PushToQueue(e);
-    e->SetHIR();
+void LIRSCacheShard::TrimGhosts() {
+  while (num_ghosts_ > num_entries_ && ghosts_.prev_queue != &ghosts_) {
+    RemoveGhost(ghosts_.prev_queue);
   }
+  StackPruning();
+}
+
+bool LIRSCacheShard::Evict(LIRSHandle* h, autovector<LIRSHandle*>* deleted) {
+  assert(h->HIR() && h->InQueue());
+  {
+    Stripe* stripe = GetStripe(h->hash);
+    MutexLock l(&stripe->mutex);
+    if (h->refs.load(std::memory_order_acquire) != LIRSHandle::kInCache) {
+      // Still referenced
+      return false;
+    }
+    if (h->InStack()) {
+      // Keep its place in the stack
+      LIRSHandle* ghost = LIRSHandle::Create(h->key(), h->hash);
+      ghost->ghost = true;
+      ghost->next_stack = h->next_stack;
+      ghost->prev_stack = h->prev_stack;
+      h->next_stack->prev_stack = ghost;
+      h->prev_stack->next_stack = ghost;
+      h->next_stack = h->prev_stack = nullptr;
+      LIRSHandle* old = stripe->table.Insert(ghost);
+      assert(old == h);
+      (void)old;
+      PushToQueue(&ghosts_, ghost);
+      ++num_ghosts_;
+    } else {
+      stripe->table.Remove(h->key(), h->hash);
+    }
+    h->refs.store(0, std::memory_order_relaxed);
+  }
+  RemoveFromQueue(h);
+  --num_entries_;
+  usage_ -= h->charge;
+  deleted->push_back(h);
+  return true;
 }
 
 void LIRSCacheShard::EvictFromLIRS(size_t charge,
                                    autovector<LIRSHandle*>* deleted) {
-  while (usage_ - stack_usage_ + charge > capacity_ - stack_capacity_ &&
-         cache_.prev_queue != &cache_) {
-    LIRSHandle* old = cache_.prev_queue;
-    assert(old->refs == 1);
-    LIRS_Remove(old);
-    table_.Remove(old->key(), old->hash);
-    old->SetInvalid();
-    Unref(old);
-    usage_ -= old->charge;
-    deleted->push_back(old);
-  }
-  while (stack_usage_ + charge > stack_capacity_ &&
-         cache_.prev_stack != &cache_) {
-    LIRSHandle* old = cache_.prev_stack;
-    stack_usage_ -= old->charge;
-    RemoveFromStack(old);
-    PushToQueue(old);
+  // Scan the HIR queue from the oldest entry, skipping referenced ones
+  LIRSHandle* h = queue_.prev_queue;
+  while (usage_ + charge > capacity_) {
+    if (h == &queue_) {
+      // No evictable HIR entry left, move the coldest LIR entry to the queue
+      if (!DemoteStackBottom()) {
+        break;
+      }
+      h = queue_.next_queue;
+      continue;
+    }
+    LIRSHandle* prev = h->prev_queue;
+    Evict(h, deleted);
+    h = prev;
   }
+  TrimGhosts();
 }
 
 void LIRSCacheShard::SetCapacity(size_t capacity) {
-  MutexLock l(&mutex_);
-  capacity_ = capacity;
-  stack_capacity_ = capacity_ * irr_ratio_;
+  autovector<LIRSHandle*> last_reference_list;
+  {
+    MutexLock l(&mutex_);
+    DrainAccesses();
+    capacity_ = capacity;
+    lir_capacity_ = static_cast<size_t>(capacity * irr_ratio_);
+    while (lir_usage_ > lir_capacity_ && DemoteStackBottom()) {
+    }
+    EvictFromLIRS(0, &last_reference_list);
+  }
+
+  for (auto entry : last_reference_list) {
+    entry->Free();
+  }
 }
 
-Cache::Handle* LIRSCacheShard::Lookup(const Slice& key, uint32_t hash) {
+void LIRSCacheShard::SetStrictCapacityLimit(bool strict_capacity_limit) {
   MutexLock l(&mutex_);
-  LIRSHandle* h = table_.Lookup(key, hash);
-  if (h != nullptr) {
-    if (!h->Remote()) {
-      if (h->refs == 1) {
-        LIRS_Remove(h);
-      } else {
-        if (h->LIR()) {
-          AdjustToStackTop(h);
-        } else if (h->HIR()) {
-          if (h->next_stack != nullptr) {
-            h->SetLIR();
-            AdjustToStackTop(h);
-            RemoveFromQueue(h);
-            AdjustStackBottom();
-          } else {
-            PushToStack(h);
-            AdjustToQueueTail(h);
-          }
-        } else {
-          ShiftQueueHead();
-          if (h->next_stack != nullptr) {
-            h->SetLIR();
-            AdjustToStackTop(h);
-            AdjustStackBottom();
-          } else {
-            h->SetHIR();
-            PushToStack(h);
-            PushToQueue(h);
+  strict_capacity_limit_ = strict_capacity_limit;
+}
+
+void LIRSCacheShard::EraseUnRefEntries() {
+  autovector<LIRSHandle*> last_reference_list;
+  {
+    MutexLock l(&mutex_);
+    DrainAccesses();
+    while (ghosts_.prev_queue != &ghosts_) {
+      RemoveGhost(ghosts_.prev_queue);
+    }
+    for (size_t i = 0; i < num_stripes_; i++) {
+      Stripe* stripe = &stripes_[i];
+      size_t begin = last_reference_list.size();
+      {
+        MutexLock sl(&stripe->mutex);
+        stripe->table.ApplyToAllCacheEntries([&](LIRSHandle* h) {
+          if (h->refs.load(std::memory_order_acquire) ==
+              LIRSHandle::kInCache) {
+            last_reference_list.push_back(h);
           }
+        });
+        for (size_t j = begin; j < last_reference_list.size(); ++j) {
+          LIRSHandle* h = last_reference_list[j];
+          stripe->table.Remove(h->key(), h->hash);
+          h->refs.store(0, std::memory_order_relaxed);
         }
-        StackPruning();
       }
+      for (size_t j = begin; j < last_reference_list.size(); ++j) {
+        LIRSHandle* h = last_reference_list[j];
+        RemoveEntry(h);
+        usage_ -= h->charge;
+      }
+    }
+  }
+
+  for (auto entry : last_reference_list) {
+    entry->Free();
+  }
+}
+
+void LIRSCacheShard::ApplyToAllCacheEntries(void (*callback)(void*, size_t),
+                                            bool thread_safe) {
+  for (size_t i = 0; i < num_stripes_; i++) {
+    Stripe* stripe = &stripes_[i];
+    if (thread_safe) {
+      stripe->mutex.Lock();
+    }
+    stripe->table.ApplyToAllCacheEntries([callback](LIRSHandle* h) {
+      if (!h->ghost) {
+        callback(h->value, h->charge);
+      }
+    });
+    if (thread_safe) {
+      stripe->mutex.Unlock();
+    }
+  }
+}
+
+// Add an external reference to h, the stripe of h is locked
+LIRSHandle* LIRSCacheShard::Pin(LIRSHandle* h) {
+  if (h == nullptr || h->ghost) {
+    return nullptr;
+  }
+  if (LIRSHandle::ExternalRefs(h->refs.fetch_add(1)) == 0) {
+    pinned_usage_ += h->charge;
+  }
+  return h;
+}
+
+bool LIRSCacheShard::Unref(LIRSHandle* h) {
+  // h may be evicted by another thread as soon as the reference is dropped
+  size_t charge = h->charge;
+  uint32_t old_refs = h->refs.fetch_sub(1);
+  assert(LIRSHandle::ExternalRefs(old_refs) > 0);
+  if (LIRSHandle::ExternalRefs(old_refs) == 1) {
+    pinned_usage_ -= charge;
+  }
+  if (old_refs == 1) {
+    // Last reference to an entry which is no longer in the cache
+    usage_ -= charge;
+    h->Free();
+    return true;
+  }
+  return false;
+}
+
+Cache::Handle* LIRSCacheShard::Lookup(const Slice& key, uint32_t hash) {
+  Stripe* stripe = GetStripe(hash);
+  LIRSHandle* h;
+  if (!buffered_access_) {
+    MutexLock l(&mutex_);
+    {
+      MutexLock sl(&stripe->mutex);
+      h = Pin(stripe->table.Lookup(key, hash));
+    }
+    if (h != nullptr) {
+      Access(h);
     }
-    h->refs++;
+    return reinterpret_cast<Cache::Handle*>(h);
+  }
+  bool drain = false;
+  {
+    MutexLock l(&stripe->mutex);
+    h = Pin(stripe->table.Lookup(key, hash));
+    if (h != nullptr && stripe->num_accesses < kAccessBufferSize) {
+      stripe->accesses[stripe->num_accesses++] = hash;
+      drain = stripe->num_accesses == kAccessBufferSize;
+    }
+  }
+  if (drain) {
+    MutexLock l(&mutex_);
+    DrainAccesses(stripe);
   }
   return reinterpret_cast<Cache::Handle*>(h);
 }
 
 bool LIRSCacheShard::Ref(Cache::Handle* h) {
   LIRSHandle* handle = reinterpret_cast<LIRSHandle*>(h);
-  MutexLock l(&mutex_);
-  if (handle->InCache() && handle->refs == 1) {
-    LIRS_Remove(handle);
-  }
-  handle->refs++;
+  uint32_t old_refs = handle->refs.fetch_add(1);
+  assert(LIRSHandle::ExternalRefs(old_refs) > 0);
+  (void)old_refs;
   return true;
 }
 
@@ -323,32 +507,38 @@ bool LIRSCacheShard::Release(Cache::Handle* handle, bool force_erase) {
     return false;
   }
   LIRSHandle* e = reinterpret_cast<LIRSHandle*>(handle);
+  if (!force_erase && usage_ <= capacity_) {
+    return Unref(e);
+  }
   bool last_reference = false;
   {
     MutexLock l(&mutex_);
-    last_reference = Unref(e);
-    if (last_reference) {
-      usage_ -= e->charge;
-    }
-    if (e->refs == 1 && e->InCache()) {
-      // The item is still in cache, and nobody else holds a reference to it
-      if (usage_ > capacity_ || force_erase) {
-        // the cache is full
-        // take this opportunity and remove the item
-        table_.Remove(e->key(), e->hash);
-        e->SetInvalid();
-        Unref(e);
-        usage_ -= e->charge;
+    {
+      MutexLock sl(&GetStripe(e->hash)->mutex);
+      if (e->refs.load(std::memory_order_acquire) ==
+          (LIRSHandle::kInCache | 1)) {
+        // The item is still in cache, and nobody else holds a reference to
+        // it. The cache is full or the caller asks to erase it, take this
+        // opportunity and remove the item
+        GetStripe(e->hash)->table.Remove(e->key(), e->hash);
+        e->refs.store(0, std::memory_order_relaxed);
         last_reference = true;
       }
     }
+    if (last_reference) {
+      RemoveEntry(e);
+      pinned_usage_ -= e->charge;
+      usage_ -= e->charge;
+      TrimGhosts();
+    }
   }
 
   // free outside of mutex
   if (last_reference) {
     e->Free();
+    return true;
   }
-  return last_reference;
+  return Unref(e);
 }
 
 Status LIRSCacheShard::Insert(const Slice& key, uint32_t hash, void* value,
@@ -356,44 +546,67 @@ Status LIRSCacheShard::Insert(const Slice& key, uint32_t hash, void* value,
                               void (*deleter)(const Slice& key, void* value),
                               Cache::Handle** handle,
                               Cache::Priority /*priority*/) {
-  LIRSHandle* e = reinterpret_cast<LIRSHandle*>(
-      new char[sizeof(LIRSHandle) - 1 + key.size()]);
+  LIRSHandle* e = LIRSHandle::Create(key, hash);
   Status s;
 
   e->value = value;
   e->deleter = deleter;
   e->charge = charge;
-  e->key_length = key.size();
-  e->hash = hash;
-  e->refs = (handle == nullptr ? 1 : 2);
-  e->next_stack = e->prev_stack = e->next_queue = e->prev_queue = nullptr;
-  memcpy(e->key_data, key.data(), key.size());
+  if (handle != nullptr) {
+    e->refs.store(LIRSHandle::kInCache | 1, std::memory_order_relaxed);
+  }
 
   autovector<LIRSHandle*> last_reference_list;
   {
     MutexLock l(&mutex_);
+    DrainAccesses();
     EvictFromLIRS(charge, &last_reference_list);
     if (usage_ + charge > capacity_ && strict_capacity_limit_) {
-      e->refs = 0;
+      e->refs.store(0, std::memory_order_relaxed);
       last_reference_list.push_back(e);
       if (handle != nullptr) {
         *handle = nullptr;
       }
       s = Status::Incomplete("Insert failed due to LIRS cache being full.");
     } else {
-      LIRSHandle* old = table_.Insert(e);
-      usage_ += e->charge;
+      LIRSHandle* old;
+      {
+        MutexLock sl(&GetStripe(hash)->mutex);
+        old = GetStripe(hash)->table.Insert(e);
+      }
+      usage_ += charge;
+      if (handle != nullptr) {
+        pinned_usage_ += charge;
+      }
+      // A key inserted again within the recency of the LIR set is hot
+      bool hot = false;
       if (old != nullptr) {
-        old->SetInvalid();
-        if (Unref(old)) {
+        hot = old->InStack();
+        bool ghost = old->ghost;
+        RemoveEntry(old);
+        if (ghost) {
+          old->Free();
+        } else if (old->refs.fetch_and(~LIRSHandle::kInCache) ==
+                   LIRSHandle::kInCache) {
           usage_ -= old->charge;
-          LIRS_Remove(old);
+          last_reference_list.push_back(old);
         }
       }
-      if (handle == nullptr) {
-        LIRS_Insert(e);
+      ++num_entries_;
+      if (hot || lir_usage_ + charge <= lir_capacity_) {
+        e->state = LIRSHandle::kLIR;
+        lir_usage_ += charge;
+        PushToStack(e);
+        while (lir_usage_ > lir_capacity_ && stack_.prev_stack != e) {
+          DemoteStackBottom();
+        }
       } else {
-        e->SetRemote();
+        PushToStack(e);
+        PushToQueue(&queue_, e);
+      }
+      StackPruning();
+      TrimGhosts();
+      if (handle != nullptr) {
         *handle = reinterpret_cast<Cache::Handle*>(e);
       }
       s = Status::OK();
@@ -412,16 +625,22 @@ void LIRSCacheShard::Erase(const Slice& key, uint32_t hash) {
   bool last_reference = false;
   {
     MutexLock l(&mutex_);
-    e = table_.Remove(key, hash);
+    DrainAccesses();
+    {
+      MutexLock sl(&GetStripe(hash)->mutex);
+      e = GetStripe(hash)->table.Remove(key, hash);
+    }
     if (e != nullptr) {
-      last_reference = Unref(e);
-      if (last_reference) {
+      bool ghost = e->ghost;
+      RemoveEntry(e);
+      if (ghost) {
+        last_reference = true;
+      } else if (e->refs.fetch_and(~LIRSHandle::kInCache) ==
+                 LIRSHandle::kInCache) {
         usage_ -= e->charge;
+        last_reference = true;
       }
-      if (last_reference && e->InCache()) {
-        LIRS_Remove(e);
-      }
-      e->SetInvalid();
+      TrimGhosts();
     }
   }
 
@@ -432,35 +651,27 @@ void LIRSCacheShard::Erase(const Slice& key, uint32_t hash) {
   }
 }
 
-size_t LIRSCacheShard::GetUsage() const {
-  MutexLock l(&mutex_);
-  return usage_;
-}
+size_t LIRSCacheShard::GetUsage() const { return usage_; }
 
-size_t LIRSCacheShard::GetPinnedUsage() const {
-  MutexLock l(&mutex_);
-  assert(usage_ >= stack_usage_);
-  return usage_ - stack_usage_;
-}
+size_t LIRSCacheShard::GetPinnedUsage() const { return pinned_usage_; }
 
 std::string LIRSCacheShard::GetPrintableOptions() const {
   const int kBufferSize = 200;
   char buffer[kBufferSize];
   {
     MutexLock l(&mutex_);
-    snprintf(buffer, kBufferSize, "    irr_ratio : %.3lf\n", irr_ratio_);
+    snprintf(buffer, kBufferSize,
+             "    irr_ratio : %.3lf\n"
+             "    buffered_access : %d\n",
+             irr_ratio_, buffered_access_);
   }
   return std::string(buffer);
 }
 
-void LIRSCacheShard::SetStrictCapacityLimit(bool strict_capacity_limit) {
-  MutexLock l(&mutex_);
-  strict_capacity_limit_ = strict_capacity_limit;
-}
-
 LIRSCache::LIRSCache(size_t capacity, int num_shard_bits,
                      bool strict_capacity_limit, double irr_ratio,
-                     std::shared_ptr<MemoryAllocator> memory_allocator)
+                     std::shared_ptr<MemoryAllocator> memory_allocator,
+                     bool buffered_access)
     : ShardedCache(capacity, num_shard_bits, strict_capacity_limit,
                    std::move(memory_allocator)) {
   num_shards_ = 1 << num_shard_bits;
@@ -468,8 +679,8 @@ LIRSCache::LIRSCache(size_t capacity, int num_shard_bits,
       port::cacheline_aligned_alloc(sizeof(LIRSCacheShard) * num_shards_));
   size_t size_per_shard = (capacity + (num_shards_ - 1)) / num_shards_;
   for (int i = 0; i < num_shards_; i++) {
-    new (&shards_[i])
-        LIRSCacheShard(size_per_shard, strict_capacity_limit, irr_ratio);
+    new (&shards_[i]) LIRSCacheShard(size_per_shard, strict_capacity_limit,
+                                     irr_ratio, buffered_access);
   }
 }
 
@@ -521,12 +732,13 @@ void LIRSCache::DisownData() {
 std::shared_ptr<Cache> NewLIRSCache(const LIRSCacheOptions& cache_opts) {
   return NewLIRSCache(cache_opts.capacity, cache_opts.num_shard_bits,
                       cache_opts.strict_capacity_limit, cache_opts.irr_ratio,
-                      cache_opts.memory_allocator);
+                      cache_opts.memory_allocator, cache_opts.buffered_access);
 }
 
 std::shared_ptr<Cache> NewLIRSCache(
     size_t capacity, int num_shard_bits, bool strict_capacity_limit,
-    double irr_ratio, std::shared_ptr<MemoryAllocator> memory_allocator) {
+    double irr_ratio, std::shared_ptr<MemoryAllocator> memory_allocator,
+    bool buffered_access) {
   if (num_shard_bits >= 20) {
     return nullptr;  // the cache cannot be sharded into too many fine pieces
   }
@@ -537,9 +749,9 @@ std::shared_ptr<Cache> NewLIRSCache(
   if (num_shard_bits < 0) {
     num_shard_bits = GetDefaultCacheShardBits(capacity);
   }
-  return std::make_shared<LIRSCache>(capacity, num_shard_bits,
-                                     strict_capacity_limit, irr_ratio,
-                                     std::move(memory_allocator));
+  return std::make_shared<LIRSCache>(
+      capacity, num_shard_bits, strict_capacity_limit, irr_ratio,
+      std::move(memory_allocator), buffered_access);
 }
 
-}  // namespace TERARKDB_NAMESPACE
\ No newline at end of file
+}  // namespace TERARKDB_NAMESPACE
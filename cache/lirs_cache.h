@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <string>
 
 #include "cache/sharded_cache.h"
@@ -9,6 +10,14 @@
 
 namespace TERARKDB_NAMESPACE {
 
+// LIRSHandle is kept in the LIRS stack and/or the HIR queue while it is in
+// the cache, whether or not it is referenced externally. Eviction skips
+// entries which are still referenced.
+//
+// A non-resident HIR entry which is still in the stack is represented by a
+// ghost handle: it only carries the key, so that a re-insertion within a
+// short inter-reference recency goes straight to the LIR set. Ghosts are
+// linked into the ghost list through the queue links.
 struct LIRSHandle {
   void* value;
   void (*deleter)(const Slice&, void* value);
@@ -19,33 +28,36 @@ struct LIRSHandle {
   LIRSHandle* prev_queue;
   size_t charge;
   size_t key_length;
-  uint32_t refs;
+  // External references, plus kInCache while the handle is in the hash
+  // table. The handle is freed when it drops to 0.
+  std::atomic<uint32_t> refs;
   uint32_t hash;  // Hash of key(); used for fast sharding and comparisons
+  bool ghost;     // Set on creation, never changes
 
-  enum State { kRemote = 0, kLIR, kHIR, kNHIR, kInvalid } state;
+  enum State : uint8_t { kLIR, kHIR } state;
 
   char key_data[1];  // Beginning of key
 
-  Slice key() const { return Slice(key_data, key_length); }
+  static const uint32_t kInCache = 1u << 31;
+
+  static uint32_t ExternalRefs(uint32_t refs) { return refs & ~kInCache; }
 
-  bool Remote() { return state == kRemote; }
-  bool LIR() { return state == kLIR; }
-  bool HIR() { return state == kHIR; }
-  bool InCache() { return state == kLIR || state == kHIR || state == kNHIR; }
-  bool NHIR() { return state == kNHIR; }
-  bool Valid() { return state != kInvalid; }
+  static LIRSHandle* Create(const Slice& key, uint32_t hash);
+
+  Slice key() const { return Slice(key_data, key_length); }
 
-  void SetRemote() { state = kRemote; }
-  void SetLIR() { state = kLIR; }
-  void SetHIR() { state = kHIR; }
-  void SetNHIR() { state = kNHIR; }
-  void SetInvalid() { state = kInvalid; }
+  bool LIR() const { return state == kLIR; }
+  bool HIR() const { return state == kHIR; }
+  bool InStack() const { return next_stack != nullptr; }
+  bool InQueue() const { return next_queue != nullptr; }
 
   void Free() {
-    assert((refs == 1 && InCache()) || (refs == 0 && !InCache()));
+    assert(refs.load(std::memory_order_relaxed) == 0 ||
+           refs.load(std::memory_order_relaxed) == kInCache);
     if (deleter) {
       (*deleter)(key(), value);
     }
+    this->~LIRSHandle();
     delete[] reinterpret_cast<char*>(this);
   }
 };
@@ -56,6 +68,9 @@ class LIRSHandleTable {
   ~LIRSHandleTable();
 
   LIRSHandle* Lookup(const Slice& key, uint32_t hash);
+  // Return the resident entry with the given hash, used to resolve the
+  // buffered accesses
+  LIRSHandle* LookupResident(uint32_t hash);
   LIRSHandle* Insert(LIRSHandle* h);
   LIRSHandle* Remove(const Slice& key, uint32_t hash);
 
@@ -65,7 +80,6 @@ class LIRSHandleTable {
       LIRSHandle* h = list_[i];
       while (h != nullptr) {
         auto n = h->next_hash;
-        assert(h->InCache());
         func(h);
         h = n;
       }
@@ -87,10 +101,19 @@ class LIRSHandleTable {
   uint32_t elems_;
 };
 
+// Lock order: mutex_ before Stripe::mutex, and at most one stripe at a time.
+// A stripe mutex only guards the hash table and the access buffer of that
+// stripe, while mutex_ guards the LIRS stack and queues.
+//
+// With buffered_access, Lookup does not take mutex_: it pins the entry under
+// the stripe mutex and appends the hash to the access buffer of the stripe.
+// The buffered hits are applied to the stack and queue in a batch when the
+// buffer is full, or before any other operation holding mutex_. Hits on a
+// full buffer are dropped, which only makes recency slightly approximate.
 class ALIGN_AS(CACHE_LINE_SIZE) LIRSCacheShard : public CacheShard {
  public:
   LIRSCacheShard(size_t capacity, bool strict_capacity_limit,
-                 double irr_ratio = 0.9);
+                 double irr_ratio = 0.9, bool buffered_access = false);
   virtual ~LIRSCacheShard();
 
   virtual void SetCapacity(size_t capacity) override;
@@ -119,28 +142,56 @@ class ALIGN_AS(CACHE_LINE_SIZE) LIRSCacheShard : public CacheShard {
   virtual std::string GetPrintableOptions() const override;
 
  private:
-  void PushToQueue(LIRSHandle* h);
-  void RemoveFromQueue(LIRSHandle* h);
-  void AdjustToQueueTail(LIRSHandle* h);
-  void ShiftQueueHead();
+  static const int kNumStripeBits = 3;
+  static const uint32_t kAccessBufferSize = 32;
+
+  struct ALIGN_AS(CACHE_LINE_SIZE) Stripe {
+    port::Mutex mutex;
+    LIRSHandleTable table;
+    uint32_t num_accesses = 0;
+    uint32_t accesses[kAccessBufferSize];
+  };
+
+  Stripe* GetStripe(uint32_t hash) const {
+    return num_stripes_ == 1
+               ? stripes_
+               : &stripes_[(hash * 0x9e3779b9u) >> (32 - kNumStripeBits)];
+  }
+
+  static void PushToQueue(LIRSHandle* list, LIRSHandle* h);
+  static void RemoveFromQueue(LIRSHandle* h);
   void PushToStack(LIRSHandle* h);
   void RemoveFromStack(LIRSHandle* h);
   void AdjustToStackTop(LIRSHandle* h);
-  void AdjustStackBottom();
   void StackPruning();
-  void LIRS_Remove(LIRSHandle* h);
-  void LIRS_Insert(LIRSHandle* h);
-  bool Unref(LIRSHandle* h);
+  bool DemoteStackBottom();
+  void Access(LIRSHandle* h);
+  void DrainAccesses(Stripe* stripe);
+  void DrainAccesses();
+  void RemoveEntry(LIRSHandle* h);
+  void RemoveGhost(LIRSHandle* h);
+  void TrimGhosts();
+  bool Evict(LIRSHandle* h, autovector<LIRSHandle*>* deleted);
   void EvictFromLIRS(size_t charge, autovector<LIRSHandle*>* deleted);
+  LIRSHandle* Pin(LIRSHandle* h);
+  bool Unref(LIRSHandle* h);
 
-  size_t capacity_;
-  size_t stack_capacity_;
-  size_t usage_;
-  size_t stack_usage_;
+  std::atomic<size_t> capacity_;
+  size_t lir_capacity_;
+  std::atomic<size_t> usage_;
+  std::atomic<size_t> pinned_usage_;
+  size_t lir_usage_;
+  size_t num_entries_;
+  size_t num_ghosts_;
   double irr_ratio_;
-  LIRSHandle cache_;
-  LIRSHandleTable table_;
+  // Dummy heads of the LIRS stack, the resident HIR queue and the ghost list
+  LIRSHandle stack_;
+  LIRSHandle queue_;
+  LIRSHandle ghosts_;
   bool strict_capacity_limit_;
+  const bool buffered_access_;
+  size_t num_stripes_;
+  Stripe* stripes_;
   mutable port::Mutex mutex_;
 };
 
@@ -148,7 +199,8 @@ class LIRSCache : public ShardedCache {
  public:
   LIRSCache(size_t capacity, int num_shard_bits, bool strict_capacity_limit,
             double irr_ratio,
-            std::shared_ptr<MemoryAllocator> memory_allocator = nullptr);
+            std::shared_ptr<MemoryAllocator> memory_allocator = nullptr,
+            bool buffered_access = false);
   virtual ~LIRSCache();
   virtual const char* Name() const override { return "LIRSCache"; }
   virtual CacheShard* GetShard(int shard) override;
@@ -163,4 +215,4 @@ class LIRSCache : public ShardedCache {
   int num_shards_ = 0;
 };
 
-}  // namespace TERARKDB_NAMESPACE
\ No newline at end of file
+}  // namespace TERARKDB_NAMESPACE
@@ -52,7 +52,7 @@ TableBuilder* NewTableBuilder(
     const CompressionOptions& compression_opts, int level,
     double compaction_load, const std::string* compression_dict,
     bool skip_filters, uint64_t creation_time, uint64_t oldest_key_time,
-    SstPurpose sst_purpose) {
+    SstPurpose sst_purpose, TableFileCreationReason reason) {
   assert((column_family_id ==
           TablePropertiesCollectorFactory::Context::kUnknownColumnFamily) ==
          column_family_name.empty());
@@ -61,7 +61,7 @@ TableBuilder* NewTableBuilder(
                           int_tbl_prop_collector_factories, compression_type,
                           compression_opts, compression_dict, skip_filters,
                           column_family_name, level, compaction_load,
-                          creation_time, oldest_key_time, sst_purpose),
+                          creation_time, oldest_key_time, sst_purpose, reason),
       column_family_id, file);
 }
 
@@ -147,7 +147,8 @@ Status BuildTable(
           int_tbl_prop_collector_factories, column_family_id,
           column_family_name, file_writer.get(), compression, compression_opts,
           level, compaction_load, nullptr /* compression_dict */,
-          false /* skip_filters */, creation_time, oldest_key_time);
+          false /* skip_filters */, creation_time, oldest_key_time,
+          kEssenceSst, reason);
     }
 
     MergeHelper merge(env, internal_comparator.user_comparator(),
@@ -171,11 +172,12 @@ Status BuildTable(
       void* trans_to_separate_callback_args = nullptr;
 
       Status TransToSeparate(const Slice& internal_key, LazyBuffer& value,
-                             const Slice& meta, bool is_merge,
-                             bool is_index) override {
+                             const Slice& meta, bool is_merge, bool is_index,
+                             uint64_t handle_offset,
+                             uint64_t handle_size) override {
         return SeparateHelper::TransToSeparate(
             internal_key, value, value.file_number(), meta, is_merge, is_index,
-            value_meta_extractor.get());
+            value_meta_extractor.get(), handle_offset, handle_size);
       }
 
       Status TransToSeparate(const Slice& internal_key,
@@ -215,6 +217,11 @@ Status BuildTable(
         tp = blob_builder->GetTableProperties();
         blob_meta->prop.raw_key_size = tp.raw_key_size;
         blob_meta->prop.raw_value_size = tp.raw_value_size;
+        if (ioptions.ttl_extractor_factory != nullptr) {
+          GetExpireTimeRange(tp.user_collected_properties,
+                             &blob_meta->prop.earliest_expire_time,
+                             &blob_meta->prop.latest_expire_time);
+        }
         StopWatch sw(env, ioptions.statistics, TABLE_SYNC_MICROS);
         status = separate_helper.file_writer->Sync(ioptions.use_fsync);
       }
@@ -286,15 +293,22 @@ Status BuildTable(
             true));
         blob_builder = separate_helper.builder.get();
       }
+      uint64_t handle_offset = 0, handle_size = 0;
       if (status.ok()) {
-        status = blob_builder->Add(key, value);
+        if (mutable_cf_options.blob_offset_addressing) {
+          status = blob_builder->AddWithHandle(key, value, &handle_offset,
+                                               &handle_size);
+        } else {
+          status = blob_builder->Add(key, value);
+        }
       }
       if (status.ok()) {
         blob_meta->UpdateBoundaries(key, GetInternalKeySeqno(key));
         status = SeparateHelper::TransToSeparate(
             key, value, blob_meta->fd.GetNumber(), Slice(),
             GetInternalKeyType(key) == kTypeMerge, false,
-            separate_helper.value_meta_extractor.get());
+            separate_helper.value_meta_extractor.get(), handle_offset,
+            handle_size);
       }
       return status;
     };
@@ -20,6 +20,7 @@
 #include <string>
 #include <vector>
 
+#include "db/compaction_job.h"
 #include "db/compaction_picker.h"
 #include "db/compaction_picker_universal.h"
 #include "db/db_impl.h"
@@ -337,6 +338,15 @@ ColumnFamilyOptions SanitizeOptions(const ImmutableDBOptions& db_options,
   if (result.blob_gc_ratio < 0) {
     result.blob_gc_ratio = 0;
   }
+  if (result.adaptive_filter_skip_hit_ratio > 1) {
+    result.adaptive_filter_skip_hit_ratio = 1;
+  }
+  if (result.adaptive_filter_skip_hit_ratio < 0) {
+    result.adaptive_filter_skip_hit_ratio = 0;
+  }
+  if (result.blob_gc_merge_join_ratio < 0) {
+    result.blob_gc_merge_join_ratio = 0;
+  }
   if (result.maintainer_job_ratio < 0) {
     result.maintainer_job_ratio = 0;
   }
@@ -750,6 +760,11 @@ WriteStallCondition ColumnFamilyData::RecalculateWriteStallConditions(
 
     bool was_stopped = write_controller->IsStopped();
     bool needed_delay = write_controller->NeedsDelay();
+    // Compactions placed by the dispatcher are falling behind, slow down
+    // harder than the stall condition alone would
+    CompactionDispatcher* dispatcher = compaction_dispatcher();
+    bool dispatcher_overloaded =
+        dispatcher != nullptr && dispatcher->IsOverloaded();
 
     if (write_stall_condition == WriteStallCondition::kStopped &&
         write_stall_cause == WriteStallCause::kMemtableLimit) {
@@ -795,7 +810,8 @@ WriteStallCondition ColumnFamilyData::RecalculateWriteStallConditions(
                write_stall_cause == WriteStallCause::kMemtableLimit) {
       write_controller_token_ =
           SetupDelay(write_controller, compaction_needed_bytes,
-                     prev_compaction_needed_bytes_, was_stopped,
+                     prev_compaction_needed_bytes_,
+                     was_stopped || dispatcher_overloaded,
                      mutable_cf_options.disable_auto_compactions);
       internal_stats_->AddCFStats(InternalStats::MEMTABLE_LIMIT_SLOWDOWNS, 1);
       ROCKS_LOG_WARN(
@@ -813,7 +829,8 @@ WriteStallCondition ColumnFamilyData::RecalculateWriteStallConditions(
                        mutable_cf_options.level0_stop_writes_trigger - 2;
       write_controller_token_ =
           SetupDelay(write_controller, compaction_needed_bytes,
-                     prev_compaction_needed_bytes_, was_stopped || near_stop,
+                     prev_compaction_needed_bytes_,
+                     was_stopped || near_stop || dispatcher_overloaded,
                      mutable_cf_options.disable_auto_compactions);
       internal_stats_->AddCFStats(InternalStats::L0_FILE_COUNT_LIMIT_SLOWDOWNS,
                                   1);
@@ -842,7 +859,8 @@ WriteStallCondition ColumnFamilyData::RecalculateWriteStallConditions(
 
       write_controller_token_ =
           SetupDelay(write_controller, compaction_needed_bytes,
-                     prev_compaction_needed_bytes_, was_stopped || near_stop,
+                     prev_compaction_needed_bytes_,
+                     was_stopped || near_stop || dispatcher_overloaded,
                      mutable_cf_options.disable_auto_compactions);
       internal_stats_->AddCFStats(
           InternalStats::PENDING_COMPACTION_BYTES_LIMIT_SLOWDOWNS, 1);
@@ -858,7 +876,8 @@ WriteStallCondition ColumnFamilyData::RecalculateWriteStallConditions(
                        mutable_cf_options.level0_stop_writes_trigger - 2;
       write_controller_token_ =
           SetupDelay(write_controller, compaction_needed_bytes,
-                     prev_compaction_needed_bytes_, was_stopped || near_stop,
+                     prev_compaction_needed_bytes_,
+                     was_stopped || near_stop || dispatcher_overloaded,
                      mutable_cf_options.disable_auto_compactions);
       internal_stats_->AddCFStats(InternalStats::READ_AMP_LIMIT_SLOWDOWNS, 1);
       ROCKS_LOG_WARN(
@@ -880,6 +899,13 @@ WriteStallCondition ColumnFamilyData::RecalculateWriteStallConditions(
             "[%s] Increasing compaction threads because we have %d level-0 "
             "files ",
             name_.c_str(), vstorage->l0_delay_trigger_count());
+      } else if (dispatcher_overloaded) {
+        write_controller_token_ =
+            write_controller->GetCompactionPressureToken();
+        ROCKS_LOG_INFO(ioptions_.info_log,
+                       "[%s] Increasing compaction threads because the "
+                       "compaction dispatcher %s is overloaded",
+                       name_.c_str(), dispatcher->Name());
       } else if (vstorage->estimated_compaction_needed_bytes() >=
                  mutable_cf_options.soft_pending_compaction_bytes_limit / 4) {
         // Increase compaction threads if bytes needed for compaction exceeds
@@ -923,6 +949,13 @@ const EnvOptions* ColumnFamilyData::soptions() const {
   return &(column_family_set_->env_options_);
 }
 
+CompactionDispatcher* ColumnFamilyData::compaction_dispatcher() const {
+  if (ioptions_.compaction_dispatcher != nullptr) {
+    return ioptions_.compaction_dispatcher;
+  }
+  return CompactionJob::EnvCompactionDispatcher();
+}
+
 void ColumnFamilyData::SetCurrent(Version* current_version) {
   current_ = current_version;
 }
@@ -214,6 +214,9 @@ class ColumnFamilyData {
   // thread-safe
   const EnvOptions* soptions() const;
   const ImmutableCFOptions* ioptions() const { return &ioptions_; }
+  // The compaction_dispatcher of ioptions, or the one set up from the
+  // environment if there is none. May be null.
+  CompactionDispatcher* compaction_dispatcher() const;
   // REQUIRES: DB mutex held
   // This returns the MutableCFOptions used by current SuperVersion
   // You should use this API to reference MutableCFOptions most of the time.
@@ -168,6 +168,9 @@ struct CompactionWorkerContext {
   int level, output_level, number_levels;
   bool skip_filters, bottommost_level, allow_ingest_behind, preserve_deletes;
   std::vector<NameParam> int_tbl_prop_collector_factories;
+  // Not sent to the worker, the DB running the compaction. A dispatcher
+  // shared by several DBs cancels only the jobs of the DB closing.
+  const void* owner = nullptr;
 };
 
 struct CompactionWorkerResult {
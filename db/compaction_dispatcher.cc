@@ -15,9 +15,18 @@
 #define __STDC_FORMAT_MACROS
 #endif
 
+#include <fcntl.h>
 #include <inttypes.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 #include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
 
 #ifdef WITH_TERARK_ZIP
 #include <terark/num_to_str.hpp>
@@ -27,6 +36,7 @@
 #endif
 
 #include "db/compaction_iterator.h"
+#include "db/compaction_worker_codec.h"
 #include "db/map_builder.h"
 #include "db/merge_helper.h"
 #include "db/range_del_aggregator.h"
@@ -44,7 +54,11 @@
 #include "table/table_reader.h"
 #include "table/two_level_iterator.h"
 #include "util/c_style_callback.h"
+#include "util/coding.h"
 #include "util/filename.h"
+#include "util/string_util.h"
+
+extern char** environ;
 
 #ifndef WITH_TERARK_ZIP
 #define USE_AJSON 1
@@ -254,6 +268,30 @@ AJSON(CompactionWorkerContext, user_comparator, merge_operator,
 
 namespace TERARKDB_NAMESPACE {
 
+std::string SerializeCompactionWorkerContext(
+    const CompactionWorkerContext& context) {
+  ajson::string_stream stream;
+  ajson::save_to(stream, context);
+  return stream.str();
+}
+
+void DeserializeCompactionWorkerContext(const Slice& src,
+                                        CompactionWorkerContext* context) {
+  ajson::load_from_buff(*context, src);
+}
+
+std::string SerializeCompactionWorkerResult(
+    const CompactionWorkerResult& result) {
+  ajson::string_stream stream;
+  ajson::save_to(stream, result);
+  return stream.str();
+}
+
+void DeserializeCompactionWorkerResult(const Slice& src,
+                                       CompactionWorkerResult* result) {
+  ajson::load_from_buff(*result, src);
+}
+
 template <class T>
 using STMap = std::unordered_map<std::string, std::shared_ptr<T>>;
 
@@ -272,11 +310,12 @@ class WorkerSeparateHelper : public SeparateHelper, public LazyBufferState {
 
   using SeparateHelper::TransToSeparate;
   Status TransToSeparate(const Slice& internal_key, LazyBuffer& value,
-                         const Slice& meta, bool is_merge,
-                         bool is_index) override {
+                         const Slice& meta, bool is_merge, bool is_index,
+                         uint64_t handle_offset,
+                         uint64_t handle_size) override {
     return SeparateHelper::TransToSeparate(
         internal_key, value, value.file_number(), meta, is_merge, is_index,
-        value_meta_extractor_.get());
+        value_meta_extractor_.get(), handle_offset, handle_size);
   }
 
   LazyBuffer TransToCombined(const Slice& user_key, uint64_t sequence,
@@ -320,8 +359,12 @@ class WorkerSeparateHelper : public SeparateHelper, public LazyBufferState {
 std::function<CompactionWorkerResult()>
 RemoteCompactionDispatcher::StartCompaction(
     const CompactionWorkerContext& context) {
-  ajson::string_stream stream;
-  ajson::save_to(stream, context);
+  std::string encoded_context;
+  if (wire_format_ == kBinaryWireFormat) {
+    EncodeCompactionWorkerContext(context, &encoded_context);
+  } else {
+    encoded_context = SerializeCompactionWorkerContext(context);
+  }
   struct Result {
     Result(std::future<std::string>&& _future) : future(_future.share()) {}
 
@@ -330,8 +373,18 @@ RemoteCompactionDispatcher::StartCompaction(
     CompactionWorkerResult operator()() {
       CompactionWorkerResult result;
       std::string encoded_result = future.get();
+      // The worker answers in the format of the job, and errors of the
+      // dispatcher itself use the default one
+      if (IsBinaryCompactionWorkerMessage(encoded_result)) {
+        Status s = DecodeCompactionWorkerResult(encoded_result, &result);
+        if (!s.ok()) {
+          result = CompactionWorkerResult();
+          result.status = std::move(s);
+        }
+        return result;
+      }
       try {
-        ajson::load_from_buff(result, encoded_result);
+        DeserializeCompactionWorkerResult(encoded_result, &result);
       } catch (const std::exception& ex) {
         terark::string_appender<> detail;
         detail << "encoded_result[len=" << encoded_result.size() << "]: ";
@@ -342,7 +395,8 @@ RemoteCompactionDispatcher::StartCompaction(
       return result;
     }
   };
-  std::future<std::string> str_result = DoCompaction(stream.str());
+  std::future<std::string> str_result =
+      DoCompactionFor(context.owner, std::move(encoded_context));
   return Result(std::move(str_result));
 }
 
@@ -352,6 +406,31 @@ bool IsCompactionWorkerNode() { return g_isCompactionWorkerNode; }
 struct RemoteCompactionDispatcher::Worker::Rep {
   EnvOptions env_options;
   Env* env;
+
+  // Table factories are kept across jobs, so a long-lived worker does not
+  // parse the options again and keeps its block cache warm
+  std::mutex table_factories_mutex;
+  std::unordered_map<std::string, std::shared_ptr<TableFactory>>
+      table_factories;
+
+  std::shared_ptr<TableFactory> GetTableFactory(const std::string& name,
+                                                const std::string& options,
+                                                Status* s) {
+    std::string key = name;
+    key.push_back('\0');
+    key.append(options);
+    std::lock_guard<std::mutex> lock(table_factories_mutex);
+    auto find = table_factories.find(key);
+    if (find != table_factories.end()) {
+      return find->second;
+    }
+    std::shared_ptr<TableFactory> factory(
+        TableFactory::create(name, options, s));
+    if (factory) {
+      table_factories.emplace(std::move(key), factory);
+    }
+    return factory;
+  }
 };
 
 RemoteCompactionDispatcher::Worker::Worker(EnvOptions env_options, Env* env) {
@@ -397,17 +476,33 @@ class RemoteCompactionProxy : public CompactionIterator::CompactionProxy {
   bool bottommost_level_, allow_ingest_behind_, preserve_deletes_;
 };
 
-static std::string make_error(Status&& status) {
+static CompactionWorkerResult ErrorResult(Status&& status) {
   CompactionWorkerResult result;
   result.status = std::move(status);
-  ajson::string_stream stream;
-  ajson::save_to(stream, result);
-  return stream.str();
+  return result;
+}
+
+static std::string make_error(Status&& status) {
+  return SerializeCompactionWorkerResult(ErrorResult(std::move(status)));
 };
 
 std::string RemoteCompactionDispatcher::Worker::DoCompaction(Slice data) {
   CompactionWorkerContext context;
-  ajson::load_from_buff(context, data);
+  if (IsBinaryCompactionWorkerMessage(data)) {
+    Status s = DecodeCompactionWorkerContext(data, &context);
+    std::string encoded_result;
+    EncodeCompactionWorkerResult(
+        s.ok() ? RunCompaction(&context) : ErrorResult(std::move(s)),
+        &encoded_result);
+    return encoded_result;
+  }
+  DeserializeCompactionWorkerContext(data, &context);
+  return SerializeCompactionWorkerResult(RunCompaction(&context));
+}
+
+CompactionWorkerResult RemoteCompactionDispatcher::Worker::RunCompaction(
+    CompactionWorkerContext* context_ptr) {
+  CompactionWorkerContext& context = *context_ptr;
   context.compaction_filter_context.smallest_user_key =
       context.smallest_user_key;
   context.compaction_filter_context.largest_user_key = context.largest_user_key;
@@ -415,19 +510,19 @@ std::string RemoteCompactionDispatcher::Worker::DoCompaction(Slice data) {
   ImmutableDBOptions immutable_db_options = ImmutableDBOptions(DBOptions());
   ColumnFamilyOptions cf_options;
   if (context.user_comparator.empty()) {
-    return make_error(Status::Corruption("Comparator name is empty!"));
+    return ErrorResult(Status::Corruption("Comparator name is empty!"));
   } else {
     cf_options.comparator = Comparator::create(context.user_comparator);
     if (!cf_options.comparator) {
-      return make_error(Status::Corruption("Can not find comparator",
-                                           context.user_comparator));
+      return ErrorResult(Status::Corruption("Can not find comparator",
+                                            context.user_comparator));
     }
   }
   if (!context.merge_operator.empty()) {
     cf_options.merge_operator.reset(MergeOperator::create(
         context.merge_operator, context.merge_operator_data));
     if (!cf_options.merge_operator) {
-      return make_error(Status::Corruption("Missing merge_operator !"));
+      return ErrorResult(Status::Corruption("Missing merge_operator !"));
     }
   }
   if (!context.value_meta_extractor_factory.empty()) {
@@ -435,37 +530,39 @@ std::string RemoteCompactionDispatcher::Worker::DoCompaction(Slice data) {
         context.value_meta_extractor_factory,
         context.value_meta_extractor_factory_options));
     if (!cf_options.value_meta_extractor_factory) {
-      return make_error(Status::Corruption("Missing value_meta_extractor !"));
+      return ErrorResult(Status::Corruption("Missing value_meta_extractor !"));
     }
   }
   std::unique_ptr<CompactionFilter> filter_ptr;
   if (!context.compaction_filter.empty()) {
     if (!context.compaction_filter_factory.empty()) {
-      return make_error(Status::Corruption(
+      return ErrorResult(Status::Corruption(
           "CompactonFilter and CompactionFilterFactory are both specified"));
     }
     filter_ptr.reset(CompactionFilter::create(
         context.compaction_filter, context.compaction_filter_data,
         context.compaction_filter_context));
     if (!filter_ptr) {
-      return make_error(Status::Corruption("Missing CompactionFilterFactory!"));
+      return ErrorResult(
+          Status::Corruption("Missing CompactionFilterFactory!"));
     }
     cf_options.compaction_filter = filter_ptr.get();
   } else if (!context.compaction_filter_factory.empty()) {
     cf_options.compaction_filter_factory.reset(CompactionFilterFactory::create(
         context.compaction_filter_factory, context.compaction_filter_data));
     if (!cf_options.compaction_filter_factory) {
-      return make_error(Status::Corruption("Missing CompactionFilterFactory!"));
+      return ErrorResult(
+          Status::Corruption("Missing CompactionFilterFactory!"));
     }
   }
   if (context.table_factory.empty()) {
-    return make_error(Status::Corruption("Bad table_factory name !"));
+    return ErrorResult(Status::Corruption("Bad table_factory name !"));
   } else {
     Status s;
-    cf_options.table_factory.reset(TableFactory::create(
-        context.table_factory, context.table_factory_options, &s));
+    cf_options.table_factory = rep_->GetTableFactory(
+        context.table_factory, context.table_factory_options, &s);
     if (!cf_options.table_factory) {
-      return make_error(std::move(s));
+      return ErrorResult(std::move(s));
     }
   }
   cf_options.bloom_locality = context.bloom_locality;
@@ -476,7 +573,7 @@ std::string RemoteCompactionDispatcher::Worker::DoCompaction(Slice data) {
     cf_options.prefix_extractor.reset(SliceTransform::create(
         context.prefix_extractor, context.prefix_extractor_options));
     if (!cf_options.prefix_extractor) {
-      return make_error(Status::Corruption("Missing prefix_extractor !"));
+      return ErrorResult(Status::Corruption("Missing prefix_extractor !"));
     }
   }
   ImmutableCFOptions immutable_cf_options(immutable_db_options, cf_options);
@@ -494,13 +591,13 @@ std::string RemoteCompactionDispatcher::Worker::DoCompaction(Slice data) {
   for (auto& collector : context.int_tbl_prop_collector_factories) {
     auto user_fac = TablePropertiesCollectorFactory::create(collector.name);
     if (!user_fac) {
-      return make_error(
+      return ErrorResult(
           Status::Corruption("Missing int_tbl_prop_collector_factories !"));
     }
     if (user_fac->NeedSerialize()) {
       Status s = user_fac->Deserialize(collector.param);
       if (!s.ok()) {
-        return make_error(std::move(s));
+        return ErrorResult(std::move(s));
       }
     }
     int_tbl_prop_collector_factories.data.emplace_back(
@@ -1093,9 +1190,7 @@ std::string RemoteCompactionDispatcher::Worker::DoCompaction(Slice data) {
   auto finish_time = system_clock::now();
   auto duration = duration_cast<microseconds>(finish_time - start_time);
   result.time_us = duration.count();
-  ajson::string_stream stream;
-  ajson::save_to(stream, result);
-  return stream.str();
+  return result;
 }
 
 void RemoteCompactionDispatcher::Worker::DebugSerializeCheckResult(Slice data) {
@@ -1131,6 +1226,91 @@ void RemoteCompactionDispatcher::Worker::DebugSerializeCheckResult(Slice data) {
 #endif
 }
 
+namespace {
+const char kWorkerFdEnv[] = "TerarkDB_compactionWorkerFd";
+const int kWorkerFd = 3;
+// Larger frames come from a broken peer, not from a compaction job
+const uint64_t kMaxFrameSize = 512ull << 20;
+
+Status SendAll(int fd, const char* data, size_t size) {
+  while (size > 0) {
+    ssize_t n = ::send(fd, data, size, MSG_NOSIGNAL);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return Status::IOError("send compaction frame", strerror(errno));
+    }
+    data += n;
+    size -= n;
+  }
+  return Status::OK();
+}
+
+// Return Incomplete if the peer closed the socket
+Status RecvAll(int fd, char* data, size_t size) {
+  while (size > 0) {
+    ssize_t n = ::recv(fd, data, size, 0);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return Status::IOError("recv compaction frame", strerror(errno));
+    }
+    if (n == 0) {
+      return Status::Incomplete("compaction socket closed");
+    }
+    data += n;
+    size -= n;
+  }
+  return Status::OK();
+}
+
+// Jobs and results are sent as a fixed64 length followed by the payload
+Status WriteFrame(int fd, const Slice& data) {
+  char header[sizeof(uint64_t)];
+  EncodeFixed64(header, data.size());
+  Status s = SendAll(fd, header, sizeof header);
+  if (s.ok()) {
+    s = SendAll(fd, data.data(), data.size());
+  }
+  return s;
+}
+
+Status ReadFrame(int fd, std::string* data) {
+  char header[sizeof(uint64_t)];
+  Status s = RecvAll(fd, header, sizeof header);
+  if (s.ok()) {
+    uint64_t size = DecodeFixed64(header);
+    if (size > kMaxFrameSize) {
+      return Status::Corruption("compaction worker frame too large",
+                                ToString(size));
+    }
+    data->resize(size);
+    s = RecvAll(fd, &(*data)[0], data->size());
+  }
+  return s;
+}
+}  // namespace
+
+Status RemoteCompactionDispatcher::Worker::Serve(int fd) {
+  std::string request;
+  while (true) {
+    Status s = ReadFrame(fd, &request);
+    if (s.IsIncomplete()) {
+      // Dispatcher has gone away
+      return Status::OK();
+    }
+    if (!s.ok()) {
+      return s;
+    }
+    s = WriteFrame(fd, DoCompaction(request));
+    if (!s.ok()) {
+      return s;
+    }
+  }
+}
+
 const char* RemoteCompactionDispatcher::Name() const {
   return "RemoteCompactionDispatcher";
 }
@@ -1178,4 +1358,218 @@ std::shared_ptr<CompactionDispatcher> NewCommandLineCompactionDispatcher(
   return std::make_shared<CommandLineCompactionDispatcher>(std::move(cmd));
 }
 
+// Each worker process is driven by one thread of the dispatcher, which takes
+// the next job from the queue, sends it to its worker and waits for the
+// result. A job which fails on the socket fails with an error result, and
+// its worker is stopped and restarted on the next job.
+class WorkerPoolCompactionDispatcher : public RemoteCompactionDispatcher {
+ public:
+  WorkerPoolCompactionDispatcher(std::string&& cmd, int num_workers)
+      : cmd_(std::move(cmd)), workers_(std::max(1, num_workers)) {
+    for (auto& worker : workers_) {
+      threads_.emplace_back(&WorkerPoolCompactionDispatcher::Run, this,
+                            &worker);
+    }
+  }
+
+  ~WorkerPoolCompactionDispatcher() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      shutdown_ = true;
+    }
+    CancelCompactions(nullptr);
+    cv_.notify_all();
+    for (auto& t : threads_) {
+      t.join();
+    }
+    for (auto& worker : workers_) {
+      Stop(&worker, false /* force */);
+    }
+  }
+
+  const char* Name() const override { return "WorkerPoolCompactionDispatcher"; }
+
+  std::future<std::string> DoCompaction(std::string data) override {
+    return DoCompactionFor(nullptr, std::move(data));
+  }
+
+  std::future<std::string> DoCompactionFor(const void* owner,
+                                           std::string data) override {
+    std::unique_ptr<Job> job(new Job);
+    job->data = std::move(data);
+    job->owner = owner;
+    std::future<std::string> future = job->promise.get_future();
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (shutdown_) {
+      job->promise.set_value(
+          make_error(Status::ShutdownInProgress("compaction worker pool")));
+    } else {
+      jobs_.emplace_back(std::move(job));
+      cv_.notify_one();
+    }
+    return future;
+  }
+
+  void CancelCompactions(const void* owner) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto cancelled = [owner](const void* job_owner) {
+      return owner == nullptr || owner == job_owner;
+    };
+    std::deque<std::unique_ptr<Job>> jobs;
+    for (auto& job : jobs_) {
+      if (cancelled(job->owner)) {
+        job->promise.set_value(make_error(
+            Status::ShutdownInProgress("compaction job cancelled")));
+      } else {
+        jobs.emplace_back(std::move(job));
+      }
+    }
+    jobs_.swap(jobs);
+    for (auto& worker : workers_) {
+      if (worker.busy && worker.pid > 0 && cancelled(worker.owner)) {
+        // The thread waiting for the result sees the socket closed
+        worker.cancelled = true;
+        kill(-worker.pid, SIGKILL);
+      }
+    }
+  }
+
+ private:
+  struct Job {
+    std::string data;
+    const void* owner = nullptr;
+    std::promise<std::string> promise;
+  };
+
+  struct WorkerProcess {
+    // Also the process group of the worker
+    pid_t pid = -1;
+    int fd = -1;
+    // A job is in flight, pid is not reaped until it is done
+    bool busy = false;
+    bool cancelled = false;
+    // Owner of the job in flight
+    const void* owner = nullptr;
+  };
+
+  void Run(WorkerProcess* worker) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      cv_.wait(lock, [this] { return shutdown_ || !jobs_.empty(); });
+      if (shutdown_) {
+        break;
+      }
+      std::unique_ptr<Job> job = std::move(jobs_.front());
+      jobs_.pop_front();
+      Status s;
+      if (worker->pid <= 0) {
+        s = Spawn(worker);
+      }
+      worker->busy = true;
+      worker->cancelled = false;
+      worker->owner = job->owner;
+      lock.unlock();
+
+      std::string result;
+      if (s.ok()) {
+        s = WriteFrame(worker->fd, job->data);
+      }
+      if (s.ok()) {
+        s = ReadFrame(worker->fd, &result);
+      }
+
+      lock.lock();
+      worker->busy = false;
+      if (!s.ok()) {
+        if (worker->cancelled) {
+          s = Status::ShutdownInProgress("compaction job cancelled");
+        }
+        fprintf(stderr, "ERROR: CompactionWorker(%s, pid=%d) = %s\n",
+                cmd_.c_str(), int(worker->pid), s.ToString().c_str());
+        Stop(worker, true /* force */);
+        result = make_error(std::move(s));
+      }
+      job->promise.set_value(std::move(result));
+    }
+  }
+
+  // REQUIRES: mutex_ held
+  Status Spawn(WorkerProcess* worker) {
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) != 0) {
+      return Status::IOError("socketpair", strerror(errno));
+    }
+    // Prepared before fork, the child may only call async-signal-safe
+    // functions
+    std::string fd_env = std::string(kWorkerFdEnv) + "=" + ToString(kWorkerFd);
+    std::vector<char*> envp;
+    for (char** e = environ; *e != nullptr; ++e) {
+      if (strncmp(*e, kWorkerFdEnv, sizeof kWorkerFdEnv - 1) != 0) {
+        envp.push_back(*e);
+      }
+    }
+    envp.push_back(&fd_env[0]);
+    envp.push_back(nullptr);
+
+    pid_t pid = fork();
+    if (pid == 0) {
+      // The shell may fork the command, so the worker is killed by its
+      // process group
+      setpgid(0, 0);
+      // Only the worker end is inherited by the command, as a fixed fd so
+      // that scripts can use it
+      if (fds[1] != kWorkerFd && dup2(fds[1], kWorkerFd) < 0) {
+        _exit(127);
+      }
+      fcntl(kWorkerFd, F_SETFD, 0);
+      execle("/bin/sh", "sh", "-c", cmd_.c_str(), (char*)nullptr, envp.data());
+      _exit(127);
+    }
+    close(fds[1]);
+    if (pid < 0) {
+      close(fds[0]);
+      return Status::IOError("fork compaction worker", strerror(errno));
+    }
+    // Also set by the parent, CancelCompactions may kill the group before
+    // the child runs. Fails with EACCES once the child has exec'ed, when it
+    // is already done
+    setpgid(pid, pid);
+    fprintf(stderr, "INFO: CompactionWorker(%s) started, pid=%d\n",
+            cmd_.c_str(), int(pid));
+    worker->pid = pid;
+    worker->fd = fds[0];
+    return Status::OK();
+  }
+
+  // Closing the socket makes an idle worker exit by itself
+  void Stop(WorkerProcess* worker, bool force) {
+    if (worker->fd >= 0) {
+      close(worker->fd);
+      worker->fd = -1;
+    }
+    if (worker->pid > 0) {
+      if (force) {
+        kill(-worker->pid, SIGKILL);
+      }
+      while (waitpid(worker->pid, nullptr, 0) < 0 && errno == EINTR) {
+      }
+      worker->pid = -1;
+    }
+  }
+
+  const std::string cmd_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<std::unique_ptr<Job>> jobs_;
+  std::vector<WorkerProcess> workers_;
+  std::vector<std::thread> threads_;
+  bool shutdown_ = false;
+};
+
+std::shared_ptr<CompactionDispatcher> NewWorkerPoolCompactionDispatcher(
+    std::string cmd, int num_workers) {
+  return std::make_shared<WorkerPoolCompactionDispatcher>(std::move(cmd),
+                                                          num_workers);
+}
+
 }  // namespace TERARKDB_NAMESPACE
@@ -0,0 +1,109 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#include <chrono>
+
+#include "db/compaction.h"
+#include "rocksdb/compaction_dispatcher.h"
+#include "rocksdb/terark_namespace.h"
+#include "util/testharness.h"
+
+namespace TERARKDB_NAMESPACE {
+
+// The workers are shell commands talking on fd 3 instead of Worker::Serve(),
+// so that they can misbehave
+class WorkerPoolCompactionDispatcherTest : public testing::Test {
+ public:
+  void Open(const std::string& cmd, int num_workers) {
+    dispatcher_ = NewWorkerPoolCompactionDispatcher(cmd, num_workers);
+    remote()->set_wire_format(RemoteCompactionDispatcher::kBinaryWireFormat);
+  }
+
+  RemoteCompactionDispatcher* remote() {
+    return static_cast<RemoteCompactionDispatcher*>(dispatcher_.get());
+  }
+
+  CompactionWorkerResult RunJob(const void* owner) {
+    CompactionWorkerContext context;
+    context.owner = owner;
+    return dispatcher_->StartCompaction(context)();
+  }
+
+  std::shared_ptr<CompactionDispatcher> dispatcher_;
+};
+
+TEST_F(WorkerPoolCompactionDispatcherTest, WorkerCrash) {
+  Open("exit 3", 1);
+  auto result = RunJob(nullptr);
+  ASSERT_NOK(result.status);
+  ASSERT_FALSE(result.status.IsShutdownInProgress());
+  // The worker is restarted for the next job
+  result = RunJob(nullptr);
+  ASSERT_NOK(result.status);
+  ASSERT_FALSE(result.status.IsShutdownInProgress());
+}
+
+TEST_F(WorkerPoolCompactionDispatcherTest, MalformedResult) {
+  // A frame of 5 bytes: the result magic and a bad format version
+  Open("printf '\\005\\000\\000\\000\\000\\000\\000\\000TCWR\\377' >&3;"
+       " cat <&3 >/dev/null",
+       1);
+  auto result = RunJob(nullptr);
+  ASSERT_TRUE(result.status.IsCorruption()) << result.status.ToString();
+}
+
+TEST_F(WorkerPoolCompactionDispatcherTest, FrameTooLarge) {
+  // A length header of 2^56 bytes
+  Open("printf '\\000\\000\\000\\000\\000\\000\\000\\001' >&3;"
+       " cat <&3 >/dev/null",
+       1);
+  auto result = RunJob(nullptr);
+  ASSERT_TRUE(result.status.IsCorruption()) << result.status.ToString();
+  // The worker is restarted for the next job
+  result = RunJob(nullptr);
+  ASSERT_TRUE(result.status.IsCorruption()) << result.status.ToString();
+}
+
+TEST_F(WorkerPoolCompactionDispatcherTest, CancelOwnJobs) {
+  // The workers never answer
+  Open("cat <&3 >/dev/null", 2);
+  int db_a = 0, db_b = 0;
+  std::future<std::string> job_b = remote()->DoCompactionFor(&db_b, "job");
+  auto job_a = dispatcher_->StartCompaction([&] {
+    CompactionWorkerContext context;
+    context.owner = &db_a;
+    return context;
+  }());
+
+  dispatcher_->CancelCompactions(&db_a);
+  auto result = job_a();
+  ASSERT_TRUE(result.status.IsShutdownInProgress())
+      << result.status.ToString();
+  // The jobs of other DBs go on
+  ASSERT_EQ(std::future_status::timeout,
+            job_b.wait_for(std::chrono::milliseconds(100)));
+
+  dispatcher_->CancelCompactions(&db_b);
+  ASSERT_EQ(std::future_status::ready,
+            job_b.wait_for(std::chrono::seconds(10)));
+}
+
+TEST_F(WorkerPoolCompactionDispatcherTest, CancelOnDestroy) {
+  Open("cat <&3 >/dev/null", 1);
+  int db = 0;
+  std::future<std::string> job = remote()->DoCompactionFor(&db, "job");
+  std::future<std::string> queued = remote()->DoCompactionFor(&db, "job");
+  dispatcher_.reset();
+  ASSERT_EQ(std::future_status::ready, job.wait_for(std::chrono::seconds(0)));
+  ASSERT_EQ(std::future_status::ready,
+            queued.wait_for(std::chrono::seconds(0)));
+}
+
+}  // namespace TERARKDB_NAMESPACE
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
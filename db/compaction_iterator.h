@@ -179,6 +179,9 @@ class CompactionIterator {
   // current output.
   LazyBuffer value_;
   std::string value_meta_;
+  // Handle of value_ in its blob file, value_handle_size_ is 0 if none
+  uint64_t value_handle_offset_ = 0;
+  uint64_t value_handle_size_ = 0;
   // The status is OK unless compaction iterator encounters a merge operand
   // while not having a merge operator defined.
   Status status_;
@@ -159,6 +159,13 @@ struct CompactionJob::SubcompactionState {
   // actual range for this subcompaction
   InternalKey actual_start, actual_end;
 
+  // Input blob files of garbage collection subcompaction, empty means all
+  // inputs of the compaction
+  std::vector<CompactionInputFiles> gc_inputs;
+  const std::vector<CompactionInputFiles>& garbage_collection_inputs() const {
+    return gc_inputs.empty() ? *compaction->inputs() : gc_inputs;
+  }
+
   // The return status of this subcompaction
   Status status;
 
@@ -247,6 +254,7 @@ struct CompactionJob::SubcompactionState {
     end = std::move(o.end);
     actual_start = std::move(o.actual_start);
     actual_end = std::move(o.actual_end);
+    gc_inputs = std::move(o.gc_inputs);
     status = std::move(o.status);
     outputs = std::move(o.outputs);
     outfile = std::move(o.outfile);
@@ -808,6 +816,25 @@ int CompactionJob::Prepare(int sub_compaction_slots) {
       }
       compact_->sub_compact_states.emplace_back(c, start, end);
     }
+  } else if (c->compaction_type() == kGarbageCollection &&
+             c->max_subcompactions() > 1 && sub_compaction_slots > 0) {
+    const uint64_t start_micros = env_->NowMicros();
+    GenGarbageCollectionGroups(sub_compaction_slots + 1);
+    MeasureTime(stats_, SUBCOMPACTION_SETUP_TIME,
+                env_->NowMicros() - start_micros);
+
+    for (size_t i = 0; i < gc_input_groups_.size(); i++) {
+      compact_->sub_compact_states.emplace_back(c, nullptr, nullptr,
+                                                sizes_[i]);
+      compact_->sub_compact_states.back().gc_inputs.emplace_back(
+          CompactionInputFiles{-1, gc_input_groups_[i]});
+    }
+    if (compact_->sub_compact_states.empty()) {
+      compact_->sub_compact_states.emplace_back(c, nullptr, nullptr);
+    } else {
+      MeasureTime(stats_, NUM_SUBCOMPACTIONS_SCHEDULED,
+                  compact_->sub_compact_states.size());
+    }
   } else if (c->ShouldFormSubcompactions()) {
     const uint64_t start_micros = env_->NowMicros();
     GenSubcompactionBoundaries(sub_compaction_slots + 1);
@@ -978,35 +1005,141 @@ void CompactionJob::GenSubcompactionBoundaries(int max_usable_threads) {
   }
 }
 
+// Split garbage collection into subcompactions by input blob files. The
+// output of a subcompaction inherits only its own inputs, so every input blob
+// is still inherited by exactly one output. Blobs are sorted by smallest key
+// and grouped greedily by file size.
+void CompactionJob::GenGarbageCollectionGroups(int max_usable_threads) {
+  auto* c = compact_->compaction;
+  auto* cfd = c->column_family_data();
+  auto ucmp = cfd->user_comparator();
+  assert(c->inputs()->size() == 1 && c->inputs()->front().level == -1);
+  std::vector<FileMetaData*> blobs = c->inputs()->front().files;
+
+  uint64_t sum = 0;
+  for (auto f : blobs) {
+    sum += f->fd.GetFileSize();
+  }
+  // Don't split GC into pieces smaller than blob_file_defragment_size, they
+  // will be picked again by the next GC
+  uint64_t fragment_size = c->mutable_cf_options()->blob_file_defragment_size;
+  if (fragment_size == 0) {
+    fragment_size =
+        MaxBlobSize(*c->mutable_cf_options(), cfd->ioptions()->num_levels,
+                    cfd->ioptions()->compaction_style) /
+        8;
+  }
+  uint64_t max_output_files =
+      std::max<uint64_t>(1, sum / std::max<uint64_t>(1, fragment_size));
+  size_t subcompactions = static_cast<size_t>(std::min<uint64_t>(
+      {uint64_t(max_usable_threads), blobs.size(), c->max_subcompactions(),
+       max_output_files}));
+  if (subcompactions <= 1) {
+    return;
+  }
+
+  std::sort(blobs.begin(), blobs.end(),
+            [ucmp](const FileMetaData* a, const FileMetaData* b) {
+              return ucmp->Compare(a->smallest.user_key(),
+                                   b->smallest.user_key()) < 0;
+            });
+  double mean = sum * 1.0 / subcompactions;
+  gc_input_groups_.emplace_back();
+  sizes_.emplace_back(0);
+  for (size_t i = 0; i < blobs.size(); ++i) {
+    uint64_t file_size = blobs[i]->fd.GetFileSize();
+    size_t groups_left = subcompactions - gc_input_groups_.size();
+    // Close the group once it is about mean sized, or when every remaining
+    // blob is needed to make up the remaining groups
+    if (!gc_input_groups_.back().empty() && groups_left > 0 &&
+        (sizes_.back() + file_size / 2 >= mean ||
+         blobs.size() - i <= groups_left)) {
+      gc_input_groups_.emplace_back();
+      sizes_.emplace_back(0);
+    }
+    gc_input_groups_.back().emplace_back(blobs[i]);
+    sizes_.back() += file_size;
+  }
+}
+
 static std::shared_ptr<CompactionDispatcher> GetCmdLineDispatcher() {
   const char* cmdline = getenv("TerarkDB_compactionWorkerCommandLine");
   if (cmdline) {
 #ifdef WITH_TERARK_ZIP
-    return NewCommandLineCompactionDispatcher(cmdline);
+    std::shared_ptr<CompactionDispatcher> dispatcher;
+    const char* pool_size = getenv("TerarkDB_compactionWorkerPoolSize");
+    if (pool_size != nullptr && atoi(pool_size) > 0) {
+      dispatcher = NewWorkerPoolCompactionDispatcher(cmdline, atoi(pool_size));
+    } else {
+      dispatcher = NewCommandLineCompactionDispatcher(cmdline);
+    }
+    const char* wire_format = getenv("TerarkDB_compactionWireFormat");
+    if (wire_format != nullptr && strcmp(wire_format, "binary") == 0) {
+      static_cast<RemoteCompactionDispatcher*>(dispatcher.get())
+          ->set_wire_format(RemoteCompactionDispatcher::kBinaryWireFormat);
+    }
+    const char* local_slots = getenv("TerarkDB_compactionHybridLocalSlots");
+    if (local_slots != nullptr && atoi(local_slots) > 0) {
+      HybridCompactionDispatcherOptions hybrid_options;
+      hybrid_options.local_slots = atoi(local_slots);
+      if (pool_size != nullptr && atoi(pool_size) > 0) {
+        hybrid_options.remote_slots = atoi(pool_size);
+      }
+      dispatcher =
+          NewHybridCompactionDispatcher(std::move(dispatcher), hybrid_options);
+    }
+    return dispatcher;
 #endif
   }
   return {};
 }
 
+CompactionDispatcher* CompactionJob::EnvCompactionDispatcher() {
+  static std::shared_ptr<CompactionDispatcher> command_line_dispatcher(
+      GetCmdLineDispatcher());
+  return command_line_dispatcher.get();
+}
+
 Status CompactionJob::Run() {
   TEST_SYNC_POINT("CompactionJob::Run():OuterStart");
 #ifdef WITH_TERARK_ZIP
   assert(!IsCompactionWorkerNode());
 #endif
   ColumnFamilyData* cfd = compact_->compaction->column_family_data();
-  CompactionDispatcher* dispatcher = cfd->ioptions()->compaction_dispatcher;
+  CompactionDispatcher* dispatcher = cfd->compaction_dispatcher();
   Compaction* c = compact_->compaction;
   if (!dispatcher) {
-    static std::shared_ptr<CompactionDispatcher> command_line_dispatcher(
-        GetCmdLineDispatcher());
-    dispatcher = command_line_dispatcher.get();
-  }
-  if (!dispatcher || c->compaction_type() != kKeyValueCompaction) {
     return RunSelf();
   }
+  if (c->compaction_type() != kKeyValueCompaction) {
+    // Garbage collection and map compactions never leave this node
+    uint64_t input_bytes = c->CalculateTotalInputSize();
+    dispatcher->OnLocalJobStarted(input_bytes);
+    Status s = RunSelf();
+    dispatcher->OnLocalJobFinished(input_bytes);
+    return s;
+  }
+  CompactionJobEstimate estimate;
+  estimate.input_bytes = c->CalculateTotalInputSize();
+  estimate.level = c->level();
+  estimate.output_level = c->output_level();
+  estimate.separation_type = c->separation_type();
+  estimate.is_manual_compaction = c->is_manual_compaction();
+  bool dispatched = dispatcher->ShouldDispatch(estimate);
+  const uint64_t start_micros = env_->NowMicros();
+  Status s = dispatched ? RunRemote(dispatcher) : RunSelf();
+  dispatcher->OnCompactionFinished(estimate, dispatched, s,
+                                   env_->NowMicros() - start_micros);
+  return s;
+}
+
+Status CompactionJob::RunRemote(CompactionDispatcher* dispatcher) {
+  ColumnFamilyData* cfd = compact_->compaction->column_family_data();
+  Compaction* c = compact_->compaction;
   Status s;
   const ImmutableCFOptions* iopt = c->immutable_cf_options();
   CompactionWorkerContext context;
+  context.owner = versions_;
   context.user_comparator = iopt->user_comparator->Name();
   if (iopt->merge_operator != nullptr) {
     context.merge_operator = iopt->merge_operator->Name();
@@ -1098,7 +1231,11 @@ Status CompactionJob::Run() {
   context.output_level = c->output_level();
   context.number_levels = iopt->num_levels;
   context.skip_filters =
-      c->mutable_cf_options()->optimize_filters_for_hits && bottommost_level_;
+      (c->mutable_cf_options()->optimize_filters_for_hits &&
+       bottommost_level_) ||
+      cfd->internal_stats()->FilterRarelyUseful(
+          c->output_level(),
+          c->mutable_cf_options()->adaptive_filter_skip_hit_ratio);
   context.bottommost_level = c->bottommost_level();
   context.allow_ingest_behind = iopt->allow_ingest_behind;
   context.preserve_deletes = iopt->preserve_deletes;
@@ -1207,6 +1344,11 @@ Status CompactionJob::Run() {
                 ", latest_time_end_compact = %" PRIu64,
                 output.meta.prop.earliest_time_begin_compact,
                 output.meta.prop.latest_time_end_compact);
+            // Blob outputs of the worker, so that ScheduleTtlGC can release
+            // them once their values expired
+            GetExpireTimeRange(tp->user_collected_properties,
+                               &output.meta.prop.earliest_expire_time,
+                               &output.meta.prop.latest_expire_time);
           }
           output.finished = true;
           c->AddOutputTableFileNumber(file_number);
@@ -1294,6 +1436,11 @@ Status CompactionJob::RunSelf() {
     }
   }
 
+  if (status.ok() &&
+      compact_->compaction->compaction_type() == kGarbageCollection) {
+    DropRedundantGarbageCollectionOutputs();
+  }
+
   if (status.ok() && output_directory_) {
     status = output_directory_->Fsync();
   }
@@ -1588,11 +1735,12 @@ void CompactionJob::ProcessKeyValueCompaction(SubcompactionState* sub_compact) {
     void* trans_to_separate_callback_args = nullptr;
 
     Status TransToSeparate(const Slice& internal_key, LazyBuffer& value,
-                           const Slice& meta, bool is_merge,
-                           bool is_index) override {
+                           const Slice& meta, bool is_merge, bool is_index,
+                           uint64_t handle_offset,
+                           uint64_t handle_size) override {
       return SeparateHelper::TransToSeparate(
           internal_key, value, value.file_number(), meta, is_merge, is_index,
-          value_meta_extractor.get());
+          value_meta_extractor.get(), handle_offset, handle_size);
     }
 
     Status TransToSeparate(const Slice& key, LazyBuffer& value) override {
@@ -1634,15 +1782,22 @@ void CompactionJob::ProcessKeyValueCompaction(SubcompactionState* sub_compact) {
       blob_builder = sub_compact->blob_builder.get();
       blob_meta = &sub_compact->current_blob_output()->meta;
     }
+    uint64_t handle_offset = 0, handle_size = 0;
     if (s.ok()) {
-      s = blob_builder->Add(key, value);
+      if (mutable_cf_options->blob_offset_addressing) {
+        s = blob_builder->AddWithHandle(key, value, &handle_offset,
+                                        &handle_size);
+      } else {
+        s = blob_builder->Add(key, value);
+      }
     }
     if (s.ok()) {
       blob_meta->UpdateBoundaries(key, GetInternalKeySeqno(key));
       s = SeparateHelper::TransToSeparate(
           key, value, blob_meta->fd.GetNumber(), Slice(),
           GetInternalKeyType(key) == kTypeMerge, false,
-          separate_helper.value_meta_extractor.get());
+          separate_helper.value_meta_extractor.get(), handle_offset,
+          handle_size);
     }
     return s;
   };
@@ -2038,12 +2193,102 @@ void CompactionJob::ProcessKeyValueCompaction(SubcompactionState* sub_compact) {
   sub_compact->status = status;
 }  // namespace TERARKDB_NAMESPACE
 
+// Estimate whether GC liveness check is cheaper as a streaming merge-join
+// against the key SSTs than as per-key point lookups. Merge-join reads every
+// key SST entry overlapping the blob inputs sequentially, point lookups cost
+// one FilePicker walk per blob record.
+static bool UseGarbageCollectionMergeJoin(const Compaction* c) {
+  double ratio = c->mutable_cf_options()->blob_gc_merge_join_ratio;
+  if (ratio <= 0) {
+    return false;
+  }
+  auto* vstorage = c->input_version()->storage_info();
+  auto& dependence_map = vstorage->dependence_map();
+  auto ucmp = c->column_family_data()->user_comparator();
+  auto& inputs = c->inputs()->front().files;
+  assert(!inputs.empty());
+
+  uint64_t blob_entries = 0;
+  Slice smallest = inputs.front()->smallest.user_key();
+  Slice largest = inputs.front()->largest.user_key();
+  for (auto f : inputs) {
+    blob_entries += f->prop.num_entries;
+    if (ucmp->Compare(f->smallest.user_key(), smallest) < 0) {
+      smallest = f->smallest.user_key();
+    }
+    if (ucmp->Compare(f->largest.user_key(), largest) > 0) {
+      largest = f->largest.user_key();
+    }
+  }
+  double limit = blob_entries * ratio;
+  double lsm_entries = 0;
+  for (int level = 0; level < vstorage->num_non_empty_levels(); ++level) {
+    for (auto f : vstorage->LevelFiles(level)) {
+      if (ucmp->Compare(f->largest.user_key(), smallest) < 0 ||
+          ucmp->Compare(f->smallest.user_key(), largest) > 0) {
+        continue;
+      }
+      if (!f->prop.is_map_sst()) {
+        lsm_entries += f->prop.num_entries;
+      } else {
+        for (auto& dependence : f->prop.dependence) {
+          auto find = dependence_map.find(dependence.file_number);
+          if (find != dependence_map.end() &&
+              find->second->is_gc_forbidden()) {
+            lsm_entries += find->second->prop.num_entries;
+          }
+        }
+      }
+      if (lsm_entries > limit) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// Same as VersionSet::MakeInputIterator, but only over the specified blobs
+static InternalIterator* NewGarbageCollectionInputIterator(
+    const Compaction* c, const std::vector<FileMetaData*>& blobs,
+    const EnvOptions& env_options) {
+  auto cfd = c->column_family_data();
+  ReadOptions read_options;
+  read_options.verify_checksums = true;
+  read_options.fill_cache = false;
+  read_options.total_order_seek = true;
+
+  auto& dependence_map = c->input_version()->storage_info()->dependence_map();
+  std::vector<InternalIterator*> list;
+  list.reserve(blobs.size());
+  for (auto f : blobs) {
+    list.emplace_back(cfd->table_cache()->NewIterator(
+        read_options, env_options, *f, dependence_map,
+        nullptr /* range_del_agg */,
+        c->mutable_cf_options()->prefix_extractor.get(),
+        nullptr /* table_reader_ptr */,
+        nullptr /* no per level latency histogram */, true /* for_compaction */,
+        nullptr /* arena */, false /* skip_filters */, -1 /* level */));
+  }
+  return NewMergingIterator(&cfd->internal_comparator(), list.data(),
+                            static_cast<int>(list.size()));
+}
+
 void CompactionJob::ProcessGarbageCollection(SubcompactionState* sub_compact) {
   assert(sub_compact != nullptr);
   ColumnFamilyData* cfd = sub_compact->compaction->column_family_data();
 
-  std::unique_ptr<InternalIterator> input(versions_->MakeInputIterator(
-      sub_compact->compaction, nullptr, env_options_for_read_));
+  auto& gc_inputs = sub_compact->garbage_collection_inputs();
+  assert(gc_inputs.size() == 1 && gc_inputs.front().level == -1);
+  auto make_input_iterator = [&]() -> InternalIterator* {
+    if (sub_compact->gc_inputs.empty()) {
+      return versions_->MakeInputIterator(sub_compact->compaction, nullptr,
+                                          env_options_for_read_);
+    }
+    return NewGarbageCollectionInputIterator(
+        sub_compact->compaction, gc_inputs.front().files,
+        env_options_for_read_);
+  };
+  std::unique_ptr<InternalIterator> input(make_input_iterator());
 
   AutoThreadOperationStageUpdater stage_updater(
       ThreadStatus::STAGE_COMPACTION_PROCESS_KV);
@@ -2072,10 +2317,7 @@ void CompactionJob::ProcessGarbageCollection(SubcompactionState* sub_compact) {
   std::unordered_map<Slice, uint64_t, SliceHasher> conflict_map;
   std::mutex conflict_map_mutex;
 
-  auto create_iter = [&](Arena* /* arena */) {
-    return versions_->MakeInputIterator(sub_compact->compaction, nullptr,
-                                        env_options_for_read_);
-  };
+  auto create_iter = [&](Arena* /* arena */) { return make_input_iterator(); };
   auto filter_conflict = [&](const Slice& ikey, const LazyBuffer& value) {
     std::lock_guard<std::mutex> lock(conflict_map_mutex);
     auto find = conflict_map.find(ikey);
@@ -2089,6 +2331,7 @@ void CompactionJob::ProcessGarbageCollection(SubcompactionState* sub_compact) {
 
   Status status = OpenCompactionOutputBlob(sub_compact);
   if (!status.ok()) {
+    sub_compact->status = status;
     return;
   }
   sub_compact->blob_builder->SetSecondPassIterator(&second_pass_iter);
@@ -2107,10 +2350,80 @@ void CompactionJob::ProcessGarbageCollection(SubcompactionState* sub_compact) {
     uint64_t file_number_mismatch = 0;
   } counter;
   std::vector<std::pair<uint64_t, FileMetaData*>> blob_meta_cache;
-  assert(!sub_compact->compaction->inputs()->empty());
-  blob_meta_cache.reserve(sub_compact->compaction->inputs()->front().size());
+  blob_meta_cache.reserve(gc_inputs.front().size());
+
+  // GC input is sorted by internal key, so liveness can be checked by walking
+  // a merging iterator of the key SSTs alongside it instead of GetKey
+  bool merge_join = UseGarbageCollectionMergeJoin(sub_compact->compaction);
+  Arena lsm_arena;
+  ScopedArenaIterator lsm_iter;
+  bool lsm_iter_positioned = false;
+  if (merge_join) {
+    ReadOptions read_options;
+    read_options.verify_checksums = true;
+    read_options.fill_cache = false;
+    read_options.total_order_seek = true;
+    read_options.readahead_size =
+        env_options_for_read_.compaction_readahead_size;
+    MergeIteratorBuilder merge_iter_builder(&comp, &lsm_arena);
+    input_version->AddIterators(read_options, env_options_for_read_,
+                                &merge_iter_builder, nullptr);
+    lsm_iter.set(merge_iter_builder.Finish());
+  }
+  // Same contract as Version::GetKey, targets must be non-decreasing
+  auto merge_join_get_key = [&](const Slice& user_key, const Slice& seek_key,
+                                Status* s, ValueType* type,
+                                SequenceNumber* seq, LazyBuffer* value) {
+    RecordTick(stats_, GC_MERGE_JOIN_KEYS);
+    if (!lsm_iter_positioned) {
+      RecordTick(stats_, GC_MERGE_JOIN_SEEKS);
+      lsm_iter->Seek(seek_key);
+      lsm_iter_positioned = true;
+    } else {
+      // Sequential records usually land close by, try a few Next() first
+      const int kMaxNextBeforeSeek = 8;
+      int step = 0;
+      while (lsm_iter->Valid() && comp.Compare(lsm_iter->key(), seek_key) < 0) {
+        if (++step > kMaxNextBeforeSeek) {
+          RecordTick(stats_, GC_MERGE_JOIN_SEEKS);
+          lsm_iter->Seek(seek_key);
+          break;
+        }
+        lsm_iter->Next();
+      }
+    }
+    if (!lsm_iter->Valid()) {
+      *s = lsm_iter->status();
+      if (s->ok()) {
+        *s = Status::NotFound();
+      }
+      return;
+    }
+    ParsedInternalKey lsm_ikey;
+    if (!ParseInternalKey(lsm_iter->key(), &lsm_ikey)) {
+      *s = Status::Corruption("ProcessGarbageCollection invalid InternalKey");
+      return;
+    }
+    if (comp.user_comparator()->Compare(lsm_ikey.user_key, user_key) != 0) {
+      *s = Status::NotFound();
+      return;
+    }
+    switch (lsm_ikey.type) {
+      case kTypeValue:
+      case kTypeValueIndex:
+      case kTypeMerge:
+      case kTypeMergeIndex:
+        *s = Status::OK();
+        *type = lsm_ikey.type;
+        *seq = lsm_ikey.sequence;
+        *value = lsm_iter->value();
+        break;
+      default:
+        *s = Status::NotFound();
+        break;
+    }
+  };
   while (status.ok() && !cfd->IsDropped() && input->Valid()) {
-    ++counter.input;
     Slice curr_key = input->key();
     uint64_t curr_file_number = uint64_t(-1);
     if (!ParseInternalKey(curr_key, &ikey)) {
@@ -2118,6 +2431,7 @@ void CompactionJob::ProcessGarbageCollection(SubcompactionState* sub_compact) {
           Status::Corruption("ProcessGarbageCollection invalid InternalKey");
       break;
     }
+    ++counter.input;
     uint64_t blob_file_number = input->value().file_number();
     FileMetaData* blob_meta;
     auto find_cache = std::find_if(
@@ -2148,8 +2462,13 @@ void CompactionJob::ProcessGarbageCollection(SubcompactionState* sub_compact) {
       ValueType type = kTypeDeletion;
       SequenceNumber seq = kMaxSequenceNumber;
       LazyBuffer value;
-      input_version->GetKey(ikey.user_key, iter_key.GetInternalKey(), &s, &type,
-                            &seq, &value, *blob_meta);
+      if (merge_join) {
+        merge_join_get_key(ikey.user_key, iter_key.GetInternalKey(), &s, &type,
+                           &seq, &value);
+      } else {
+        input_version->GetKey(ikey.user_key, iter_key.GetInternalKey(), &s,
+                              &type, &seq, &value, *blob_meta);
+      }
       if (s.IsNotFound()) {
         ++counter.get_not_found;
         break;
@@ -2212,12 +2531,13 @@ void CompactionJob::ProcessGarbageCollection(SubcompactionState* sub_compact) {
   if (status.ok()) {
     status = input->status();
   }
+  lsm_iter.set(nullptr);
   std::vector<uint64_t> inheritance_tree;
   size_t inheritance_tree_pruge_count = 0;
   if (status.ok()) {
-    status = BuildInheritanceTree(
-        *sub_compact->compaction->inputs(), dependence_map, input_version,
-        &inheritance_tree, &inheritance_tree_pruge_count);
+    status = BuildInheritanceTree(gc_inputs, dependence_map, input_version,
+                                  &inheritance_tree,
+                                  &inheritance_tree_pruge_count);
   }
   Status s = FinishCompactionOutputBlob(status, sub_compact, inheritance_tree);
   if (status.ok()) {
@@ -2225,34 +2545,30 @@ void CompactionJob::ProcessGarbageCollection(SubcompactionState* sub_compact) {
   }
   if (status.ok()) {
     auto& meta = sub_compact->blob_outputs.front().meta;
-    auto& inputs = *sub_compact->compaction->inputs();
-    assert(inputs.size() == 1 && inputs.front().level == -1);
-    auto& files = inputs.front().files;
+    auto& files = gc_inputs.front().files;
     ROCKS_LOG_INFO(
         db_options_.info_log,
-        "[%s] [JOB %d] Table #%" PRIu64 " GC: %" PRIu64
+        "[%s] [JOB %d] Table #%" PRIu64 " GC (%s): %" PRIu64
         " inputs from %zd files. %" PRIu64
         " clear, %.2f%% estimation: [ %" PRIu64 " garbage type, %" PRIu64
         " get not found, %" PRIu64
         " file number mismatch ], inheritance tree: %zd -> %zd",
-        cfd->GetName().c_str(), job_id_, meta.fd.GetNumber(), counter.input,
+        cfd->GetName().c_str(), job_id_, meta.fd.GetNumber(),
+        merge_join ? "merge join" : "point lookup", counter.input,
         files.size(), counter.input - meta.prop.num_entries,
-        sub_compact->compaction->num_antiquation() * 100. / counter.input,
+        sub_compact->compaction->num_antiquation() * 100. /
+            std::max<uint64_t>(1, counter.input),
         counter.garbage_type, counter.get_not_found,
         counter.file_number_mismatch,
         meta.prop.inheritance.size() + inheritance_tree_pruge_count,
         meta.prop.inheritance.size());
-    if ((std::find_if(files.begin(), files.end(),
-                      [](FileMetaData* f) {
-                        return f->marked_for_compaction;
-                      }) == files.end() &&
-         files.size() == 1 && counter.input == meta.prop.num_entries) ||
-        meta.prop.num_entries == 0) {
+    // Whether anything was purged at all is decided when all subcompactions
+    // are finished, see DropRedundantGarbageCollectionOutputs
+    if (meta.prop.num_entries == 0) {
       ROCKS_LOG_INFO(db_options_.info_log,
                      "[%s] [JOB %d] Table #%" PRIu64
-                     " GC purge %s records, dropped",
-                     cfd->GetName().c_str(), job_id_, meta.fd.GetNumber(),
-                     meta.prop.num_entries == 0 ? "whole" : "0");
+                     " GC purge whole records, dropped",
+                     cfd->GetName().c_str(), job_id_, meta.fd.GetNumber());
       std::string fname = TableFileName(
           sub_compact->compaction->immutable_cf_options()->cf_paths,
           meta.fd.GetNumber(), meta.fd.GetPathId());
@@ -2260,6 +2576,7 @@ void CompactionJob::ProcessGarbageCollection(SubcompactionState* sub_compact) {
       sub_compact->blob_outputs.clear();
     }
   }
+  sub_compact->num_input_records = counter.input;
 
   if (measure_io_stats_) {
     sub_compact->compaction_job_stats.file_write_nanos +=
@@ -2279,6 +2596,42 @@ void CompactionJob::ProcessGarbageCollection(SubcompactionState* sub_compact) {
   sub_compact->status = status;
 }
 
+void CompactionJob::DropRedundantGarbageCollectionOutputs() {
+  assert(compact_->compaction->compaction_type() == kGarbageCollection);
+  auto& inputs = *compact_->compaction->inputs();
+  assert(inputs.size() == 1 && inputs.front().level == -1);
+  auto& files = inputs.front().files;
+  if (files.size() != 1 || files.front()->marked_for_compaction) {
+    return;
+  }
+  uint64_t num_input_records = 0;
+  uint64_t num_output_records = 0;
+  for (auto& sub_compact : compact_->sub_compact_states) {
+    num_input_records += sub_compact.num_input_records;
+    for (auto& output : sub_compact.blob_outputs) {
+      num_output_records += output.meta.prop.num_entries;
+    }
+  }
+  if (num_input_records != num_output_records) {
+    return;
+  }
+  auto cfd = compact_->compaction->column_family_data();
+  for (auto& sub_compact : compact_->sub_compact_states) {
+    for (auto& output : sub_compact.blob_outputs) {
+      ROCKS_LOG_INFO(db_options_.info_log,
+                     "[%s] [JOB %d] Table #%" PRIu64
+                     " GC purge 0 records, dropped",
+                     cfd->GetName().c_str(), job_id_,
+                     output.meta.fd.GetNumber());
+      std::string fname = TableFileName(
+          compact_->compaction->immutable_cf_options()->cf_paths,
+          output.meta.fd.GetNumber(), output.meta.fd.GetPathId());
+      env_->DeleteFile(fname);
+    }
+    sub_compact.blob_outputs.clear();
+  }
+}
+
 void CompactionJob::RecordDroppedKeys(
     const CompactionIterationStats& c_iter_stats,
     CompactionJobStats* compaction_job_stats) {
@@ -2597,6 +2950,11 @@ Status CompactionJob::FinishCompactionOutputBlob(
     meta->prop.raw_key_size = tp.raw_key_size;
     meta->prop.raw_value_size = tp.raw_value_size;
     meta->prop.flags |= TablePropertyCache::kNoRangeDeletions;
+    if (cfd->ioptions()->ttl_extractor_factory != nullptr) {
+      GetExpireTimeRange(tp.user_collected_properties,
+                         &meta->prop.earliest_expire_time,
+                         &meta->prop.latest_expire_time);
+    }
   }
 
   if (s.ok()) {
@@ -2945,10 +3303,16 @@ Status CompactionJob::OpenCompactionOutputFile(
 
   // If the Column family flag is to only optimize filters for hits,
   // we can skip creating filters if this is the bottommost_level where
-  // data is going to be found
-  bool skip_filters = sub_compact->compaction->mutable_cf_options()
-                          ->optimize_filters_for_hits &&
-                      bottommost_level_;
+  // data is going to be found. The adaptive form skips them on any level
+  // where most of the sampled Gets found their key.
+  bool skip_filters =
+      (sub_compact->compaction->mutable_cf_options()
+           ->optimize_filters_for_hits &&
+       bottommost_level_) ||
+      cfd->internal_stats()->FilterRarelyUseful(
+          sub_compact->compaction->output_level(),
+          sub_compact->compaction->mutable_cf_options()
+              ->adaptive_filter_skip_hit_ratio);
 
   uint64_t output_file_creation_time =
       sub_compact->compaction->MaxInputFileCreationTime();
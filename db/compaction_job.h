@@ -93,6 +93,7 @@ class CompactionJob {
   // REQUIRED mutex not held
   Status Run();
   Status RunSelf();
+  Status RunRemote(CompactionDispatcher* dispatcher);
 
   Status VerifyFiles();
 
@@ -110,11 +111,16 @@ class CompactionJob {
 
   static void CallProcessCompaction(void* arg);
 
+  // The dispatcher of the column families without one, set up from the
+  // environment variable TerarkDB_compactionWorkerCommandLine, may be null
+  static CompactionDispatcher* EnvCompactionDispatcher();
+
  private:
   struct SubcompactionState;
 
   void AggregateStatistics();
   void GenSubcompactionBoundaries(int max_usable_threads);
+  void GenGarbageCollectionGroups(int max_usable_threads);
 
   // update the thread status for starting a compaction.
   void ReportStartedCompaction(Compaction* compaction);
@@ -124,6 +130,8 @@ class CompactionJob {
   void ProcessCompaction(SubcompactionState* sub_compact);
   void ProcessKeyValueCompaction(SubcompactionState* sub_compact);
   void ProcessGarbageCollection(SubcompactionState* sub_compact);
+  // Drop GC outputs when subcompactions purged nothing at all
+  void DropRedundantGarbageCollectionOutputs();
 
   Status FinishCompactionOutputFile(
       const Status& input_status, SubcompactionState* sub_compact,
@@ -199,6 +207,8 @@ class CompactionJob {
   std::vector<Slice> boundaries_;
   // Stores the approx size of keys covered in the range of each subcompaction
   std::vector<uint64_t> sizes_;
+  // Stores the input blob files of each garbage collection subcompaction
+  std::vector<std::vector<FileMetaData*>> gc_input_groups_;
   Env::WriteLifeTimeHint write_hint_;
 };
 
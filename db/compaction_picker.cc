@@ -857,6 +857,12 @@ Compaction* CompactionPicker::PickGarbageCollection(
   if (fragment_size == 0) {
     fragment_size = target_blob_file_size / 8;
   }
+  // GC splits its inputs into parallel subcompactions by user key, each of
+  // them rewrites up to target_blob_file_size
+  uint32_t max_subcompactions =
+      std::max<uint32_t>(1, mutable_cf_options.max_subcompactions);
+  size_t max_input_files = 8 * size_t(max_subcompactions);
+  uint64_t max_input_size = target_blob_file_size * max_subcompactions;
   // Preferentially select files marked by high priority
   auto candidate_cmp = [](const GarbageFileInfo& l, const GarbageFileInfo& r) {
     assert(l.f != nullptr && !l.f->being_compacted);
@@ -955,10 +961,11 @@ Compaction* CompactionPicker::PickGarbageCollection(
 
   std::make_heap(candidate_blob_vec.begin(), candidate_blob_vec.end(),
                  candidate_cmp);
-  while (!candidate_blob_vec.empty() && input.files.size() < 8) {
+  while (!candidate_blob_vec.empty() &&
+         input.files.size() < max_input_files) {
     auto f = candidate_blob_vec.front().f;
     uint64_t estimate_size = candidate_blob_vec.front().estimate_size;
-    if (total_estimate_size + estimate_size < target_blob_file_size) {
+    if (total_estimate_size + estimate_size < max_input_size) {
       total_estimate_size += estimate_size;
       num_antiquation += f->num_antiquation;
       f->set_gc_candidate();
@@ -982,7 +989,7 @@ Compaction* CompactionPicker::PickGarbageCollection(
       ioptions_, vstorage, mutable_cf_options, bottommost_level, 1, true);
   params.compression_opts =
       GetCompressionOptions(ioptions_, vstorage, bottommost_level, true);
-  params.max_subcompactions = 1;
+  params.max_subcompactions = max_subcompactions;
   params.score = vstorage->total_garbage_ratio();
   params.compaction_type = kGarbageCollection;
   params.compaction_reason = ConvertInputsCompactionReason(
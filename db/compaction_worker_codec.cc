@@ -0,0 +1,438 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#include "db/compaction_worker_codec.h"
+
+#include <string.h>
+
+#include "rocksdb/terark_namespace.h"
+#include "util/coding.h"
+
+namespace TERARKDB_NAMESPACE {
+
+namespace {
+
+const char kContextMagic[4] = {'T', 'C', 'W', 'J'};
+const char kResultMagic[4] = {'T', 'C', 'W', 'R'};
+const uint32_t kFormatVersion = 1;
+
+class Encoder {
+ public:
+  explicit Encoder(std::string* dst) : dst_(dst) {}
+
+  void Header(const char (&magic)[4]) {
+    dst_->append(magic, sizeof magic);
+    PutVarint32(dst_, kFormatVersion);
+  }
+  void U64(uint64_t v) { PutVarint64(dst_, v); }
+  void I64(int64_t v) { PutVarsignedint64(dst_, v); }
+  void Bool(bool v) { dst_->push_back(v ? 1 : 0); }
+  void Double(double v) {
+    uint64_t bits;
+    memcpy(&bits, &v, sizeof bits);
+    PutFixed64(dst_, bits);
+  }
+  void Float(float v) {
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof bits);
+    PutFixed32(dst_, bits);
+  }
+  void Str(const Slice& v) { PutLengthPrefixedSlice(dst_, v); }
+  void Key(const InternalKey& v) { Str(*v.rep()); }
+
+  void EncodeStatus(const TERARKDB_NAMESPACE::Status& v) {
+    dst_->push_back(static_cast<char>(v.code()));
+    dst_->push_back(static_cast<char>(v.subcode()));
+    dst_->push_back(static_cast<char>(v.severity()));
+    Bool(v.getState() != nullptr);
+    if (v.getState() != nullptr) {
+      Str(v.getState());
+    }
+  }
+
+  void Prop(const TablePropertyCache& v) {
+    U64(v.num_entries);
+    U64(v.num_deletions);
+    U64(v.raw_key_size);
+    U64(v.raw_value_size);
+    U64(v.flags);
+    U64(v.purpose);
+    U64(v.max_read_amp);
+    Float(v.read_amp);
+    U64(v.dependence.size());
+    uint64_t prev = 0;
+    for (auto& d : v.dependence) {
+      I64(static_cast<int64_t>(d.file_number - prev));
+      U64(d.entry_count);
+      prev = d.file_number;
+    }
+    U64(v.inheritance.size());
+    prev = 0;
+    for (auto file_number : v.inheritance) {
+      I64(static_cast<int64_t>(file_number - prev));
+      prev = file_number;
+    }
+  }
+
+  void File(const FileMetaData& v) {
+    U64(v.fd.packed_number_and_path_id);
+    U64(v.fd.file_size);
+    U64(v.fd.smallest_seqno);
+    U64(v.fd.largest_seqno);
+    Key(v.smallest);
+    Key(v.largest);
+    Prop(v.prop);
+  }
+
+ private:
+  std::string* dst_;
+};
+
+// Malformed input is sticky, values read after it are zero or empty
+class Decoder {
+ public:
+  explicit Decoder(const Slice& src) : input_(src) {}
+
+  bool ok() const { return ok_; }
+
+  bool Header(const char (&magic)[4]) {
+    if (input_.size() < sizeof magic ||
+        memcmp(input_.data(), magic, sizeof magic) != 0) {
+      return false;
+    }
+    input_.remove_prefix(sizeof magic);
+    uint32_t version = 0;
+    return GetVarint32(&input_, &version) && version == kFormatVersion;
+  }
+  uint64_t U64() {
+    uint64_t v = 0;
+    ok_ = ok_ && GetVarint64(&input_, &v);
+    return v;
+  }
+  int64_t I64() {
+    int64_t v = 0;
+    if (ok_) {
+      const char* p = GetVarsignedint64Ptr(
+          input_.data(), input_.data() + input_.size(), &v);
+      if (p == nullptr) {
+        ok_ = false;
+      } else {
+        input_.remove_prefix(p - input_.data());
+      }
+    }
+    return v;
+  }
+  uint8_t Byte() {
+    if (!ok_ || input_.empty()) {
+      ok_ = false;
+      return 0;
+    }
+    uint8_t v = static_cast<uint8_t>(input_[0]);
+    input_.remove_prefix(1);
+    return v;
+  }
+  bool Bool() { return Byte() != 0; }
+  double Double() {
+    uint64_t bits = 0;
+    ok_ = ok_ && GetFixed64(&input_, &bits);
+    double v;
+    memcpy(&v, &bits, sizeof v);
+    return v;
+  }
+  float Float() {
+    uint32_t bits = 0;
+    ok_ = ok_ && GetFixed32(&input_, &bits);
+    float v;
+    memcpy(&v, &bits, sizeof v);
+    return v;
+  }
+  Slice Str() {
+    Slice v;
+    ok_ = ok_ && GetLengthPrefixedSlice(&input_, &v);
+    return v;
+  }
+  void Str(std::string* v) {
+    Slice s = Str();
+    v->assign(s.data(), s.size());
+  }
+  void Key(InternalKey* v) { Str(v->rep()); }
+  // Element counts are bounded by the remaining input, so that a corrupted
+  // count does not allocate a huge vector
+  size_t Count() {
+    uint64_t n = U64();
+    if (n > input_.size()) {
+      ok_ = false;
+      return 0;
+    }
+    return static_cast<size_t>(n);
+  }
+
+  TERARKDB_NAMESPACE::Status DecodeStatus() {
+    unsigned char code = Byte();
+    unsigned char subcode = Byte();
+    unsigned char sev = Byte();
+    std::string state;
+    if (Bool()) {
+      Str(&state);
+    }
+    if (!ok_) {
+      return TERARKDB_NAMESPACE::Status();
+    }
+    return TERARKDB_NAMESPACE::Status(code, subcode, sev,
+                                      state.empty() ? nullptr : state.c_str());
+  }
+
+  void Prop(TablePropertyCache* v) {
+    v->num_entries = U64();
+    v->num_deletions = U64();
+    v->raw_key_size = U64();
+    v->raw_value_size = U64();
+    v->flags = static_cast<uint8_t>(U64());
+    v->purpose = static_cast<uint8_t>(U64());
+    v->max_read_amp = static_cast<uint16_t>(U64());
+    v->read_amp = Float();
+    v->dependence.resize(Count());
+    uint64_t prev = 0;
+    for (auto& d : v->dependence) {
+      d.file_number = prev + static_cast<uint64_t>(I64());
+      d.entry_count = U64();
+      prev = d.file_number;
+    }
+    v->inheritance.resize(Count());
+    prev = 0;
+    for (auto& file_number : v->inheritance) {
+      file_number = prev + static_cast<uint64_t>(I64());
+      prev = file_number;
+    }
+  }
+
+  void File(FileMetaData* v) {
+    v->fd.packed_number_and_path_id = U64();
+    v->fd.file_size = U64();
+    v->fd.smallest_seqno = U64();
+    v->fd.largest_seqno = U64();
+    Key(&v->smallest);
+    Key(&v->largest);
+    Prop(&v->prop);
+  }
+
+ private:
+  Slice input_;
+  bool ok_ = true;
+};
+
+}  // namespace
+
+void EncodeCompactionWorkerContext(const CompactionWorkerContext& context,
+                                   std::string* dst) {
+  Encoder enc(dst);
+  enc.Header(kContextMagic);
+  enc.Str(context.user_comparator);
+  enc.Str(context.merge_operator);
+  enc.Str(context.merge_operator_data.data);
+  enc.Str(context.value_meta_extractor_factory);
+  enc.Str(context.value_meta_extractor_factory_options.data);
+  enc.Str(context.compaction_filter);
+  enc.Str(context.compaction_filter_factory);
+  enc.Bool(context.compaction_filter_context.is_full_compaction);
+  enc.Bool(context.compaction_filter_context.is_manual_compaction);
+  enc.U64(context.compaction_filter_context.column_family_id);
+  enc.Str(context.compaction_filter_data.data);
+  enc.U64(context.blob_config.blob_size);
+  enc.Double(context.blob_config.large_key_ratio);
+  enc.U64(context.separation_type);
+  enc.Str(context.table_factory);
+  enc.Str(context.table_factory_options);
+  enc.U64(context.bloom_locality);
+  enc.U64(context.cf_paths.size());
+  for (auto& path : context.cf_paths) {
+    enc.Str(path);
+  }
+  enc.Str(context.prefix_extractor);
+  enc.Str(context.prefix_extractor_options);
+  enc.Bool(context.has_start);
+  enc.Bool(context.has_end);
+  enc.Str(context.start.data);
+  enc.Str(context.end.data);
+  enc.U64(context.last_sequence);
+  enc.U64(context.earliest_write_conflict_snapshot);
+  enc.U64(context.preserve_deletes_seqnum);
+  enc.U64(context.file_metadata.size());
+  for (auto& pair : context.file_metadata) {
+    enc.U64(pair.first);
+    enc.File(pair.second);
+  }
+  enc.U64(context.inputs.size());
+  for (auto& pair : context.inputs) {
+    enc.I64(pair.first);
+    enc.U64(pair.second);
+  }
+  enc.Str(context.cf_name);
+  enc.U64(context.target_file_size);
+  enc.U64(context.compression);
+  enc.I64(context.compression_opts.window_bits);
+  enc.I64(context.compression_opts.level);
+  enc.I64(context.compression_opts.strategy);
+  enc.U64(context.compression_opts.max_dict_bytes);
+  enc.U64(context.compression_opts.zstd_max_train_bytes);
+  enc.Bool(context.compression_opts.enabled);
+  enc.U64(context.existing_snapshots.size());
+  for (auto snapshot : context.existing_snapshots) {
+    enc.U64(snapshot);
+  }
+  enc.Str(context.smallest_user_key.data);
+  enc.Str(context.largest_user_key.data);
+  enc.I64(context.level);
+  enc.I64(context.output_level);
+  enc.I64(context.number_levels);
+  enc.Bool(context.skip_filters);
+  enc.Bool(context.bottommost_level);
+  enc.Bool(context.allow_ingest_behind);
+  enc.Bool(context.preserve_deletes);
+  enc.U64(context.int_tbl_prop_collector_factories.size());
+  for (auto& collector : context.int_tbl_prop_collector_factories) {
+    enc.Str(collector.name);
+    enc.Str(collector.param.data);
+  }
+}
+
+Status DecodeCompactionWorkerContext(const Slice& src,
+                                     CompactionWorkerContext* context) {
+  Decoder dec(src);
+  if (!dec.Header(kContextMagic)) {
+    return Status::Corruption("CompactionWorkerContext",
+                              "bad magic or format version");
+  }
+  dec.Str(&context->user_comparator);
+  dec.Str(&context->merge_operator);
+  dec.Str(&context->merge_operator_data.data);
+  dec.Str(&context->value_meta_extractor_factory);
+  dec.Str(&context->value_meta_extractor_factory_options.data);
+  dec.Str(&context->compaction_filter);
+  dec.Str(&context->compaction_filter_factory);
+  context->compaction_filter_context.is_full_compaction = dec.Bool();
+  context->compaction_filter_context.is_manual_compaction = dec.Bool();
+  context->compaction_filter_context.column_family_id =
+      static_cast<uint32_t>(dec.U64());
+  dec.Str(&context->compaction_filter_data.data);
+  context->blob_config.blob_size = static_cast<size_t>(dec.U64());
+  context->blob_config.large_key_ratio = dec.Double();
+  context->separation_type = static_cast<uint32_t>(dec.U64());
+  dec.Str(&context->table_factory);
+  dec.Str(&context->table_factory_options);
+  context->bloom_locality = static_cast<uint32_t>(dec.U64());
+  context->cf_paths.resize(dec.Count());
+  for (auto& path : context->cf_paths) {
+    dec.Str(&path);
+  }
+  dec.Str(&context->prefix_extractor);
+  dec.Str(&context->prefix_extractor_options);
+  context->has_start = dec.Bool();
+  context->has_end = dec.Bool();
+  dec.Str(&context->start.data);
+  dec.Str(&context->end.data);
+  context->last_sequence = dec.U64();
+  context->earliest_write_conflict_snapshot = dec.U64();
+  context->preserve_deletes_seqnum = dec.U64();
+  context->file_metadata.resize(dec.Count());
+  for (auto& pair : context->file_metadata) {
+    pair.first = dec.U64();
+    dec.File(&pair.second);
+  }
+  context->inputs.resize(dec.Count());
+  for (auto& pair : context->inputs) {
+    pair.first = static_cast<int>(dec.I64());
+    pair.second = dec.U64();
+  }
+  dec.Str(&context->cf_name);
+  context->target_file_size = dec.U64();
+  context->compression = static_cast<CompressionType>(dec.U64());
+  context->compression_opts.window_bits = static_cast<int>(dec.I64());
+  context->compression_opts.level = static_cast<int>(dec.I64());
+  context->compression_opts.strategy = static_cast<int>(dec.I64());
+  context->compression_opts.max_dict_bytes = static_cast<uint32_t>(dec.U64());
+  context->compression_opts.zstd_max_train_bytes =
+      static_cast<uint32_t>(dec.U64());
+  context->compression_opts.enabled = dec.Bool();
+  context->existing_snapshots.resize(dec.Count());
+  for (auto& snapshot : context->existing_snapshots) {
+    snapshot = dec.U64();
+  }
+  dec.Str(&context->smallest_user_key.data);
+  dec.Str(&context->largest_user_key.data);
+  context->level = static_cast<int>(dec.I64());
+  context->output_level = static_cast<int>(dec.I64());
+  context->number_levels = static_cast<int>(dec.I64());
+  context->skip_filters = dec.Bool();
+  context->bottommost_level = dec.Bool();
+  context->allow_ingest_behind = dec.Bool();
+  context->preserve_deletes = dec.Bool();
+  context->int_tbl_prop_collector_factories.resize(dec.Count());
+  for (auto& collector : context->int_tbl_prop_collector_factories) {
+    dec.Str(&collector.name);
+    dec.Str(&collector.param.data);
+  }
+  if (!dec.ok()) {
+    return Status::Corruption("CompactionWorkerContext", "truncated");
+  }
+  return Status::OK();
+}
+
+void EncodeCompactionWorkerResult(const CompactionWorkerResult& result,
+                                  std::string* dst) {
+  Encoder enc(dst);
+  enc.Header(kResultMagic);
+  enc.EncodeStatus(result.status);
+  enc.Key(result.actual_start);
+  enc.Key(result.actual_end);
+  enc.U64(result.files.size());
+  for (auto& file : result.files) {
+    enc.Key(file.smallest);
+    enc.Key(file.largest);
+    enc.Str(file.file_name);
+    enc.U64(file.smallest_seqno);
+    enc.U64(file.largest_seqno);
+    enc.U64(file.file_size);
+    enc.U64(file.marked_for_compaction);
+  }
+  enc.Str(result.stat_all);
+  enc.U64(result.time_us);
+}
+
+Status DecodeCompactionWorkerResult(const Slice& src,
+                                    CompactionWorkerResult* result) {
+  Decoder dec(src);
+  if (!dec.Header(kResultMagic)) {
+    return Status::Corruption("CompactionWorkerResult",
+                              "bad magic or format version");
+  }
+  result->status = dec.DecodeStatus();
+  dec.Key(&result->actual_start);
+  dec.Key(&result->actual_end);
+  result->files.resize(dec.Count());
+  for (auto& file : result->files) {
+    dec.Key(&file.smallest);
+    dec.Key(&file.largest);
+    dec.Str(&file.file_name);
+    file.smallest_seqno = dec.U64();
+    file.largest_seqno = dec.U64();
+    file.file_size = static_cast<size_t>(dec.U64());
+    file.marked_for_compaction = static_cast<uint8_t>(dec.U64());
+  }
+  dec.Str(&result->stat_all);
+  result->time_us = static_cast<size_t>(dec.U64());
+  if (!dec.ok()) {
+    return Status::Corruption("CompactionWorkerResult", "truncated");
+  }
+  return Status::OK();
+}
+
+bool IsBinaryCompactionWorkerMessage(const Slice& src) {
+  return src.size() >= sizeof kContextMagic &&
+         (memcmp(src.data(), kContextMagic, sizeof kContextMagic) == 0 ||
+          memcmp(src.data(), kResultMagic, sizeof kResultMagic) == 0);
+}
+
+}  // namespace TERARKDB_NAMESPACE
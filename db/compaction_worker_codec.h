@@ -0,0 +1,49 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#pragma once
+
+#include <string>
+
+#include "db/compaction.h"
+#include "rocksdb/slice.h"
+#include "rocksdb/status.h"
+#include "rocksdb/terark_namespace.h"
+
+namespace TERARKDB_NAMESPACE {
+
+// Binary encoding of the messages between RemoteCompactionDispatcher and its
+// workers, selected by RemoteCompactionDispatcher::kBinaryWireFormat.
+//
+// A message starts with a 4 byte magic, telling a job from a result, and the
+// varint32 format version. Integers are varint coded, the file numbers of
+// dependence and inheritance vectors are delta coded, and keys and strings
+// are length prefixed and copied straight from their storage.
+extern void EncodeCompactionWorkerContext(
+    const CompactionWorkerContext& context, std::string* dst);
+extern Status DecodeCompactionWorkerContext(const Slice& src,
+                                            CompactionWorkerContext* context);
+
+extern void EncodeCompactionWorkerResult(const CompactionWorkerResult& result,
+                                         std::string* dst);
+extern Status DecodeCompactionWorkerResult(const Slice& src,
+                                           CompactionWorkerResult* result);
+
+// Whether src is a job or a result in the binary encoding, rather than in
+// the default serialization of compaction_dispatcher.cc
+extern bool IsBinaryCompactionWorkerMessage(const Slice& src);
+
+// The default serialization, DataIO with terark-zip and ajson otherwise.
+// Decoding throws on malformed input.
+extern std::string SerializeCompactionWorkerContext(
+    const CompactionWorkerContext& context);
+extern void DeserializeCompactionWorkerContext(
+    const Slice& src, CompactionWorkerContext* context);
+extern std::string SerializeCompactionWorkerResult(
+    const CompactionWorkerResult& result);
+extern void DeserializeCompactionWorkerResult(const Slice& src,
+                                              CompactionWorkerResult* result);
+
+}  // namespace TERARKDB_NAMESPACE
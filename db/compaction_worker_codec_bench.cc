@@ -0,0 +1,152 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#ifndef __STDC_FORMAT_MACROS
+#define __STDC_FORMAT_MACROS
+#endif
+#ifndef GFLAGS
+#include <cstdio>
+int main() {
+  fprintf(stderr, "Please install gflags to run rocksdb tools\n");
+  return 1;
+}
+#else
+
+#include <inttypes.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <functional>
+#include <string>
+
+#include "db/compaction_worker_codec.h"
+#include "port/port.h"
+#include "rocksdb/env.h"
+#include "rocksdb/terark_namespace.h"
+#include "util/gflags_compat.h"
+#include "util/random.h"
+#include "util/string_util.h"
+
+using GFLAGS_NAMESPACE::ParseCommandLineFlags;
+
+DEFINE_int32(num_files, 1000, "Number of input files of the job.");
+DEFINE_int32(dependence_size, 200,
+             "Entries of the dependence vector of each input file.");
+DEFINE_int32(inheritance_size, 50,
+             "Entries of the inheritance vector of each input file.");
+DEFINE_int32(key_size, 24, "Size of the smallest and largest user keys.");
+DEFINE_int32(iterations, 20, "Encode and decode rounds of each format.");
+
+namespace TERARKDB_NAMESPACE {
+
+namespace {
+
+CompactionWorkerContext MakeContext() {
+  Random64 rnd(301);
+  auto random_key = [&rnd]() {
+    std::string key;
+    for (int i = 0; i < FLAGS_key_size; ++i) {
+      key.push_back(static_cast<char>('a' + rnd.Uniform(26)));
+    }
+    return key;
+  };
+  CompactionWorkerContext context;
+  context.user_comparator = "leveldb.BytewiseComparator";
+  context.table_factory = "BlockBasedTable";
+  context.cf_name = "default";
+  context.last_sequence = 1ULL << 40;
+  context.output_level = 1;
+  context.number_levels = 7;
+  uint64_t file_number = 1000;
+  for (int i = 0; i < FLAGS_num_files; ++i) {
+    FileMetaData f;
+    file_number += 1 + rnd.Uniform(16);
+    f.fd = FileDescriptor(file_number, 0, 64 << 20, rnd.Uniform(1 << 20),
+                          1 << 20);
+    f.smallest = InternalKey(random_key(), f.fd.smallest_seqno, kTypeValue);
+    f.largest = InternalKey(random_key(), f.fd.largest_seqno, kTypeValue);
+    f.prop.num_entries = rnd.Uniform(1 << 20);
+    f.prop.purpose = kMapSst;
+    f.prop.read_amp = 2;
+    f.prop.max_read_amp = 4;
+    uint64_t dependence = file_number;
+    for (int j = 0; j < FLAGS_dependence_size; ++j) {
+      dependence -= 1 + rnd.Uniform(8);
+      f.prop.dependence.push_back({dependence, rnd.Uniform(1 << 16)});
+    }
+    uint64_t inheritance = file_number;
+    for (int j = 0; j < FLAGS_inheritance_size; ++j) {
+      inheritance -= 1 + rnd.Uniform(8);
+      f.prop.inheritance.emplace_back(inheritance);
+    }
+    context.file_metadata.emplace_back(file_number, f);
+    context.inputs.emplace_back(0, file_number);
+  }
+  return context;
+}
+
+void Run(const char* name, const std::function<std::string()>& encode,
+         const std::function<void(const std::string&)>& decode) {
+  Env* env = Env::Default();
+  std::string encoded;
+  uint64_t start = env->NowMicros();
+  for (int i = 0; i < FLAGS_iterations; ++i) {
+    encoded = encode();
+  }
+  uint64_t encode_micros = std::max<uint64_t>(env->NowMicros() - start, 1);
+  start = env->NowMicros();
+  for (int i = 0; i < FLAGS_iterations; ++i) {
+    decode(encoded);
+  }
+  uint64_t decode_micros = std::max<uint64_t>(env->NowMicros() - start, 1);
+  double total_mb = 1.0 * encoded.size() * FLAGS_iterations / 1048576;
+  printf("%-8s size %10" ROCKSDB_PRIszt
+         " bytes, encode %8.3f ms (%8.1f MB/s), decode %8.3f ms (%8.1f MB/s)"
+         "\n",
+         name, encoded.size(), encode_micros / 1000.0 / FLAGS_iterations,
+         total_mb * 1e6 / encode_micros,
+         decode_micros / 1000.0 / FLAGS_iterations,
+         total_mb * 1e6 / decode_micros);
+}
+
+}  // namespace
+
+}  // namespace TERARKDB_NAMESPACE
+
+int main(int argc, char** argv) {
+  using namespace TERARKDB_NAMESPACE;
+  ParseCommandLineFlags(&argc, &argv, true);
+  if (FLAGS_iterations <= 0) {
+    fprintf(stderr, "iterations must be positive\n");
+    return 1;
+  }
+  const CompactionWorkerContext context = MakeContext();
+  printf("%d files, %d dependence and %d inheritance entries per file\n",
+         FLAGS_num_files, FLAGS_dependence_size, FLAGS_inheritance_size);
+
+  Run("default",
+      [&context] { return SerializeCompactionWorkerContext(context); },
+      [](const std::string& encoded) {
+        CompactionWorkerContext decoded;
+        DeserializeCompactionWorkerContext(encoded, &decoded);
+      });
+  Run("binary",
+      [&context] {
+        std::string encoded;
+        EncodeCompactionWorkerContext(context, &encoded);
+        return encoded;
+      },
+      [](const std::string& encoded) {
+        CompactionWorkerContext decoded;
+        Status s = DecodeCompactionWorkerContext(encoded, &decoded);
+        if (!s.ok()) {
+          fprintf(stderr, "%s\n", s.ToString().c_str());
+          abort();
+        }
+      });
+  return 0;
+}
+
+#endif  // GFLAGS
@@ -0,0 +1,204 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#include "db/compaction_worker_codec.h"
+
+#include "rocksdb/terark_namespace.h"
+#include "util/string_util.h"
+#include "util/testharness.h"
+
+namespace TERARKDB_NAMESPACE {
+
+class CompactionWorkerCodecTest : public testing::Test {
+ public:
+  static CompactionWorkerContext MakeContext() {
+    CompactionWorkerContext context;
+    context.user_comparator = "leveldb.BytewiseComparator";
+    context.merge_operator = "StringAppendOperator";
+    context.merge_operator_data = std::string("\0,", 2);
+    context.compaction_filter_context.is_full_compaction = true;
+    context.compaction_filter_context.is_manual_compaction = false;
+    context.compaction_filter_context.column_family_id = 7;
+    context.blob_config = BlobConfig{4096, 0.25};
+    context.separation_type = 2;
+    context.table_factory = "BlockBasedTable";
+    context.table_factory_options = "block_size=4096\nwhole_key_filtering=1";
+    context.bloom_locality = 1;
+    context.cf_paths = {"/data/a", "/data/b"};
+    context.has_start = true;
+    context.has_end = false;
+    context.start = std::string("start\xff", 6);
+    context.last_sequence = 1ULL << 40;
+    context.earliest_write_conflict_snapshot = 100;
+    context.preserve_deletes_seqnum = 0;
+    for (uint64_t i = 0; i < 3; ++i) {
+      FileMetaData f;
+      f.fd = FileDescriptor(100 + i * 1000, 1, 4 << 20, 10 + i, 20 + i);
+      f.smallest = InternalKey("a" + ToString(i), 10 + i, kTypeValue);
+      f.largest = InternalKey("z" + ToString(i), 20 + i, kTypeDeletion);
+      f.prop.num_entries = 1000 + i;
+      f.prop.purpose = i == 0 ? kMapSst : kEssenceSst;
+      f.prop.read_amp = 1.5f;
+      f.prop.max_read_amp = 3;
+      // Unsorted on purpose, the deltas are signed
+      f.prop.dependence = {{900, 5}, {20, 3}, {1ULL << 50, 1}};
+      f.prop.inheritance = {5, 3, 1ULL << 60, 4};
+      context.file_metadata.emplace_back(f.fd.GetNumber(), f);
+    }
+    context.inputs = {{0, 100}, {-1, 1100}, {1, 2100}};
+    context.cf_name = "default";
+    context.target_file_size = 64 << 20;
+    context.compression = kZSTD;
+    context.compression_opts = CompressionOptions(-14, 3, 0, 16384, 0, true);
+    context.existing_snapshots = {10, 11, 1ULL << 55};
+    context.smallest_user_key = std::string("a0");
+    context.largest_user_key = std::string("z2");
+    context.level = 0;
+    context.output_level = 1;
+    context.number_levels = 7;
+    context.skip_filters = false;
+    context.bottommost_level = true;
+    context.allow_ingest_behind = false;
+    context.preserve_deletes = true;
+    context.int_tbl_prop_collector_factories.push_back(
+        {"Collector", {std::string("\x01\x00\x02", 3)}});
+    return context;
+  }
+
+  static void AssertFileEq(const FileMetaData& a, const FileMetaData& b) {
+    ASSERT_EQ(a.fd.packed_number_and_path_id, b.fd.packed_number_and_path_id);
+    ASSERT_EQ(a.fd.file_size, b.fd.file_size);
+    ASSERT_EQ(a.fd.smallest_seqno, b.fd.smallest_seqno);
+    ASSERT_EQ(a.fd.largest_seqno, b.fd.largest_seqno);
+    ASSERT_EQ(*a.smallest.rep(), *b.smallest.rep());
+    ASSERT_EQ(*a.largest.rep(), *b.largest.rep());
+    ASSERT_EQ(a.prop.num_entries, b.prop.num_entries);
+    ASSERT_EQ(a.prop.purpose, b.prop.purpose);
+    ASSERT_EQ(a.prop.read_amp, b.prop.read_amp);
+    ASSERT_EQ(a.prop.max_read_amp, b.prop.max_read_amp);
+    ASSERT_EQ(a.prop.dependence.size(), b.prop.dependence.size());
+    for (size_t i = 0; i < a.prop.dependence.size(); ++i) {
+      ASSERT_EQ(a.prop.dependence[i].file_number,
+                b.prop.dependence[i].file_number);
+      ASSERT_EQ(a.prop.dependence[i].entry_count,
+                b.prop.dependence[i].entry_count);
+    }
+    ASSERT_EQ(a.prop.inheritance, b.prop.inheritance);
+  }
+};
+
+TEST_F(CompactionWorkerCodecTest, ContextRoundTrip) {
+  CompactionWorkerContext context = MakeContext();
+  std::string encoded;
+  EncodeCompactionWorkerContext(context, &encoded);
+  ASSERT_TRUE(IsBinaryCompactionWorkerMessage(encoded));
+
+  CompactionWorkerContext decoded;
+  ASSERT_OK(DecodeCompactionWorkerContext(encoded, &decoded));
+  ASSERT_EQ(context.user_comparator, decoded.user_comparator);
+  ASSERT_EQ(context.merge_operator_data.data, decoded.merge_operator_data.data);
+  ASSERT_TRUE(decoded.compaction_filter_context.is_full_compaction);
+  ASSERT_EQ(7U, decoded.compaction_filter_context.column_family_id);
+  ASSERT_EQ(context.blob_config.blob_size, decoded.blob_config.blob_size);
+  ASSERT_EQ(context.blob_config.large_key_ratio,
+            decoded.blob_config.large_key_ratio);
+  ASSERT_EQ(context.table_factory_options, decoded.table_factory_options);
+  ASSERT_EQ(context.cf_paths, decoded.cf_paths);
+  ASSERT_TRUE(decoded.has_start);
+  ASSERT_FALSE(decoded.has_end);
+  ASSERT_EQ(context.start.data, decoded.start.data);
+  ASSERT_EQ(context.last_sequence, decoded.last_sequence);
+  ASSERT_EQ(context.file_metadata.size(), decoded.file_metadata.size());
+  for (size_t i = 0; i < context.file_metadata.size(); ++i) {
+    ASSERT_EQ(context.file_metadata[i].first, decoded.file_metadata[i].first);
+    AssertFileEq(context.file_metadata[i].second,
+                 decoded.file_metadata[i].second);
+  }
+  ASSERT_EQ(context.inputs, decoded.inputs);
+  ASSERT_EQ(context.compression, decoded.compression);
+  ASSERT_EQ(-14, decoded.compression_opts.window_bits);
+  ASSERT_EQ(16384U, decoded.compression_opts.max_dict_bytes);
+  ASSERT_TRUE(decoded.compression_opts.enabled);
+  ASSERT_EQ(context.existing_snapshots, decoded.existing_snapshots);
+  ASSERT_EQ(context.largest_user_key.data, decoded.largest_user_key.data);
+  ASSERT_EQ(1, decoded.output_level);
+  ASSERT_TRUE(decoded.bottommost_level);
+  ASSERT_TRUE(decoded.preserve_deletes);
+  ASSERT_EQ(1U, decoded.int_tbl_prop_collector_factories.size());
+  ASSERT_EQ(context.int_tbl_prop_collector_factories[0].param.data,
+            decoded.int_tbl_prop_collector_factories[0].param.data);
+}
+
+TEST_F(CompactionWorkerCodecTest, ResultRoundTrip) {
+  CompactionWorkerResult result;
+  result.status = Status::Corruption("bad block", "file 12");
+  result.actual_start = InternalKey("start", 5, kTypeValue);
+  result.files.resize(2);
+  result.files[0].smallest = InternalKey("a", 1, kTypeValue);
+  result.files[0].largest = InternalKey("b", 2, kTypeMerge);
+  result.files[0].file_name = "/tmp/worker-0";
+  result.files[0].smallest_seqno = 1;
+  result.files[0].largest_seqno = 2;
+  result.files[0].file_size = 12345;
+  result.files[0].marked_for_compaction = FileMetaData::kMarkedFromUser;
+  result.stat_all = "stat";
+  result.time_us = 99;
+
+  std::string encoded;
+  EncodeCompactionWorkerResult(result, &encoded);
+  ASSERT_TRUE(IsBinaryCompactionWorkerMessage(encoded));
+
+  CompactionWorkerResult decoded;
+  ASSERT_OK(DecodeCompactionWorkerResult(encoded, &decoded));
+  ASSERT_TRUE(decoded.status.IsCorruption());
+  ASSERT_EQ(result.status.ToString(), decoded.status.ToString());
+  ASSERT_EQ(*result.actual_start.rep(), *decoded.actual_start.rep());
+  ASSERT_TRUE(decoded.actual_end.rep()->empty());
+  ASSERT_EQ(2U, decoded.files.size());
+  ASSERT_EQ(result.files[0].file_name, decoded.files[0].file_name);
+  ASSERT_EQ(*result.files[0].largest.rep(), *decoded.files[0].largest.rep());
+  ASSERT_EQ(12345U, decoded.files[0].file_size);
+  ASSERT_EQ(FileMetaData::kMarkedFromUser,
+            decoded.files[0].marked_for_compaction);
+  ASSERT_EQ("stat", decoded.stat_all);
+  ASSERT_EQ(99U, decoded.time_us);
+
+  result.status = Status::OK();
+  encoded.clear();
+  EncodeCompactionWorkerResult(result, &encoded);
+  ASSERT_OK(DecodeCompactionWorkerResult(encoded, &decoded));
+  ASSERT_OK(decoded.status);
+}
+
+TEST_F(CompactionWorkerCodecTest, RejectsMalformedInput) {
+  std::string encoded;
+  EncodeCompactionWorkerContext(MakeContext(), &encoded);
+  CompactionWorkerContext decoded;
+  for (size_t size = 0; size < encoded.size(); size += 7) {
+    ASSERT_TRUE(DecodeCompactionWorkerContext(Slice(encoded.data(), size),
+                                              &decoded)
+                    .IsCorruption());
+  }
+
+  // A job is not a result
+  CompactionWorkerResult result;
+  ASSERT_TRUE(DecodeCompactionWorkerResult(encoded, &result).IsCorruption());
+
+  // Unknown format version
+  std::string future_version = encoded;
+  future_version[4] = 2;
+  ASSERT_TRUE(
+      DecodeCompactionWorkerContext(future_version, &decoded).IsCorruption());
+
+  ASSERT_FALSE(IsBinaryCompactionWorkerMessage("{\"status\":"));
+  ASSERT_FALSE(IsBinaryCompactionWorkerMessage("TCW"));
+}
+
+}  // namespace TERARKDB_NAMESPACE
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -6,6 +6,8 @@
 // Copyright (c) 2011 The LevelDB Authors. All rights reserved.
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file. See the AUTHORS file for names of contributors.
+#include <random>
+
 #include "db/db_test_util.h"
 #include "port/stack_trace.h"
 #include "rocksdb/perf_context.h"
@@ -815,6 +817,71 @@ TEST_F(DBBasicTest, MultiGetSimple) {
   } while (ChangeCompactOptions());
 }
 
+TEST_F(DBBasicTest, MultiGetBatchedAcrossLevels) {
+  Options options = CurrentOptions();
+  options.disable_auto_compactions = true;
+  options.merge_operator = MergeOperators::CreateStringAppendOperator();
+  BlockBasedTableOptions table_options;
+  table_options.block_size = 256;
+  table_options.filter_policy.reset(NewBloomFilterPolicy(10, false));
+  options.table_factory.reset(NewBlockBasedTableFactory(table_options));
+  DestroyAndReopen(options);
+
+  auto key = [](int i) {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "k%04d", i);
+    return std::string(buf);
+  };
+  // Oldest data in two L2 files, overwrites in L1, newest data in L0 and
+  // memtable
+  for (int i = 0; i < 200; ++i) {
+    ASSERT_OK(Put(key(i), "v1." + key(i)));
+    if (i == 99) {
+      ASSERT_OK(Flush());
+    }
+  }
+  ASSERT_OK(Flush());
+  MoveFilesToLevel(2);
+  for (int i = 0; i < 200; i += 3) {
+    ASSERT_OK(Put(key(i), "v2." + key(i)));
+  }
+  ASSERT_OK(Flush());
+  MoveFilesToLevel(1);
+  for (int i = 0; i < 200; i += 5) {
+    ASSERT_OK(Delete(key(i)));
+  }
+  ASSERT_OK(Flush());
+  for (int i = 0; i < 200; i += 7) {
+    ASSERT_OK(Merge(key(i), "m"));
+  }
+  ASSERT_OK(Flush());
+  for (int i = 0; i < 200; i += 11) {
+    ASSERT_OK(Put(key(i), "v3." + key(i)));
+  }
+
+  std::vector<std::string> key_strs;
+  for (int i = 0; i < 220; i += 2) {
+    key_strs.emplace_back(key(i));
+  }
+  // duplicate keys
+  key_strs.emplace_back(key(14));
+  key_strs.emplace_back(key(35));
+  std::shuffle(key_strs.begin(), key_strs.end(), std::mt19937_64());
+  std::vector<Slice> keys(key_strs.begin(), key_strs.end());
+  std::vector<ColumnFamilyHandle*> cfs(keys.size(), db_->DefaultColumnFamily());
+  std::vector<std::string> values;
+  std::vector<Status> s = db_->MultiGet(ReadOptions(), cfs, keys, &values);
+  ASSERT_EQ(keys.size(), s.size());
+  for (size_t i = 0; i < keys.size(); ++i) {
+    std::string expected;
+    Status expected_s = db_->Get(ReadOptions(), keys[i], &expected);
+    ASSERT_EQ(expected_s.ToString(), s[i].ToString()) << key_strs[i];
+    if (s[i].ok()) {
+      ASSERT_EQ(expected, values[i]) << key_strs[i];
+    }
+  }
+}
+
 TEST_F(DBBasicTest, MultiGetEmpty) {
   do {
     CreateAndReopenWithCF({"pikachu"}, CurrentOptions());
@@ -1247,6 +1247,97 @@ TEST_F(DBBloomFilterTest, OptimizeFiltersForHits) {
   get_perf_context()->Reset();
 }
 
+namespace {
+// Filter sizes of all the live table files
+std::vector<uint64_t> FilterSizes(DB* db) {
+  TablePropertiesCollection props;
+  EXPECT_OK(db->GetPropertiesOfAllTables(&props));
+  std::vector<uint64_t> sizes;
+  for (auto& kv : props) {
+    sizes.push_back(kv.second->filter_size);
+  }
+  return sizes;
+}
+}  // namespace
+
+TEST_F(DBBloomFilterTest, FilterBitsPerLevel) {
+  Options options = CurrentOptions();
+  options.disable_auto_compactions = true;
+  options.statistics = TERARKDB_NAMESPACE::CreateDBStatistics();
+  BlockBasedTableOptions bbto;
+  bbto.filter_policy.reset(NewBloomFilterPolicy(10, false));
+  bbto.filter_bits_per_level = {20, 0};
+  options.table_factory.reset(NewBlockBasedTableFactory(bbto));
+  DestroyAndReopen(options);
+
+  const int kNumKeys = 1000;
+  for (int i = 0; i < kNumKeys; i += 2) {
+    ASSERT_OK(Put(Key(i), "val"));
+  }
+  ASSERT_OK(Flush());
+  ASSERT_EQ(1, NumTableFilesAtLevel(0));
+  auto sizes = FilterSizes(db_);
+  ASSERT_EQ(1U, sizes.size());
+  // 20 bits per key
+  ASSERT_GE(sizes[0], kNumKeys / 2 * 20 / 8);
+
+  CompactRangeOptions cro;
+  cro.bottommost_level_compaction = BottommostLevelCompaction::kForce;
+  ASSERT_OK(db_->CompactRange(cro, nullptr, nullptr));
+  ASSERT_EQ(0, NumTableFilesAtLevel(0));
+  for (auto size : FilterSizes(db_)) {
+    ASSERT_EQ(0U, size);
+  }
+  for (int i = 0; i < kNumKeys; ++i) {
+    ASSERT_EQ(i % 2 == 0 ? "val" : "NOT_FOUND", Get(Key(i)));
+  }
+  ASSERT_EQ(0, TestGetTickerCount(options, BLOOM_FILTER_USEFUL));
+}
+
+TEST_F(DBBloomFilterTest, AdaptiveFilterSkip) {
+  Options options = CurrentOptions();
+  options.disable_auto_compactions = true;
+  options.adaptive_filter_skip_hit_ratio = 0.9;
+  BlockBasedTableOptions bbto;
+  bbto.filter_policy.reset(NewBloomFilterPolicy(10, false));
+  options.table_factory.reset(NewBlockBasedTableFactory(bbto));
+  DestroyAndReopen(options);
+
+  const int kNumKeys = 1000;
+  auto write_and_compact = [&] {
+    for (int i = 0; i < kNumKeys; ++i) {
+      ASSERT_OK(Put(Key(i), "val"));
+    }
+    ASSERT_OK(Flush());
+    CompactRangeOptions cro;
+    cro.bottommost_level_compaction = BottommostLevelCompaction::kForce;
+    ASSERT_OK(db_->CompactRange(cro, nullptr, nullptr));
+    ASSERT_EQ(0, NumTableFilesAtLevel(0));
+  };
+
+  // Nothing sampled yet
+  write_and_compact();
+  for (auto size : FilterSizes(db_)) {
+    ASSERT_GT(size, 0U);
+  }
+
+  // All the Gets find their key on the output level, ~1 in 1024 is sampled
+  for (int i = 0; i < 200 * 1024; ++i) {
+    ASSERT_EQ("val", Get(Key(i % kNumKeys)));
+  }
+  write_and_compact();
+  for (auto size : FilterSizes(db_)) {
+    ASSERT_EQ(0U, size);
+  }
+
+  // Disabled dynamically
+  ASSERT_OK(dbfull()->SetOptions({{"adaptive_filter_skip_hit_ratio", "0"}}));
+  write_and_compact();
+  for (auto size : FilterSizes(db_)) {
+    ASSERT_GT(size, 0U);
+  }
+}
+
 int CountIter(std::unique_ptr<Iterator>& iter, const Slice& key) {
   int count = 0;
   for (iter->Seek(key); iter->Valid() && iter->status() == Status::OK();
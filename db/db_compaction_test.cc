@@ -361,6 +361,12 @@ TEST_F(DBCompactionTest, LazyCompactionTest) {
   dbfull()->CompactFiles(co, {level_files[0].name, level_files[1].name}, 2);
   level_files.clear();
 
+  // The elements of the map SST are pinned and accounted
+  uint64_t map_index_mem = 0;
+  ASSERT_TRUE(dbfull()->GetIntProperty(
+      DB::Properties::kEstimateMapSstIndexMem, &map_index_mem));
+  ASSERT_GT(map_index_mem, 0U);
+
   std::vector<
       std::tuple<std::string, std::string, std::string, const Snapshot*>>
       verify;
@@ -4175,6 +4181,203 @@ TEST_P(DBCompactionTestWithParam, FixFileIngestionCompactionDeadlock) {
   Close();
 }
 
+TEST_F(DBCompactionTest, GarbageCollectionMergeJoin) {
+  std::string bigval1(100, 'a');
+  std::string bigval2(100, 'b');
+  for (double ratio : {0.0, 16.0}) {
+    SCOPED_TRACE("blob_gc_merge_join_ratio: " + ToString(ratio));
+    Options opts = CurrentOptions();
+    opts.level0_file_num_compaction_trigger = 3;
+    opts.compression = kNoCompression;
+    opts.blob_size = 32;  // turn on kv separation
+    opts.blob_gc_ratio = 0.05;
+    opts.blob_gc_merge_join_ratio = ratio;
+    opts.statistics = TERARKDB_NAMESPACE::CreateDBStatistics();
+    DestroyAndReopen(opts);
+
+    for (int i = 0; i < 2000; ++i) {
+      ASSERT_OK(Put(Key(i), bigval1));
+    }
+    ASSERT_OK(Flush());
+    for (int i = 0; i < 1000; ++i) {
+      ASSERT_OK(Put(Key(i), bigval2));
+    }
+    ASSERT_OK(Flush());
+    for (int i = 1500; i < 1600; ++i) {
+      ASSERT_OK(Delete(Key(i)));
+    }
+    ASSERT_OK(Flush());
+    dbfull()->TEST_WaitForCompact();
+
+    if (ratio > 0) {
+      ASSERT_GT(TestGetTickerCount(opts, GC_MERGE_JOIN_KEYS), 0);
+      ASSERT_EQ(TestGetTickerCount(opts, GC_GET_KEYS), 0);
+    } else {
+      ASSERT_EQ(TestGetTickerCount(opts, GC_MERGE_JOIN_KEYS), 0);
+      ASSERT_GT(TestGetTickerCount(opts, GC_GET_KEYS), 0);
+    }
+    for (int i = 0; i < 2000; ++i) {
+      if (i < 1000) {
+        ASSERT_EQ(Get(Key(i)), bigval2);
+      } else if (i >= 1500 && i < 1600) {
+        ASSERT_EQ(Get(Key(i)), "NOT_FOUND");
+      } else {
+        ASSERT_EQ(Get(Key(i)), bigval1);
+      }
+    }
+  }
+}
+
+TEST_F(DBCompactionTest, GarbageCollectionSubcompactions) {
+  std::string bigval1(100, 'a');
+  std::string bigval2(100, 'b');
+  Options opts = CurrentOptions();
+  opts.level0_file_num_compaction_trigger = 2;
+  opts.compression = kNoCompression;
+  opts.target_file_size_base = 16 << 10;
+  opts.blob_size = 32;  // turn on kv separation
+  opts.blob_gc_ratio = 0.05;
+  opts.blob_file_defragment_size = 1;
+  opts.max_subcompactions = 4;
+  opts.max_background_compactions = 8;
+  env_->SetBackgroundThreads(8, Env::LOW);
+
+  std::atomic<int> gc_outputs{0};
+  int max_gc_outputs = 0;
+  TERARKDB_NAMESPACE::SyncPoint::GetInstance()->SetCallBack(
+      "DBImpl::BackgroundGarbageCollection:NonTrivial",
+      [&](void* /*arg*/) { gc_outputs = 0; });
+  TERARKDB_NAMESPACE::SyncPoint::GetInstance()->SetCallBack(
+      "CompactionJob::FinishCompactionOutputBlob::Start",
+      [&](void* /*arg*/) { ++gc_outputs; });
+  TERARKDB_NAMESPACE::SyncPoint::GetInstance()->SetCallBack(
+      "DBImpl::BackgroundGarbageCollection:NonTrivial:AfterRun",
+      [&](void* /*arg*/) {
+        max_gc_outputs = std::max(max_gc_outputs, gc_outputs.load());
+      });
+  DestroyAndReopen(opts);
+
+  for (int i = 0; i < 4000; ++i) {
+    ASSERT_OK(Put(Key(i), bigval1));
+  }
+  ASSERT_OK(Flush());
+  TERARKDB_NAMESPACE::SyncPoint::GetInstance()->EnableProcessing();
+  for (int i = 0; i < 4000; i += 2) {
+    ASSERT_OK(Put(Key(i), bigval2));
+  }
+  ASSERT_OK(Flush());
+  dbfull()->TEST_WaitForCompact();
+  TERARKDB_NAMESPACE::SyncPoint::GetInstance()->DisableProcessing();
+  TERARKDB_NAMESPACE::SyncPoint::GetInstance()->ClearAllCallBacks();
+
+  // every GC subcompaction produces its own output blob
+  ASSERT_GT(max_gc_outputs, 1);
+  for (int i = 0; i < 4000; ++i) {
+    ASSERT_EQ(Get(Key(i)), i % 2 == 0 ? bigval2 : bigval1);
+  }
+  std::string cfstats;
+  ASSERT_TRUE(dbfull()->GetProperty(DB::Properties::kCFStats, &cfstats));
+  ASSERT_NE(cfstats.find("Cumulative GC: "), std::string::npos);
+}
+
+TEST_F(DBCompactionTest, BlobOffsetAddressing) {
+  std::string bigval1(100, 'a');
+  std::string bigval2(100, 'b');
+  Options opts = CurrentOptions();
+  opts.level0_file_num_compaction_trigger = 3;
+  opts.blob_size = 32;  // turn on kv separation
+  opts.blob_gc_ratio = 0.05;
+  opts.blob_offset_addressing = true;
+  opts.statistics = TERARKDB_NAMESPACE::CreateDBStatistics();
+  DestroyAndReopen(opts);
+
+  for (int i = 0; i < 1000; ++i) {
+    ASSERT_OK(Put(Key(i), bigval1));
+  }
+  ASSERT_OK(Flush());
+  for (int i = 0; i < 1000; ++i) {
+    ASSERT_EQ(Get(Key(i)), bigval1);
+  }
+  ASSERT_EQ(TestGetTickerCount(opts, READ_BLOB_BY_HANDLE), 1000);
+
+  // Compactions keeping the blob file keep the handles of its values
+  CompactRangeOptions cro;
+  cro.bottommost_level_compaction = BottommostLevelCompaction::kForce;
+  ASSERT_OK(db_->CompactRange(cro, nullptr, nullptr));
+  dbfull()->TEST_WaitForCompact();
+  opts.statistics->Reset();
+  for (int i = 0; i < 1000; ++i) {
+    ASSERT_EQ(Get(Key(i)), bigval1);
+  }
+  ASSERT_EQ(TestGetTickerCount(opts, READ_BLOB_BY_HANDLE), 1000);
+
+  // value handles stay readable without the option
+  opts.blob_offset_addressing = false;
+  Reopen(opts);
+  opts.statistics->Reset();
+  ASSERT_EQ(Get(Key(0)), bigval1);
+  ASSERT_EQ(TestGetTickerCount(opts, READ_BLOB_BY_HANDLE), 1);
+
+  // GC rewrites the blob, stale handles fall back to key lookup
+  opts.blob_offset_addressing = true;
+  Reopen(opts);
+  for (int i = 0; i < 1000; i += 2) {
+    ASSERT_OK(Put(Key(i), bigval2));
+  }
+  ASSERT_OK(Flush());
+  ASSERT_OK(db_->CompactRange(CompactRangeOptions(), nullptr, nullptr));
+  dbfull()->TEST_WaitForCompact();
+  for (int i = 0; i < 1000; ++i) {
+    ASSERT_EQ(Get(Key(i)), i % 2 == 0 ? bigval2 : bigval1);
+  }
+  std::unique_ptr<Iterator> iter(db_->NewIterator(ReadOptions()));
+  int count = 0;
+  for (iter->SeekToFirst(); iter->Valid(); iter->Next(), ++count) {
+    ASSERT_EQ(iter->value(), count % 2 == 0 ? bigval2 : bigval1);
+  }
+  ASSERT_OK(iter->status());
+  ASSERT_EQ(count, 1000);
+}
+
+TEST_F(DBCompactionTest, BlobCache) {
+  for (bool offset_addressing : {true, false}) {
+    Options opts = CurrentOptions();
+    opts.disable_auto_compactions = true;
+    opts.blob_size = 32;  // turn on kv separation
+    opts.blob_offset_addressing = offset_addressing;
+    opts.blob_cache = NewLRUCache(1 << 20);
+    opts.statistics = TERARKDB_NAMESPACE::CreateDBStatistics();
+    DestroyAndReopen(opts);
+
+    for (int i = 0; i < 100; ++i) {
+      ASSERT_OK(Put(Key(i), std::string(100, 'a' + i % 26)));
+    }
+    ASSERT_OK(Flush());
+    opts.statistics->Reset();
+    for (int i = 0; i < 100; ++i) {
+      ASSERT_EQ(Get(Key(i)), std::string(100, 'a' + i % 26));
+    }
+    ASSERT_EQ(TestGetTickerCount(opts, BLOB_CACHE_MISS), 100);
+    ASSERT_EQ(TestGetTickerCount(opts, BLOB_CACHE_ADD), 100);
+    ASSERT_EQ(TestGetTickerCount(opts, BLOB_CACHE_HIT), 0);
+    ASSERT_EQ(TestGetTickerCount(opts, BLOB_CACHE_BYTES_WRITE), 100 * 100);
+
+    for (int i = 0; i < 100; ++i) {
+      ASSERT_EQ(Get(Key(i)), std::string(100, 'a' + i % 26));
+    }
+    std::unique_ptr<Iterator> iter(db_->NewIterator(ReadOptions()));
+    int count = 0;
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next(), ++count) {
+      ASSERT_EQ(iter->value(), std::string(100, 'a' + count % 26));
+    }
+    ASSERT_OK(iter->status());
+    ASSERT_EQ(count, 100);
+    ASSERT_EQ(TestGetTickerCount(opts, BLOB_CACHE_MISS), 100);
+    ASSERT_EQ(TestGetTickerCount(opts, BLOB_CACHE_HIT), 200);
+    ASSERT_EQ(TestGetTickerCount(opts, BLOB_CACHE_BYTES_READ), 200 * 100);
+  }
+}
+
 TEST_F(DBCompactionTest, BlobOverlapThredhold) {
   std::string bigval =
       "012345678901234567890123456789012345678901234567890123456789012345678901"
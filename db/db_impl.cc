@@ -18,6 +18,7 @@
 
 #include <algorithm>
 #include <cinttypes>
+#include <deque>
 #include <iostream>
 #include <map>
 #include <numeric>
@@ -301,11 +302,22 @@ DBImpl::DBImpl(const DBOptions& options, const std::string& dbname,
       default_cf_handle_(nullptr),
       persist_stats_cf_handle_(nullptr),
       log_sync_cv_(&mutex_),
+      wal_sync_cv_(&wal_sync_mutex_),
+      wal_sync_requested_seq_(0),
+      wal_synced_seq_(0),
+      wal_sync_shutdown_(false),
       total_log_size_(0),
       max_total_in_memory_state_(0),
       is_snapshot_supported_(true),
       write_buffer_manager_(immutable_db_options_.write_buffer_manager.get()),
       write_thread_(immutable_db_options_),
+      wal_stream_sequencer_([this] { return versions_->LastSequence(); },
+                            [this](SequenceNumber s) {
+                              versions_->SetLastSequence(s);
+                            }),
+      wal_streams_stopped_(0),
+      wal_stream_ticket_(0),
+      wal_streams_need_preprocess_(false),
       nonmem_write_thread_(immutable_db_options_),
       write_controller_(mutable_db_options_.delayed_write_rate),
       // Use delayed_write_rate as a base line to determine the initial
@@ -458,6 +470,9 @@ DBImpl::DBImpl(const DBOptions& options, const std::string& dbname,
                                  write_buffer_manager_, &write_controller_));
   column_family_memtables_.reset(
       new ColumnFamilyMemTablesImpl(versions_->GetColumnFamilySet()));
+  for (int i = 1; i < immutable_db_options_.wal_streams; ++i) {
+    wal_streams_.emplace_back(new WalStream(immutable_db_options_));
+  }
 
   DumpRocksDBBuildVersion(immutable_db_options_.info_log.get());
   SetDbSessionId();
@@ -555,6 +570,12 @@ Status DBImpl::ResumeImpl() {
   if (s.ok()) {
     s = error_handler_.ClearBGError();
   }
+  if (s.ok() && immutable_db_options_.enable_async_wal_sync) {
+    // The memtables are flushed, the WAL synced before the failure is no
+    // longer needed
+    InstrumentedMutexLock l(&wal_sync_mutex_);
+    wal_sync_status_ = Status::OK();
+  }
   mutex_.Unlock();
 
   job_context.manifest_file_number = 1;
@@ -629,6 +650,16 @@ void DBImpl::CancelAllBackgroundWork(bool wait) {
 
   shutting_down_.store(true, std::memory_order_release);
   bg_cv_.SignalAll();
+  // Fail the remote compactions, the background threads wait for them. The
+  // dispatchers may be shared with other DBs, whose jobs go on
+  for (auto cfd : *versions_->GetColumnFamilySet()) {
+    if (auto dispatcher = cfd->ioptions()->compaction_dispatcher) {
+      dispatcher->CancelCompactions(versions_.get());
+    }
+  }
+  if (auto dispatcher = CompactionJob::EnvCompactionDispatcher()) {
+    dispatcher->CancelCompactions(versions_.get());
+  }
   if (!wait) {
     return;
   }
@@ -648,6 +679,9 @@ Status DBImpl::CloseHelper() {
   }
   mutex_.Unlock();
 
+  // Syncs the pending requests before it exits
+  StopWalSyncThread();
+
   // CancelAllBackgroundWork called with false means we just set the shutdown
   // marker. After this we do a variant of the waiting and unschedule work
   // (to consider: moving all the waiting into CancelAllBackgroundWork(true))
@@ -755,22 +789,28 @@ Status DBImpl::CloseHelper() {
   for (auto l : logs_to_free_queue_) {
     delete l;
   }
-  for (auto& log : logs_) {
-    uint64_t log_number = log.writer->get_log_number();
-    Status s = log.ClearWriter();
-    if (!s.ok()) {
-      ROCKS_LOG_WARN(
-          immutable_db_options_.info_log,
-          "Unable to Sync WAL file %s with error -- %s",
-          LogFileName(immutable_db_options_.wal_dir, log_number).c_str(),
-          s.ToString().c_str());
-      // Retain the first error
-      if (ret.ok()) {
-        ret = s;
+  auto clear_writers = [&](std::deque<LogWriterNumber>* logs) {
+    for (auto& log : *logs) {
+      uint64_t log_number = log.writer->get_log_number();
+      Status s = log.ClearWriter();
+      if (!s.ok()) {
+        ROCKS_LOG_WARN(
+            immutable_db_options_.info_log,
+            "Unable to Sync WAL file %s with error -- %s",
+            LogFileName(immutable_db_options_.wal_dir, log_number).c_str(),
+            s.ToString().c_str());
+        // Retain the first error
+        if (ret.ok()) {
+          ret = s;
+        }
       }
     }
+    logs->clear();
+  };
+  clear_writers(&logs_);
+  for (auto& stream : wal_streams_) {
+    clear_writers(&stream->logs);
   }
-  logs_.clear();
 
   // Table cache may have table handles holding blocks from the block cache.
   // We need to release them before the block cache is destroyed. The block
@@ -1045,6 +1085,44 @@ void DBImpl::ScheduleTtlGC() {
     }
     uint64_t now = cfd->ioptions()->ttl_extractor_factory->Now();
     VersionStorageInfo* vstorage = cfd->current()->storage_info();
+    // Blob ssts whose values are all expired and invisible to any snapshot.
+    // Compacting the ssts which reference them lets the compaction filter
+    // drop the rows, then the blob ssts lose their last reference and are
+    // deleted as a whole instead of being rewritten by GC
+    std::unordered_set<const FileMetaData*> expired_blobs;
+    for (auto meta : vstorage->LevelFiles(-1)) {
+      if (meta->prop.latest_expire_time <= now &&
+          (snapshots_.empty() ||
+           snapshots_.GetNewest() < meta->fd.smallest_seqno)) {
+        expired_blobs.emplace(meta);
+      }
+    }
+    auto& dependence_map = vstorage->dependence_map();
+    auto is_expired_dependence = [&](const Dependence& dependence) {
+      auto find = dependence_map.find(dependence.file_number);
+      return find != dependence_map.end() &&
+             expired_blobs.count(find->second) > 0;
+    };
+    auto depends_on_expired_blob = [&](const FileMetaData* meta) {
+      for (auto& dependence : meta->prop.dependence) {
+        if (is_expired_dependence(dependence)) {
+          return true;
+        }
+        if (!meta->prop.is_map_sst()) {
+          continue;
+        }
+        auto find = dependence_map.find(dependence.file_number);
+        if (find == dependence_map.end()) {
+          continue;
+        }
+        for (auto& blob_dependence : find->second->prop.dependence) {
+          if (is_expired_dependence(blob_dependence)) {
+            return true;
+          }
+        }
+      }
+      return false;
+    };
     for (int l = 0; l < vstorage->num_non_empty_levels(); l++) {
       for (auto meta : vstorage->LevelFiles(l)) {
         if (meta->being_compacted) {
@@ -1062,6 +1140,17 @@ void DBImpl::ScheduleTtlGC() {
           meta->marked_for_compaction |= FileMetaData::kMarkedFromTTL;
           marked = true;
         }
+        if (!marked && !expired_blobs.empty() &&
+            depends_on_expired_blob(meta)) {
+          ROCKS_LOG_BUFFER(&log_buffer_info,
+                           "SST #%" PRIu64
+                           " marked for compaction @L%d , depends on expired "
+                           "blob, now: %" PRIu64,
+                           meta->fd.GetNumber(), l, now);
+          meta->marked_for_compaction |= FileMetaData::kMarkedFromTTL;
+          marked = true;
+          TEST_SYNC_POINT("DBImpl:ScheduleTtlGC-mark-expired-blob");
+        }
         if (marked) {
           new_mark_count++;
           TEST_SYNC_POINT("DBImpl:ScheduleTtlGC-mark");
@@ -1601,7 +1690,7 @@ Status DBImpl::SetDBOptions(
           mutable_db_options_.compaction_readahead_size;
       WriteThread::Writer w;
       write_thread_.EnterUnbatched(&w, &mutex_);
-      if (alive_log_files_.back().size > GetMaxWalSize() ||
+      if (GetCurrentWalSize() > GetMaxWalSize() ||
           total_log_size_ > GetMaxTotalWalSize() || wal_changed) {
         Status purge_wal_status = SwitchWAL(&write_context);
         if (!purge_wal_status.ok()) {
@@ -1701,20 +1790,46 @@ Status DBImpl::SyncWAL() {
     // This SyncWAL() call only cares about logs up to this number.
     current_log_number = logfile_number_;
 
-    while (logs_.front().number <= current_log_number &&
-           logs_.front().getting_synced) {
+    auto getting_synced = [&] {
+      if (logs_.front().number <= current_log_number &&
+          logs_.front().getting_synced) {
+        return true;
+      }
+      for (auto& stream : wal_streams_) {
+        if (stream->logs.front().getting_synced) {
+          return true;
+        }
+      }
+      return false;
+    };
+    while (getting_synced()) {
       log_sync_cv_.Wait();
     }
     // First check that logs are safe to sync in background.
-    for (auto it = logs_.begin();
-         it != logs_.end() && it->number <= current_log_number; ++it) {
-      if (!it->writer->file()->writable_file()->IsSyncThreadSafe()) {
+    auto check_sync_thread_safe = [&](const LogWriterNumber& log) {
+      if (!log.writer->file()->writable_file()->IsSyncThreadSafe()) {
         return Status::NotSupported(
             "SyncWAL() is not supported for this implementation of WAL file",
             immutable_db_options_.allow_mmap_writes
                 ? "try setting Options::allow_mmap_writes to false"
                 : Slice());
       }
+      return Status::OK();
+    };
+    for (auto it = logs_.begin();
+         it != logs_.end() && it->number <= current_log_number; ++it) {
+      Status s = check_sync_thread_safe(*it);
+      if (!s.ok()) {
+        return s;
+      }
+    }
+    for (auto& stream : wal_streams_) {
+      for (auto& log : stream->logs) {
+        Status s = check_sync_thread_safe(log);
+        if (!s.ok()) {
+          return s;
+        }
+      }
     }
     for (auto it = logs_.begin();
          it != logs_.end() && it->number <= current_log_number; ++it) {
@@ -1725,6 +1840,15 @@ Status DBImpl::SyncWAL() {
     }
 
     need_log_dir_sync = !log_dir_synced_;
+    // The secondary WAL streams are synced up to their current logs
+    for (auto& stream : wal_streams_) {
+      for (auto& log : stream->logs) {
+        assert(!log.getting_synced);
+        log.getting_synced = true;
+        logs_to_sync.push_back(log.writer);
+      }
+      need_log_dir_sync = need_log_dir_sync || !stream->log_dir_synced;
+    }
   }
 
   TEST_SYNC_POINT("DBWALTest::SyncWALNotWaitWrite:1");
@@ -1745,6 +1869,9 @@ Status DBImpl::SyncWAL() {
   {
     InstrumentedMutexLock l(&mutex_);
     MarkLogsSynced(current_log_number, need_log_dir_sync, status);
+    for (auto& stream : wal_streams_) {
+      MarkWalStreamLogsSynced(stream.get(), need_log_dir_sync, status);
+    }
   }
   TEST_SYNC_POINT("DBImpl::SyncWAL:BeforeMarkLogsSynced:2");
 
@@ -1794,6 +1921,28 @@ void DBImpl::MarkLogsSynced(uint64_t up_to, bool synced_dir,
   log_sync_cv_.SignalAll();
 }
 
+void DBImpl::MarkWalStreamLogsSynced(WalStream* stream, bool synced_dir,
+                                     const Status& status) {
+  mutex_.AssertHeld();
+  auto& logs = stream->logs;
+  if (synced_dir && logs.back().getting_synced && status.ok()) {
+    stream->log_dir_synced = true;
+  }
+  for (auto it = logs.begin(); it != logs.end() && it->getting_synced;) {
+    auto& log = *it;
+    if (status.ok() && std::next(it) != logs.end()) {
+      logs_to_free_.push_back(log.ReleaseWriter());
+      // To modify logs both mutex_ and log_write_mutex_ must be held
+      InstrumentedMutexLock l(&log_write_mutex_);
+      it = logs.erase(it);
+    } else {
+      log.getting_synced = false;
+      ++it;
+    }
+  }
+  log_sync_cv_.SignalAll();
+}
+
 SequenceNumber DBImpl::GetLatestSequenceNumber() const {
   return versions_->LastSequence();
 }
@@ -2238,6 +2387,8 @@ std::vector<Status> DBImpl::MultiGet(
   struct MultiGetColumnFamilyData {
     ColumnFamilyData* cfd;
     SuperVersion* super_version;
+    // Keys missed by the memtables, looked up in SSTs as a batch
+    std::vector<Version::GetRequest> sst_requests;
   };
   std::unordered_map<uint32_t, MultiGetColumnFamilyData*> multiget_cf_data;
   // fill up and allocate outside of mutex
@@ -2280,6 +2431,7 @@ std::vector<Status> DBImpl::MultiGet(
   // s is both in/out. When in, s could either be OK or MergeInProgress.
   // merge_operands will contain the sequence of merges in the latter case.
   size_t num_found = 0;
+#ifdef WITH_BOOSTLIB
   size_t counting = num_keys;
   auto get_one = [&](size_t i) {
     // Contain a list of merge operations if merge occurs.
@@ -2326,8 +2478,80 @@ std::vector<Status> DBImpl::MultiGet(
     }
     counting--;
   };
+#endif
+  // Per key state of get_batched
+  struct KeyContext {
+    KeyContext(const Slice& key, SequenceNumber seq, std::string* value)
+        : lkey(key, seq), lazy_val(value) {}
+    LookupKey lkey;
+    LazyBuffer lazy_val;
+    MergeContext merge_context;
+    SequenceNumber max_covering_tombstone_seq = 0;
+  };
+  // Lookup all keys in the memtables first, then hand the misses of each
+  // column family to Version::MultiGet, which walks the levels once for the
+  // whole batch
+  auto get_batched = [&]() {
+    std::deque<KeyContext> key_contexts;
+    bool skip_memtable =
+        (read_options.read_tier == kPersistedTier &&
+         has_unpersisted_data_.load(std::memory_order_relaxed));
+    for (size_t i = 0; i < num_keys; ++i) {
+      key_contexts.emplace_back(keys[i], snapshot, &(*values)[i]);
+      KeyContext& ctx = key_contexts.back();
+      Status& s = stat_list[i];
+      auto cfh = reinterpret_cast<ColumnFamilyHandleImpl*>(column_family[i]);
+      auto mgd_iter = multiget_cf_data.find(cfh->cfd()->GetID());
+      assert(mgd_iter != multiget_cf_data.end());
+      auto mgd = mgd_iter->second;
+      auto super_version = mgd->super_version;
+      bool done = false;
+      if (!skip_memtable) {
+        if (super_version->mem->Get(ctx.lkey, &ctx.lazy_val, &s,
+                                    &ctx.merge_context,
+                                    &ctx.max_covering_tombstone_seq,
+                                    read_options)) {
+          done = true;
+          RecordTick(stats_, MEMTABLE_HIT);
+        } else if (super_version->imm->Get(ctx.lkey, &ctx.lazy_val, &s,
+                                           &ctx.merge_context,
+                                           &ctx.max_covering_tombstone_seq,
+                                           read_options)) {
+          done = true;
+          RecordTick(stats_, MEMTABLE_HIT);
+        }
+      }
+      if (!done) {
+        mgd->sst_requests.push_back({keys[i], &ctx.lkey, &ctx.lazy_val, &s,
+                                     &ctx.merge_context,
+                                     &ctx.max_covering_tombstone_seq});
+        RecordTick(stats_, MEMTABLE_MISS);
+      }
+    }
+    {
+      PERF_TIMER_GUARD(get_from_output_files_time);
+      for (auto mgd_iter : multiget_cf_data) {
+        auto mgd = mgd_iter.second;
+        mgd->super_version->current->MultiGet(read_options,
+                                              &mgd->sst_requests);
+      }
+    }
+    for (size_t i = 0; i < num_keys; ++i) {
+      Status& s = stat_list[i];
+      std::string* value = &(*values)[i];
+      if (s.ok()) {
+        s = std::move(key_contexts[i].lazy_val).dump(value);
+      }
+      if (s.ok()) {
+        bytes_read += value->size();
+        num_found++;
+      }
+    }
+  };
 #ifdef WITH_BOOSTLIB
-  if (read_options.aio_concurrency && immutable_db_options_.use_aio_reads) {
+  if (read_options.aio_concurrency &&
+      (immutable_db_options_.use_aio_reads ||
+       immutable_db_options_.use_io_uring_reads)) {
 #if 0
     static thread_local terark::RunOnceFiberPool fiber_pool(16);
     // current calling fiber's list head, can be treated as a handle
@@ -2350,9 +2574,7 @@ std::vector<Status> DBImpl::MultiGet(
 #endif
   } else {
 #endif
-    for (size_t i = 0; i < num_keys; ++i) {
-      get_one(i);
-    }
+    get_batched();
 #ifdef WITH_BOOSTLIB
   }
 #endif
@@ -2594,11 +2816,13 @@ autovector<Status> DBImpl::CreateColumnFamilyImpl(
     if (ok_count > 0) {  // write thread
       WriteThread::Writer w;
       write_thread_.EnterUnbatched(&w, &mutex_);
+      EnterWalStreamsUnbatched();
       // LogAndApply will both write the creation in MANIFEST and create
       // ColumnFamilyData object
       auto apply_s = versions_->LogAndApply(
           cfds, mutable_cf_options_list, edit_lists, &mutex_,
           directories_.GetDbDir(), false, column_family_options_list);
+      ExitWalStreamsUnbatched();
       write_thread_.ExitUnbatched(&w);
       if (!apply_s.ok()) {
         for (size_t i = 0; i < cf_options.size(); ++i) {
@@ -2707,8 +2931,10 @@ Status DBImpl::DropColumnFamilyImpl(ColumnFamilyHandle* column_family) {
       // we drop column family from a single write thread
       WriteThread::Writer w;
       write_thread_.EnterUnbatched(&w, &mutex_);
+      EnterWalStreamsUnbatched();
       s = versions_->LogAndApply(cfd, *cfd->GetLatestMutableCFOptions(), &edit,
                                  &mutex_);
+      ExitWalStreamsUnbatched();
       write_thread_.ExitUnbatched(&w);
     }
     if (s.ok()) {
@@ -3354,6 +3580,10 @@ Status DBImpl::GetUpdatesSince(
     SequenceNumber seq, std::unique_ptr<TransactionLogIterator>* iter,
     const TransactionLogIterator::ReadOptions& read_options) {
   RecordTick(stats_, GET_UPDATES_SINCE_CALLS);
+  if (!wal_streams_.empty()) {
+    // The log files of the streams interleave their sequences
+    return Status::NotSupported("GetUpdatesSince() with wal_streams > 1");
+  }
   if (seq > versions_->LastSequence()) {
     return Status::NotFound("Requested sequence not yet written in the db");
   }
@@ -4577,6 +4807,7 @@ Status DBImpl::IngestExternalFile(
     if (two_write_queues_) {
       nonmem_write_thread_.EnterUnbatched(&nonmem_w, &mutex_);
     }
+    EnterWalStreamsUnbatched();
 
     num_running_ingest_file_++;
     TEST_SYNC_POINT("DBImpl::IngestExternalFile:AfterIncIngestFileCounter");
@@ -4622,6 +4853,7 @@ Status DBImpl::IngestExternalFile(
     }
 
     // Resume writes to the DB
+    ExitWalStreamsUnbatched();
     if (two_write_queues_) {
       nonmem_write_thread_.ExitUnbatched(&nonmem_w);
     }
@@ -37,6 +37,7 @@
 #include "db/snapshot_impl.h"
 #include "db/version_edit.h"
 #include "db/wal_manager.h"
+#include "db/wal_stream_sequencer.h"
 #include "db/write_controller.h"
 #include "db/write_thread.h"
 #include "memtable_list.h"
@@ -1105,6 +1106,16 @@ class DBImpl : public DB {
   Status RecoverLogFiles(const std::vector<uint64_t>& log_numbers,
                          SequenceNumber* next_sequence, bool read_only);
 
+  // Part of RecoverLogFiles with wal_streams > 1, replays the batches of all
+  // the logs in sequence order.
+  Status ReplayWalStreams(const std::vector<uint64_t>& log_numbers,
+                          SequenceNumber* next_sequence, bool read_only,
+                          int job_id,
+                          std::unordered_map<int, VersionEdit>* version_edits,
+                          std::vector<SequenceNumber>* log_seqs, bool* flushed,
+                          bool* stop_replay_for_corruption,
+                          uint64_t* corrupted_log_number);
+
   // The following two methods are used to flush a memtable to
   // storage. The first one is used at database RecoveryTime (when the
   // database is opened) and is heavyweight because it holds the mutex
@@ -1193,6 +1204,82 @@ class DBImpl : public DB {
                               uint64_t* log_used, SequenceNumber* last_sequence,
                               size_t seq_inc);
 
+  struct WalStream;
+
+  // Write path of the secondary WAL streams, see DBOptions::wal_streams.
+  // The group leader writes its own log and inserts the whole group with
+  // concurrent memtable writes.
+  Status WalStreamWriteImpl(WalStream* stream, const WriteOptions& options,
+                            WriteBatch* updates, uint64_t* log_used,
+                            uint64_t* seq_used);
+
+  // Stops the write groups of all the secondary WAL streams, so that the
+  // caller may switch memtables and logs. Nested calls are counted.
+  // REQUIRES: mutex_ held and this thread is the leader of write_thread_ or
+  // entered it unbatched
+  void EnterWalStreamsUnbatched();
+  void ExitWalStreamsUnbatched();
+
+  // True if the next write has to run PreprocessWrite, which the secondary
+  // WAL streams skip.
+  // REQUIRES: mutex_ held
+  bool WalStreamsNeedPreprocess();
+
+  // Creates the next log of every secondary WAL stream. They are numbered
+  // after the new log of logs_, and before any later one.
+  Status NewWalStreamLogWriters(
+      std::vector<std::unique_ptr<log::Writer>>* new_logs,
+      const DBOptions& db_options, Env::WriteLifeTimeHint write_hint);
+
+  // Switches the secondary WAL streams to new_logs, the current logs are
+  // added to alive_log_files_ with seq.
+  // REQUIRES: mutex_ and log_write_mutex_ held, streams stopped or not
+  // yet writing
+  Status InstallWalStreamLogWriters(
+      std::vector<std::unique_ptr<log::Writer>>* new_logs,
+      size_t preallocate_block_size, SequenceNumber seq);
+
+  // MarkLogsSynced for the logs of a secondary WAL stream that have
+  // getting_synced set.
+  void MarkWalStreamLogsSynced(WalStream* stream, bool synced_dir,
+                               const Status& status);
+
+  // Waits until no log of logs_ or of the secondary WAL streams is being
+  // synced, then sets getting_synced on all of them. A sync write of any
+  // queue syncs them all, so that no earlier write of another stream is
+  // lost on a crash while the sync write is recovered.
+  // REQUIRES: mutex_ held
+  Status BeginWalStreamsSync();
+
+  // Resets getting_synced after BeginWalStreamsSync(), before anything was
+  // synced.
+  // REQUIRES: mutex_ held
+  void CancelWalStreamsSync();
+
+  // True if the WAL directory was synced for the current logs of logs_ and
+  // of all the secondary WAL streams.
+  // REQUIRES: mutex_ held
+  bool WalStreamsDirSynced() const;
+
+  // Waits until the batches of all the tickets before ticket are in their
+  // logs, then syncs the logs of the other queues than own_stream, nullptr
+  // for write_thread_. The caller syncs its own logs.
+  // REQUIRES: BeginWalStreamsSync() succeeded
+  Status SyncOtherWalStreams(const WalStream* own_stream, uint64_t ticket);
+
+  // With enable_async_wal_sync, a dedicated thread syncs the WAL for the
+  // sync writes while the write groups go on appending to it.
+  void StartWalSyncThread();
+  void StopWalSyncThread();
+  void BGWorkWalSync();
+
+  // Asks the WAL sync thread for a sync, the WAL already holds seq.
+  void RequestWalSync(SequenceNumber seq);
+
+  // Returns the status of writer w once its batch is synced, if it is a sync
+  // write.
+  Status WaitForWalSync(WriteThread::Writer* w);
+
   // Used by WriteImpl to update bg_error_ if paranoid check is enabled.
   void WriteStatusCheck(const Status& status);
 
@@ -1305,6 +1392,9 @@ class DBImpl : public DB {
 
   uint64_t GetMaxWalSize() const;
   uint64_t GetMaxTotalWalSize() const;
+  // Size of the current WAL, with the current logs of the secondary WAL
+  // streams
+  uint64_t GetCurrentWalSize() const;
 
   Directory* GetDataDir(ColumnFamilyData* cfd, size_t path_id) const;
 
@@ -1408,6 +1498,23 @@ class DBImpl : public DB {
     // true for some prefix of logs_
     bool getting_synced = false;
   };
+  struct WalStream {
+    explicit WalStream(const ImmutableDBOptions& db_options)
+        : write_thread(db_options) {}
+
+    WriteThread write_thread;
+    WriteBatch tmp_batch;
+    // Held while the stream is stopped
+    std::unique_ptr<WriteThread::Writer> unbatched_writer;
+    // Synchronized like logs_, with the leader of write_thread in place of
+    // the leader of write_thread_
+    std::deque<LogWriterNumber> logs;
+    // Bytes in logs.back(), written by the leader of write_thread or with
+    // the stream stopped, read with mutex_ held by the max_wal_size checks
+    std::atomic<uint64_t> log_size{0};
+    // Protected by mutex_
+    bool log_dir_synced = false;
+  };
 
   ColumnFamilyHandleImpl* persist_stats_cf_handle_;
   bool persistent_stats_cfd_exists_ = true;
@@ -1434,6 +1541,20 @@ class DBImpl : public DB {
   std::deque<LogWriterNumber> logs_;
   // Signaled when getting_synced becomes false for some of the logs_.
   InstrumentedCondVar log_sync_cv_;
+  // See StartWalSyncThread
+  port::Thread wal_sync_thread_;
+  InstrumentedMutex wal_sync_mutex_;
+  // Signaled when either of the following two changes
+  InstrumentedCondVar wal_sync_cv_;
+  // Protected by wal_sync_mutex_. The WAL holds all the sequences up to
+  // wal_sync_requested_seq_ and is synced up to wal_synced_seq_.
+  SequenceNumber wal_sync_requested_seq_;
+  SequenceNumber wal_synced_seq_;
+  // First failure of the WAL sync thread, protected by wal_sync_mutex_.
+  // Cleared when Resume() recovers from the background error it raised.
+  // Lock order: mutex_ before wal_sync_mutex_.
+  Status wal_sync_status_;
+  bool wal_sync_shutdown_;
   // This is the app-level state that is written to the WAL but will be used
   // only during recovery. Using this feature enables not writing the state to
   // memtable on normal writes and hence improving the throughput. Each new
@@ -1492,6 +1613,17 @@ class DBImpl : public DB {
 
   WriteThread write_thread_;
   WriteBatch tmp_batch_;
+  // The secondary WAL streams, empty unless wal_streams > 1
+  std::vector<std::unique_ptr<WalStream>> wal_streams_;
+  // With wal_streams_, allocates the sequences of all the write groups
+  WalStreamSequencer wal_stream_sequencer_;
+  // Nesting depth of EnterWalStreamsUnbatched, protected by mutex_
+  int wal_streams_stopped_;
+  // Sequencer ticket of the current write group of write_thread_
+  uint64_t wal_stream_ticket_;
+  // Set by a secondary stream when flushes or stalls are pending, all writes
+  // go through write_thread_ until PreprocessWrite has run.
+  std::atomic<bool> wal_streams_need_preprocess_;
   // The write thread when the writers have no memtable write. This will be used
   // in 2PC to batch the prepares separately from the serial commit.
   WriteThread nonmem_write_thread_;
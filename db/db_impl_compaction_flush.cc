@@ -66,8 +66,19 @@ Status DBImpl::SyncClosedLogs(JobContext* job_context) {
   mutex_.AssertHeld();
   autovector<log::Writer*, 1> logs_to_sync;
   uint64_t current_log_number = logfile_number_;
-  while (logs_.front().number < current_log_number &&
-         logs_.front().getting_synced) {
+  auto getting_synced = [&] {
+    if (logs_.front().number < current_log_number &&
+        logs_.front().getting_synced) {
+      return true;
+    }
+    for (auto& stream : wal_streams_) {
+      if (stream->logs.front().getting_synced) {
+        return true;
+      }
+    }
+    return false;
+  };
+  while (getting_synced()) {
     log_sync_cv_.Wait();
   }
   for (auto it = logs_.begin();
@@ -77,6 +88,14 @@ Status DBImpl::SyncClosedLogs(JobContext* job_context) {
     log.getting_synced = true;
     logs_to_sync.push_back(log.writer);
   }
+  // All but the current logs of the secondary WAL streams are closed
+  for (auto& stream : wal_streams_) {
+    for (auto it = stream->logs.begin(); std::next(it) != stream->logs.end();
+         ++it) {
+      it->getting_synced = true;
+      logs_to_sync.push_back(it->writer);
+    }
+  }
 
   Status s;
   if (!logs_to_sync.empty()) {
@@ -100,6 +119,9 @@ Status DBImpl::SyncClosedLogs(JobContext* job_context) {
     // "number <= current_log_number - 1" is equivalent to
     // "number < current_log_number".
     MarkLogsSynced(current_log_number - 1, true, s);
+    for (auto& stream : wal_streams_) {
+      MarkWalStreamLogsSynced(stream.get(), false /*synced_dir*/, s);
+    }
     if (!s.ok()) {
       error_handler_.SetBGError(s, BackgroundErrorReason::kFlush);
       TEST_SYNC_POINT("DBImpl::SyncClosedLogs:Failed");
@@ -3043,7 +3065,9 @@ Status DBImpl::BackgroundGarbageCollection(bool* made_progress,
         &event_logger_, c->mutable_cf_options()->paranoid_file_checks,
         c->mutable_cf_options()->report_bg_io_stats, dbname_,
         &garbage_collection_job_stats);
-    garbage_collection_job.Prepare(0 /* sub_compaction_slots */);
+    int sub_compaction_scheduled = garbage_collection_job.Prepare(
+        GetSubCompactionSlots(c->max_subcompactions()));
+    bg_compaction_scheduled_ += sub_compaction_scheduled;
     NotifyOnCompactionBegin(c->column_family_data(), c.get(), status,
                             garbage_collection_job_stats, job_context->job_id);
 
@@ -3051,6 +3075,7 @@ Status DBImpl::BackgroundGarbageCollection(bool* made_progress,
     garbage_collection_job.Run();
     TEST_SYNC_POINT("DBImpl::BackgroundGarbageCollection:NonTrivial:AfterRun");
     mutex_.Lock();
+    bg_compaction_scheduled_ -= sub_compaction_scheduled;
     status = garbage_collection_job.Install(*c->mutable_cf_options());
     if (status.ok()) {
       InstallSuperVersionAndScheduleWork(
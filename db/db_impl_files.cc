@@ -267,6 +267,19 @@ void DBImpl::FindObsoleteFiles(JobContext* job_context, bool force,
     }
     // Current log cannot be obsolete.
     assert(!logs_.empty());
+    for (auto& stream : wal_streams_) {
+      auto& logs = stream->logs;
+      while (logs.size() > 1 && logs.front().number < min_log_number) {
+        auto& log = logs.front();
+        if (log.getting_synced) {
+          log_sync_cv_.Wait();
+          continue;
+        }
+        logs_to_free_.push_back(log.ReleaseWriter());
+        InstrumentedMutexLock wl(&log_write_mutex_);
+        logs.pop_front();
+      }
+    }
   }
 
   // We're just cleaning up for DB::Write().
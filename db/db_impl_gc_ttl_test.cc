@@ -5,12 +5,71 @@
 #include "db/db_test_util.h"
 #include "db/periodic_work_scheduler.h"
 #include "rocksdb/terark_namespace.h"
+#include "util/coding.h"
 #include "util/string_util.h"
 #include "util/sync_point.h"
 #include "util/testharness.h"
 
 namespace TERARKDB_NAMESPACE {
 
+namespace {
+
+// The expiration time is only known from the value, which is the case for
+// separated values
+class ValueTtlExtractor : public TtlExtractor {
+ public:
+  Status Extract(EntryType entry_type, const Slice& /*user_key*/,
+                 const Slice& value_or_meta, bool* has_ttl,
+                 uint64_t* ttl_time_point) const override {
+    *has_ttl = (entry_type == kEntryPut || entry_type == kEntryMerge) &&
+               value_or_meta.size() >= sizeof(uint64_t);
+    if (*has_ttl) {
+      *ttl_time_point = DecodeFixed64(value_or_meta.data() +
+                                      value_or_meta.size() - sizeof(uint64_t));
+    }
+    return Status::OK();
+  }
+};
+
+class ValueTtlExtractorFactory : public TtlExtractorFactory {
+ public:
+  explicit ValueTtlExtractorFactory(Env* env) : env_(env) {}
+
+  std::unique_ptr<TtlExtractor> CreateTtlExtractor(
+      const TtlExtractorContext& /*context*/) const override {
+    return std::unique_ptr<TtlExtractor>(new ValueTtlExtractor);
+  }
+  uint64_t Now() const override { return env_->NowMicros() / 1000U / 1000U; }
+  const char* Name() const override { return "ValueTtlExtractorFactory"; }
+  Status Serialize(std::string* /*bytes*/) const override {
+    return Status::NotSupported();
+  }
+
+ private:
+  Env* env_;
+};
+
+// Drops the values which expired
+class ExpiredValueFilter : public CompactionFilter {
+ public:
+  explicit ExpiredValueFilter(const TtlExtractorFactory* factory)
+      : factory_(factory) {}
+
+  bool Filter(int /*level*/, const Slice& /*key*/, const Slice& value,
+              std::string* /*new_value*/,
+              bool* /*value_changed*/) const override {
+    return value.size() >= sizeof(uint64_t) &&
+           DecodeFixed64(value.data() + value.size() - sizeof(uint64_t)) <=
+               factory_->Now();
+  }
+  const char* Name() const override { return "ExpiredValueFilter"; }
+
+ private:
+  const TtlExtractorFactory* factory_;
+};
+
+}  // namespace
+
 class DBImplGCTTL_Test : public DBTestBase {
  public:
   DBImplGCTTL_Test()
@@ -100,6 +159,64 @@ TEST_F(DBImplGCTTL_Test, BlockBasedTableTest) {
   run();
   read();
 }
+TEST_F(DBImplGCTTL_Test, ExpiredBlobReleasedWithoutRewrite) {
+  init();
+  options.ttl_extractor_factory.reset(
+      new ValueTtlExtractorFactory(mock_env_.get()));
+  ExpiredValueFilter filter(options.ttl_extractor_factory.get());
+  options.compaction_filter = &filter;
+  options.blob_size = 16;  // turn on kv separation
+  options.env = mock_env_.get();
+  SetUp();
+  Reopen(options);
+  auto blob_count = [&] {
+    auto cfd = static_cast<ColumnFamilyHandleImpl*>(db_->DefaultColumnFamily())
+                   ->cfd();
+    return cfd->current()->storage_info()->LevelFiles(-1).size();
+  };
+
+  char ts_string[8];
+  EncodeFixed64(ts_string, ttl);
+  for (int i = 0; i < 100; i++) {
+    std::string value(64, 'v');
+    value.append(ts_string, 8);
+    ASSERT_OK(Put(Key(i), value));
+  }
+  ASSERT_OK(Flush());
+  ASSERT_EQ(1U, blob_count());
+
+  int expired_blob_marks = 0;
+  int gc_runs = 0;
+  SyncPoint::GetInstance()->SetCallBack(
+      "DBImpl:ScheduleTtlGC-mark-expired-blob",
+      [&](void* /*arg*/) { expired_blob_marks++; });
+  SyncPoint::GetInstance()->SetCallBack(
+      "DBImpl::BackgroundGarbageCollection:NonTrivial",
+      [&](void* /*arg*/) { gc_runs++; });
+
+  // Not expired yet
+  dbfull()->TEST_WaitForStatsDumpRun(
+      [&] { mock_env_->set_current_time(ttl / 2); });
+  ASSERT_EQ(0, expired_blob_marks);
+
+  dbfull()->TEST_WaitForStatsDumpRun(
+      [&] { mock_env_->set_current_time(ttl); });
+  // Only the blob sst knows the values expired
+  ASSERT_EQ(1, expired_blob_marks);
+  ASSERT_OK(dbfull()->TEST_WaitForCompact());
+
+  // The blob sst went away with its last reference, GC never read it
+  ASSERT_EQ(0U, blob_count());
+  ASSERT_EQ(0, gc_runs);
+  for (int i = 0; i < 100; i++) {
+    ASSERT_EQ("NOT_FOUND", Get(Key(i)));
+  }
+  SyncPoint::GetInstance()->ClearCallBack(
+      "DBImpl:ScheduleTtlGC-mark-expired-blob");
+  SyncPoint::GetInstance()->ClearCallBack(
+      "DBImpl::BackgroundGarbageCollection:NonTrivial");
+}
+
 #ifdef TERARK_ZIP
 TEST_F(DBImplGCTTL_Test, TerarkTableTest) {
   init();
@@ -13,6 +13,8 @@
 #endif
 #include <inttypes.h>
 
+#include <queue>
+
 #include "db/builder.h"
 #include "db/error_handler.h"
 #include "db/map_builder.h"
@@ -108,6 +110,17 @@ DBOptions SanitizeOptions(const std::string& dbname, const DBOptions& src) {
     result.wal_recovery_mode = WALRecoveryMode::kTolerateCorruptedTailRecords;
   }
 
+  if (result.wal_streams < 1) {
+    result.wal_streams = 1;
+  }
+  if (result.wal_streams > 1) {
+    // The logs of all the streams are created together on a memtable switch,
+    // a pre-created log would be numbered before the streams of the current
+    // one
+    result.recycle_log_file_num = 0;
+    result.prepare_log_writer_num = 0;
+  }
+
   if (result.recycle_log_file_num && result.prepare_log_writer_num) {
     result.recycle_log_file_num =
         std::max(result.prepare_log_writer_num, result.recycle_log_file_num);
@@ -239,8 +252,157 @@ static Status ValidateOptions(
     return Status::InvalidArgument("keep_log_file_num must be greater than 0");
   }
 
+  if (db_options.wal_streams > 1) {
+    if (!db_options.allow_concurrent_memtable_write) {
+      return Status::InvalidArgument(
+          "wal_streams > 1 requires allow_concurrent_memtable_write");
+    }
+    if (db_options.enable_pipelined_write || db_options.two_write_queues ||
+        db_options.manual_wal_flush || db_options.allow_2pc ||
+        db_options.allow_mmap_writes) {
+      return Status::NotSupported(
+          "wal_streams > 1 is not compatible with enable_pipelined_write, "
+          "two_write_queues, manual_wal_flush, allow_2pc or "
+          "allow_mmap_writes");
+    }
+#ifndef ROCKSDB_LITE
+    if (db_options.wal_filter != nullptr) {
+      return Status::NotSupported("wal_streams > 1 is not compatible with "
+                                  "wal_filter");
+    }
+#endif  // ROCKSDB_LITE
+  }
+
+  if (db_options.enable_async_wal_sync &&
+      (db_options.enable_pipelined_write || db_options.two_write_queues ||
+       db_options.manual_wal_flush || db_options.allow_mmap_writes ||
+       db_options.wal_streams > 1)) {
+    return Status::NotSupported(
+        "enable_async_wal_sync is not compatible with enable_pipelined_write, "
+        "two_write_queues, manual_wal_flush, allow_mmap_writes or "
+        "wal_streams > 1");
+  }
+
   return Status::OK();
 }
+
+// Inserts groups of WAL batches into the memtables with concurrent memtable
+// writes, so that the recovery thread can read and checksum the next group
+// meanwhile. Each batch carries its own sequence number, so the order in
+// which the workers insert them doesn't matter.
+class ParallelWalReplay {
+ public:
+  // Size of the batches read before the group is handed to the workers
+  static const size_t kGroupSize = 4 << 20;
+
+  ParallelWalReplay(DBImpl* db, ColumnFamilySet* column_family_set,
+                    FlushScheduler* flush_scheduler, int num_threads,
+                    bool batch_per_txn)
+      : db_(db),
+        column_family_set_(column_family_set),
+        flush_scheduler_(flush_scheduler),
+        num_threads_(num_threads),
+        batch_per_txn_(batch_per_txn),
+        pending_size_(0),
+        log_number_(0),
+        next_batch_(0) {}
+
+  ~ParallelWalReplay() {
+    for (auto& t : threads_) {
+      t.join();
+    }
+  }
+
+  // Queue a record of the current log, return true if the pending group is
+  // large enough to be submitted
+  bool Add(const Slice& record) {
+    pending_.emplace_back();
+    WriteBatchInternal::SetContents(&pending_.back().batch, record);
+    pending_size_ += record.size();
+    return pending_size_ >= kGroupSize;
+  }
+
+  bool HasPending() const { return !pending_.empty(); }
+
+  void ClearPending() {
+    pending_.clear();
+    pending_size_ = 0;
+  }
+
+  // Start inserting the pending group. REQUIRES: the previous group has
+  // been waited for
+  void Submit(uint64_t log_number) {
+    assert(threads_.empty());
+    TEST_SYNC_POINT_CALLBACK("ParallelWalReplay::Submit", &pending_size_);
+    running_.swap(pending_);
+    ClearPending();
+    log_number_ = log_number;
+    next_batch_.store(0, std::memory_order_relaxed);
+    size_t num_threads =
+        std::min<size_t>(num_threads_, running_.size());
+    for (size_t i = 0; i < num_threads; i++) {
+      threads_.emplace_back([this] { InsertBatches(); });
+    }
+  }
+
+  // Wait for the running group. Returns the status of the first failed
+  // batch and its size in *failed_size, sets *next_sequence past the last
+  // batch of the group.
+  Status Wait(SequenceNumber* next_sequence, bool* has_valid_writes,
+              size_t* failed_size) {
+    for (auto& t : threads_) {
+      t.join();
+    }
+    threads_.clear();
+    Status s;
+    for (auto& b : running_) {
+      *has_valid_writes |= b.has_valid_writes;
+      if (s.ok() && !b.status.ok()) {
+        s = b.status;
+        *failed_size = WriteBatchInternal::ByteSize(&b.batch);
+      }
+    }
+    if (!running_.empty()) {
+      *next_sequence = running_.back().next_sequence;
+    }
+    running_.clear();
+    return s;
+  }
+
+ private:
+  struct Batch {
+    WriteBatch batch;
+    SequenceNumber next_sequence = 0;
+    bool has_valid_writes = false;
+    Status status;
+  };
+
+  void InsertBatches() {
+    ColumnFamilyMemTablesImpl column_family_memtables(column_family_set_);
+    for (size_t i = next_batch_.fetch_add(1, std::memory_order_relaxed);
+         i < running_.size();
+         i = next_batch_.fetch_add(1, std::memory_order_relaxed)) {
+      Batch& b = running_[i];
+      b.status = WriteBatchInternal::InsertInto(
+          &b.batch, &column_family_memtables, flush_scheduler_, true,
+          log_number_, db_, true /* concurrent_memtable_writes */,
+          &b.next_sequence, &b.has_valid_writes, false /* seq_per_batch */,
+          batch_per_txn_);
+    }
+  }
+
+  DBImpl* db_;
+  ColumnFamilySet* column_family_set_;
+  FlushScheduler* flush_scheduler_;
+  const size_t num_threads_;
+  const bool batch_per_txn_;
+  std::vector<Batch> pending_;
+  size_t pending_size_;
+  std::vector<Batch> running_;
+  uint64_t log_number_;
+  std::atomic<size_t> next_batch_;
+  std::vector<port::Thread> threads_;
+};
 }  // namespace
 Status DBImpl::NewDB() {
   VersionEdit new_db;
@@ -407,7 +569,21 @@ Status DBImpl::Recover(
     }
   }
 
+  uint64_t manifest_start_micros = env_->NowMicros();
   Status s = versions_->Recover(column_families, read_only);
+  if (s.ok()) {
+    const auto& stats = versions_->recovery_stats();
+    event_logger_.Log() << "event"
+                        << "manifest_recovered"
+                        << "manifest_file_number"
+                        << versions_->manifest_file_number() << "num_edits"
+                        << stats.num_edits << "read_micros" << stats.read_micros
+                        << "apply_micros" << stats.apply_micros
+                        << "load_table_micros" << stats.load_table_micros
+                        << "save_to_micros" << stats.save_to_micros
+                        << "total_micros"
+                        << env_->NowMicros() - manifest_start_micros;
+  }
 
   if (immutable_db_options_.paranoid_checks && s.ok()) {
     s = CheckConsistency(read_only);
@@ -640,24 +816,26 @@ Status DBImpl::InitPersistStatsColumnFamily() {
   return s;
 }
 
+namespace {
+struct LogReporter : public log::Reader::Reporter {
+  Env* env;
+  Logger* info_log;
+  const char* fname;
+  Status* status;  // nullptr if immutable_db_options_.paranoid_checks==false
+  virtual void Corruption(size_t bytes, const Status& s) override {
+    ROCKS_LOG_WARN(info_log, "%s%s: dropping %d bytes; %s",
+                   (this->status == nullptr ? "(ignoring error) " : ""),
+                   fname, static_cast<int>(bytes), s.ToString().c_str());
+    if (this->status != nullptr && this->status->ok()) {
+      *this->status = s;
+    }
+  }
+};
+}  // namespace
+
 // REQUIRES: log_numbers are sorted in ascending order
 Status DBImpl::RecoverLogFiles(const std::vector<uint64_t>& log_numbers,
                                SequenceNumber* next_sequence, bool read_only) {
-  struct LogReporter : public log::Reader::Reporter {
-    Env* env;
-    Logger* info_log;
-    const char* fname;
-    Status* status;  // nullptr if immutable_db_options_.paranoid_checks==false
-    virtual void Corruption(size_t bytes, const Status& s) override {
-      ROCKS_LOG_WARN(info_log, "%s%s: dropping %d bytes; %s",
-                     (this->status == nullptr ? "(ignoring error) " : ""),
-                     fname, static_cast<int>(bytes), s.ToString().c_str());
-      if (this->status != nullptr && this->status->ok()) {
-        *this->status = s;
-      }
-    }
-  };
-
   mutex_.AssertHeld();
   Status status;
   std::unordered_map<int, VersionEdit> version_edits;
@@ -668,6 +846,7 @@ Status DBImpl::RecoverLogFiles(const std::vector<uint64_t>& log_numbers,
     version_edits.insert({cfd->GetID(), edit});
   }
   int job_id = next_job_id_.fetch_add(1);
+  uint64_t recovery_start_micros = env_->NowMicros();
   {
     auto stream = event_logger_.Log();
     stream << "job" << job_id << "event"
@@ -695,15 +874,47 @@ Status DBImpl::RecoverLogFiles(const std::vector<uint64_t>& log_numbers,
   }
 #endif
 
+  // The logs of the WAL streams interleave their sequences, so they are
+  // replayed together instead of one after the other
+  const bool replay_wal_streams = immutable_db_options_.wal_streams > 1;
+  std::unique_ptr<ParallelWalReplay> parallel_replay;
+  if (immutable_db_options_.wal_recovery_threads > 1 && !replay_wal_streams &&
+      immutable_db_options_.allow_concurrent_memtable_write &&
+#ifndef ROCKSDB_LITE
+      immutable_db_options_.wal_filter == nullptr &&
+#endif  // ROCKSDB_LITE
+      !immutable_db_options_.allow_2pc && !seq_per_batch_) {
+    parallel_replay.reset(new ParallelWalReplay(
+        this, versions_->GetColumnFamilySet(), &flush_scheduler_,
+        immutable_db_options_.wal_recovery_threads, batch_per_txn_));
+  }
+
   bool stop_replay_by_wal_filter = false;
   bool stop_replay_for_corruption = false;
   bool flushed = false;
   uint64_t corrupted_log_number = kMaxSequenceNumber;
   std::vector<SequenceNumber> log_seqs;
   log_seqs.resize(log_numbers.size(), kMaxSequenceNumber);
-  for (size_t log_it = 0; log_it < log_numbers.size(); ++log_it) {
+  if (replay_wal_streams) {
+    status = ReplayWalStreams(log_numbers, next_sequence, read_only, job_id,
+                              &version_edits, &log_seqs, &flushed,
+                              &stop_replay_for_corruption,
+                              &corrupted_log_number);
+    if (!status.ok()) {
+      return status;
+    }
+  }
+  const size_t serial_log_count = replay_wal_streams ? 0 : log_numbers.size();
+  // The highest batch sequence of the logs before log_number. A lower one
+  // means that the logs were written by several WAL streams.
+  SequenceNumber prev_logs_max_sequence = 0;
+  SequenceNumber log_max_sequence = 0;
+  for (size_t log_it = 0; log_it < serial_log_count; ++log_it) {
     uint64_t log_number = log_numbers[log_it];
     uint64_t& log_seq = log_seqs[log_it];
+    prev_logs_max_sequence =
+        std::max(prev_logs_max_sequence, log_max_sequence);
+    log_max_sequence = 0;
     if (log_number < versions_->min_log_number_to_keep_2pc()) {
       ROCKS_LOG_INFO(immutable_db_options_.info_log,
                      "Skipping log #%" PRIu64
@@ -772,6 +983,78 @@ Status DBImpl::RecoverLogFiles(const std::vector<uint64_t>& log_numbers,
                        &reporter, true /*checksum*/, log_number,
                        false /* retry_after_eof */);
 
+    // Flush the memtables which became full while inserting
+    auto flush_full_memtables = [&]() -> Status {
+      // we can do this because this is called before client has access to the
+      // DB and there is only a single thread operating on DB
+      ColumnFamilyData* cfd;
+
+      while ((cfd = flush_scheduler_.TakeNextColumnFamily()) != nullptr) {
+        cfd->Unref();
+        // If this asserts, it means that InsertInto failed in
+        // filtering updates to already-flushed column families
+        assert(cfd->GetLogNumber() <= log_number);
+        auto iter = version_edits.find(cfd->GetID());
+        assert(iter != version_edits.end());
+        VersionEdit* edit = &iter->second;
+        Status s = WriteLevel0TableForRecovery(job_id, cfd, cfd->mem(), edit);
+        if (!s.ok()) {
+          return s;
+        }
+        flushed = true;
+
+        cfd->CreateNewMemtable(*cfd->GetLatestMutableCFOptions(),
+                               /* needs_dup_key_check */ false,
+                               *next_sequence);
+      }
+      return Status::OK();
+    };
+
+    // Wait until the running group of parallel_replay is in the memtables.
+    // An insert error is handled like in the sequential replay below, except
+    // that the following batches of the group are already inserted.
+    bool parallel_replay_failed = false;
+    auto wait_parallel_replay = [&]() -> Status {
+      bool has_valid_writes = false;
+      size_t failed_size = 0;
+      Status s = parallel_replay->Wait(next_sequence, &has_valid_writes,
+                                       &failed_size);
+      if (!s.ok()) {
+        status = s;
+        MaybeIgnoreError(&status);
+        if (!status.ok()) {
+          reporter.Corruption(failed_size, status);
+          parallel_replay_failed = true;
+        }
+      }
+      if (has_valid_writes && !read_only) {
+        return flush_full_memtables();
+      }
+      return Status::OK();
+    };
+
+    // Insert all the batches queued in parallel_replay. They were read
+    // before a reading error in status, if any, so they are still inserted
+    // unless a previous batch failed.
+    auto drain_parallel_replay = [&]() -> Status {
+      Status s;
+      if (!parallel_replay_failed) {
+        Status read_status = status;
+        status = Status::OK();
+        s = wait_parallel_replay();
+        if (s.ok() && !parallel_replay_failed &&
+            parallel_replay->HasPending()) {
+          parallel_replay->Submit(log_number);
+          s = wait_parallel_replay();
+        }
+        if (status.ok()) {
+          status = read_status;
+        }
+      }
+      parallel_replay->ClearPending();
+      return s;
+    };
+
     // Determine if we should tolerate incomplete records at the tail end of the
     // Read all the records and add to a memtable
     std::string scratch;
@@ -810,6 +1093,18 @@ Status DBImpl::RecoverLogFiles(const std::vector<uint64_t>& log_numbers,
         }
       }
 
+      // The batches after a corruption may be out of order when skipped
+      if (immutable_db_options_.wal_recovery_mode !=
+          WALRecoveryMode::kSkipAnyCorruptedRecords) {
+        if (sequence < prev_logs_max_sequence) {
+          return Status::InvalidArgument(
+              "Log #" + ToString(log_number) +
+                  " was written by several WAL streams",
+              "reopen with wal_streams > 1");
+        }
+        log_max_sequence = std::max(log_max_sequence, sequence);
+      }
+
 #ifndef ROCKSDB_LITE
       if (immutable_db_options_.wal_filter != nullptr) {
         WriteBatch new_batch;
@@ -887,6 +1182,31 @@ Status DBImpl::RecoverLogFiles(const std::vector<uint64_t>& log_numbers,
       }
 #endif  // ROCKSDB_LITE
 
+      if (parallel_replay != nullptr) {
+        // Merges are not supported by concurrent memtable writes
+        if (!batch.HasMerge()) {
+          if (parallel_replay->Add(record)) {
+            // Flushes must not run concurrently with the inserts, so the
+            // previous group is finished before submitting this one
+            Status s = wait_parallel_replay();
+            if (!s.ok()) {
+              return s;
+            }
+            if (status.ok()) {
+              parallel_replay->Submit(log_number);
+            }
+          }
+          continue;
+        }
+        Status s = drain_parallel_replay();
+        if (!s.ok()) {
+          return s;
+        }
+        if (!status.ok()) {
+          break;
+        }
+      }
+
       // If column family was not found, it might mean that the WAL write
       // batch references to the column family that was dropped after the
       // insert. We don't want to fail the whole write batch in that case --
@@ -906,33 +1226,24 @@ Status DBImpl::RecoverLogFiles(const std::vector<uint64_t>& log_numbers,
       }
 
       if (has_valid_writes && !read_only) {
-        // we can do this because this is called before client has access to the
-        // DB and there is only a single thread operating on DB
-        ColumnFamilyData* cfd;
-
-        while ((cfd = flush_scheduler_.TakeNextColumnFamily()) != nullptr) {
-          cfd->Unref();
-          // If this asserts, it means that InsertInto failed in
-          // filtering updates to already-flushed column families
-          assert(cfd->GetLogNumber() <= log_number);
-          auto iter = version_edits.find(cfd->GetID());
-          assert(iter != version_edits.end());
-          VersionEdit* edit = &iter->second;
-          status = WriteLevel0TableForRecovery(job_id, cfd, cfd->mem(), edit);
-          if (!status.ok()) {
-            // Reflect errors immediately so that conditions like full
-            // file-systems cause the DB::Open() to fail.
-            return status;
-          }
-          flushed = true;
-
-          cfd->CreateNewMemtable(*cfd->GetLatestMutableCFOptions(),
-                                 /* needs_dup_key_check */ false,
-                                 *next_sequence);
+        status = flush_full_memtables();
+        if (!status.ok()) {
+          // Reflect errors immediately so that conditions like full
+          // file-systems cause the DB::Open() to fail.
+          return status;
         }
       }
     }
 
+    if (parallel_replay != nullptr) {
+      Status s = drain_parallel_replay();
+      if (!s.ok()) {
+        // Reflect errors immediately so that conditions like full
+        // file-systems cause the DB::Open() to fail.
+        return s;
+      }
+    }
+
     if (!status.ok()) {
       if (status.IsNotSupported()) {
         // We should not treat NotSupported as corruption. It is rather a clear
@@ -1063,11 +1374,229 @@ Status DBImpl::RecoverLogFiles(const std::vector<uint64_t>& log_numbers,
   }
 
   event_logger_.Log() << "job" << job_id << "event"
-                      << "recovery_finished";
+                      << "recovery_finished"
+                      << "recovery_micros"
+                      << env_->NowMicros() - recovery_start_micros;
 
   return status;
 }
 
+Status DBImpl::ReplayWalStreams(
+    const std::vector<uint64_t>& log_numbers, SequenceNumber* next_sequence,
+    bool read_only, int job_id,
+    std::unordered_map<int, VersionEdit>* version_edits,
+    std::vector<SequenceNumber>* log_seqs, bool* flushed,
+    bool* stop_replay_for_corruption, uint64_t* corrupted_log_number) {
+  mutex_.AssertHeld();
+  const auto recovery_mode = immutable_db_options_.wal_recovery_mode;
+  struct Source {
+    size_t log_it;
+    uint64_t number;
+    std::string fname;
+    LogReporter reporter;
+    Status status;
+    std::unique_ptr<log::Reader> reader;
+    std::string scratch;
+    WriteBatch batch;
+    size_t record_size = 0;
+    bool has_batch = false;
+    // Sequence of batch, or where a failed source is handled
+    SequenceNumber key = 0;
+  };
+  auto logFileDropped = [this](const std::string& fname) {
+    uint64_t bytes;
+    if (env_->GetFileSize(fname, &bytes).ok()) {
+      auto info_log = immutable_db_options_.info_log.get();
+      ROCKS_LOG_WARN(info_log, "%s: dropping %d bytes", fname.c_str(),
+                     static_cast<int>(bytes));
+    }
+  };
+  auto read_next = [&](Source* src) {
+    Slice record;
+    src->has_batch = false;
+    while (src->reader->ReadRecord(&record, &src->scratch, recovery_mode) &&
+           src->status.ok()) {
+      if (record.size() < WriteBatchInternal::kHeader) {
+        src->reporter.Corruption(record.size(),
+                                 Status::Corruption("log record too small"));
+        continue;
+      }
+      WriteBatchInternal::SetContents(&src->batch, record);
+      src->record_size = record.size();
+      src->has_batch = true;
+      src->key = WriteBatchInternal::Sequence(&src->batch);
+      SequenceNumber& log_seq = (*log_seqs)[src->log_it];
+      if (log_seq == kMaxSequenceNumber) {
+        assert(src->key > 0);
+        log_seq = std::max<SequenceNumber>(src->key, 1) - 1;
+      }
+      return;
+    }
+  };
+
+  std::vector<std::unique_ptr<Source>> sources;
+  for (size_t log_it = 0; log_it < log_numbers.size(); ++log_it) {
+    uint64_t log_number = log_numbers[log_it];
+    if (log_number < versions_->min_log_number_to_keep_2pc()) {
+      ROCKS_LOG_INFO(immutable_db_options_.info_log,
+                     "Skipping log #%" PRIu64
+                     " since it is older than min log to keep #%" PRIu64,
+                     log_number, versions_->min_log_number_to_keep_2pc());
+      continue;
+    }
+    versions_->MarkFileNumberUsed(log_number);
+    std::unique_ptr<Source> src(new Source);
+    src->log_it = log_it;
+    src->number = log_number;
+    src->fname = LogFileName(immutable_db_options_.wal_dir, log_number);
+    ROCKS_LOG_INFO(immutable_db_options_.info_log,
+                   "Recovering log #%" PRIu64 " mode %d", log_number,
+                   int(recovery_mode));
+
+    std::unique_ptr<SequentialFile> file;
+    Status s = env_->NewSequentialFile(src->fname, &file,
+                                       env_->OptimizeForLogRead(env_options_));
+    if (!s.ok()) {
+      MaybeIgnoreError(&s);
+      if (!s.ok()) {
+        return s;
+      }
+      continue;
+    }
+    src->reporter.env = env_;
+    src->reporter.info_log = immutable_db_options_.info_log.get();
+    src->reporter.fname = src->fname.c_str();
+    if (!immutable_db_options_.paranoid_checks ||
+        recovery_mode == WALRecoveryMode::kSkipAnyCorruptedRecords) {
+      src->reporter.status = nullptr;
+    } else {
+      src->reporter.status = &src->status;
+    }
+    std::unique_ptr<SequentialFileReader> file_reader(
+        new SequentialFileReader(std::move(file), src->fname));
+    src->reader.reset(new log::Reader(
+        immutable_db_options_.info_log, std::move(file_reader),
+        &src->reporter, true /*checksum*/, log_number,
+        false /* retry_after_eof */));
+    read_next(src.get());
+    sources.emplace_back(std::move(src));
+  }
+
+  // The logs of one generation interleave, a later generation starts after
+  // all of them. A file failing before its first batch is ordered after the
+  // first batches of the files before it.
+  auto greater = [](const Source* a, const Source* b) {
+    return a->key != b->key ? a->key > b->key : a->log_it > b->log_it;
+  };
+  std::priority_queue<Source*, std::vector<Source*>, decltype(greater)> heap(
+      greater);
+  SequenceNumber floor = 0;
+  for (auto& src : sources) {
+    if (src->has_batch) {
+      floor = std::max(floor, src->key);
+    } else {
+      src->key = floor;
+    }
+    if (src->has_batch || !src->status.ok()) {
+      heap.push(src.get());
+    }
+  }
+
+  // Flush the memtables which became full while inserting
+  auto flush_full_memtables = [&](uint64_t log_number) -> Status {
+    ColumnFamilyData* cfd;
+    while ((cfd = flush_scheduler_.TakeNextColumnFamily()) != nullptr) {
+      cfd->Unref();
+      assert(cfd->GetLogNumber() <= log_number);
+      (void)log_number;
+      auto iter = version_edits->find(cfd->GetID());
+      assert(iter != version_edits->end());
+      VersionEdit* edit = &iter->second;
+      Status s = WriteLevel0TableForRecovery(job_id, cfd, cfd->mem(), edit);
+      if (!s.ok()) {
+        return s;
+      }
+      *flushed = true;
+      cfd->CreateNewMemtable(*cfd->GetLatestMutableCFOptions(),
+                             /* needs_dup_key_check */ false, *next_sequence);
+    }
+    return Status::OK();
+  };
+
+  while (!heap.empty()) {
+    Source* src = heap.top();
+    heap.pop();
+    if (src->has_batch) {
+      if (recovery_mode == WALRecoveryMode::kPointInTimeRecovery) {
+        // See RecoverLogFiles
+        if (src->key == *next_sequence) {
+          *stop_replay_for_corruption = false;
+        }
+        if (*stop_replay_for_corruption) {
+          logFileDropped(src->fname);
+          continue;
+        }
+      }
+      bool has_valid_writes = false;
+      src->status = WriteBatchInternal::InsertInto(
+          &src->batch, column_family_memtables_.get(), &flush_scheduler_, true,
+          src->number, this, false /* concurrent_memtable_writes */,
+          next_sequence, &has_valid_writes, seq_per_batch_, batch_per_txn_);
+      MaybeIgnoreError(&src->status);
+      if (!src->status.ok()) {
+        src->reporter.Corruption(src->record_size, src->status);
+      } else {
+        if (has_valid_writes && !read_only) {
+          Status s = flush_full_memtables(src->number);
+          if (!s.ok()) {
+            return s;
+          }
+        }
+        read_next(src);
+        if (!src->has_batch) {
+          // A failure is handled once the batches before it are replayed
+          src->key = *next_sequence;
+        }
+        if (src->has_batch || !src->status.ok()) {
+          heap.push(src);
+        }
+        continue;
+      }
+    }
+
+    // Same as for a failed log in RecoverLogFiles
+    Status s = src->status;
+    assert(!s.ok());
+    if (s.IsNotSupported()) {
+      return s;
+    }
+    if (recovery_mode == WALRecoveryMode::kSkipAnyCorruptedRecords) {
+      continue;
+    } else if (recovery_mode == WALRecoveryMode::kPointInTimeRecovery) {
+      *stop_replay_for_corruption = true;
+      *corrupted_log_number = src->number;
+      ROCKS_LOG_INFO(immutable_db_options_.info_log,
+                     "Point in time recovered to log #%" PRIu64
+                     " seq #%" PRIu64,
+                     src->number, *next_sequence);
+    } else {
+      assert(recovery_mode == WALRecoveryMode::kTolerateCorruptedTailRecords ||
+             recovery_mode == WALRecoveryMode::kAbsoluteConsistency);
+      return s;
+    }
+  }
+
+  flush_scheduler_.Clear();
+  auto last_sequence = *next_sequence - 1;
+  if ((*next_sequence != kMaxSequenceNumber) &&
+      (versions_->LastSequence() <= last_sequence)) {
+    versions_->SetLastAllocatedSequence(last_sequence);
+    versions_->SetLastPublishedSequence(last_sequence);
+    versions_->SetLastSequence(last_sequence);
+  }
+  return Status::OK();
+}
+
 Status DBImpl::RestoreAliveLogFiles(
     const std::vector<uint64_t>& log_numbers,
     const std::vector<SequenceNumber>& log_seqs) {
@@ -1379,6 +1908,21 @@ Status DBImpl::Open(const DBOptions& db_options, const std::string& dbname,
                 impl->immutable_db_options_.recycle_log_file_num > 0,
                 impl->immutable_db_options_.manual_wal_flush));
       }
+      if (!impl->wal_streams_.empty()) {
+        std::vector<std::unique_ptr<log::Writer>> new_stream_logs;
+        s = impl->NewWalStreamLogWriters(
+            &new_stream_logs,
+            BuildDBOptions(impl->immutable_db_options_,
+                           impl->mutable_db_options_),
+            write_hint);
+        if (s.ok()) {
+          InstrumentedMutexLock wl(&impl->log_write_mutex_);
+          s = impl->InstallWalStreamLogWriters(
+              &new_stream_logs,
+              impl->GetWalPreallocateBlockSize(max_write_buffer_size),
+              impl->versions_->LastSequence());
+        }
+      }
 
       autovector<const ColumnFamilyOptions*> cf_options_list;
       autovector<const std::string*> column_family_name_list;
@@ -1473,6 +2017,9 @@ Status DBImpl::Open(const DBOptions& db_options, const std::string& dbname,
     *dbptr = impl;
     impl->opened_successfully_ = true;
     impl->MaybeScheduleFlushOrCompaction();
+    if (impl->immutable_db_options_.enable_async_wal_sync) {
+      impl->StartWalSyncThread();
+    }
   }
   impl->FillLogWriterPool();
   impl->mutex_.Unlock();
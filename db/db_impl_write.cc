@@ -19,6 +19,7 @@
 #include "options/options_helper.h"
 #include "rocksdb/metrics_reporter.h"
 #include "rocksdb/terark_namespace.h"
+#include "util/random.h"
 #include "util/sync_point.h"
 
 namespace TERARKDB_NAMESPACE {
@@ -120,6 +121,22 @@ Status DBImpl::WriteImpl(const WriteOptions& write_options,
                             log_ref, seq_used, batch_cnt, pre_release_callback);
   }
 
+  if (!wal_streams_.empty() && callback == nullptr && log_ref == 0 &&
+      !disable_memtable && pre_release_callback == nullptr &&
+      !write_options.disableWAL && !seq_per_batch_ && !my_batch->HasMerge() &&
+      !wal_streams_need_preprocess_.load(std::memory_order_relaxed)) {
+    // Writers stay on the stream of their core, index 0 is write_thread_
+    int core = port::PhysicalCoreID();
+    size_t index = core >= 0 ? static_cast<size_t>(core)
+                             : Random::GetTLSInstance()->Next();
+    index %= wal_streams_.size() + 1;
+    TEST_SYNC_POINT_CALLBACK("DBImpl::WriteImpl:WalStreamIndex", &index);
+    if (index > 0) {
+      return WalStreamWriteImpl(wal_streams_[index - 1].get(), write_options,
+                                my_batch, log_used, seq_used);
+    }
+  }
+
   if (immutable_db_options_.enable_pipelined_write) {
     return PipelinedWriteImpl(write_options, my_batch, callback, log_used,
                               log_ref, disable_memtable, seq_used);
@@ -168,7 +185,11 @@ Status DBImpl::WriteImpl(const WriteOptions& write_options,
       }
       // TODO(myabandeh): propagate status to write_group
       auto last_sequence = w.write_group->last_sequence;
-      versions_->SetLastSequence(last_sequence);
+      if (wal_streams_.empty()) {
+        versions_->SetLastSequence(last_sequence);
+      } else {
+        wal_stream_sequencer_.Publish(wal_stream_ticket_, last_sequence);
+      }
       MemTableInsertStatusCheck(w.status);
       write_thread_.ExitAsBatchGroupFollower(&w);
     }
@@ -185,6 +206,9 @@ Status DBImpl::WriteImpl(const WriteOptions& write_options,
       *seq_used = w.sequence;
     }
     // write is complete and leader has updated sequence
+    if (immutable_db_options_.enable_async_wal_sync) {
+      return WaitForWalSync(&w);
+    }
     return w.FinalStatus();
   }
   // else we are the leader of the write batch group
@@ -197,15 +221,19 @@ Status DBImpl::WriteImpl(const WriteOptions& write_options,
   WriteContext write_context(immutable_db_options_.info_log.get());
   WriteThread::WriteGroup write_group;
   bool in_parallel_group = false;
+  bool wal_stream_allocated = false;
+  bool wal_streams_stopped = false;
   uint64_t last_sequence = kMaxSequenceNumber;
-  if (!two_write_queues_) {
+  if (!two_write_queues_ && wal_streams_.empty()) {
     last_sequence = versions_->LastSequence();
   }
 
   mutex_.Lock();
 
-  bool need_log_sync = write_options.sync;
-  bool need_log_dir_sync = need_log_sync && !log_dir_synced_;
+  // With enable_async_wal_sync the group only requests a sync
+  bool need_log_sync =
+      write_options.sync && !immutable_db_options_.enable_async_wal_sync;
+  bool need_log_dir_sync = need_log_sync && !WalStreamsDirSynced();
   if (!two_write_queues_ || !disable_memtable) {
     // With concurrent writes we do preprocess only in the write thread that
     // also does write to memtable to avoid sync issue on shared data structure
@@ -248,12 +276,14 @@ Status DBImpl::WriteImpl(const WriteOptions& write_options,
     size_t total_count = 0;
     size_t valid_batches = 0;
     size_t total_byte_size = 0;
+    bool has_merge = false;
     for (auto* writer : write_group) {
       if (writer->CheckCallback(this)) {
         valid_batches += writer->batch_cnt;
         if (writer->ShouldWriteToMemtable()) {
           total_count += WriteBatchInternal::Count(writer->batch);
-          parallel = parallel && !writer->batch->HasMerge();
+          has_merge = has_merge || writer->batch->HasMerge();
+          parallel = parallel && !has_merge;
         }
 
         total_byte_size = WriteBatchInternal::AppendedByteSize(
@@ -268,7 +298,30 @@ Status DBImpl::WriteImpl(const WriteOptions& write_options,
     // the seq per valid written key to mem.
     size_t seq_inc = seq_per_batch_ ? valid_batches : total_count;
 
-    const bool concurrent_update = two_write_queues_;
+    if (!wal_streams_.empty()) {
+      // The secondary WAL streams write the memtables concurrently, which
+      // merges don't support
+      if (has_merge) {
+        mutex_.Lock();
+        if (need_log_sync) {
+          // A stream leader may be waiting for the logs this group is to
+          // sync, so they are taken again once the streams are stopped
+          CancelWalStreamsSync();
+          EnterWalStreamsUnbatched();
+          status = BeginWalStreamsSync();
+          assert(status.ok());
+        } else {
+          EnterWalStreamsUnbatched();
+        }
+        mutex_.Unlock();
+        wal_streams_stopped = true;
+      }
+      last_sequence =
+          wal_stream_sequencer_.Allocate(seq_inc, &wal_stream_ticket_);
+      wal_stream_allocated = true;
+    }
+
+    const bool concurrent_update = two_write_queues_ || !wal_streams_.empty();
     // Update stats while we are an exclusive group leader, so we know
     // that nobody else can be writing to these particular stats.
     // We're optimistic, updating the stats before we successfully
@@ -302,6 +355,13 @@ Status DBImpl::WriteImpl(const WriteOptions& write_options,
         status = WriteToWAL(write_group, log_writer, log_used, need_log_sync,
                             need_log_dir_sync, last_sequence + 1);
       }
+      if (wal_stream_allocated) {
+        wal_stream_sequencer_.MarkLogged(wal_stream_ticket_);
+        if (status.ok() && need_log_sync) {
+          PERF_TIMER_GUARD(write_wal_time);
+          status = SyncOtherWalStreams(nullptr, wal_stream_ticket_);
+        }
+      }
     } else {
       if (status.ok() && !write_options.disableWAL) {
         PERF_TIMER_GUARD(write_wal_time);
@@ -317,16 +377,21 @@ Status DBImpl::WriteImpl(const WriteOptions& write_options,
     assert(last_sequence != kMaxSequenceNumber);
     const SequenceNumber current_sequence = last_sequence + 1;
     last_sequence += seq_inc;
+    if (status.ok() && write_options.sync && seq_inc > 0 &&
+        immutable_db_options_.enable_async_wal_sync) {
+      RequestWalSync(last_sequence);
+    }
 
     if (status.ok()) {
       PERF_TIMER_GUARD(write_memtable_time);
 
       if (!parallel) {
+        bool concurrent = !wal_streams_.empty() && !wal_streams_stopped;
         // w.sequence will be set inside InsertInto
         w.status = WriteBatchInternal::InsertInto(
             write_group, current_sequence, column_family_memtables_.get(),
             &flush_scheduler_, write_options.ignore_missing_column_families,
-            0 /*recovery_log_number*/, this, parallel, seq_per_batch_,
+            0 /*recovery_log_number*/, this, concurrent, seq_per_batch_,
             batch_per_txn_);
       } else {
         SequenceNumber next_sequence = current_sequence;
@@ -377,6 +442,9 @@ Status DBImpl::WriteImpl(const WriteOptions& write_options,
   if (need_log_sync) {
     mutex_.Lock();
     MarkLogsSynced(logfile_number_, need_log_dir_sync, status);
+    for (auto& stream : wal_streams_) {
+      MarkWalStreamLogsSynced(stream.get(), need_log_dir_sync, status);
+    }
     mutex_.Unlock();
     // Requesting sync with two_write_queues_ is expected to be very rare. We
     // hence provide a simple implementation that is not necessarily efficient.
@@ -408,14 +476,29 @@ Status DBImpl::WriteImpl(const WriteOptions& write_options,
           }
         }
       }
-      versions_->SetLastSequence(last_sequence);
+      if (wal_streams_.empty()) {
+        versions_->SetLastSequence(last_sequence);
+      }
+    }
+    if (wal_stream_allocated) {
+      wal_stream_sequencer_.Publish(wal_stream_ticket_, last_sequence);
+    }
+    if (wal_streams_stopped) {
+      mutex_.Lock();
+      ExitWalStreamsUnbatched();
+      mutex_.Unlock();
     }
     MemTableInsertStatusCheck(w.status);
     write_thread_.ExitAsBatchGroupLeader(write_group, status);
   }
 
   if (status.ok()) {
-    status = w.FinalStatus();
+    if (immutable_db_options_.enable_async_wal_sync) {
+      // Outside of the write group, so that the next group can append
+      status = WaitForWalSync(&w);
+    } else {
+      status = w.FinalStatus();
+    }
   }
   return status;
 }
@@ -719,6 +802,14 @@ Status DBImpl::PreprocessWrite(const WriteOptions& write_options,
     status = error_handler_.GetBGError();
   }
 
+  // The secondary WAL streams skip this, they are stopped while flushes are
+  // scheduled and while writes are delayed
+  bool wal_streams_stopped = false;
+  if (!wal_streams_.empty() && WalStreamsNeedPreprocess()) {
+    EnterWalStreamsUnbatched();
+    wal_streams_stopped = true;
+  }
+
   PERF_TIMER_GUARD(write_scheduling_flushes_compactions_time);
 
   assert(!single_column_family_mode_ ||
@@ -739,11 +830,16 @@ Status DBImpl::PreprocessWrite(const WriteOptions& write_options,
   }
 
   if (UNLIKELY(status.ok() && !single_column_family_mode_ &&
-               alive_log_files_.back().size > GetMaxWalSize())) {
+               GetCurrentWalSize() > GetMaxWalSize())) {
     status = HandleMaxWalSize(write_context);
   }
 
   if (UNLIKELY(status.ok() && !flush_scheduler_.Empty())) {
+    if (!wal_streams_.empty() && !wal_streams_stopped) {
+      // Filled by a stream meanwhile
+      EnterWalStreamsUnbatched();
+      wal_streams_stopped = true;
+    }
     status = ScheduleFlushes(write_context);
   }
 
@@ -762,7 +858,19 @@ Status DBImpl::PreprocessWrite(const WriteOptions& write_options,
     PERF_TIMER_START(write_pre_and_post_process_time);
   }
 
-  if (status.ok() && *need_log_sync) {
+  if (!wal_streams_.empty()) {
+    wal_streams_need_preprocess_.store(false, std::memory_order_relaxed);
+    if (wal_streams_stopped) {
+      ExitWalStreamsUnbatched();
+    }
+  }
+
+  if (status.ok() && *need_log_sync && !wal_streams_.empty()) {
+    status = BeginWalStreamsSync();
+    if (!status.ok()) {
+      *need_log_sync = false;
+    }
+  } else if (status.ok() && *need_log_sync) {
     // Wait until the parallel syncs are finished. Any sync process has to sync
     // the front log too so it is enough to check the status of front()
     // We do a while loop since log_sync_cv_ is signalled when any sync is
@@ -987,6 +1095,446 @@ Status DBImpl::ConcurrentWriteToWAL(const WriteThread::WriteGroup& write_group,
   return status;
 }
 
+Status DBImpl::WalStreamWriteImpl(WalStream* stream,
+                                  const WriteOptions& write_options,
+                                  WriteBatch* my_batch, uint64_t* log_used,
+                                  uint64_t* seq_used) {
+  PERF_TIMER_GUARD(write_pre_and_post_process_time);
+  WriteThread::Writer w(write_options, my_batch, nullptr /*callback*/,
+                        0 /*log_ref*/, false /*disable_memtable*/);
+  RecordTick(stats_, WRITE_WITH_WAL);
+  StopWatch write_sw(env_, immutable_db_options_.statistics.get(), DB_WRITE);
+
+  stream->write_thread.JoinBatchGroup(&w);
+  if (w.state == WriteThread::STATE_COMPLETED) {
+    if (log_used != nullptr) {
+      *log_used = w.log_used;
+    }
+    if (seq_used != nullptr) {
+      *seq_used = w.sequence;
+    }
+    return w.FinalStatus();
+  }
+  assert(w.state == WriteThread::STATE_GROUP_LEADER);
+
+  Status status;
+  mutex_.Lock();
+  if (error_handler_.IsDBStopped()) {
+    status = error_handler_.GetBGError();
+  }
+  if (WalStreamsNeedPreprocess()) {
+    // Served by the next write of write_thread_, this one goes on since it
+    // can't stop the other streams
+    wal_streams_need_preprocess_.store(true, std::memory_order_relaxed);
+  }
+  bool need_log_sync = write_options.sync && status.ok();
+  bool need_log_dir_sync = need_log_sync && !WalStreamsDirSynced();
+  if (need_log_sync) {
+    status = BeginWalStreamsSync();
+    need_log_sync = status.ok();
+  }
+  // The main log synced by this group, logs_ doesn't change while a stream
+  // is writing
+  const uint64_t main_log_number = logfile_number_;
+  log::Writer* log_writer = stream->logs.back().writer;
+  uint64_t log_number = stream->logs.back().number;
+  mutex_.Unlock();
+
+  WriteThread::WriteGroup write_group;
+  stream->write_thread.EnterAsBatchGroupLeader(&w, &write_group);
+
+  size_t total_count = 0;
+  size_t total_byte_size = 0;
+  for (auto* writer : write_group) {
+    total_count += WriteBatchInternal::Count(writer->batch);
+    total_byte_size = WriteBatchInternal::AppendedByteSize(
+        total_byte_size, WriteBatchInternal::ByteSize(writer->batch));
+  }
+  const bool concurrent = true;
+  auto stats = default_cf_internal_stats_;
+  stats->AddDBStats(InternalStats::NUMBER_KEYS_WRITTEN, total_count,
+                    concurrent);
+  RecordTick(stats_, NUMBER_KEYS_WRITTEN, total_count);
+  stats->AddDBStats(InternalStats::BYTES_WRITTEN, total_byte_size, concurrent);
+  RecordTick(stats_, BYTES_WRITTEN, total_byte_size);
+  stats->AddDBStats(InternalStats::WRITE_DONE_BY_SELF, 1, concurrent);
+  RecordTick(stats_, WRITE_DONE_BY_SELF);
+  auto write_done_by_other = write_group.size - 1;
+  if (write_done_by_other > 0) {
+    stats->AddDBStats(InternalStats::WRITE_DONE_BY_OTHER, write_done_by_other,
+                      concurrent);
+    RecordTick(stats_, WRITE_DONE_BY_OTHER, write_done_by_other);
+  }
+  MeasureTime(stats_, BYTES_PER_WRITE, total_byte_size);
+
+  uint64_t ticket;
+  SequenceNumber last_sequence =
+      wal_stream_sequencer_.Allocate(total_count, &ticket);
+  const SequenceNumber current_sequence = last_sequence + 1;
+  last_sequence += total_count;
+  PERF_TIMER_STOP(write_pre_and_post_process_time);
+
+  if (status.ok()) {
+    PERF_TIMER_GUARD(write_wal_time);
+    size_t write_with_wal = 0;
+    WriteBatch* to_be_cached_state = nullptr;
+    WriteBatch* merged_batch = MergeBatch(write_group, &stream->tmp_batch,
+                                          &write_with_wal, &to_be_cached_state);
+    assert(to_be_cached_state == nullptr);
+    for (auto* writer : write_group) {
+      writer->log_used = log_number;
+    }
+    WriteBatchInternal::SetSequence(merged_batch, current_sequence);
+    Slice log_entry = WriteBatchInternal::Contents(merged_batch);
+    status = log_writer->AddRecord(log_entry);
+    wal_stream_sequencer_.MarkLogged(ticket);
+    total_log_size_ += log_entry.size();
+    stream->log_size.fetch_add(log_entry.size(), std::memory_order_relaxed);
+    stream->tmp_batch.Clear();
+
+    if (status.ok() && need_log_sync) {
+      StopWatch sw(env_, stats_, WAL_FILE_SYNC_MICROS);
+      // Safe without mutex_ for the same reasons as in WriteToWAL
+      for (auto& log : stream->logs) {
+        auto f = log.writer->file();
+        if (f != nullptr) {
+          status = f->Sync(immutable_db_options_.use_fsync);
+        }
+        if (!status.ok()) {
+          break;
+        }
+      }
+      if (status.ok() && need_log_dir_sync) {
+        status = directories_.GetWalDir()->Fsync();
+      }
+      if (status.ok()) {
+        status = SyncOtherWalStreams(stream, ticket);
+      }
+    }
+    if (status.ok()) {
+      if (need_log_sync) {
+        stats->AddDBStats(InternalStats::WAL_FILE_SYNCED, 1, concurrent);
+        RecordTick(stats_, WAL_FILE_SYNCED);
+      }
+      stats->AddDBStats(InternalStats::WAL_FILE_BYTES, log_entry.size(),
+                        concurrent);
+      RecordTick(stats_, WAL_FILE_BYTES, log_entry.size());
+      stats->AddDBStats(InternalStats::WRITE_WITH_WAL, write_with_wal,
+                        concurrent);
+      RecordTick(stats_, WRITE_WITH_WAL, write_with_wal);
+    }
+  }
+
+  if (status.ok()) {
+    PERF_TIMER_GUARD(write_memtable_time);
+    ColumnFamilyMemTablesImpl column_family_memtables(
+        versions_->GetColumnFamilySet());
+    w.status = WriteBatchInternal::InsertInto(
+        write_group, current_sequence, &column_family_memtables,
+        &flush_scheduler_, write_options.ignore_missing_column_families,
+        0 /*recovery_log_number*/, this, true /*concurrent_memtable_writes*/,
+        false /*seq_per_batch*/, batch_per_txn_);
+  }
+  PERF_TIMER_START(write_pre_and_post_process_time);
+
+  WriteStatusCheck(status);
+  // Also on failure, the later tickets wait for this one
+  wal_stream_sequencer_.Publish(ticket, last_sequence);
+
+  if (need_log_sync) {
+    mutex_.Lock();
+    MarkLogsSynced(main_log_number, need_log_dir_sync, status);
+    for (auto& s : wal_streams_) {
+      MarkWalStreamLogsSynced(s.get(), need_log_dir_sync, status);
+    }
+    mutex_.Unlock();
+  }
+
+  MemTableInsertStatusCheck(w.status);
+  stream->write_thread.ExitAsBatchGroupLeader(write_group, status);
+
+  if (status.ok()) {
+    status = w.FinalStatus();
+  }
+  if (log_used != nullptr) {
+    *log_used = w.log_used;
+  }
+  if (seq_used != nullptr) {
+    *seq_used = w.sequence;
+  }
+  return status;
+}
+
+void DBImpl::EnterWalStreamsUnbatched() {
+  mutex_.AssertHeld();
+  if (wal_streams_stopped_++ > 0) {
+    return;
+  }
+  for (auto& stream : wal_streams_) {
+    // A writer can't enter twice
+    stream->unbatched_writer.reset(new WriteThread::Writer);
+    stream->write_thread.EnterUnbatched(stream->unbatched_writer.get(),
+                                        &mutex_);
+  }
+}
+
+void DBImpl::ExitWalStreamsUnbatched() {
+  mutex_.AssertHeld();
+  assert(wal_streams_stopped_ > 0);
+  if (--wal_streams_stopped_ > 0) {
+    return;
+  }
+  for (auto& stream : wal_streams_) {
+    stream->write_thread.ExitUnbatched(stream->unbatched_writer.get());
+    stream->unbatched_writer.reset();
+  }
+}
+
+bool DBImpl::WalStreamsNeedPreprocess() {
+  mutex_.AssertHeld();
+  // Mirrors the checks of PreprocessWrite
+  if (!single_column_family_mode_ &&
+      total_log_size_ > GetMaxTotalWalSize() &&
+      !alive_log_files_.begin()->getting_flushed) {
+    return true;
+  }
+  if (write_buffer_manager_->ShouldFlush()) {
+    return true;
+  }
+  if (!single_column_family_mode_ &&
+      GetCurrentWalSize() > GetMaxWalSize()) {
+    return true;
+  }
+  return !flush_scheduler_.Empty() || write_controller_.IsStopped() ||
+         write_controller_.NeedsDelay();
+}
+
+Status DBImpl::BeginWalStreamsSync() {
+  mutex_.AssertHeld();
+  auto getting_synced = [&] {
+    if (logs_.front().getting_synced) {
+      return true;
+    }
+    for (auto& stream : wal_streams_) {
+      if (stream->logs.front().getting_synced) {
+        return true;
+      }
+    }
+    return false;
+  };
+  while (getting_synced()) {
+    log_sync_cv_.Wait();
+  }
+  // The logs of the other queues are synced while they are written
+  bool thread_safe = true;
+  auto check_sync_thread_safe = [&](const std::deque<LogWriterNumber>& logs) {
+    for (auto& log : logs) {
+      if (!log.writer->file()->writable_file()->IsSyncThreadSafe()) {
+        thread_safe = false;
+      }
+    }
+  };
+  check_sync_thread_safe(logs_);
+  for (auto& stream : wal_streams_) {
+    check_sync_thread_safe(stream->logs);
+  }
+  if (!thread_safe) {
+    return Status::NotSupported(
+        "Sync writes with wal_streams > 1 are not supported for this "
+        "implementation of WAL file");
+  }
+  for (auto& log : logs_) {
+    assert(!log.getting_synced);
+    log.getting_synced = true;
+  }
+  for (auto& stream : wal_streams_) {
+    for (auto& log : stream->logs) {
+      assert(!log.getting_synced);
+      log.getting_synced = true;
+    }
+  }
+  return Status::OK();
+}
+
+void DBImpl::CancelWalStreamsSync() {
+  mutex_.AssertHeld();
+  for (auto& log : logs_) {
+    assert(log.getting_synced);
+    log.getting_synced = false;
+  }
+  for (auto& stream : wal_streams_) {
+    for (auto& log : stream->logs) {
+      assert(log.getting_synced);
+      log.getting_synced = false;
+    }
+  }
+  log_sync_cv_.SignalAll();
+}
+
+bool DBImpl::WalStreamsDirSynced() const {
+  mutex_.AssertHeld();
+  bool synced = log_dir_synced_;
+  for (auto& stream : wal_streams_) {
+    synced = synced && stream->log_dir_synced;
+  }
+  return synced;
+}
+
+Status DBImpl::SyncOtherWalStreams(const WalStream* own_stream,
+                                   uint64_t ticket) {
+  StopWatch sw(env_, stats_, WAL_FILE_SYNC_MICROS);
+  // A write of another queue may be logged but not yet synced by its group
+  wal_stream_sequencer_.WaitLogged(ticket);
+  TEST_SYNC_POINT("DBImpl::SyncOtherWalStreams:Logged");
+  Status s;
+  // Safe without mutex_ since all the logs are getting_synced, and logs are
+  // only added with all the streams stopped
+  auto sync_logs = [&](const std::deque<LogWriterNumber>& logs) {
+    for (auto& log : logs) {
+      if (s.ok()) {
+        s = log.writer->file()->SyncWithoutFlush(
+            immutable_db_options_.use_fsync);
+      }
+    }
+  };
+  if (own_stream != nullptr) {
+    sync_logs(logs_);
+  }
+  for (auto& stream : wal_streams_) {
+    if (stream.get() != own_stream) {
+      sync_logs(stream->logs);
+    }
+  }
+  return s;
+}
+
+Status DBImpl::NewWalStreamLogWriters(
+    std::vector<std::unique_ptr<log::Writer>>* new_logs,
+    const DBOptions& db_options, Env::WriteLifeTimeHint write_hint) {
+  new_logs->clear();
+  for (size_t i = 0; i < wal_streams_.size(); ++i) {
+    std::unique_ptr<log::Writer> new_log;
+    Status s = NewLogWriter(&new_log, 0 /*recycle_log_number*/, db_options,
+                            write_hint);
+    if (!s.ok()) {
+      return s;
+    }
+    new_logs->emplace_back(std::move(new_log));
+  }
+  return Status::OK();
+}
+
+Status DBImpl::InstallWalStreamLogWriters(
+    std::vector<std::unique_ptr<log::Writer>>* new_logs,
+    size_t preallocate_block_size, SequenceNumber seq) {
+  mutex_.AssertHeld();
+  log_write_mutex_.AssertHeld();
+  assert(new_logs->size() == wal_streams_.size());
+  Status s;
+  for (size_t i = 0; i < wal_streams_.size(); ++i) {
+    auto& stream = wal_streams_[i];
+    if (!stream->logs.empty()) {
+      auto& cur_log = stream->logs.back();
+      Status write_s = cur_log.writer->WriteBuffer();
+      if (write_s.ok()) {
+        write_s = cur_log.writer->Frozen();
+      }
+      if (s.ok()) {
+        s = write_s;
+      }
+      alive_log_files_.emplace_back(cur_log.number, seq);
+      alive_log_files_.back().AddSize(stream->log_size.load());
+    }
+    log::Writer* new_log = (*new_logs)[i].release();
+    uint64_t log_number = new_log->get_log_number();
+    new_log->file()->writable_file()->SetPreallocationBlockSize(
+        preallocate_block_size);
+    stream->logs.emplace_back(log_number, new_log);
+    stream->log_size = 0;
+    stream->log_dir_synced = false;
+  }
+  new_logs->clear();
+  return s;
+}
+
+void DBImpl::StartWalSyncThread() {
+  assert(!wal_sync_thread_.joinable());
+  wal_sync_thread_ = port::Thread([this] { BGWorkWalSync(); });
+}
+
+void DBImpl::StopWalSyncThread() {
+  if (!wal_sync_thread_.joinable()) {
+    return;
+  }
+  {
+    InstrumentedMutexLock l(&wal_sync_mutex_);
+    wal_sync_shutdown_ = true;
+    wal_sync_cv_.SignalAll();
+  }
+  wal_sync_thread_.join();
+}
+
+void DBImpl::BGWorkWalSync() {
+  InstrumentedMutexLock l(&wal_sync_mutex_);
+  while (true) {
+    while (wal_synced_seq_ >= wal_sync_requested_seq_ && !wal_sync_shutdown_) {
+      wal_sync_cv_.Wait();
+    }
+    if (wal_synced_seq_ >= wal_sync_requested_seq_) {
+      break;
+    }
+    // Everything appended before the request is covered by this sync, and
+    // the requests coming in meanwhile are served by the next one
+    SequenceNumber seq = wal_sync_requested_seq_;
+    wal_sync_mutex_.Unlock();
+    TEST_SYNC_POINT("DBImpl::BGWorkWalSync:BeforeSync");
+    Status s = SyncWAL();
+    TEST_SYNC_POINT_CALLBACK("DBImpl::BGWorkWalSync:AfterSync", &s);
+    wal_sync_mutex_.Lock();
+    if (!s.ok()) {
+      if (wal_sync_status_.ok()) {
+        ROCKS_LOG_ERROR(immutable_db_options_.info_log,
+                        "WAL sync thread failed: %s", s.ToString().c_str());
+        wal_sync_status_ = s;
+      }
+      // After wal_sync_status_ is set, so that the Resume() clearing the
+      // background error also clears it, and before the waiters see it
+      wal_sync_mutex_.Unlock();
+      WriteStatusCheck(s);
+      wal_sync_mutex_.Lock();
+    }
+    wal_synced_seq_ = seq;
+    wal_sync_cv_.SignalAll();
+  }
+}
+
+void DBImpl::RequestWalSync(SequenceNumber seq) {
+  InstrumentedMutexLock l(&wal_sync_mutex_);
+  if (wal_sync_requested_seq_ < seq) {
+    wal_sync_requested_seq_ = seq;
+    wal_sync_cv_.SignalAll();
+  }
+}
+
+Status DBImpl::WaitForWalSync(WriteThread::Writer* w) {
+  Status s = w->FinalStatus();
+  // A batch without keys has no sequence of its own to wait for
+  if (!s.ok() || !w->sync || WriteBatchInternal::Count(w->batch) == 0) {
+    return s;
+  }
+  PERF_TIMER_GUARD(write_wal_time);
+  InstrumentedMutexLock l(&wal_sync_mutex_);
+  // Usually requested already by the group leader
+  if (wal_sync_requested_seq_ < w->sequence) {
+    wal_sync_requested_seq_ = w->sequence;
+    wal_sync_cv_.SignalAll();
+  }
+  while (wal_synced_seq_ < w->sequence) {
+    wal_sync_cv_.Wait();
+  }
+  return wal_sync_status_;
+}
+
 Status DBImpl::WriteRecoverableState() {
   mutex_.AssertHeld();
   if (!cached_recoverable_state_empty_) {
@@ -1242,7 +1790,7 @@ Status DBImpl::HandleMaxWalSize(WriteContext* write_context) {
     }
   }
   if (cfd_picked != nullptr && cfd_picked->mem()->SwitchFlushScheduled()) {
-    uint64_t alive_log_files_back_size = alive_log_files_.back().size;
+    uint64_t alive_log_files_back_size = GetCurrentWalSize();
     uint64_t max_wal_size = GetMaxWalSize();
     ROCKS_LOG_BUFFER(
         &write_context->info_buffer,
@@ -1261,6 +1809,15 @@ uint64_t DBImpl::GetMaxWalSize() const {
              : mutable_db_options_.max_wal_size;
 }
 
+uint64_t DBImpl::GetCurrentWalSize() const {
+  mutex_.AssertHeld();
+  uint64_t size = alive_log_files_.back().size;
+  for (auto& stream : wal_streams_) {
+    size += stream->log_size.load(std::memory_order_relaxed);
+  }
+  return size;
+}
+
 uint64_t DBImpl::GetMaxTotalWalSize() const {
   mutex_.AssertHeld();
   return mutable_db_options_.max_total_wal_size == 0
@@ -1517,14 +2074,17 @@ Status DBImpl::SwitchMemtable(ColumnFamilyData* cfd, WriteContext* context) {
     // that there is no concurrent thread writing to WAL.
     nonmem_write_thread_.EnterUnbatched(&nonmem_w, &mutex_);
   }
+  EnterWalStreamsUnbatched();
 
   std::unique_ptr<WritableFile> lfile;
   log::Writer* new_log = nullptr;
+  std::vector<std::unique_ptr<log::Writer>> new_stream_logs;
 
   // Recoverable state is persisted in WAL. After memtable switch, WAL might
   // be deleted, so we write the state to memtable to be persisted as well.
   Status s = WriteRecoverableState();
   if (!s.ok()) {
+    ExitWalStreamsUnbatched();
     return s;
   }
 
@@ -1548,6 +2108,9 @@ Status DBImpl::SwitchMemtable(ColumnFamilyData* cfd, WriteContext* context) {
   if (two_write_queues_) {
     log_write_mutex_.Unlock();
   }
+  for (auto& stream : wal_streams_) {
+    creating_new_log = creating_new_log || stream->log_size > 0;
+  }
   uint64_t new_log_number = logfile_number_;
   const MutableCFOptions mutable_cf_options = *cfd->GetLatestMutableCFOptions();
 
@@ -1608,6 +2171,9 @@ Status DBImpl::SwitchMemtable(ColumnFamilyData* cfd, WriteContext* context) {
     std::unique_ptr<log::Writer> unique_new_log;
     s = NewLogWriter(&unique_new_log, recycle_log_number, db_options,
                      write_hint);
+    if (s.ok()) {
+      s = NewWalStreamLogWriters(&new_stream_logs, db_options, write_hint);
+    }
     if (s.ok()) {
       new_log = unique_new_log.release();
       new_log_number = new_log->get_log_number();
@@ -1684,6 +2250,14 @@ Status DBImpl::SwitchMemtable(ColumnFamilyData* cfd, WriteContext* context) {
                          cur_log_writer->get_log_number(), new_log_number);
       }
     }
+    if (!wal_streams_.empty()) {
+      Status stream_s = InstallWalStreamLogWriters(
+          &new_stream_logs, preallocate_block_size,
+          alive_log_files_.back().seq);
+      if (s.ok()) {
+        s = stream_s;
+      }
+    }
     logs_.emplace_back(logfile_number_, new_log);
     alive_log_files_.emplace_back(logfile_number_, versions_->LastSequence());
     log_write_mutex_.Unlock();
@@ -1693,6 +2267,7 @@ Status DBImpl::SwitchMemtable(ColumnFamilyData* cfd, WriteContext* context) {
     // how do we fail if we're not creating new log?
     assert(creating_new_log);
     assert(!new_log);
+    ExitWalStreamsUnbatched();
     if (two_write_queues_) {
       nonmem_write_thread_.ExitUnbatched(&nonmem_w);
     }
@@ -1724,6 +2299,7 @@ Status DBImpl::SwitchMemtable(ColumnFamilyData* cfd, WriteContext* context) {
   cfd->SetMemtable(new_mem);
   InstallSuperVersionAndScheduleWork(cfd, &context->superversion_context,
                                      mutable_cf_options);
+  ExitWalStreamsUnbatched();
   if (two_write_queues_) {
     nonmem_write_thread_.ExitUnbatched(&nonmem_w);
   }
@@ -9,6 +9,7 @@
 
 #include "db/db_iter.h"
 
+#include <deque>
 #include <limits>
 #include <string>
 
@@ -135,7 +136,11 @@ class DBIter final : public Iterator {
         read_callback_(read_callback),
         db_impl_(db_impl),
         cfd_(cfd),
-        start_seqnum_(read_options.iter_start_seqnum) {
+        start_seqnum_(read_options.iter_start_seqnum),
+        separated_value_readahead_(
+            read_options.tailing || read_options.iter_start_seqnum > 0
+                ? 0
+                : read_options.separated_value_readahead) {
     RecordTick(statistics_, NO_ITERATOR_CREATED);
     prefix_extractor_ = mutable_cf_options.prefix_extractor.get();
     max_skip_ = max_sequential_skip_in_iterations;
@@ -180,9 +185,14 @@ class DBIter final : public Iterator {
     return &range_del_agg_;
   }
 
-  virtual bool Valid() const override { return valid_; }
+  virtual bool Valid() const override {
+    return valid_ || !readahead_.empty();
+  }
   virtual Slice key() const override {
-    assert(valid_);
+    assert(Valid());
+    if (!readahead_.empty()) {
+      return readahead_.front().key;
+    }
     if (start_seqnum_ > 0) {
       return saved_key_.GetInternalKey();
     } else {
@@ -190,7 +200,18 @@ class DBIter final : public Iterator {
     }
   }
   virtual Slice value() const override {
-    assert(valid_);
+    assert(Valid());
+    if (!readahead_.empty()) {
+      auto& entry = readahead_.front();
+      auto s = entry.value.fetch();
+      if (!s.ok()) {
+        readahead_.clear();
+        valid_ = false;
+        status_ = s;
+        return Slice::Invalid();
+      }
+      return entry.value.slice();
+    }
     auto s = value_.fetch();
     if (!s.ok()) {
       valid_ = false;
@@ -200,7 +221,10 @@ class DBIter final : public Iterator {
     return value_.slice();
   }
   virtual Status status() const override {
-    if (status_.ok()) {
+    if (!readahead_.empty()) {
+      // Errors met while reading ahead are reported after the entries
+      return Status::OK();
+    } else if (status_.ok()) {
       return iter_->status();
     } else {
       assert(!valid_);
@@ -217,7 +241,8 @@ class DBIter final : public Iterator {
       // First try to pass the value returned from inner iterator.
       return iter_->GetProperty(prop_name, prop);
     } else if (prop_name == "rocksdb.iterator.internal-key") {
-      *prop = saved_key_.GetUserKey().ToString();
+      *prop = readahead_.empty() ? saved_key_.GetUserKey().ToString()
+                                 : readahead_.front().key;
       return Status::OK();
     }
     return Status::InvalidArgument("Unidentified property.");
@@ -231,7 +256,10 @@ class DBIter final : public Iterator {
   virtual void SeekToLast() override;
   Env* env() { return env_; }
   void set_sequence(uint64_t s) { sequence_ = s; }
-  void set_valid(bool v) { valid_ = v; }
+  void set_valid(bool v) {
+    readahead_.clear();
+    valid_ = v;
+  }
 
  private:
   // For all methods in this block:
@@ -258,6 +286,7 @@ class DBIter final : public Iterator {
   }
 
   void PrevInternal();
+  void ReadaheadSeparatedValues();
   bool TooManyInternalKeysSkipped(bool increment = true);
   bool IsVisible(SequenceNumber sequence);
 
@@ -328,6 +357,16 @@ class DBIter final : public Iterator {
   // if this value > 0 iterator will return internal keys
   SequenceNumber start_seqnum_;
 
+  // Entries read ahead by ReadaheadSeparatedValues(). If not empty, the front
+  // is the current entry, and the state above describes the entry after the
+  // back one
+  struct ReadaheadEntry {
+    std::string key;
+    LazyBuffer value;
+  };
+  const size_t separated_value_readahead_;
+  mutable std::deque<ReadaheadEntry> readahead_;
+
   // No copying allowed
   DBIter(const DBIter&);
   void operator=(const DBIter&);
@@ -356,6 +395,11 @@ void DBIter::Next() {
                              : (db_impl_->next_qps_reporter().AddCount(1),
                                 &db_impl_->next_latency_reporter()));
 
+  if (!readahead_.empty()) {
+    // Already counted by ReadaheadSeparatedValues()
+    readahead_.pop_front();
+    return;
+  }
   assert(valid_);
   assert(status_.ok());
 
@@ -389,6 +433,70 @@ void DBIter::Next() {
     // local_stats_.bytes_read_ += (key().size() + value().size());
     local_stats_.bytes_read_ += key().size();
   }
+  ReadaheadSeparatedValues();
+}
+
+// Collect the entries following a separated value into readahead_, then
+// issue the blob reads of all of them together, so that a scan over
+// separated values doesn't wait for one blob read per Next()
+void DBIter::ReadaheadSeparatedValues() {
+  if (separated_value_readahead_ == 0 || separate_helper_ == nullptr ||
+      !valid_ || direction_ != kForward || current_entry_is_merged_ ||
+      ikey_.type != kTypeValueIndex) {
+    return;
+  }
+  assert(readahead_.empty());
+  while (valid_ && readahead_.size() < separated_value_readahead_) {
+    readahead_.emplace_back();
+    auto& entry = readahead_.back();
+    entry.key.assign(saved_key_.GetUserKey().data(),
+                     saved_key_.GetUserKey().size());
+    if (current_entry_is_merged_) {
+      // value_ refers to value_buffer_, which is reused by the next entry
+      auto s = value_.fetch();
+      if (!s.ok()) {
+        entry.value.reset(std::move(s));
+      } else {
+        entry.value.reset(value_.slice(), true, value_.file_number());
+      }
+    } else if (ikey_.type == kTypeValueIndex) {
+      // value_ refers to saved_key_, combine again with the entry's own key
+      entry.value = separate_helper_->TransToCombined(
+          entry.key, ikey_.sequence, iter_->value());
+    } else {
+      entry.value = std::move(value_);
+      entry.value.pin(LazyBufferPinLevel::Internal);
+    }
+
+    // Same as Next() in forward direction
+    ResetValueAndCounter();
+    if (iter_->Valid() && !current_entry_is_merged_) {
+      iter_->Next();
+      PERF_COUNTER_ADD(internal_key_skipped_count, 1);
+    }
+    if (statistics_ != nullptr) {
+      local_stats_.next_count_++;
+    }
+    if (iter_->Valid()) {
+      FindNextUserEntry(true /* skipping the current user key */,
+                        prefix_same_as_start_);
+    } else {
+      valid_ = false;
+    }
+    if (statistics_ != nullptr && valid_) {
+      local_stats_.next_found_count_++;
+      local_stats_.bytes_read_ += saved_key_.GetUserKey().size();
+    }
+  }
+  std::vector<LazyBuffer*> values;
+  values.reserve(readahead_.size() + 1);
+  for (auto& entry : readahead_) {
+    values.emplace_back(&entry.value);
+  }
+  if (valid_) {
+    values.emplace_back(&value_);
+  }
+  separate_helper_->PrefetchCombined(values.data(), values.size());
 }
 
 // PRE: saved_key_ has the current user key if skipping
@@ -688,6 +796,16 @@ void DBIter::Prev() {
                              : (db_impl_->prev_qps_reporter().AddCount(1),
                                 &db_impl_->prev_latency_reporter()));
 
+  if (!readahead_.empty()) {
+    // iter_ is ahead of the current entry, bring it back there in reverse
+    // direction
+    std::string current_key = std::move(readahead_.front().key);
+    readahead_.clear();
+    SeekForPrev(current_key);
+    if (!valid_) {
+      return;
+    }
+  }
   assert(valid_);
   assert(status_.ok());
   ResetValueAndCounter();
@@ -711,6 +829,9 @@ void DBIter::Prev() {
 }
 
 void DBIter::PinLazyBuffer() {
+  for (auto& entry : readahead_) {
+    entry.value.pin(LazyBufferPinLevel::DB);
+  }
   value_.pin(LazyBufferPinLevel::DB);
   merge_context_.PinLazyBuffer();
 }
@@ -1188,6 +1309,7 @@ void DBIter::Seek(const Slice& target) {
                                 &db_impl_->seek_latency_reporter()));
 
   StopWatch sw(env_, statistics_, DB_SEEK);
+  readahead_.clear();
   status_ = Status::OK();
   ResetValueAndCounter();
 
@@ -1242,6 +1364,7 @@ void DBIter::Seek(const Slice& target) {
     prefix_start_buf_.SetUserKey(prefix_start_key_);
     prefix_start_key_ = prefix_start_buf_.GetUserKey();
   }
+  ReadaheadSeparatedValues();
 }
 
 static const std::string seekforprev_metric_name = "dbiter_seekforprev";
@@ -1252,6 +1375,7 @@ void DBIter::SeekForPrev(const Slice& target) {
                              &db_impl_->seekforprev_latency_reporter()));
 
   StopWatch sw(env_, statistics_, DB_SEEK);
+  readahead_.clear();
   status_ = Status::OK();
   ResetValueAndCounter();
   saved_key_.Clear();
@@ -1321,6 +1445,7 @@ void DBIter::SeekToFirst() {
   if (prefix_extractor_ != nullptr && !total_order_seek_) {
     max_skip_ = std::numeric_limits<uint64_t>::max();
   }
+  readahead_.clear();
   status_ = Status::OK();
   direction_ = kForward;
   ResetValueAndCounter();
@@ -1353,6 +1478,7 @@ void DBIter::SeekToFirst() {
         prefix_extractor_->Transform(saved_key_.GetUserKey()));
     prefix_start_key_ = prefix_start_buf_.GetUserKey();
   }
+  ReadaheadSeparatedValues();
 }
 
 void DBIter::SeekToLast() {
@@ -1374,6 +1500,7 @@ void DBIter::SeekToLast() {
   if (prefix_extractor_ != nullptr && !total_order_seek_) {
     max_skip_ = std::numeric_limits<uint64_t>::max();
   }
+  readahead_.clear();
   status_ = Status::OK();
   direction_ = kReverse;
   ResetValueAndCounter();
@@ -2101,6 +2101,122 @@ TEST_P(DBIteratorTest, SeekBackwardAfterOutOfUpperBound) {
   ASSERT_EQ("a", it->key().ToString());
 }
 
+TEST_P(DBIteratorTest, SeparatedValueReadahead) {
+  Options options = CurrentOptions();
+  options.disable_auto_compactions = true;
+  options.blob_size = 32;  // turn on kv separation
+  options.blob_offset_addressing = true;
+  options.merge_operator = MergeOperators::CreateStringAppendOperator();
+  DestroyAndReopen(options);
+
+  for (int i = 0; i < 500; ++i) {
+    ASSERT_OK(Put(Key(i), std::string(100, 'a' + i % 26)));
+  }
+  ASSERT_OK(Flush());
+  MoveFilesToLevel(1);
+  for (int i = 0; i < 500; i += 3) {
+    ASSERT_OK(Put(Key(i), "small"));
+  }
+  for (int i = 0; i < 500; i += 7) {
+    ASSERT_OK(Delete(Key(i)));
+  }
+  for (int i = 0; i < 500; i += 11) {
+    ASSERT_OK(Merge(Key(i), "m"));
+  }
+  ASSERT_OK(Flush());
+
+  std::vector<std::pair<std::string, std::string>> expected;
+  {
+    std::unique_ptr<Iterator> iter(NewIterator(ReadOptions()));
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+      expected.emplace_back(iter->key().ToString(), iter->value().ToString());
+    }
+    ASSERT_OK(iter->status());
+  }
+  ASSERT_GT(expected.size(), 300U);
+
+  // Ranges of blob blocks read ahead
+  std::atomic<int> prefetches{0};
+  SyncPoint::GetInstance()->SetCallBack(
+      "Version::PrefetchCombined:Range",
+      [&](void* /*arg*/) { prefetches.fetch_add(1); });
+  SyncPoint::GetInstance()->EnableProcessing();
+
+  ReadOptions read_options;
+  read_options.separated_value_readahead = 16;
+  auto scan = [&] {
+    std::unique_ptr<Iterator> scan_iter(NewIterator(read_options));
+    size_t n = 0;
+    for (scan_iter->SeekToFirst(); scan_iter->Valid();
+         scan_iter->Next(), ++n) {
+      ASSERT_LT(n, expected.size());
+      ASSERT_EQ(expected[n].first, scan_iter->key().ToString());
+      ASSERT_EQ(expected[n].second, scan_iter->value().ToString());
+    }
+    ASSERT_OK(scan_iter->status());
+    ASSERT_EQ(expected.size(), n);
+  };
+  scan();
+#ifndef NDEBUG
+  ASSERT_GT(prefetches.load(), 0);
+#endif
+
+  // Compaction rewrites the key ssts, their values must still be addressed
+  // by handle so that they can be read ahead
+  ASSERT_OK(db_->CompactRange(CompactRangeOptions(), nullptr, nullptr));
+  prefetches = 0;
+  scan();
+#ifndef NDEBUG
+  ASSERT_GT(prefetches.load(), 0);
+#endif
+
+  // Change direction while entries are read ahead
+  std::unique_ptr<Iterator> iter(NewIterator(read_options));
+  iter->Seek(Key(100));
+  size_t i = 0;
+  while (expected[i].first < Key(100)) {
+    ++i;
+  }
+  for (size_t n = 0; n < 5; ++n, ++i) {
+    ASSERT_TRUE(iter->Valid());
+    ASSERT_EQ(expected[i].first, iter->key().ToString());
+    iter->Next();
+  }
+  iter->Prev();
+  iter->Prev();
+  i -= 2;
+  ASSERT_TRUE(iter->Valid());
+  ASSERT_EQ(expected[i].first, iter->key().ToString());
+  ASSERT_EQ(expected[i].second, iter->value().ToString());
+  iter->Next();
+  ASSERT_TRUE(iter->Valid());
+  ASSERT_EQ(expected[i + 1].first, iter->key().ToString());
+  ASSERT_EQ(expected[i + 1].second, iter->value().ToString());
+
+  // MultiGet fetches the separated values together
+  std::vector<std::string> key_strs;
+  for (int k = 0; k < 500; k += 2) {
+    key_strs.emplace_back(Key(k));
+  }
+  std::vector<Slice> keys(key_strs.begin(), key_strs.end());
+  std::vector<std::string> values;
+  prefetches = 0;
+  std::vector<Status> s = db_->MultiGet(ReadOptions(), keys, &values);
+#ifndef NDEBUG
+  ASSERT_GT(prefetches.load(), 0);
+#endif
+  SyncPoint::GetInstance()->DisableProcessing();
+  SyncPoint::GetInstance()->ClearAllCallBacks();
+  for (size_t k = 0; k < keys.size(); ++k) {
+    std::string value;
+    Status expected_s = db_->Get(ReadOptions(), keys[k], &value);
+    ASSERT_EQ(expected_s.ToString(), s[k].ToString());
+    if (s[k].ok()) {
+      ASSERT_EQ(value, values[k]);
+    }
+  }
+}
+
 INSTANTIATE_TEST_CASE_P(DBIteratorTestInstance, DBIteratorTest,
                         testing::Values(true, false));
 
@@ -246,6 +246,110 @@ TEST_F(DBWALTest, SyncWALNotWaitWrite) {
   TERARKDB_NAMESPACE::SyncPoint::GetInstance()->DisableProcessing();
 }
 
+TEST_F(DBWALTest, AsyncWalSync) {
+  Options options = CurrentOptions();
+  options.enable_async_wal_sync = true;
+  Reopen(options);
+
+  // A sync write returns after the sync thread synced it, the writes after
+  // it don't wait meanwhile
+  TERARKDB_NAMESPACE::SyncPoint::GetInstance()->LoadDependency({
+      {"DBWALTest::AsyncWalSync:1", "DBImpl::BGWorkWalSync:BeforeSync"},
+  });
+  TERARKDB_NAMESPACE::SyncPoint::GetInstance()->EnableProcessing();
+  std::atomic<bool> synced(false);
+  TERARKDB_NAMESPACE::port::Thread thread([&]() {
+    WriteOptions wo;
+    wo.sync = true;
+    ASSERT_OK(db_->Put(wo, "foo1", "bar1"));
+    synced = true;
+  });
+  while (Get("foo1") != "bar1") {
+    env_->SleepForMicroseconds(1000);
+  }
+  ASSERT_OK(Put("foo2", "bar2"));
+  ASSERT_FALSE(synced.load());
+  TEST_SYNC_POINT("DBWALTest::AsyncWalSync:1");
+  thread.join();
+  ASSERT_TRUE(synced.load());
+  TERARKDB_NAMESPACE::SyncPoint::GetInstance()->DisableProcessing();
+  TERARKDB_NAMESPACE::SyncPoint::GetInstance()->ClearTrace();
+
+  std::vector<port::Thread> threads;
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([&, t]() {
+      WriteOptions wo;
+      wo.sync = true;
+      for (int i = 0; i < 100; i++) {
+        ASSERT_OK(db_->Put(wo, Key(t * 100 + i), "v"));
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+
+  Reopen(options);
+  ASSERT_EQ("bar1", Get("foo1"));
+  ASSERT_EQ("bar2", Get("foo2"));
+  for (int k = 0; k < 400; k++) {
+    ASSERT_EQ("v", Get(Key(k)));
+  }
+
+  options.enable_pipelined_write = true;
+  ASSERT_TRUE(TryReopen(options).IsNotSupported());
+}
+
+#if !defined(ROCKSDB_LITE) && !defined(NDEBUG)
+class NoAutoRecoveryListener : public EventListener {
+ public:
+  void OnErrorRecoveryBegin(BackgroundErrorReason /*reason*/,
+                            Status /*bg_error*/, bool* auto_recovery) override {
+    *auto_recovery = false;
+  }
+};
+
+TEST_F(DBWALTest, AsyncWalSyncResume) {
+  std::unique_ptr<FaultInjectionTestEnv> fault_env(
+      new FaultInjectionTestEnv(env_));
+  Options options = CurrentOptions();
+  options.env = fault_env.get();
+  options.enable_async_wal_sync = true;
+  options.listeners.emplace_back(new NoAutoRecoveryListener());
+  DestroyAndReopen(options);
+
+  WriteOptions sync_wo;
+  sync_wo.sync = true;
+  ASSERT_OK(Put("foo1", "bar1", sync_wo));
+  SyncPoint::GetInstance()->SetCallBack(
+      "DBImpl::BGWorkWalSync:AfterSync", [&](void* arg) {
+        *static_cast<Status*>(arg) = Status::NoSpace("injected");
+      });
+  SyncPoint::GetInstance()->EnableProcessing();
+  ASSERT_TRUE(Put("foo2", "bar2", sync_wo).IsNoSpace());
+  SyncPoint::GetInstance()->DisableProcessing();
+  SyncPoint::GetInstance()->ClearAllCallBacks();
+  ASSERT_NOK(Put("foo3", "bar3", sync_wo));
+
+  // The failure of the sync thread is reported until the DB resumes
+  ASSERT_OK(dbfull()->Resume());
+  ASSERT_OK(Put("foo3", "bar3", sync_wo));
+  ASSERT_OK(Put("foo4", "bar4"));
+
+  // Simulate a crash
+  fault_env->SetFilesystemActive(false);
+  Close();
+  ASSERT_OK(fault_env->DropUnsyncedFileData());
+  fault_env->ResetState();
+  Reopen(options);
+  ASSERT_EQ("bar1", Get("foo1"));
+  ASSERT_EQ("bar3", Get("foo3"));
+  ASSERT_EQ("NOT_FOUND", Get("foo4"));
+  // Destroy DB before destruct fault_env.
+  Destroy(options);
+}
+#endif  // !defined(ROCKSDB_LITE) && !defined(NDEBUG)
+
 TEST_F(DBWALTest, Recover) {
   do {
     CreateAndReopenWithCF({"pikachu"}, CurrentOptions());
@@ -600,6 +704,226 @@ TEST_F(DBWALTest, RecoverWithLargeLog) {
   } while (ChangeWalOptions());
 }
 
+TEST_F(DBWALTest, RecoverWithParallelReplay) {
+  Options options = CurrentOptions();
+  options.merge_operator = MergeOperators::CreateStringAppendOperator();
+  options.write_buffer_size = 64 << 20;
+  CreateAndReopenWithCF({"pikachu"}, options);
+
+  // Puts and deletes filling a whole replay group and more, then smaller
+  // groups cut by merges, which are replayed sequentially
+  Random rnd(301);
+  std::map<std::string, std::string> expected[2];
+  for (int i = 0; i < 30000; i++) {
+    int cf = i % 2;
+    std::string key = Key(rnd.Uniform(5000));
+    std::string value = RandomString(&rnd, 300);
+    if (i >= 20000 && i % 1000 == 999) {
+      ASSERT_OK(Merge(cf, key, value));
+      auto& v = expected[cf][key];
+      v = v.empty() ? value : v + "," + value;
+    } else if (i % 7 == 0) {
+      ASSERT_OK(Delete(cf, key));
+      expected[cf].erase(key);
+    } else {
+      ASSERT_OK(Put(cf, key, value));
+      expected[cf][key] = value;
+    }
+  }
+  ASSERT_EQ(NumTableFilesAtLevel(0, 1), 0);
+
+  auto verify = [&]() {
+    for (int cf = 0; cf < 2; cf++) {
+      for (int k = 0; k < 5000; k++) {
+        auto it = expected[cf].find(Key(k));
+        ASSERT_EQ(it == expected[cf].end() ? "NOT_FOUND" : it->second,
+                  Get(cf, Key(k)));
+      }
+    }
+  };
+
+  // Flush in the middle of the replay
+  options.write_buffer_size = 1 << 20;
+  options.wal_recovery_threads = 4;
+  // ParallelWalReplay::kGroupSize
+  const size_t kGroupSize = 4 << 20;
+  int full_groups = 0;
+  int groups = 0;
+  SyncPoint::GetInstance()->SetCallBack(
+      "ParallelWalReplay::Submit", [&](void* arg) {
+        size_t group_size = *static_cast<size_t*>(arg);
+        // A group is cut by the record crossing the limit
+        ASSERT_LT(group_size, kGroupSize + 1024);
+        full_groups += group_size >= kGroupSize;
+        groups++;
+      });
+  SyncPoint::GetInstance()->EnableProcessing();
+  ReopenWithColumnFamilies({"default", "pikachu"}, options);
+  SyncPoint::GetInstance()->DisableProcessing();
+  SyncPoint::GetInstance()->ClearAllCallBacks();
+#ifndef NDEBUG
+  ASSERT_EQ(1, full_groups);
+  ASSERT_GT(groups, 10);
+#endif  // NDEBUG
+  ASSERT_GT(NumTableFilesAtLevel(0, 1), 1);
+  verify();
+  ASSERT_OK(Put(1, "foo", "bar"));
+  expected[1]["foo"] = "bar";
+
+  ReopenWithColumnFamilies({"default", "pikachu"}, options);
+  verify();
+  ASSERT_EQ("bar", Get(1, "foo"));
+}
+
+TEST_F(DBWALTest, WalStreams) {
+  Options options = CurrentOptions();
+  options.wal_streams = 4;
+  options.allow_concurrent_memtable_write = true;
+  options.merge_operator = MergeOperators::CreateStringAppendOperator();
+  options.write_buffer_size = 1 << 20;
+  CreateAndReopenWithCF({"pikachu"}, options);
+  SequenceNumber last_sequence = db_->GetLatestSequenceNumber();
+
+  // The threads overwrite each other's keys, so recovery has to apply them
+  // in the order they were written
+  const int kThreads = 8;
+  const int kKeys = 500;
+  std::vector<port::Thread> threads;
+  for (int t = 0; t < kThreads; t++) {
+    threads.emplace_back([&, t]() {
+      Random rnd(301 + t);
+      WriteOptions wo;
+      for (int i = 0; i < 5000; i++) {
+        wo.sync = i % 500 == 0;
+        std::string value = RandomString(&rnd, 100);
+        ASSERT_OK(db_->Put(wo, handles_[i % 2], Key(rnd.Uniform(kKeys)),
+                           value));
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  ASSERT_OK(Merge(1, "merge", "a"));
+  ASSERT_OK(Put(1, "merge", "b"));
+
+  std::vector<std::string> expected[2];
+  for (int cf = 0; cf < 2; cf++) {
+    for (int k = 0; k < kKeys; k++) {
+      expected[cf].push_back(Get(cf, Key(k)));
+    }
+  }
+  last_sequence += kThreads * 5000 + 2;
+  ASSERT_EQ(last_sequence, db_->GetLatestSequenceNumber());
+
+  auto verify = [&]() {
+    ASSERT_EQ(last_sequence, db_->GetLatestSequenceNumber());
+    for (int cf = 0; cf < 2; cf++) {
+      for (int k = 0; k < kKeys; k++) {
+        ASSERT_EQ(expected[cf][k], Get(cf, Key(k)));
+      }
+    }
+    ASSERT_EQ("b", Get(1, "merge"));
+  };
+  // Also with flushes in the middle of the replay
+  for (size_t write_buffer_size : {64 << 20, 256 << 10}) {
+    options.write_buffer_size = write_buffer_size;
+    ReopenWithColumnFamilies({"default", "pikachu"}, options);
+    verify();
+  }
+
+  std::unique_ptr<TransactionLogIterator> iter;
+  ASSERT_TRUE(db_->GetUpdatesSince(0, &iter).IsNotSupported());
+  options.enable_pipelined_write = true;
+  ASSERT_TRUE(
+      TryReopenWithColumnFamilies({"default", "pikachu"}, options)
+          .IsNotSupported());
+}
+
+#ifndef NDEBUG
+TEST_F(DBWALTest, WalStreamsSyncIsPointInTime) {
+  std::unique_ptr<FaultInjectionTestEnv> fault_env(
+      new FaultInjectionTestEnv(env_));
+  Options options = CurrentOptions();
+  options.env = fault_env.get();
+  options.wal_streams = 3;
+  options.allow_concurrent_memtable_write = true;
+  DestroyAndReopen(options);
+
+  size_t stream = 0;
+  SyncPoint::GetInstance()->SetCallBack(
+      "DBImpl::WriteImpl:WalStreamIndex",
+      [&](void* arg) { *static_cast<size_t*>(arg) = stream; });
+  SyncPoint::GetInstance()->EnableProcessing();
+  WriteOptions sync_wo;
+  sync_wo.sync = true;
+  // A sync write of any queue syncs the earlier writes of the others
+  stream = 1;
+  ASSERT_OK(Put("a", "v"));
+  stream = 2;
+  ASSERT_OK(Put("b", "v", sync_wo));
+  ASSERT_OK(Put("c", "v"));
+  stream = 0;
+  ASSERT_OK(Put("d", "v", sync_wo));
+  ASSERT_OK(Put("e", "v"));
+  stream = 1;
+  ASSERT_OK(Put("f", "v", sync_wo));
+  stream = 2;
+  ASSERT_OK(Put("g", "v"));
+  SyncPoint::GetInstance()->DisableProcessing();
+  SyncPoint::GetInstance()->ClearAllCallBacks();
+
+  // Simulate a crash
+  fault_env->SetFilesystemActive(false);
+  Close();
+  ASSERT_OK(fault_env->DropUnsyncedFileData());
+  fault_env->ResetState();
+  Reopen(options);
+  for (const char* key : {"a", "b", "c", "d", "e", "f"}) {
+    ASSERT_EQ("v", Get(key));
+  }
+  ASSERT_EQ("NOT_FOUND", Get("g"));
+  // Destroy DB before destruct fault_env.
+  Destroy(options);
+}
+
+TEST_F(DBWALTest, WalStreamsReopenWithOneStream) {
+  Options options = CurrentOptions();
+  options.wal_streams = 3;
+  options.allow_concurrent_memtable_write = true;
+  DestroyAndReopen(options);
+
+  size_t stream = 0;
+  SyncPoint::GetInstance()->SetCallBack(
+      "DBImpl::WriteImpl:WalStreamIndex",
+      [&](void* arg) { *static_cast<size_t*>(arg) = stream; });
+  SyncPoint::GetInstance()->EnableProcessing();
+  // The sequences of the logs interleave
+  for (size_t i = 0; i < 4; i++) {
+    stream = 1 + i % 2;
+    ASSERT_OK(Put(Key(static_cast<int>(i)), "v"));
+  }
+  SyncPoint::GetInstance()->DisableProcessing();
+  SyncPoint::GetInstance()->ClearAllCallBacks();
+  Close();
+
+  options.wal_streams = 1;
+  ASSERT_TRUE(TryReopen(options).IsInvalidArgument());
+  options.wal_streams = 3;
+  Reopen(options);
+  for (int i = 0; i < 4; i++) {
+    ASSERT_EQ("v", Get(Key(i)));
+  }
+
+  // Once flushed, the logs of one stream are enough
+  ASSERT_OK(Flush());
+  Close();
+  options.wal_streams = 1;
+  Reopen(options);
+  ASSERT_EQ("v", Get(Key(0)));
+}
+#endif  // NDEBUG
+
 // In https://reviews.facebook.net/D20661 we change
 // recovery behavior: previously for each log file each column family
 // memtable was flushed, even it was empty. Now it's changed:
@@ -198,18 +198,32 @@ void IterKey::EnlargeBuffer(size_t key_size) {
   buf_size_ = key_size;
 }
 
+constexpr uint64_t SeparateHelper::kValueHandleFlag;
+
 Status SeparateHelper::TransToSeparate(
     const Slice& internal_key, LazyBuffer& value, uint64_t file_number,
     const Slice& meta, bool is_merge, bool is_index,
-    const ValueExtractor* value_meta_extractor) {
+    const ValueExtractor* value_meta_extractor, uint64_t handle_offset,
+    uint64_t handle_size) {
   assert(file_number != uint64_t(-1));
+  assert((file_number & kValueHandleFlag) == 0);
+  uint64_t encoded_file_number = file_number;
+  char handle_buf[kMaxVarint64Length * 2];
+  Slice handle;
+  if (handle_size != 0) {
+    encoded_file_number |= kValueHandleFlag;
+    char* end = EncodeVarint64(handle_buf, handle_offset);
+    end = EncodeVarint64(end, handle_size);
+    handle = Slice(handle_buf, end - handle_buf);
+  }
   if (value_meta_extractor == nullptr || is_merge) {
-    value.reset(EncodeFileNumber(file_number), true, file_number);
+    Slice parts[] = {EncodeFileNumber(encoded_file_number), handle};
+    value.reset(SliceParts(parts, 2), file_number);
     return Status::OK();
   }
   if (is_index) {
-    Slice parts[] = {EncodeFileNumber(file_number), meta};
-    value.reset(SliceParts(parts, 2), file_number);
+    Slice parts[] = {EncodeFileNumber(encoded_file_number), handle, meta};
+    value.reset(SliceParts(parts, 3), file_number);
     return Status::OK();
   } else {
     auto s = value.fetch();
@@ -220,8 +234,9 @@ Status SeparateHelper::TransToSeparate(
     s = value_meta_extractor->Extract(ExtractUserKey(internal_key),
                                       value.slice(), &value_meta);
     if (s.ok()) {
-      Slice parts[] = {EncodeFileNumber(file_number), value_meta};
-      value.reset(SliceParts(parts, 2), file_number);
+      Slice parts[] = {EncodeFileNumber(encoded_file_number), handle,
+                       value_meta};
+      value.reset(SliceParts(parts, 3), file_number);
     }
     return s;
   }
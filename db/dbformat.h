@@ -784,17 +784,24 @@ struct ParsedInternalKeyComparator {
   const InternalKeyComparator* cmp;
 };
 
+// Value index layout
+//   fixed64 file_number
+//   [varint64 offset, varint64 size]  if file_number & kValueHandleFlag
+//   value meta
 class SeparateHelper {
  public:
   virtual ~SeparateHelper() = default;
 
+  // Set in the encoded file number if a value handle follows it
+  static constexpr uint64_t kValueHandleFlag = 1ULL << 63;
+
   static Slice EncodeFileNumber(uint64_t& file_number) {
     if (!port::kLittleEndian) {
       file_number = EndianTransform(file_number, sizeof file_number);
     }
     return Slice(reinterpret_cast<char*>(&file_number), sizeof file_number);
   }
-  static uint64_t DecodeFileNumber(const Slice& slice) {
+  static uint64_t DecodeRawFileNumber(const Slice& slice) {
     assert(slice.size() >= sizeof(uint64_t));
     uint64_t file_number;
     memcpy(&file_number, slice.data(), sizeof(uint64_t));
@@ -803,23 +810,50 @@ class SeparateHelper {
     }
     return file_number;
   }
+  static uint64_t DecodeFileNumber(const Slice& slice) {
+    return DecodeRawFileNumber(slice) & ~kValueHandleFlag;
+  }
+  // Decode the (offset, size) handle of the value inside its blob file,
+  // return false if the value index doesn't carry one
+  static bool DecodeValueHandle(const Slice& slice, uint64_t* offset,
+                                uint64_t* size) {
+    if ((DecodeRawFileNumber(slice) & kValueHandleFlag) == 0) {
+      return false;
+    }
+    Slice input(slice.data() + sizeof(uint64_t),
+                slice.size() - sizeof(uint64_t));
+    return GetVarint64(&input, offset) && GetVarint64(&input, size);
+  }
   static Slice DecodeValueMeta(const Slice& slice) {
     assert(slice.size() >= sizeof(uint64_t));
-    return Slice(slice.data() + sizeof(uint64_t),
-                 slice.size() - sizeof(uint64_t));
+    Slice meta(slice.data() + sizeof(uint64_t),
+               slice.size() - sizeof(uint64_t));
+    if ((DecodeRawFileNumber(slice) & kValueHandleFlag) != 0) {
+      uint64_t offset, size;
+      GetVarint64(&meta, &offset);
+      GetVarint64(&meta, &size);
+    }
+    return meta;
   }
 
+  // handle_size == 0 means the blob value has no direct handle
   static Status TransToSeparate(const Slice& internal_key, LazyBuffer& value,
                                 uint64_t file_number, const Slice& meta,
                                 bool is_merge, bool is_index,
-                                const ValueExtractor* value_meta_extractor);
+                                const ValueExtractor* value_meta_extractor,
+                                uint64_t handle_offset = 0,
+                                uint64_t handle_size = 0);
 
+  // Re-encodes the value index of a value kept in its blob file, a handle
+  // of the value in that file is kept as well
   virtual Status TransToSeparate(const Slice& internal_key, LazyBuffer& value,
                                  const Slice& meta, bool is_merge,
-                                 bool is_index) {
+                                 bool is_index, uint64_t handle_offset,
+                                 uint64_t handle_size) {
     assert(value.file_number() != uint64_t(-1));
     return TransToSeparate(internal_key, value, value.file_number(), meta,
-                           is_merge, is_index, nullptr);
+                           is_merge, is_index, nullptr, handle_offset,
+                           handle_size);
   }
 
   virtual Status TransToSeparate(const Slice& /*internal_key*/,
@@ -829,6 +863,14 @@ class SeparateHelper {
 
   virtual LazyBuffer TransToCombined(const Slice& user_key, uint64_t sequence,
                                      const LazyBuffer& value) const = 0;
+
+  // Hint that the combined values returned by TransToCombined() will be
+  // fetched soon, so the blob blocks of nearby values are read ahead
+  // together. Only a readahead hint, it does nothing under direct I/O.
+  // Values that are already fetched, addressed by key instead of by blob
+  // handle, or not combined by this helper are ignored.
+  virtual void PrefetchCombined(LazyBuffer* const* /*values*/,
+                                size_t /*n*/) const {}
 };
 
 extern Slice ArenaPinSlice(const Slice& slice, Arena* arena);
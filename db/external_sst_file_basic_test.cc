@@ -748,6 +748,77 @@ TEST_P(ExternalSSTFileBasicTest, IngestionWithRangeDeletions) {
   ASSERT_EQ(2, NumTableFilesAtLevel(options.num_levels - 1));
 }
 
+TEST_F(ExternalSSTFileBasicTest, IngestSeparatedValues) {
+  Options options = CurrentOptions();
+  options.blob_size = 64;
+  DestroyAndReopen(options);
+  auto blob_count = [&] {
+    auto cfd = static_cast<ColumnFamilyHandleImpl*>(db_->DefaultColumnFamily())
+                   ->cfd();
+    return cfd->current()->storage_info()->LevelFiles(-1).size();
+  };
+  auto large_value = [](int k) { return std::string(128, 'a' + k % 26); };
+
+  // Overlaps with the file, which gets a global seqno
+  ASSERT_OK(Put(Key(10), "old"));
+  ASSERT_OK(Flush());
+  ASSERT_EQ(0U, blob_count());
+
+  SstFileWriter sst_file_writer(EnvOptions(), options);
+  std::string file1 = sst_files_dir_ + "file1.sst";
+  std::string blob1 = sst_files_dir_ + "blob1.sst";
+  ASSERT_OK(sst_file_writer.Open(file1, blob1));
+  for (int k = 0; k < 100; k++) {
+    if (k % 2 == 0) {
+      ASSERT_OK(sst_file_writer.Put(Key(k), large_value(k)));
+    } else {
+      ASSERT_OK(sst_file_writer.Put(Key(k), Key(k) + "_val"));
+    }
+  }
+  ExternalSstFileInfo file1_info;
+  ASSERT_OK(sst_file_writer.Finish(&file1_info));
+  ASSERT_EQ(file1_info.num_entries, 100);
+  ASSERT_EQ(file1_info.blob_file_path, blob1);
+  ASSERT_EQ(file1_info.blob_num_entries, 50);
+  ASSERT_GT(file1_info.blob_file_size, 50 * 128);
+  ASSERT_LT(file1_info.file_size, file1_info.blob_file_size);
+
+  // The key sst can't be ingested without its blob sst and vice versa
+  IngestExternalFileOptions ifo;
+  ASSERT_TRUE(db_->IngestExternalFile({file1}, ifo).IsInvalidArgument());
+  ASSERT_TRUE(db_->IngestExternalFile({blob1}, ifo).IsInvalidArgument());
+
+  ASSERT_OK(db_->IngestExternalFile({file1, blob1}, ifo));
+  ASSERT_EQ(1U, blob_count());
+  auto verify = [&] {
+    for (int k = 0; k < 100; k++) {
+      ASSERT_EQ(Get(Key(k)), k % 2 == 0 ? large_value(k) : Key(k) + "_val");
+    }
+  };
+  verify();
+
+  // No value is large enough, no blob sst is left
+  std::string file2 = sst_files_dir_ + "file2.sst";
+  std::string blob2 = sst_files_dir_ + "blob2.sst";
+  ASSERT_OK(sst_file_writer.Open(file2, blob2));
+  ASSERT_OK(sst_file_writer.Put(Key(200), "small"));
+  ExternalSstFileInfo file2_info;
+  ASSERT_OK(sst_file_writer.Finish(&file2_info));
+  ASSERT_EQ(file2_info.blob_file_path, "");
+  ASSERT_EQ(file2_info.blob_num_entries, 0);
+  ASSERT_TRUE(env_->FileExists(blob2).IsNotFound());
+  ASSERT_OK(db_->IngestExternalFile({file2}, ifo));
+  ASSERT_EQ(Get(Key(200)), "small");
+
+  Reopen(options);
+  verify();
+  ASSERT_OK(db_->CompactRange(CompactRangeOptions(), nullptr, nullptr));
+  verify();
+  ASSERT_EQ(Get(Key(200)), "small");
+
+  DestroyAndRecreateExternalSSTFilesDir();
+}
+
 INSTANTIATE_TEST_CASE_P(ExternalSSTFileBasicTest, ExternalSSTFileBasicTest,
                         testing::Bool());
 
@@ -17,6 +17,7 @@
 #include <string>
 #include <vector>
 
+#include "db/compaction.h"
 #include "db/version_edit.h"
 #include "rocksdb/terark_namespace.h"
 #include "table/merging_iterator.h"
@@ -45,6 +46,10 @@ Status ExternalSstFileIngestionJob::Prepare(
     }
     files_to_ingest_.push_back(file_to_ingest);
   }
+  status = PairBlobFiles();
+  if (!status.ok()) {
+    return status;
+  }
 
   for (const IngestedFileInfo& f : files_to_ingest_) {
     if (f.cf_id !=
@@ -60,15 +65,18 @@ Status ExternalSstFileIngestionJob::Prepare(
   if (num_files == 0) {
     return Status::InvalidArgument("The list of files is empty");
   } else if (num_files > 1) {
-    // Verify that passed files dont have overlapping ranges
+    // Verify that passed files dont have overlapping ranges, blob ssts are
+    // within the range of the files depending on them
     autovector<const IngestedFileInfo*> sorted_files;
     for (size_t i = 0; i < num_files; i++) {
-      sorted_files.push_back(&files_to_ingest_[i]);
+      if (!files_to_ingest_[i].is_blob) {
+        sorted_files.push_back(&files_to_ingest_[i]);
+      }
     }
     std::sort(sorted_files.begin(), sorted_files.end(),
               TERARK_FIELD_P(smallest_user_key) < *ucmp);
 
-    for (size_t i = 0; i < num_files - 1; i++) {
+    for (size_t i = 0; i + 1 < sorted_files.size(); i++) {
       if (ucmp->Compare(sorted_files[i]->largest_user_key,
                         sorted_files[i + 1]->smallest_user_key) >= 0) {
         return Status::NotSupported("Files have overlapping ranges");
@@ -139,6 +147,9 @@ Status ExternalSstFileIngestionJob::NeedsFlush(bool* flush_needed,
                                                SuperVersion* super_version) {
   autovector<Range> ranges;
   for (const IngestedFileInfo& file_to_ingest : files_to_ingest_) {
+    if (file_to_ingest.is_blob) {
+      continue;
+    }
     ranges.emplace_back(file_to_ingest.smallest_user_key,
                         file_to_ingest.largest_user_key);
   }
@@ -179,6 +190,9 @@ Status ExternalSstFileIngestionJob::Run() {
   // The levels that the files will be ingested into
 
   for (IngestedFileInfo& f : files_to_ingest_) {
+    if (f.is_blob) {
+      continue;
+    }
     SequenceNumber assigned_seqno = 0;
     if (ingestion_options_.ingest_behind) {
       status = CheckLevelForIngestedBehindFile(&f);
@@ -207,12 +221,46 @@ Status ExternalSstFileIngestionJob::Run() {
     prop.flags |= f.table_properties.num_range_deletions > 0
                       ? 0
                       : TablePropertyCache::kNoRangeDeletions;
+    prop.dependence = f.table_properties.dependence;
     edit_.AddFile(f.picked_level, f.fd.GetNumber(), f.fd.GetPathId(),
                   f.fd.GetFileSize(), f.smallest_internal_key(),
                   f.largest_internal_key(), f.assigned_seqno, f.assigned_seqno,
                   ingestion_options_.marked_for_compaction, prop);
   }
 
+  // Blob ssts are hidden, their values are looked up by the sequence number
+  // of the keys depending on them
+  auto& dependence_map = cfd_->current()->storage_info()->dependence_map();
+  for (IngestedFileInfo& f : files_to_ingest_) {
+    if (!f.is_blob) {
+      continue;
+    }
+    assert(f.paired_file >= 0);
+    status = AssignGlobalSeqnoForIngestedFile(
+        &f, files_to_ingest_[f.paired_file].assigned_seqno);
+    if (!status.ok()) {
+      return status;
+    }
+    TablePropertyCache prop;
+    prop.num_entries = f.table_properties.num_entries;
+    prop.num_deletions = f.table_properties.num_deletions;
+    prop.raw_key_size = f.table_properties.raw_key_size;
+    prop.raw_value_size = f.table_properties.raw_value_size;
+    prop.flags |= TablePropertyCache::kNoRangeDeletions;
+    prop.inheritance =
+        InheritanceTreeToSet(f.table_properties.inheritance_tree);
+    for (auto file_number : prop.inheritance) {
+      if (dependence_map.count(file_number) > 0) {
+        return Status::InvalidArgument(
+            "External blob file id conflicts with the DB, rewrite it");
+      }
+    }
+    f.picked_level = -1;
+    edit_.AddFile(-1, f.fd.GetNumber(), f.fd.GetPathId(), f.fd.GetFileSize(),
+                  f.smallest_internal_key(), f.largest_internal_key(),
+                  f.assigned_seqno, f.assigned_seqno, 0, prop);
+  }
+
   if (consumed_seqno) {
     versions_->SetLastAllocatedSequence(last_seqno + 1);
     versions_->SetLastPublishedSequence(last_seqno + 1);
@@ -228,6 +276,14 @@ void ExternalSstFileIngestionJob::UpdateStats() {
   uint64_t total_l0_files = 0;
   uint64_t total_time = env_->NowMicros() - job_start_time_;
   for (IngestedFileInfo& f : files_to_ingest_) {
+    if (f.is_blob) {
+      // Accounted to the level of the file depending on it
+      continue;
+    }
+    uint64_t file_size = f.fd.GetFileSize();
+    if (f.paired_file >= 0) {
+      file_size += files_to_ingest_[f.paired_file].fd.GetFileSize();
+    }
     InternalStats::CompactionStats stats(
         CompactionReason::kExternalSstIngestion, 1);
     stats.micros = total_time;
@@ -236,14 +292,14 @@ void ExternalSstFileIngestionJob::UpdateStats() {
     // the bytes written for file metadata.
     // TODO (yanqin) maybe account for file metadata bytes for exact accuracy?
     if (f.copy_file) {
-      stats.bytes_written = f.fd.GetFileSize();
+      stats.bytes_written = file_size;
     } else {
-      stats.bytes_moved = f.fd.GetFileSize();
+      stats.bytes_moved = file_size;
     }
-    stats.num_output_files = 1;
+    stats.num_output_files = f.paired_file >= 0 ? 2 : 1;
     cfd_->internal_stats()->AddCompactionStats(f.picked_level, stats);
     cfd_->internal_stats()->AddCFStats(InternalStats::BYTES_INGESTED_ADD_FILE,
-                                       f.fd.GetFileSize());
+                                       file_size);
     total_keys += f.num_entries;
     if (f.picked_level == 0) {
       total_l0_files += 1;
@@ -443,6 +499,8 @@ Status ExternalSstFileIngestionJob::GetIngestedFileInfo(
   }
 
   file_to_ingest->cf_id = static_cast<uint32_t>(props->column_family_id);
+  // Only the blob ssts of SstFileWriter carry an inheritance tree
+  file_to_ingest->is_blob = !props->inheritance_tree.empty();
 
   file_to_ingest->table_properties = *props;
 
@@ -567,6 +625,42 @@ Status ExternalSstFileIngestionJob::AssignGlobalSeqnoForIngestedFile(
   return Status::OK();
 }
 
+Status ExternalSstFileIngestionJob::PairBlobFiles() {
+  for (size_t i = 0; i < files_to_ingest_.size(); i++) {
+    IngestedFileInfo& f = files_to_ingest_[i];
+    auto& dependence = f.table_properties.dependence;
+    if (f.is_blob || dependence.empty()) {
+      continue;
+    }
+    if (dependence.size() > 1) {
+      return Status::NotSupported(
+          "External file depends on more than one blob file");
+    }
+    for (size_t j = 0; j < files_to_ingest_.size(); j++) {
+      IngestedFileInfo& blob = files_to_ingest_[j];
+      auto& tree = blob.table_properties.inheritance_tree;
+      if (blob.is_blob && blob.paired_file < 0 &&
+          std::find(tree.begin(), tree.end(),
+                    dependence.front().file_number) != tree.end()) {
+        f.paired_file = static_cast<int>(j);
+        blob.paired_file = static_cast<int>(i);
+        break;
+      }
+    }
+    if (f.paired_file < 0) {
+      return Status::InvalidArgument("External blob file not found",
+                                     f.external_file_path);
+    }
+  }
+  for (const IngestedFileInfo& f : files_to_ingest_) {
+    if (f.is_blob && f.paired_file < 0) {
+      return Status::InvalidArgument("External blob file is not referenced",
+                                     f.external_file_path);
+    }
+  }
+  return Status::OK();
+}
+
 bool ExternalSstFileIngestionJob::IngestedFileFitInLevel(
     const IngestedFileInfo* file_to_ingest, int level) {
   if (level == 0) {
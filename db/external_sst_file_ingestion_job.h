@@ -58,6 +58,12 @@ struct IngestedFileInfo {
   // ingestion_options.move_files is false by default, thus copy_file is true
   // by default.
   bool copy_file = true;
+  // Whether this is a blob sst holding the separated values of another
+  // ingested file, see SstFileWriter::Open
+  bool is_blob = false;
+  // Index in the ingested files of the blob sst this file depends on, or of
+  // the file which depends on this blob sst, -1 if none
+  int paired_file = -1;
 
   InternalKey smallest_internal_key() const {
     return InternalKey(smallest_user_key, assigned_seqno,
@@ -147,6 +153,9 @@ class ExternalSstFileIngestionJob {
   bool IngestedFileFitInLevel(const IngestedFileInfo* file_to_ingest,
                               int level);
 
+  // Pair every file with separated values with its blob sst
+  Status PairBlobFiles();
+
   Env* env_;
   VersionSet* versions_;
   ColumnFamilyData* cfd_;
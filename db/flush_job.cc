@@ -33,6 +33,7 @@
 #include "monitoring/perf_context_imp.h"
 #include "monitoring/thread_status_util.h"
 #include "port/port.h"
+#include "rocksdb/compaction_dispatcher.h"
 #include "rocksdb/db.h"
 #include "rocksdb/env.h"
 #include "rocksdb/statistics.h"
@@ -231,9 +232,23 @@ Status FlushJob::Run(LogsWithPrepTracker* prep_tracker) {
     prev_prepare_write_nanos = IOSTATS(prepare_write_nanos);
   }
 
+  // The flush takes a local thread the dispatcher could place compactions on
+  CompactionDispatcher* dispatcher = cfd_->compaction_dispatcher();
+  uint64_t input_bytes = 0;
+  for (auto* mem : mems_) {
+    input_bytes += mem->ApproximateMemoryUsage();
+  }
+  if (dispatcher != nullptr) {
+    dispatcher->OnLocalJobStarted(input_bytes);
+  }
+
   // This will release and re-acquire the mutex.
   Status s = WriteLevel0Table();
 
+  if (dispatcher != nullptr) {
+    dispatcher->OnLocalJobFinished(input_bytes);
+  }
+
   if (s.ok() &&
       (shutting_down_->load(std::memory_order_acquire) || cfd_->IsDropped())) {
     s = Status::ShutdownInProgress(
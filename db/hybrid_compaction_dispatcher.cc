@@ -0,0 +1,154 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#include <algorithm>
+#include <cassert>
+#include <mutex>
+
+#include "rocksdb/compaction_dispatcher.h"
+#include "rocksdb/options.h"
+#include "rocksdb/terark_namespace.h"
+
+namespace TERARKDB_NAMESPACE {
+
+namespace {
+
+class HybridCompactionDispatcher : public CompactionDispatcher {
+ public:
+  HybridCompactionDispatcher(std::shared_ptr<CompactionDispatcher> remote,
+                             const HybridCompactionDispatcherOptions& options)
+      : remote_dispatcher_(std::move(remote)), options_(options) {
+    double bytes_per_micro =
+        std::max<uint64_t>(options_.initial_bytes_per_second, 1) / 1e6;
+    local_.slots = std::max(options_.local_slots, 1);
+    local_.overhead_micros = 0;
+    local_.bytes_per_micro = bytes_per_micro;
+    remote_.slots = std::max(options_.remote_slots, 1);
+    remote_.overhead_micros = double(options_.remote_overhead_micros);
+    remote_.bytes_per_micro = bytes_per_micro;
+  }
+
+  std::function<CompactionWorkerResult()> StartCompaction(
+      const CompactionWorkerContext& context) override {
+    return remote_dispatcher_->StartCompaction(context);
+  }
+
+  const char* Name() const override { return "HybridCompactionDispatcher"; }
+
+  void CancelCompactions(const void* owner) override {
+    remote_dispatcher_->CancelCompactions(owner);
+  }
+
+  bool ShouldDispatch(const CompactionJobEstimate& estimate) override {
+    double cost = Cost(estimate);
+    std::lock_guard<std::mutex> lock(mutex_);
+    bool dispatch;
+    if (estimate.level == 0 &&
+        estimate.input_bytes <= options_.local_only_bytes) {
+      dispatch = false;
+    } else {
+      dispatch = remote_.ExpectedMicros(cost) < local_.ExpectedMicros(cost);
+    }
+    Route& route = dispatch ? remote_ : local_;
+    ++route.running;
+    route.running_cost += cost;
+    return dispatch;
+  }
+
+  void OnCompactionFinished(const CompactionJobEstimate& estimate,
+                            bool dispatched, const Status& status,
+                            uint64_t elapsed_micros) override {
+    double cost = Cost(estimate);
+    std::lock_guard<std::mutex> lock(mutex_);
+    Route& route = dispatched ? remote_ : local_;
+    route.Finish(cost);
+    // Tiny compactions are dominated by noise, failed ones didn't do all the
+    // work or never started
+    if (status.ok() && estimate.input_bytes >= kMinSampleBytes) {
+      double busy_micros =
+          std::max(double(elapsed_micros) - route.overhead_micros, 1.0);
+      route.bytes_per_micro =
+          route.bytes_per_micro * (1 - kSampleWeight) +
+          cost / busy_micros * kSampleWeight;
+    }
+  }
+
+  void OnLocalJobStarted(uint64_t input_bytes) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++local_.running;
+    local_.running_cost += double(input_bytes);
+  }
+
+  void OnLocalJobFinished(uint64_t input_bytes) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    local_.Finish(double(input_bytes));
+  }
+
+  bool IsOverloaded() const override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    double max_backlog = double(options_.max_backlog_micros);
+    return local_.BacklogMicros() > max_backlog &&
+           remote_.BacklogMicros() > max_backlog;
+  }
+
+ private:
+  static constexpr uint64_t kMinSampleBytes = 1ull << 20;
+  static constexpr double kSampleWeight = 0.2;
+
+  struct Route {
+    int slots;
+    double overhead_micros;
+    // Throughput of a single slot
+    double bytes_per_micro;
+    size_t running = 0;
+    double running_cost = 0;
+
+    void Finish(double cost) {
+      assert(running > 0);
+      --running;
+      running_cost = running == 0 ? 0 : std::max(running_cost - cost, 0.0);
+    }
+
+    double BacklogMicros() const {
+      return running_cost / (slots * bytes_per_micro);
+    }
+
+    double ExpectedMicros(double cost) const {
+      // Once all slots are taken, a compaction waits for its share of the
+      // running ones
+      double wait_micros = running >= size_t(slots) ? BacklogMicros() : 0;
+      return overhead_micros + wait_micros + cost / bytes_per_micro;
+    }
+  };
+
+  double Cost(const CompactionJobEstimate& estimate) const {
+    double cost = double(estimate.input_bytes);
+    if (estimate.separation_type == kCompactionForceRebuildBlob ||
+        estimate.separation_type == kCompactionCombineValue) {
+      cost *= options_.blob_rebuild_cost_ratio;
+    }
+    return cost;
+  }
+
+  std::shared_ptr<CompactionDispatcher> remote_dispatcher_;
+  const HybridCompactionDispatcherOptions options_;
+  mutable std::mutex mutex_;
+  Route local_;
+  Route remote_;
+};
+
+constexpr uint64_t HybridCompactionDispatcher::kMinSampleBytes;
+constexpr double HybridCompactionDispatcher::kSampleWeight;
+
+}  // namespace
+
+std::shared_ptr<CompactionDispatcher> NewHybridCompactionDispatcher(
+    std::shared_ptr<CompactionDispatcher> remote,
+    const HybridCompactionDispatcherOptions& options) {
+  return std::make_shared<HybridCompactionDispatcher>(std::move(remote),
+                                                      options);
+}
+
+}  // namespace TERARKDB_NAMESPACE
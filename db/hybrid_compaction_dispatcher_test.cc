@@ -0,0 +1,159 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#include "db/compaction.h"
+#include "rocksdb/compaction_dispatcher.h"
+#include "rocksdb/terark_namespace.h"
+#include "util/testharness.h"
+
+namespace TERARKDB_NAMESPACE {
+
+namespace {
+
+class CountingDispatcher : public CompactionDispatcher {
+ public:
+  std::function<CompactionWorkerResult()> StartCompaction(
+      const CompactionWorkerContext& /*context*/) override {
+    ++started;
+    return [] {
+      CompactionWorkerResult result;
+      result.status = Status::OK();
+      return result;
+    };
+  }
+
+  const char* Name() const override { return "CountingDispatcher"; }
+
+  void CancelCompactions(const void* /*owner*/) override { ++cancelled; }
+
+  int started = 0;
+  int cancelled = 0;
+};
+
+}  // namespace
+
+class HybridCompactionDispatcherTest : public testing::Test {
+ public:
+  HybridCompactionDispatcherTest() : remote_(new CountingDispatcher) {
+    options_.local_slots = 1;
+    options_.remote_slots = 4;
+    options_.local_only_bytes = 8 << 20;
+    options_.remote_overhead_micros = 100000;
+    options_.initial_bytes_per_second = 100 << 20;
+    options_.max_backlog_micros = 10 * 1000000;
+    dispatcher_ = NewHybridCompactionDispatcher(remote_, options_);
+  }
+
+  static CompactionJobEstimate Estimate(int level, uint64_t input_bytes) {
+    CompactionJobEstimate estimate;
+    estimate.level = level;
+    estimate.output_level = level + 1;
+    estimate.input_bytes = input_bytes;
+    return estimate;
+  }
+
+  std::shared_ptr<CountingDispatcher> remote_;
+  HybridCompactionDispatcherOptions options_;
+  std::shared_ptr<CompactionDispatcher> dispatcher_;
+};
+
+TEST_F(HybridCompactionDispatcherTest, SmallL0StaysLocal) {
+  // Even with the local slot taken
+  auto busy = Estimate(2, 1 << 30);
+  ASSERT_FALSE(dispatcher_->ShouldDispatch(busy));
+  auto l0 = Estimate(0, 4 << 20);
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_FALSE(dispatcher_->ShouldDispatch(l0));
+  }
+  // Larger L0 compactions are placed like any other
+  ASSERT_TRUE(dispatcher_->ShouldDispatch(Estimate(0, 64 << 20)));
+}
+
+TEST_F(HybridCompactionDispatcherTest, SpillsToRemoteWhenLocalIsBusy) {
+  auto job = Estimate(1, 64 << 20);
+  // Idle local slot wins, remote costs its overhead
+  ASSERT_FALSE(dispatcher_->ShouldDispatch(job));
+  // The local slot is taken now
+  ASSERT_TRUE(dispatcher_->ShouldDispatch(job));
+  ASSERT_TRUE(dispatcher_->ShouldDispatch(job));
+
+  dispatcher_->OnCompactionFinished(job, false, Status::OK(), 640000);
+  ASSERT_FALSE(dispatcher_->ShouldDispatch(job));
+}
+
+TEST_F(HybridCompactionDispatcherTest, LocalJobsTakeSlots) {
+  auto job = Estimate(1, 64 << 20);
+  // A flush holds the local slot
+  dispatcher_->OnLocalJobStarted(64 << 20);
+  ASSERT_TRUE(dispatcher_->ShouldDispatch(job));
+  dispatcher_->OnLocalJobFinished(64 << 20);
+  ASSERT_FALSE(dispatcher_->ShouldDispatch(job));
+}
+
+TEST_F(HybridCompactionDispatcherTest, LearnsThroughput) {
+  auto job = Estimate(1, 64 << 20);
+  ASSERT_FALSE(dispatcher_->ShouldDispatch(job));
+  // Local compacts much slower than expected
+  dispatcher_->OnCompactionFinished(job, false, Status::OK(), 60 * 1000000);
+  ASSERT_TRUE(dispatcher_->ShouldDispatch(job));
+  dispatcher_->OnCompactionFinished(job, true, Status::OK(), 200000);
+  // Remote stays preferred with both sides idle
+  ASSERT_TRUE(dispatcher_->ShouldDispatch(job));
+  dispatcher_->OnCompactionFinished(job, true, Status::OK(), 200000);
+
+  // Blob rebuilding costs more, but on both sides alike
+  job.separation_type = kCompactionForceRebuildBlob;
+  ASSERT_TRUE(dispatcher_->ShouldDispatch(job));
+  dispatcher_->OnCompactionFinished(job, true, Status::OK(), 300000);
+}
+
+TEST_F(HybridCompactionDispatcherTest, IgnoresFailedSamples) {
+  auto job = Estimate(1, 64 << 20);
+  ASSERT_FALSE(dispatcher_->ShouldDispatch(job));
+  // A local compaction which failed late tells nothing of the local speed
+  dispatcher_->OnCompactionFinished(job, false, Status::IOError("disk"),
+                                    60 * 1000000);
+  ASSERT_FALSE(dispatcher_->ShouldDispatch(job));
+  ASSERT_TRUE(dispatcher_->ShouldDispatch(job));
+  // Neither does a remote one which failed right away of the remote speed
+  dispatcher_->OnCompactionFinished(job, true, Status::Aborted("worker"), 1);
+  dispatcher_->OnCompactionFinished(job, false, Status::OK(), 640000);
+  ASSERT_FALSE(dispatcher_->ShouldDispatch(job));
+}
+
+TEST_F(HybridCompactionDispatcherTest, Overload) {
+  ASSERT_FALSE(dispatcher_->IsOverloaded());
+  // 2GB at 100MB/s exceeds the 10 seconds backlog of the local slot
+  auto big = Estimate(3, 2ull << 30);
+  ASSERT_FALSE(dispatcher_->ShouldDispatch(big));
+  ASSERT_FALSE(dispatcher_->IsOverloaded());
+  int dispatched = 0;
+  while (!dispatcher_->IsOverloaded()) {
+    ASSERT_TRUE(dispatcher_->ShouldDispatch(big));
+    ++dispatched;
+    ASSERT_LE(dispatched, 4);
+  }
+  // 2 of them exceed the backlog of 4 remote slots
+  ASSERT_EQ(2, dispatched);
+  dispatcher_->OnCompactionFinished(big, true, Status::OK(), 20 * 1000000);
+  ASSERT_FALSE(dispatcher_->IsOverloaded());
+}
+
+TEST_F(HybridCompactionDispatcherTest, ForwardsToRemote) {
+  CompactionWorkerContext context;
+  auto result = dispatcher_->StartCompaction(context)();
+  ASSERT_OK(result.status);
+  ASSERT_EQ(1, remote_->started);
+  dispatcher_->CancelCompactions(nullptr);
+  ASSERT_EQ(1, remote_->cancelled);
+  ASSERT_STREQ("HybridCompactionDispatcher", dispatcher_->Name());
+}
+
+}  // namespace TERARKDB_NAMESPACE
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
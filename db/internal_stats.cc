@@ -61,6 +61,10 @@ namespace {
 const double kMB = 1048576.0;
 const double kGB = kMB * 1024;
 const double kMicrosInSec = 1000000.0;
+// Sampled lookups of a level needed to judge its filters
+const uint64_t kMinLevelLookups = 64;
+// The counters of a level are halved at twice this many sampled lookups
+const uint64_t kLevelLookupWindow = 2048;
 
 void PrintLevelStatsHeader(char* buf, size_t len, const std::string& cf_name) {
   int written_size =
@@ -239,6 +243,8 @@ static const std::string num_deletes_imm_mem_tables =
 static const std::string estimate_num_keys = "estimate-num-keys";
 static const std::string estimate_table_readers_mem =
     "estimate-table-readers-mem";
+static const std::string estimate_map_sst_index_mem =
+    "estimate-map-sst-index-mem";
 static const std::string is_file_deletions_enabled =
     "is-file-deletions-enabled";
 static const std::string num_snapshots = "num-snapshots";
@@ -314,6 +320,8 @@ const std::string DB::Properties::kEstimateNumKeys =
     rocksdb_prefix + estimate_num_keys;
 const std::string DB::Properties::kEstimateTableReadersMem =
     rocksdb_prefix + estimate_table_readers_mem;
+const std::string DB::Properties::kEstimateMapSstIndexMem =
+    rocksdb_prefix + estimate_map_sst_index_mem;
 const std::string DB::Properties::kIsFileDeletionsEnabled =
     rocksdb_prefix + is_file_deletions_enabled;
 const std::string DB::Properties::kNumSnapshots =
@@ -427,6 +435,9 @@ const std::unordered_map<std::string, DBPropertyInfo>
         {DB::Properties::kEstimateTableReadersMem,
          {true, nullptr, &InternalStats::HandleEstimateTableReadersMem, nullptr,
           nullptr}},
+        {DB::Properties::kEstimateMapSstIndexMem,
+         {true, nullptr, &InternalStats::HandleEstimateMapSstIndexMem, nullptr,
+          nullptr}},
         {DB::Properties::kIsFileDeletionsEnabled,
          {false, nullptr, &InternalStats::HandleIsFileDeletionsEnabled, nullptr,
           nullptr}},
@@ -833,6 +844,14 @@ bool InternalStats::HandleEstimateTableReadersMem(uint64_t* value,
   return true;
 }
 
+bool InternalStats::HandleEstimateMapSstIndexMem(uint64_t* value,
+                                                 DBImpl* /*db*/,
+                                                 Version* version) {
+  *value =
+      (version == nullptr) ? 0 : version->GetMemoryUsageByMapSstIndexes();
+  return true;
+}
+
 bool InternalStats::HandleEstimateLiveDataSize(uint64_t* value, DBImpl* /*db*/,
                                                Version* version) {
   const auto* vstorage = version->storage_info();
@@ -1294,7 +1313,7 @@ void InternalStats::DumpCFStatsNoFileHistogram(std::string* value) {
     compact_bytes_lsm_write += comp_stats_[level].bytes_written;
     compact_micros += comp_stats_[level].micros;
   }
-  compact_bytes_read += comp_blob_stat_.bytes_read_non_output_levels +
+  compact_bytes_read += comp_blob_stat_.bytes_read_output_level +
                         comp_blob_stat_.bytes_read_non_output_levels;
   compact_bytes_write += comp_blob_stat_.bytes_written +
                          comp_blob_stat_.bytes_blob_written +
@@ -1311,11 +1330,27 @@ void InternalStats::DumpCFStatsNoFileHistogram(std::string* value) {
 
   snprintf(buf, sizeof(buf),
            "Cumulative compaction: %.2f GB (write-lsm), %.2f GB "
-           "(write-rebuild), %.2f GB (write-gc)",
+           "(write-rebuild), %.2f GB (write-gc)\n",
            compact_bytes_lsm_write / kGB, compact_bytes_rebuild_write / kGB,
            comp_blob_stat_.bytes_blob_written / kGB);
   value->append(buf);
 
+  // Garbage collection throughput, measured against time spent in GC jobs
+  // (subcompactions of a job run in parallel)
+  uint64_t gc_bytes_read = comp_blob_stat_.bytes_read_output_level +
+                           comp_blob_stat_.bytes_read_non_output_levels;
+  uint64_t gc_bytes_write = comp_blob_stat_.bytes_blob_written;
+  double gc_seconds = comp_blob_stat_.micros / kMicrosInSec;
+  snprintf(buf, sizeof(buf),
+           "Cumulative GC: %d jobs, %.2f GB read, %.2f MB/s read, "
+           "%.2f GB write, %.2f MB/s write, %.1f seconds\n",
+           comp_blob_stat_.count, gc_bytes_read / kGB,
+           gc_seconds > 0 ? gc_bytes_read / kMB / gc_seconds : 0.0,
+           gc_bytes_write / kGB,
+           gc_seconds > 0 ? gc_bytes_write / kMB / gc_seconds : 0.0,
+           gc_seconds);
+  value->append(buf);
+
   // Compaction interval
   uint64_t interval_compact_bytes_write =
       compact_bytes_write - cf_stats_snapshot_.compact_bytes_write;
@@ -1377,6 +1412,31 @@ void InternalStats::DumpCFStatsNoFileHistogram(std::string* value) {
   cf_stats_snapshot_.stall_count = total_stall_count;
 }
 
+void InternalStats::RecordLevelLookup(int level, bool found) {
+  assert(level >= 0 && level < number_levels_);
+  auto& stats = level_lookup_stats_[level];
+  if (found) {
+    stats.hits.fetch_add(1, std::memory_order_relaxed);
+  }
+  uint64_t lookups = stats.lookups.fetch_add(1, std::memory_order_relaxed) + 1;
+  if (lookups == 2 * kLevelLookupWindow) {
+    // Concurrent samples may be lost, which doesn't matter for a ratio
+    stats.hits.store(stats.hits.load(std::memory_order_relaxed) / 2,
+                     std::memory_order_relaxed);
+    stats.lookups.store(kLevelLookupWindow, std::memory_order_relaxed);
+  }
+}
+
+bool InternalStats::FilterRarelyUseful(int level, double hit_ratio) const {
+  if (hit_ratio <= 0 || level < 0 || level >= number_levels_) {
+    return false;
+  }
+  auto& stats = level_lookup_stats_[level];
+  uint64_t lookups = stats.lookups.load(std::memory_order_relaxed);
+  uint64_t hits = stats.hits.load(std::memory_order_relaxed);
+  return lookups >= kMinLevelLookups && hits >= hit_ratio * lookups;
+}
+
 void InternalStats::DumpCFFileHistogram(std::string* value) {
   char buf[2000];
   snprintf(buf, sizeof(buf),
@@ -1393,6 +1453,19 @@ void InternalStats::DumpCFFileHistogram(std::string* value) {
       value->append(buf2);
     }
   }
+
+  for (int level = 0; level < number_levels_; level++) {
+    uint64_t lookups =
+        level_lookup_stats_[level].lookups.load(std::memory_order_relaxed);
+    if (lookups > 0) {
+      snprintf(buf, sizeof(buf),
+               "** Level %d sampled lookups: %" PRIu64 ", found: %" PRIu64
+               "\n",
+               level, lookups,
+               level_lookup_stats_[level].hits.load(std::memory_order_relaxed));
+      value->append(buf);
+    }
+  }
 }
 
 #else
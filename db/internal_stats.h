@@ -9,7 +9,9 @@
 //
 
 #pragma once
+#include <atomic>
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -129,6 +131,7 @@ class InternalStats {
         cf_stats_count_{},
         comp_stats_(num_levels),
         file_read_latency_(num_levels),
+        level_lookup_stats_(new LevelLookupStats[num_levels]),
         bg_error_count_(0),
         number_levels_(num_levels),
         env_(env),
@@ -301,6 +304,10 @@ class InternalStats {
     for (auto& h : file_read_latency_) {
       h.Clear();
     }
+    for (int i = 0; i < number_levels_; i++) {
+      level_lookup_stats_[i].lookups.store(0, std::memory_order_relaxed);
+      level_lookup_stats_[i].hits.store(0, std::memory_order_relaxed);
+    }
     cf_stats_snapshot_.Clear();
     db_stats_snapshot_.Clear();
     bg_error_count_ = 0;
@@ -347,6 +354,15 @@ class InternalStats {
     return &file_read_latency_[level];
   }
 
+  // Records a sampled point lookup that reached a file of the level, found
+  // if the key was there. Older samples decay.
+  void RecordLevelLookup(int level, bool found);
+
+  // True if at least hit_ratio of the sampled lookups that reached the level
+  // found their key there, i.e. its filters rarely saved a read. False
+  // while there are too few samples.
+  bool FilterRarelyUseful(int level, double hit_ratio) const;
+
   uint64_t GetBackgroundErrorCount() const { return bg_error_count_; }
 
   uint64_t BumpAndGetBackgroundErrorCount() { return ++bg_error_count_; }
@@ -397,6 +413,12 @@ class InternalStats {
   std::vector<CompactionStats> comp_stats_;
   CompactionStats comp_blob_stat_;
   std::vector<HistogramImpl> file_read_latency_;
+  // Sampled point lookups per level, updated without the DB mutex
+  struct LevelLookupStats {
+    std::atomic<uint64_t> lookups{0};
+    std::atomic<uint64_t> hits{0};
+  };
+  std::unique_ptr<LevelLookupStats[]> level_lookup_stats_;
 
   // Used to compute per-interval statistics
   struct CFStatsSnapshot {
@@ -538,6 +560,8 @@ class InternalStats {
                                             Version* version);
   bool HandleEstimateTableReadersMem(uint64_t* value, DBImpl* db,
                                      Version* version);
+  bool HandleEstimateMapSstIndexMem(uint64_t* value, DBImpl* db,
+                                    Version* version);
   bool HandleEstimateLiveDataSize(uint64_t* value, DBImpl* db,
                                   Version* version);
   bool HandleMinLogNumberToKeep(uint64_t* value, DBImpl* db, Version* version);
@@ -638,6 +662,12 @@ class InternalStats {
 
   HistogramImpl* GetFileReadHist(int /*level*/) { return nullptr; }
 
+  void RecordLevelLookup(int /*level*/, bool /*found*/) {}
+
+  bool FilterRarelyUseful(int /*level*/, double /*hit_ratio*/) const {
+    return false;
+  }
+
   uint64_t GetBackgroundErrorCount() const { return 0; }
 
   uint64_t BumpAndGetBackgroundErrorCount() { return 0; }
@@ -24,6 +24,7 @@
 #include "db/builder.h"
 #include "db/dbformat.h"
 #include "db/event_helpers.h"
+#include "db/map_sst_index.h"
 #include "db/range_del_aggregator.h"
 #include "monitoring/thread_status_util.h"
 #include "rocksdb/terark_namespace.h"
@@ -549,7 +550,13 @@ Status LoadRangeWithDepend(std::vector<RangeWithDepend>& ranges, Arena* arena,
   MapSstElement map_element;
   for (size_t i = 0; i < n; ++i) {
     auto f = file_meta[i];
-    if (f->prop.is_map_sst()) {
+    if (f->map_index != nullptr) {
+      // Pinned when the version was built, no table access
+      for (size_t j = 0; j < f->map_index->size(); ++j) {
+        f->map_index->GetElement(j, &map_element);
+        ranges.emplace_back(map_element, arena);
+      }
+    } else if (f->prop.is_map_sst()) {
       auto iter = iterator_cache.GetIterator(f, nullptr);
       assert(iter != nullptr);
       if (!iter->status().ok()) {
@@ -0,0 +1,168 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#include "db/map_sst_index.h"
+
+#include <algorithm>
+
+#include "rocksdb/terark_namespace.h"
+#include "util/arena.h"
+#include "util/coding.h"
+
+namespace TERARKDB_NAMESPACE {
+
+namespace {
+
+class MapSstIndexIterator : public InternalIterator {
+ public:
+  MapSstIndexIterator(std::shared_ptr<const MapSstIndex> index,
+                      const InternalKeyComparator* icomp)
+      : index_(std::move(index)), icomp_(icomp), current_(index_->size()) {}
+
+  bool Valid() const override { return current_ < index_->size(); }
+  void SeekToFirst() override { current_ = 0; }
+  void SeekToLast() override {
+    current_ = index_->size() == 0 ? 0 : index_->size() - 1;
+  }
+  void Seek(const Slice& target) override {
+    current_ = index_->Seek(*icomp_, target);
+  }
+  void SeekForPrev(const Slice& target) override {
+    current_ = index_->Seek(*icomp_, target);
+    if (current_ == index_->size() ||
+        icomp_->Compare(key(), target) > 0) {
+      // Wraps around to size() past the first element
+      current_ = current_ == 0 ? index_->size() : current_ - 1;
+    }
+  }
+  void Next() override {
+    assert(Valid());
+    ++current_;
+  }
+  void Prev() override {
+    assert(Valid());
+    current_ = current_ == 0 ? index_->size() : current_ - 1;
+  }
+  Slice key() const override {
+    assert(Valid());
+    return index_->largest_key(index_->element(current_));
+  }
+  LazyBuffer value() const override {
+    assert(Valid());
+    return LazyBuffer(index_->value(index_->element(current_)));
+  }
+  Status status() const override { return Status::OK(); }
+
+ private:
+  std::shared_ptr<const MapSstIndex> index_;
+  const InternalKeyComparator* icomp_;
+  size_t current_;
+};
+
+}  // namespace
+
+Status MapSstIndex::Build(InternalIterator* iter,
+                          std::shared_ptr<const MapSstIndex>* index) {
+  const char* err_msg = "Invalid MapSstElement";
+  std::shared_ptr<MapSstIndex> result(new MapSstIndex);
+  for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+    LazyBuffer value = iter->value();
+    Status s = value.fetch();
+    if (!s.ok()) {
+      return s;
+    }
+    Slice key = iter->key();
+    Slice map_input = value.slice();
+    if (result->data_.size() + key.size() + map_input.size() >
+        port::kMaxUint32) {
+      return Status::NotSupported("MapSstIndex: map sst too large");
+    }
+    Element e;
+    e.key_offset = static_cast<uint32_t>(result->data_.size());
+    e.key_size = static_cast<uint32_t>(key.size());
+    e.value_size = static_cast<uint32_t>(map_input.size());
+    result->data_.append(key.data(), key.size());
+    const char* value_base = map_input.data();
+    uint32_t value_offset = static_cast<uint32_t>(result->data_.size());
+    result->data_.append(map_input.data(), map_input.size());
+
+    // Manual inline MapSstElement::Decode
+    uint64_t flags;
+    uint64_t link_count;
+    Slice smallest_key;
+    if (!GetVarint64(&map_input, &flags) ||
+        !GetVarint64(&map_input, &link_count) ||
+        !GetLengthPrefixedSlice(&map_input, &smallest_key) ||
+        link_count > map_input.size()) {
+      return Status::Corruption(err_msg);
+    }
+    e.smallest_offset =
+        value_offset + static_cast<uint32_t>(smallest_key.data() - value_base);
+    e.smallest_size = static_cast<uint32_t>(smallest_key.size());
+    e.link_count = static_cast<uint32_t>(link_count);
+    e.link_offset = result->links_.size();
+    e.flags = flags;
+    result->links_.resize(e.link_offset + link_count);
+    auto links = result->links_.begin() + e.link_offset;
+    for (uint64_t i = 0; i < link_count; ++i) {
+      if (!GetVarint64(&map_input, &links[i].file_number)) {
+        return Status::Corruption(err_msg);
+      }
+    }
+    for (uint64_t i = 0; i < link_count; ++i) {
+      if (!GetVarint64(&map_input, &links[i].size)) {
+        return Status::Corruption(err_msg);
+      }
+    }
+    result->elements_.push_back(e);
+  }
+  if (!iter->status().ok()) {
+    return iter->status();
+  }
+  result->data_.shrink_to_fit();
+  result->elements_.shrink_to_fit();
+  result->links_.shrink_to_fit();
+  *index = std::move(result);
+  return Status::OK();
+}
+
+size_t MapSstIndex::Seek(const InternalKeyComparator& icomp,
+                         const Slice& ikey) const {
+  auto it = std::lower_bound(elements_.begin(), elements_.end(), ikey,
+                             [&](const Element& e, const Slice& k) {
+                               return icomp.Compare(largest_key(e), k) < 0;
+                             });
+  return it - elements_.begin();
+}
+
+void MapSstIndex::GetElement(size_t i, MapSstElement* element) const {
+  const Element& e = elements_[i];
+  element->largest_key = largest_key(e);
+  element->smallest_key = smallest_key(e);
+  element->include_smallest = (e.flags & MapSstElement::kIncludeSmallest) != 0;
+  element->include_largest = (e.flags & MapSstElement::kIncludeLargest) != 0;
+  element->has_delete_range = (e.flags & MapSstElement::kHasDeleteRange) != 0;
+  element->marked_for_compaction =
+      (e.flags & MapSstElement::kMarkedForCompaction) != 0;
+  element->link.assign(links(e), links(e) + e.link_count);
+}
+
+size_t MapSstIndex::ApproximateMemoryUsage() const {
+  return sizeof(*this) + data_.capacity() +
+         elements_.capacity() * sizeof(Element) +
+         links_.capacity() * sizeof(MapSstElement::LinkTarget);
+}
+
+InternalIterator* MapSstIndex::NewIterator(
+    std::shared_ptr<const MapSstIndex> index,
+    const InternalKeyComparator* icomp, Arena* arena) {
+  if (arena == nullptr) {
+    return new MapSstIndexIterator(std::move(index), icomp);
+  }
+  auto mem = arena->AllocateAligned(sizeof(MapSstIndexIterator));
+  return new (mem) MapSstIndexIterator(std::move(index), icomp);
+}
+
+}  // namespace TERARKDB_NAMESPACE
@@ -0,0 +1,85 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "db/dbformat.h"
+#include "rocksdb/status.h"
+#include "rocksdb/terark_namespace.h"
+#include "table/internal_iterator.h"
+
+namespace TERARKDB_NAMESPACE {
+
+class Arena;
+
+// The elements of a map SST, decoded once when the table is loaded and
+// pinned in FileMetaData::map_index. Keys and raw values of all elements
+// live in one buffer, the elements and their link targets in flat arrays,
+// so that a lookup is a binary search without any block access or
+// allocation.
+class MapSstIndex {
+ public:
+  struct Element {
+    // Offsets into data_, the raw value follows the key
+    uint32_t key_offset;
+    uint32_t key_size;
+    uint32_t value_size;
+    // smallest_key is part of the raw value
+    uint32_t smallest_offset;
+    uint32_t smallest_size;
+    uint32_t link_count;
+    // Index of the first link target in links_
+    uint64_t link_offset : 56;
+    // MapSstElement::Flags
+    uint64_t flags : 8;
+  };
+
+  // Decode all elements of iter, which iterates a map SST from the start.
+  static Status Build(InternalIterator* iter,
+                      std::shared_ptr<const MapSstIndex>* index);
+
+  size_t size() const { return elements_.size(); }
+
+  // Index of the first element whose largest key is at or past ikey, size()
+  // if there is none
+  size_t Seek(const InternalKeyComparator& icomp, const Slice& ikey) const;
+
+  const Element& element(size_t i) const { return elements_[i]; }
+  Slice largest_key(const Element& e) const {
+    return Slice(data_.data() + e.key_offset, e.key_size);
+  }
+  Slice smallest_key(const Element& e) const {
+    return Slice(data_.data() + e.smallest_offset, e.smallest_size);
+  }
+  Slice value(const Element& e) const {
+    return Slice(data_.data() + e.key_offset + e.key_size, e.value_size);
+  }
+  const MapSstElement::LinkTarget* links(const Element& e) const {
+    return links_.data() + e.link_offset;
+  }
+
+  // Fill *element as MapSstElement::Decode would, its keys point into the
+  // index
+  void GetElement(size_t i, MapSstElement* element) const;
+
+  size_t ApproximateMemoryUsage() const;
+
+  // Iterate the elements as the table reader of the map SST would, keys are
+  // largest keys and values are raw values.
+  static InternalIterator* NewIterator(
+      std::shared_ptr<const MapSstIndex> index,
+      const InternalKeyComparator* icomp, Arena* arena = nullptr);
+
+ private:
+  std::string data_;
+  std::vector<Element> elements_;
+  std::vector<MapSstElement::LinkTarget> links_;
+};
+
+}  // namespace TERARKDB_NAMESPACE
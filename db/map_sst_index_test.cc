@@ -0,0 +1,161 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#include "db/map_sst_index.h"
+
+#include "rocksdb/terark_namespace.h"
+#include "util/testharness.h"
+#include "util/testutil.h"
+
+namespace TERARKDB_NAMESPACE {
+
+class MapSstIndexTest : public testing::Test {
+ public:
+  MapSstIndexTest() : icomp_(BytewiseComparator()) {}
+
+  // Elements [a, b), [c, d], [e, f] with 1, 2 and 3 links
+  void AddElements() {
+    const char* bounds[][2] = {{"a", "b"}, {"c", "d"}, {"e", "f"}};
+    uint64_t file_number = 10;
+    for (size_t i = 0; i < 3; ++i) {
+      MapSstElement element;
+      std::string smallest = Key(bounds[i][0], 100);
+      std::string largest = Key(bounds[i][1], 50);
+      element.smallest_key = smallest;
+      element.largest_key = largest;
+      element.include_smallest = true;
+      element.include_largest = i > 0;
+      for (size_t j = 0; j <= i; ++j) {
+        element.link.push_back({file_number++, 1000});
+      }
+      std::string buffer;
+      keys_.push_back(largest);
+      values_.push_back(element.Value(&buffer).ToString());
+    }
+  }
+
+  static std::string Key(const std::string& user_key, SequenceNumber seq) {
+    return InternalKey(user_key, seq, kTypeValue).Encode().ToString();
+  }
+
+  Status Build() {
+    test::VectorIterator iter(keys_, values_);
+    return MapSstIndex::Build(&iter, &index_);
+  }
+
+  InternalKeyComparator icomp_;
+  std::vector<std::string> keys_;
+  std::vector<std::string> values_;
+  std::shared_ptr<const MapSstIndex> index_;
+};
+
+TEST_F(MapSstIndexTest, Decode) {
+  AddElements();
+  ASSERT_OK(Build());
+  ASSERT_EQ(3U, index_->size());
+  uint64_t file_number = 10;
+  for (size_t i = 0; i < 3; ++i) {
+    auto& e = index_->element(i);
+    ASSERT_EQ(keys_[i], index_->largest_key(e).ToString());
+    ASSERT_EQ(values_[i], index_->value(e).ToString());
+    MapSstElement element;
+    ASSERT_TRUE(element.Decode(keys_[i], values_[i]));
+    ASSERT_EQ(element.smallest_key, index_->smallest_key(e));
+    ASSERT_EQ(element.include_smallest,
+              (e.flags & MapSstElement::kIncludeSmallest) != 0);
+    ASSERT_EQ(element.include_largest,
+              (e.flags & MapSstElement::kIncludeLargest) != 0);
+    ASSERT_EQ(i + 1, e.link_count);
+    for (size_t j = 0; j < e.link_count; ++j) {
+      ASSERT_EQ(file_number++, index_->links(e)[j].file_number);
+      ASSERT_EQ(1000U, index_->links(e)[j].size);
+    }
+
+    MapSstElement from_index;
+    index_->GetElement(i, &from_index);
+    ASSERT_EQ(element.largest_key, from_index.largest_key);
+    ASSERT_EQ(element.smallest_key, from_index.smallest_key);
+    ASSERT_EQ(element.union_flags, from_index.union_flags);
+    ASSERT_EQ(element.link.size(), from_index.link.size());
+    for (size_t j = 0; j < element.link.size(); ++j) {
+      ASSERT_EQ(element.link[j].file_number, from_index.link[j].file_number);
+      ASSERT_EQ(element.link[j].size, from_index.link[j].size);
+    }
+  }
+}
+
+TEST_F(MapSstIndexTest, Seek) {
+  AddElements();
+  ASSERT_OK(Build());
+  ASSERT_EQ(0U, index_->Seek(icomp_, Key("a", 0)));
+  ASSERT_EQ(0U, index_->Seek(icomp_, Key("b", 50)));
+  // Same user key, smaller seqno sorts after the largest key
+  ASSERT_EQ(1U, index_->Seek(icomp_, Key("b", 49)));
+  ASSERT_EQ(1U, index_->Seek(icomp_, Key("c", 10)));
+  ASSERT_EQ(2U, index_->Seek(icomp_, Key("e", 10)));
+  ASSERT_EQ(3U, index_->Seek(icomp_, Key("g", 10)));
+}
+
+TEST_F(MapSstIndexTest, Iterator) {
+  AddElements();
+  ASSERT_OK(Build());
+  std::unique_ptr<InternalIterator> iter(
+      MapSstIndex::NewIterator(index_, &icomp_));
+  index_.reset();  // the iterator keeps the index alive
+  size_t count = 0;
+  for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+    ASSERT_EQ(keys_[count], iter->key().ToString());
+    LazyBuffer value = iter->value();
+    ASSERT_OK(value.fetch());
+    ASSERT_EQ(values_[count], value.slice().ToString());
+    ++count;
+  }
+  ASSERT_EQ(3U, count);
+  for (iter->SeekToLast(); iter->Valid(); iter->Prev()) {
+    ASSERT_EQ(keys_[--count], iter->key().ToString());
+  }
+  ASSERT_EQ(0U, count);
+
+  iter->Seek(Key("c", 10));
+  ASSERT_TRUE(iter->Valid());
+  ASSERT_EQ(keys_[1], iter->key().ToString());
+  iter->SeekForPrev(Key("c", 10));
+  ASSERT_TRUE(iter->Valid());
+  ASSERT_EQ(keys_[0], iter->key().ToString());
+  iter->SeekForPrev(keys_[1]);
+  ASSERT_TRUE(iter->Valid());
+  ASSERT_EQ(keys_[1], iter->key().ToString());
+  iter->SeekForPrev(Key("a", 0));
+  ASSERT_FALSE(iter->Valid());
+  iter->SeekForPrev(Key("z", 0));
+  ASSERT_TRUE(iter->Valid());
+  ASSERT_EQ(keys_[2], iter->key().ToString());
+}
+
+TEST_F(MapSstIndexTest, Empty) {
+  ASSERT_OK(Build());
+  ASSERT_EQ(0U, index_->size());
+  ASSERT_EQ(0U, index_->Seek(icomp_, Key("a", 0)));
+  std::unique_ptr<InternalIterator> iter(
+      MapSstIndex::NewIterator(index_, &icomp_));
+  iter->SeekToFirst();
+  ASSERT_FALSE(iter->Valid());
+  iter->SeekToLast();
+  ASSERT_FALSE(iter->Valid());
+}
+
+TEST_F(MapSstIndexTest, Corruption) {
+  AddElements();
+  values_[1].resize(values_[1].size() / 2);
+  ASSERT_TRUE(Build().IsCorruption());
+  ASSERT_EQ(nullptr, index_);
+}
+
+}  // namespace TERARKDB_NAMESPACE
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -10,6 +10,7 @@
 #include "db/table_cache.h"
 
 #include "db/dbformat.h"
+#include "db/map_sst_index.h"
 #include "db/range_tombstone_fragmenter.h"
 #include "db/version_edit.h"
 #include "monitoring/perf_context_imp.h"
@@ -142,7 +143,13 @@ TableCache::TableCache(const ImmutableCFOptions& ioptions,
     : ioptions_(ioptions),
       env_options_(env_options),
       cache_(cache),
-      immortal_tables_(false) {}
+      immortal_tables_(false) {
+  if (ioptions_.blob_cache) {
+    // If the same blob cache is shared by multiple instances, we need to
+    // disambiguate its entries.
+    PutVarint64(&blob_cache_id_, ioptions_.blob_cache->NewId());
+  }
+}
 
 TableCache::~TableCache() {}
 
@@ -349,12 +356,17 @@ InternalIterator* TableCache::NewIterator(
                                            skip_filters, for_compaction);
       }
     } else {
-      ReadOptions map_options = options;
-      map_options.total_order_seek = true;
-      map_options.readahead_size = 0;
-      result =
-          table_reader->NewIterator(map_options, prefix_extractor, arena,
-                                    skip_filters, false /* for_compaction */);
+      if (file_meta.map_index != nullptr) {
+        result = MapSstIndex::NewIterator(
+            file_meta.map_index, &ioptions_.internal_comparator, arena);
+      } else {
+        ReadOptions map_options = options;
+        map_options.total_order_seek = true;
+        map_options.readahead_size = 0;
+        result =
+            table_reader->NewIterator(map_options, prefix_extractor, arena,
+                                      skip_filters, false /* for_compaction */);
+      }
       if (!dependence_map.empty()) {
         bool ignore_range_deletions =
             options.ignore_range_deletions ||
@@ -483,27 +495,14 @@ Status TableCache::Get(const ReadOptions& options,
       ReadOptions forward_options = options;
       forward_options.ignore_range_deletions |=
           file_meta.prop.map_handle_range_deletions();
-      auto get_from_map = [&](const Slice& largest_key,
-                              LazyBuffer&& map_value) {
-        s = map_value.fetch();
-        if (!s.ok()) {
-          return false;
-        }
-        // Manual inline MapSstElement::Decode
-        const char* err_msg = "Map sst invalid link_value";
-        Slice map_input = map_value.slice();
-        Slice smallest_key;
-        uint64_t link_count;
-        uint64_t flags;
+      auto& icomp = ioptions_.internal_comparator;
+      // Forward to the link targets of a map element, next_link(&file_number)
+      // yields them one by one. Returns whether the next element may also
+      // hold k
+      auto forward_to_links = [&](const Slice& largest_key, uint64_t flags,
+                                  const Slice& smallest_key,
+                                  uint64_t link_count, auto&& next_link) {
         Slice find_k = k;
-        auto& icomp = ioptions_.internal_comparator;
-
-        if (!GetVarint64(&map_input, &flags) ||
-            !GetVarint64(&map_input, &link_count) ||
-            !GetLengthPrefixedSlice(&map_input, &smallest_key)) {
-          s = Status::Corruption(err_msg);
-          return false;
-        }
         // don't care kNoRecords, Get call need load
         // max_covering_tombstone_seq
         int include_smallest = (flags & MapSstElement::kIncludeSmallest) != 0;
@@ -557,8 +556,8 @@ Status TableCache::Get(const ReadOptions& options,
 
         uint64_t file_number;
         for (uint64_t i = 0; i < link_count; ++i) {
-          if (!GetVarint64(&map_input, &file_number)) {
-            s = Status::Corruption(err_msg);
+          if (!next_link(&file_number)) {
+            s = Status::Corruption("Map sst invalid link_value");
             return false;
           }
           auto find = dependence_map.find(file_number);
@@ -580,9 +579,143 @@ Status TableCache::Get(const ReadOptions& options,
         get_context->SetMinSequenceAndType(min_seq_type_backup);
         return is_largest_user_key;
       };
-      t->RangeScan(&k, prefix_extractor, &get_from_map,
-                   c_style_callback(get_from_map));
+      if (auto map_index = file_meta.map_index.get()) {
+        // Pre-decoded elements, no block access
+        for (size_t i = map_index->Seek(icomp, k); i < map_index->size();
+             ++i) {
+          auto& element = map_index->element(i);
+          auto link = map_index->links(element);
+          if (!forward_to_links(map_index->largest_key(element),
+                                element.flags,
+                                map_index->smallest_key(element),
+                                element.link_count, [&](uint64_t* fn) {
+                                  *fn = (link++)->file_number;
+                                  return true;
+                                })) {
+            break;
+          }
+        }
+      } else {
+        auto get_from_map = [&](const Slice& largest_key,
+                                LazyBuffer&& map_value) {
+          s = map_value.fetch();
+          if (!s.ok()) {
+            return false;
+          }
+          // Manual inline MapSstElement::Decode
+          Slice map_input = map_value.slice();
+          Slice smallest_key;
+          uint64_t link_count;
+          uint64_t flags;
+          if (!GetVarint64(&map_input, &flags) ||
+              !GetVarint64(&map_input, &link_count) ||
+              !GetLengthPrefixedSlice(&map_input, &smallest_key)) {
+            s = Status::Corruption("Map sst invalid link_value");
+            return false;
+          }
+          return forward_to_links(
+              largest_key, flags, smallest_key, link_count,
+              [&](uint64_t* fn) { return GetVarint64(&map_input, fn); });
+        };
+        t->RangeScan(&k, prefix_extractor, &get_from_map,
+                     c_style_callback(get_from_map));
+      }
+    }
+  } else if (options.read_tier == kBlockCacheTier && s.IsIncomplete()) {
+    // Couldn't find Table in cache but treat as kFound if no_io set
+    get_context->MarkKeyMayExist();
+    s = Status::OK();
+  }
+  if (handle != nullptr) {
+    ReleaseHandle(handle);
+  }
+  return s;
+}
+
+void TableCache::MultiGet(const ReadOptions& options,
+                          const FileMetaData& file_meta,
+                          const DependenceMap& dependence_map, size_t num_keys,
+                          const Slice* keys, GetContext** get_contexts,
+                          Status* statuses,
+                          const SliceTransform* prefix_extractor,
+                          HistogramImpl* file_read_hist, bool skip_filters,
+                          int level) {
+  if (num_keys == 1 || file_meta.prop.is_map_sst()) {
+    for (size_t i = 0; i < num_keys; ++i) {
+      statuses[i] = Get(options, file_meta, dependence_map, keys[i],
+                        get_contexts[i], prefix_extractor, file_read_hist,
+                        skip_filters, level);
+    }
+    return;
+  }
+  auto& fd = file_meta.fd;
+  Status s;
+  TableReader* t = fd.table_reader;
+  Cache::Handle* handle = nullptr;
+  if (t == nullptr) {
+    s = FindTable(env_options_, fd, &handle, prefix_extractor,
+                  options.read_tier == kBlockCacheTier /* no_io */,
+                  true /* record_read_stats */, file_read_hist, skip_filters,
+                  level, true /* prefetch_index_and_filter_in_cache */);
+    if (s.ok()) {
+      t = GetTableReaderFromHandle(handle);
+    }
+  }
+  if (s.ok()) {
+    if (!options.ignore_range_deletions) {
+      // One tombstone iterator for the whole batch
+      std::unique_ptr<FragmentedRangeTombstoneIterator> range_del_iter(
+          t->NewRangeTombstoneIterator(options));
+      if (range_del_iter != nullptr) {
+        for (size_t i = 0; i < num_keys; ++i) {
+          SequenceNumber* max_covering_tombstone_seq =
+              get_contexts[i]->max_covering_tombstone_seq();
+          if (max_covering_tombstone_seq != nullptr) {
+            *max_covering_tombstone_seq = std::max(
+                *max_covering_tombstone_seq,
+                range_del_iter->MaxCoveringTombstoneSeqnum(
+                    ExtractUserKey(keys[i])));
+          }
+        }
+      }
+    }
+    t->MultiGet(options, num_keys, keys, get_contexts, statuses,
+                prefix_extractor, skip_filters);
+  } else {
+    if (options.read_tier == kBlockCacheTier && s.IsIncomplete()) {
+      // Couldn't find Table in cache but treat as kFound if no_io set
+      for (size_t i = 0; i < num_keys; ++i) {
+        get_contexts[i]->MarkKeyMayExist();
+      }
+      s = Status::OK();
+    }
+    for (size_t i = 0; i < num_keys; ++i) {
+      statuses[i] = s;
     }
+  }
+  if (handle != nullptr) {
+    ReleaseHandle(handle);
+  }
+}
+
+Status TableCache::GetFromHandle(const ReadOptions& options,
+                                 const FileMetaData& file_meta, const Slice& k,
+                                 uint64_t offset, uint64_t size,
+                                 GetContext* get_context) {
+  assert(!file_meta.prop.is_map_sst());
+  auto& fd = file_meta.fd;
+  Status s;
+  TableReader* t = fd.table_reader;
+  Cache::Handle* handle = nullptr;
+  if (t == nullptr) {
+    s = FindTable(env_options_, fd, &handle, nullptr /* prefix_extractor */,
+                  options.read_tier == kBlockCacheTier /* no_io */);
+    if (s.ok()) {
+      t = GetTableReaderFromHandle(handle);
+    }
+  }
+  if (s.ok()) {
+    s = t->GetFromHandle(options, k, offset, size, get_context);
   } else if (options.read_tier == kBlockCacheTier && s.IsIncomplete()) {
     // Couldn't find Table in cache but treat as kFound if no_io set
     get_context->MarkKeyMayExist();
@@ -594,6 +727,84 @@ Status TableCache::Get(const ReadOptions& options,
   return s;
 }
 
+static void DeleteBlobEntry(const Slice& /*key*/, void* value) {
+  delete static_cast<std::string*>(value);
+}
+
+static void ReleaseBlobEntry(void* cache, void* handle) {
+  static_cast<Cache*>(cache)->Release(static_cast<Cache::Handle*>(handle));
+}
+
+void TableCache::CreateBlobCacheKey(uint64_t file_number, const Slice& record,
+                                    std::string* key) const {
+  key->assign(blob_cache_id_);
+  PutVarint64(key, file_number);
+  key->append(record.data(), record.size());
+}
+
+bool TableCache::GetBlobFromCache(uint64_t file_number, const Slice& record,
+                                  LazyBuffer* value) {
+  Cache* blob_cache = ioptions_.blob_cache.get();
+  if (blob_cache == nullptr) {
+    return false;
+  }
+  std::string key;
+  CreateBlobCacheKey(file_number, record, &key);
+  auto handle = blob_cache->Lookup(key, ioptions_.statistics);
+  if (handle == nullptr) {
+    RecordTick(ioptions_.statistics, BLOB_CACHE_MISS);
+    return false;
+  }
+  auto blob = static_cast<const std::string*>(blob_cache->Value(handle));
+  RecordTick(ioptions_.statistics, BLOB_CACHE_HIT);
+  RecordTick(ioptions_.statistics, BLOB_CACHE_BYTES_READ, blob->size());
+  Cleanable release;
+  release.RegisterCleanup(&ReleaseBlobEntry, blob_cache, handle);
+  value->reset(*blob, std::move(release), file_number);
+  return true;
+}
+
+void TableCache::AddBlobToCache(uint64_t file_number, const Slice& record,
+                                const Slice& value) {
+  Cache* blob_cache = ioptions_.blob_cache.get();
+  if (blob_cache == nullptr) {
+    return;
+  }
+  std::string key;
+  CreateBlobCacheKey(file_number, record, &key);
+  auto blob = new std::string(value.data(), value.size());
+  size_t charge = key.size() + blob->size() + sizeof(std::string);
+  Status s = blob_cache->Insert(key, blob, charge, &DeleteBlobEntry,
+                                nullptr /* handle */,
+                                ioptions_.blob_cache_priority);
+  if (s.ok()) {
+    RecordTick(ioptions_.statistics, BLOB_CACHE_ADD);
+    RecordTick(ioptions_.statistics, BLOB_CACHE_BYTES_WRITE, value.size());
+  } else {
+    RecordTick(ioptions_.statistics, BLOB_CACHE_ADD_FAILURES);
+  }
+}
+
+void TableCache::PrefetchFromHandle(const FileMetaData& file_meta,
+                                    uint64_t offset, uint64_t size) {
+  assert(!file_meta.prop.is_map_sst());
+  auto& fd = file_meta.fd;
+  TableReader* t = fd.table_reader;
+  Cache::Handle* handle = nullptr;
+  if (t == nullptr) {
+    Status s = FindTable(env_options_, fd, &handle);
+    if (!s.ok()) {
+      // Just a hint, the following read reports the error
+      return;
+    }
+    t = GetTableReaderFromHandle(handle);
+  }
+  t->PrefetchFromHandle(offset, size);
+  if (handle != nullptr) {
+    ReleaseHandle(handle);
+  }
+}
+
 Status TableCache::GetTableProperties(
     const EnvOptions& env_options, const FileMetaData& file_meta,
     std::shared_ptr<const TableProperties>* properties,
@@ -76,6 +76,41 @@ class TableCache {
              HistogramImpl* file_read_hist = nullptr, bool skip_filters = false,
              int level = -1, const FileMetaData* inheritance = nullptr);
 
+  // Batched Get() of the internal keys keys[0, num_keys) in the specified
+  // file, keys must be sorted by the internal key comparator. statuses[i]
+  // receives the result of looking up keys[i] into get_contexts[i]. Map SSTs
+  // are resolved per key.
+  void MultiGet(const ReadOptions& options, const FileMetaData& file_meta,
+                const DependenceMap& dependence_map, size_t num_keys,
+                const Slice* keys, GetContext** get_contexts,
+                Status* statuses,
+                const SliceTransform* prefix_extractor = nullptr,
+                HistogramImpl* file_read_hist = nullptr,
+                bool skip_filters = false, int level = -1);
+
+  // Lookup internal key "k" in the data addressed by (offset, size) inside
+  // the specified file, without searching the index. See
+  // TableReader::GetFromHandle()
+  Status GetFromHandle(const ReadOptions& options,
+                       const FileMetaData& file_meta, const Slice& k,
+                       uint64_t offset, uint64_t size, GetContext* get_context);
+
+  // Lookup a separated value in ImmutableCFOptions::blob_cache. `record`
+  // identifies the value inside the blob file. On hit, *value refers to the
+  // cache entry. Returns false if the blob cache is disabled or misses.
+  bool GetBlobFromCache(uint64_t file_number, const Slice& record,
+                        LazyBuffer* value);
+
+  // Insert a separated value into ImmutableCFOptions::blob_cache, see
+  // GetBlobFromCache()
+  void AddBlobToCache(uint64_t file_number, const Slice& record,
+                      const Slice& value);
+
+  // Issue readahead for the data addressed by (offset, size) inside the
+  // specified file. See TableReader::PrefetchFromHandle()
+  void PrefetchFromHandle(const FileMetaData& file_meta, uint64_t offset,
+                          uint64_t size);
+
   // Evict any entry for the specified file number
   static void Evict(Cache* cache, uint64_t file_number);
 
@@ -153,9 +188,15 @@ class TableCache {
                             bool prefetch_index_and_filter_in_cache,
                             bool for_compaction, bool force_memory);
 
+  void CreateBlobCacheKey(uint64_t file_number, const Slice& record,
+                          std::string* key) const;
+
   const ImmutableCFOptions& ioptions_;
   const EnvOptions& env_options_;
   Cache* const cache_;
+  // Distinguish the blob cache entries of this column family from others
+  // sharing the same blob cache
+  std::string blob_cache_id_;
   bool immortal_tables_;
 };
 
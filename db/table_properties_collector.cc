@@ -230,6 +230,99 @@ class TtlIntTblPropCollectorFactory : public IntTblPropCollectorFactory {
   std::string name_;
 };
 
+// Collects the expiration time range of the values of a blob sst, see
+// TablePropertyCache::latest_expire_time
+class TtlExpireIntTblPropCollector : public IntTblPropCollector {
+ public:
+  TtlExpireIntTblPropCollector(TtlExtractor* _ttl_extractor,
+                               const std::string& _name)
+      : ttl_extractor_(_ttl_extractor), name_(_name) {}
+
+  ~TtlExpireIntTblPropCollector() { delete ttl_extractor_; }
+
+  Status Finish(UserCollectedProperties* properties) override {
+    if (earliest_expire_time_ != port::kMaxUint64) {
+      TtlIntTblPropCollector::PushItem(properties,
+                                       TablePropertiesNames::kEarliestExpireTime,
+                                       earliest_expire_time_);
+    }
+    if (latest_expire_time_ != port::kMaxUint64) {
+      TtlIntTblPropCollector::PushItem(properties,
+                                       TablePropertiesNames::kLatestExpireTime,
+                                       latest_expire_time_);
+    }
+    return Status::OK();
+  }
+
+  const char* Name() const override { return name_.c_str(); }
+
+  Status InternalAdd(const Slice& key, const Slice& value,
+                     uint64_t /*file_size*/) override {
+    EntryType entry_type = GetEntryType(ExtractValueType(key));
+    bool has_ttl = false;
+    uint64_t ttl_time_point = port::kMaxUint64;
+    if (entry_type == kEntryPut || entry_type == kEntryMerge) {
+      assert(ttl_extractor_ != nullptr);
+      Status s = ttl_extractor_->Extract(entry_type, ExtractUserKey(key), value,
+                                         &has_ttl, &ttl_time_point);
+      if (!s.ok()) {
+        return s;
+      }
+    }
+    if (!has_ttl) {
+      ttl_time_point = port::kMaxUint64;
+    }
+    if (first_entry_) {
+      latest_expire_time_ = ttl_time_point;
+      first_entry_ = false;
+    } else {
+      latest_expire_time_ = std::max(latest_expire_time_, ttl_time_point);
+    }
+    earliest_expire_time_ = std::min(earliest_expire_time_, ttl_time_point);
+    return Status::OK();
+  }
+
+  UserCollectedProperties GetReadableProperties() const override {
+    return UserCollectedProperties();
+  }
+
+ private:
+  TtlExtractor* ttl_extractor_;
+  std::string name_;
+  bool first_entry_ = true;
+  uint64_t earliest_expire_time_ = port::kMaxUint64;
+  uint64_t latest_expire_time_ = port::kMaxUint64;
+};
+
+class TtlExpireIntTblPropCollectorFactory : public IntTblPropCollectorFactory {
+ public:
+  explicit TtlExpireIntTblPropCollectorFactory(
+      const TtlExtractorFactory* _ttl_extractor_factory)
+      : ttl_extractor_factory_(_ttl_extractor_factory) {
+    name_ = std::string("TtlExpireCollectorFactory.") +
+            ttl_extractor_factory_->Name();
+  }
+  // has to be thread-safe
+  IntTblPropCollector* CreateIntTblPropCollector(
+      const TablePropertiesCollectorFactory::Context& context) override {
+    TtlExtractorContext ttl_context;
+    ttl_context.column_family_id = context.column_family_id;
+    auto ttl_extractor =
+        ttl_extractor_factory_->CreateTtlExtractor(ttl_context);
+    return new TtlExpireIntTblPropCollector(
+        ttl_extractor.release(),
+        std::string("TtlExpireCollector.") + ttl_extractor_factory_->Name());
+  }
+
+  const char* Name() const override { return name_.c_str(); }
+
+  bool NeedSerialize() const override { return false; }
+
+ private:
+  const TtlExtractorFactory* ttl_extractor_factory_;
+  std::string name_;
+};
+
 IntTblPropCollectorFactory* NewTtlIntTblPropCollectorFactory(
     const TtlExtractorFactory* ttl_extractor_factory, double ttl_gc_ratio,
     size_t ttl_max_scan_cap) {
@@ -237,6 +330,11 @@ IntTblPropCollectorFactory* NewTtlIntTblPropCollectorFactory(
                                            ttl_max_scan_cap);
 }
 
+IntTblPropCollectorFactory* NewTtlExpireIntTblPropCollectorFactory(
+    const TtlExtractorFactory* ttl_extractor_factory) {
+  return new TtlExpireIntTblPropCollectorFactory(ttl_extractor_factory);
+}
+
 uint64_t GetDeletedKeys(const UserCollectedProperties& props) {
   bool property_present_ignored;
   return GetUint64Property(props, TablePropertiesNames::kDeletedKeys,
@@ -271,6 +369,27 @@ void GetCompactionTimePoint(const UserCollectedProperties& props,
   }
 }
 
+void GetExpireTimeRange(const UserCollectedProperties& props,
+                        uint64_t* earliest_expire_time,
+                        uint64_t* latest_expire_time) {
+  assert(earliest_expire_time != nullptr);
+  assert(latest_expire_time != nullptr);
+
+  bool property_present;
+
+  *earliest_expire_time = GetUint64Property(
+      props, TablePropertiesNames::kEarliestExpireTime, &property_present);
+  if (!property_present) {
+    *earliest_expire_time = port::kMaxUint64;
+  }
+
+  *latest_expire_time = GetUint64Property(
+      props, TablePropertiesNames::kLatestExpireTime, &property_present);
+  if (!property_present) {
+    *latest_expire_time = port::kMaxUint64;
+  }
+}
+
 }  // namespace TERARKDB_NAMESPACE
 
 TERARK_FACTORY_INSTANTIATE_GNS(
@@ -157,4 +157,8 @@ extern IntTblPropCollectorFactory* NewTtlIntTblPropCollectorFactory(
     const TtlExtractorFactory* ttl_extractor_factory, double ttl_gc_ratio,
     size_t ttl_max_scan_cap);
 
+// Records the expiration time range of the values of a blob sst
+extern IntTblPropCollectorFactory* NewTtlExpireIntTblPropCollectorFactory(
+    const TtlExtractorFactory* ttl_extractor_factory);
+
 }  // namespace TERARKDB_NAMESPACE
@@ -23,6 +23,7 @@
 
 #include "db/dbformat.h"
 #include "db/internal_stats.h"
+#include "db/map_sst_index.h"
 #include "db/table_cache.h"
 #include "db/version_set.h"
 #include "port/port.h"
@@ -30,6 +31,7 @@
 #include "util/c_style_callback.h"
 #include "util/chash_map.h"
 #include "util/chash_set.h"
+#include "util/logging.h"
 
 #define ROCKS_VERSION_BUILDER_DEBUG 0
 
@@ -789,6 +791,9 @@ class VersionBuilder::Rep {
           // Load table_reader
           file_meta->fd.table_reader = table_cache_->GetTableReaderFromHandle(
               file_meta->table_reader_handle);
+          if (file_meta->prop.is_map_sst() && file_meta->map_index == nullptr) {
+            LoadMapSstIndex(file_meta, prefix_extractor);
+          }
         }
       }
     });
@@ -803,6 +808,25 @@ class VersionBuilder::Rep {
     }
   }
 
+  // Failing to decode leaves the map SST to be read through its table reader
+  void LoadMapSstIndex(FileMetaData* file_meta,
+                       const SliceTransform* prefix_extractor) {
+    ReadOptions read_options;
+    read_options.total_order_seek = true;
+    read_options.fill_cache = false;
+    std::unique_ptr<InternalIterator> iter(
+        file_meta->fd.table_reader->NewIterator(read_options,
+                                                prefix_extractor));
+    std::shared_ptr<const MapSstIndex> map_index;
+    Status s = MapSstIndex::Build(iter.get(), &map_index);
+    if (s.ok()) {
+      file_meta->map_index = std::move(map_index);
+    } else {
+      ROCKS_LOG_WARN(info_log_, "Load map sst index of #%" PRIu64 ": %s",
+                     file_meta->fd.GetNumber(), s.ToString().c_str());
+    }
+  }
+
   void UpgradeFileMetaData(const SliceTransform* prefix_extractor,
                            int max_threads) {
     Init();
@@ -230,6 +230,8 @@ bool VersionEdit::EncodeTo(std::string* dst) const {
                           f.prop.raw_value_size);
       PutVarint64(&encode_property_cache, f.prop.earliest_time_begin_compact);
       PutVarint64(&encode_property_cache, f.prop.latest_time_end_compact);
+      PutVarint64Varint64(&encode_property_cache, f.prop.earliest_expire_time,
+                          f.prop.latest_expire_time);
       PutLengthPrefixedSlice(dst, encode_property_cache);
     }
     TEST_SYNC_POINT_CALLBACK("VersionEdit::EncodeTo:NewFile4:CustomizeFields",
@@ -408,6 +410,12 @@ const char* VersionEdit::DecodeNewFile4From(Slice* input) {
                 return error_msg;
               }
             }
+            if (!field.empty()) {
+              if (!GetVarint64(&field, &f.prop.earliest_expire_time) ||
+                  !GetVarint64(&field, &f.prop.latest_expire_time)) {
+                return error_msg;
+              }
+            }
             if (f.prop.num_entries > 0 || f.prop.raw_key_size > 0 ||
                 f.prop.raw_value_size > 0) {
               f.need_upgrade = false;
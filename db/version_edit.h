@@ -10,6 +10,7 @@
 #pragma once
 #include <algorithm>
 #include <atomic>
+#include <memory>
 #include <set>
 #include <string>
 #include <utility>
@@ -23,6 +24,7 @@
 
 namespace TERARKDB_NAMESPACE {
 
+class MapSstIndex;
 class VersionSet;
 
 const uint64_t kFileNumberMask = 0x3FFFFFFFFFFFFFFF;
@@ -98,6 +100,10 @@ struct TablePropertyCache {
   std::vector<uint64_t> inheritance;   // inheritance set
   uint64_t earliest_time_begin_compact = port::kMaxUint64;
   uint64_t latest_time_end_compact = port::kMaxUint64;
+  // Expiration time range of the values of a blob sst, latest is kMaxUint64
+  // if any value has no ttl
+  uint64_t earliest_expire_time = port::kMaxUint64;
+  uint64_t latest_expire_time = port::kMaxUint64;
 
   bool is_map_sst() const { return purpose == kMapSst; }
   bool has_range_deletions() const { return (flags & kNoRangeDeletions) == 0; }
@@ -150,6 +156,10 @@ struct FileMetaData {
 
   TablePropertyCache prop;  // Cache some TableProperty fields into manifest
 
+  // Elements of a map SST, decoded when its table reader is loaded. nullptr
+  // for essence SSTs and map SSTs which are read through the table reader.
+  std::shared_ptr<const MapSstIndex> map_index;
+
   FileMetaData()
       : table_reader_handle(nullptr),
         compensated_file_size(0),
@@ -17,6 +17,7 @@
 #include <stdio.h>
 
 #include <algorithm>
+#include <deque>
 #include <list>
 #include <map>
 #include <string>
@@ -26,6 +27,7 @@
 #include "db/compaction.h"
 #include "db/log_reader.h"
 #include "db/log_writer.h"
+#include "db/map_sst_index.h"
 #include "db/memtable.h"
 #include "db/merge_context.h"
 #include "db/merge_helper.h"
@@ -940,6 +942,18 @@ size_t Version::GetMemoryUsageByTableReaders() {
   return total_usage;
 }
 
+size_t Version::GetMemoryUsageByMapSstIndexes() const {
+  size_t total_usage = 0;
+  for (int level = -1; level < storage_info_.num_levels(); ++level) {
+    for (auto file_meta : storage_info_.LevelFiles(level)) {
+      if (file_meta->map_index != nullptr) {
+        total_usage += file_meta->map_index->ApproximateMemoryUsage();
+      }
+    }
+  }
+  return total_usage;
+}
+
 double Version::GetCompactionLoad() const {
   double read_amp = storage_info_.read_amplification();
   int level_add = cfd_->ioptions()->num_levels - 1;
@@ -1276,27 +1290,78 @@ Version::Version(ColumnFamilyData* column_family_data, VersionSet* vset,
 
 Status Version::fetch_buffer(LazyBuffer* buffer) const {
   auto context = get_context(buffer);
-  Slice user_key(reinterpret_cast<const char*>(context->data[0]),
-                 context->data[1]);
+  Slice user_key;
   uint64_t sequence = context->data[2];
-  auto pair = *reinterpret_cast<DependenceMap::value_type*>(context->data[3]);
-  if (pair.second->fd.GetNumber() != pair.first) {
+  const FileMetaData* blob = nullptr;
+  uint64_t file_number;
+  uint64_t handle_offset = 0, handle_size = 0;
+  if ((sequence & SeparateHelper::kValueHandleFlag) != 0) {
+    // see TransToCombined
+    sequence &= ~SeparateHelper::kValueHandleFlag;
+    user_key = Slice(reinterpret_cast<const char*>(context->data[0]),
+                     context->data[1] & 0xFFFFFFFFULL);
+    handle_size = context->data[1] >> 32;
+    handle_offset = context->data[3];
+    file_number = buffer->file_number();
+    auto find = storage_info_.dependence_map().find(file_number);
+    assert(find != storage_info_.dependence_map().end());
+    blob = find->second;
+  } else {
+    user_key = Slice(reinterpret_cast<const char*>(context->data[0]),
+                     context->data[1]);
+    auto pair = *reinterpret_cast<DependenceMap::value_type*>(context->data[3]);
+    file_number = pair.first;
+    blob = pair.second;
+  }
+  if (blob->fd.GetNumber() != file_number) {
     RecordTick(db_statistics_, READ_BLOB_INVALID);
   } else {
     RecordTick(db_statistics_, READ_BLOB_VALID);
   }
+  IterKey iter_key;
+  iter_key.SetInternalKey(user_key, sequence, kValueTypeForSeek);
+  // Identify the value inside the blob by its handle if any, or by its key
+  std::string blob_record;
+  const bool use_blob_cache = cfd_->ioptions()->blob_cache != nullptr;
+  if (use_blob_cache) {
+    if (handle_size != 0) {
+      blob_record.push_back('h');
+      PutVarint64(&blob_record, handle_offset);
+    } else {
+      blob_record.push_back('k');
+      blob_record.append(iter_key.GetInternalKey().data(),
+                         iter_key.GetInternalKey().size());
+    }
+    if (table_cache_->GetBlobFromCache(blob->fd.GetNumber(), blob_record,
+                                       buffer)) {
+      return Status::OK();
+    }
+  }
   bool value_found = false;
   SequenceNumber context_seq;
   GetContext get_context(cfd_->internal_comparator().user_comparator(), nullptr,
                          cfd_->ioptions()->info_log, db_statistics_,
                          GetContext::kNotFound, user_key, buffer, &value_found,
                          nullptr, nullptr, nullptr, env_, &context_seq);
-  IterKey iter_key;
-  iter_key.SetInternalKey(user_key, sequence, kValueTypeForSeek);
-  auto s = table_cache_->Get(
-      ReadOptions(), *pair.second, storage_info_.dependence_map(),
-      iter_key.GetInternalKey(), &get_context,
-      mutable_cf_options_.prefix_extractor.get(), nullptr, true);
+  // Values are cached by the blob cache, keep their blocks out of the block
+  // cache
+  ReadOptions read_options;
+  read_options.fill_cache = !use_blob_cache;
+  Status s = Status::NotSupported();
+  if (handle_size != 0) {
+    s = table_cache_->GetFromHandle(read_options, *blob,
+                                    iter_key.GetInternalKey(), handle_offset,
+                                    handle_size, &get_context);
+    if (s.ok()) {
+      RecordTick(db_statistics_, READ_BLOB_BY_HANDLE);
+    }
+  }
+  if (s.IsNotSupported()) {
+    s = table_cache_->Get(
+        read_options, *blob, storage_info_.dependence_map(),
+        iter_key.GetInternalKey(), &get_context,
+        mutable_cf_options_.prefix_extractor.get(), nullptr, true);
+  }
   if (!s.ok()) {
     return s;
   }
@@ -1308,11 +1373,19 @@ Status Version::fetch_buffer(LazyBuffer* buffer) const {
       char buf[128];
       snprintf(buf, sizeof buf,
                "file number = %" PRIu64 "(%" PRIu64 "), sequence = %" PRIu64,
-               pair.second->fd.GetNumber(), pair.first, sequence);
+               blob->fd.GetNumber(), file_number, sequence);
       return Status::Corruption("Separate value missing", buf);
     }
   }
-  assert(buffer->file_number() == pair.second->fd.GetNumber());
+  assert(buffer->file_number() == blob->fd.GetNumber());
+  if (use_blob_cache && get_context.State() == GetContext::kFound) {
+    s = buffer->fetch();
+    if (!s.ok()) {
+      return s;
+    }
+    table_cache_->AddBlobToCache(blob->fd.GetNumber(), blob_record,
+                                 buffer->slice());
+  }
   return Status::OK();
 }
 
@@ -1325,8 +1398,22 @@ LazyBuffer Version::TransToCombined(const Slice& user_key, uint64_t sequence,
   uint64_t file_number = SeparateHelper::DecodeFileNumber(value.slice());
   auto& dependence_map = storage_info_.dependence_map();
   auto find = dependence_map.find(file_number);
+  uint64_t handle_offset, handle_size;
   if (find == dependence_map.end()) {
     return LazyBuffer(Status::Corruption("Separate value dependence missing"));
+  } else if (find->second->fd.GetNumber() == file_number &&
+             SeparateHelper::DecodeValueHandle(value.slice(), &handle_offset,
+                                               &handle_size) &&
+             handle_size <= 0xFFFFFFFFULL && user_key.size() <= 0xFFFFFFFFULL) {
+    // The handle is only valid while the blob file isn't rewritten by GC.
+    // Pack user_key size & handle size into data[1], mark data[2] with
+    // kValueHandleFlag
+    return LazyBuffer(
+        this,
+        {reinterpret_cast<uint64_t>(user_key.data()),
+         user_key.size() | (handle_size << 32),
+         sequence | SeparateHelper::kValueHandleFlag, handle_offset},
+        Slice::Invalid(), file_number);
   } else {
     return LazyBuffer(
         this,
@@ -1336,6 +1423,64 @@ LazyBuffer Version::TransToCombined(const Slice& user_key, uint64_t sequence,
   }
 }
 
+void Version::PrefetchCombined(LazyBuffer* const* values, size_t n) const {
+  // Blocks closer than this are read by one readahead
+  const uint64_t kMaxCoalesceGap = 32ULL << 10;
+  struct BlobRange {
+    const FileMetaData* blob;
+    uint64_t offset;
+    uint64_t size;
+  };
+  std::vector<BlobRange> ranges;
+  auto& dependence_map = storage_info_.dependence_map();
+  for (size_t i = 0; i < n; ++i) {
+    LazyBuffer* buffer = values[i];
+    if (buffer->valid() || get_state(buffer) != this) {
+      continue;
+    }
+    auto context = get_context(buffer);
+    if ((context->data[2] & SeparateHelper::kValueHandleFlag) == 0) {
+      // Addressed by key, the block is unknown until the index is searched
+      continue;
+    }
+    auto find = dependence_map.find(buffer->file_number());
+    if (find == dependence_map.end()) {
+      continue;
+    }
+    ranges.emplace_back(
+        BlobRange{find->second, context->data[3], context->data[1] >> 32});
+  }
+  if (ranges.size() < 2) {
+    // The fetch itself is as good as a readahead
+    return;
+  }
+  std::sort(ranges.begin(), ranges.end(),
+            [](const BlobRange& l, const BlobRange& r) {
+              return l.blob->fd.GetNumber() != r.blob->fd.GetNumber()
+                         ? l.blob->fd.GetNumber() < r.blob->fd.GetNumber()
+                         : l.offset < r.offset;
+            });
+  BlobRange merged = ranges.front();
+  for (size_t i = 1; i <= ranges.size(); ++i) {
+    if (i < ranges.size()) {
+      auto& range = ranges[i];
+      if (range.blob == merged.blob &&
+          range.offset <= merged.offset + merged.size + kMaxCoalesceGap) {
+        merged.size = std::max(merged.offset + merged.size,
+                               range.offset + range.size) -
+                      merged.offset;
+        continue;
+      }
+    }
+    TEST_SYNC_POINT_CALLBACK("Version::PrefetchCombined:Range", &merged);
+    table_cache_->PrefetchFromHandle(*merged.blob, merged.offset,
+                                     merged.size);
+    if (i < ranges.size()) {
+      merged = ranges[i];
+    }
+  }
+}
+
 void Version::Get(const ReadOptions& read_options, const Slice& user_key,
                   const LookupKey& k, LazyBuffer* value, Status* status,
                   MergeContext* merge_context,
@@ -1369,8 +1514,10 @@ void Version::Get(const ReadOptions& read_options, const Slice& user_key,
       // stop here.
       break;
     }
+    size_t num_operands = 0;
     if (get_context.sample()) {
       sample_file_read_inc(f->file_metadata);
+      num_operands = merge_context->GetNumOperands();
     }
 
     bool timer_enabled =
@@ -1392,6 +1539,13 @@ void Version::Get(const ReadOptions& read_options, const Slice& user_key,
     if (!status->ok()) {
       return;
     }
+    if (get_context.sample()) {
+      cfd_->internal_stats()->RecordLevelLookup(
+          static_cast<int>(fp.GetHitFileLevel()),
+          get_context.State() == GetContext::kMerge
+              ? merge_context->GetNumOperands() > num_operands
+              : get_context.State() != GetContext::kNotFound);
+    }
 
     // report the counters before returning
     if (get_context.State() != GetContext::kNotFound &&
@@ -1455,6 +1609,255 @@ void Version::Get(const ReadOptions& read_options, const Slice& user_key,
   }
 }
 
+void Version::MultiGet(const ReadOptions& read_options,
+                       std::vector<GetRequest>* requests) {
+  auto& reqs = *requests;
+  const size_t num_keys = reqs.size();
+  if (num_keys == 0) {
+    return;
+  }
+  auto icmp = internal_comparator();
+  auto ucmp = user_comparator();
+  std::sort(reqs.begin(), reqs.end(),
+            [icmp](const GetRequest& a, const GetRequest& b) {
+              return icmp->Compare(a.lkey->internal_key(),
+                                   b.lkey->internal_key()) < 0;
+            });
+
+  // GetContext is not movable, deque keeps them in place
+  std::deque<GetContext> get_contexts;
+  for (auto& req : reqs) {
+    assert(req.status->ok() || req.status->IsMergeInProgress());
+    get_contexts.emplace_back(
+        ucmp, merge_operator_, info_log_, db_statistics_,
+        req.status->ok() ? GetContext::kNotFound : GetContext::kMerge,
+        req.user_key, req.value, nullptr /* value_found */,
+        req.merge_context, this, req.max_covering_tombstone_seq, env_);
+    get_contexts.back().DeferSeparatedFetch();
+  }
+  enum : uint8_t {
+    kSearching,
+    // Reached the end of its history, needs the final merge or NotFound
+    kExhausted,
+    // Got its final status
+    kDone,
+  };
+  std::vector<uint8_t> key_state(num_keys, kSearching);
+  size_t num_searching = num_keys;
+
+  // (file index, key index) of the current level, grouped by file with the
+  // keys of each file in order
+  std::vector<std::pair<uint32_t, size_t>> hits;
+  std::vector<Slice> batch_keys;
+  std::vector<GetContext*> batch_contexts;
+  std::vector<size_t> batch_index;
+  std::vector<Status> batch_status;
+  // Merge operands of the sampled keys before the file
+  std::vector<size_t> batch_operands;
+
+  auto& level_files_brief = storage_info_.level_files_brief_;
+  for (int level = 0;
+       level < storage_info_.num_non_empty_levels_ && num_searching > 0;
+       ++level) {
+    const LevelFilesBrief& file_level = level_files_brief[level];
+    auto in_range = [&](size_t i, const FdWithKeyRange& f, int* cmp_largest) {
+      if (ucmp->Compare(reqs[i].user_key, ExtractUserKey(f.smallest_key)) <
+          0) {
+        return false;
+      }
+      *cmp_largest =
+          ucmp->Compare(reqs[i].user_key, ExtractUserKey(f.largest_key));
+      return *cmp_largest <= 0;
+    };
+    hits.clear();
+    if (level == 0) {
+      // Level-0 files overlap each other, visit them from newest to oldest
+      for (uint32_t fi = 0; fi < file_level.num_files; ++fi) {
+        for (size_t i = 0; i < num_keys; ++i) {
+          int cmp_largest;
+          if (key_state[i] == kSearching &&
+              in_range(i, file_level.files[fi], &cmp_largest)) {
+            hits.emplace_back(fi, i);
+          }
+        }
+      }
+    } else {
+      // Keys are sorted, so the binary search never goes backward
+      uint32_t left = 0;
+      for (size_t i = 0; i < num_keys; ++i) {
+        if (key_state[i] != kSearching) {
+          continue;
+        }
+        left = static_cast<uint32_t>(
+            FindFileInRange(*icmp, file_level, reqs[i].lkey->internal_key(),
+                            left, static_cast<uint32_t>(file_level.num_files)));
+        // Same as FilePicker, a user key may continue into the next file
+        for (uint32_t fi = left; fi < file_level.num_files; ++fi) {
+          int cmp_largest;
+          if (!in_range(i, file_level.files[fi], &cmp_largest)) {
+            break;
+          }
+          hits.emplace_back(fi, i);
+          if (cmp_largest < 0) {
+            break;
+          }
+        }
+      }
+      std::stable_sort(hits.begin(), hits.end(),
+                       [](const std::pair<uint32_t, size_t>& a,
+                          const std::pair<uint32_t, size_t>& b) {
+                         return a.first < b.first;
+                       });
+    }
+
+    for (size_t h = 0; h < hits.size();) {
+      const uint32_t fi = hits[h].first;
+      FdWithKeyRange* f = &file_level.files[fi];
+      batch_keys.clear();
+      batch_contexts.clear();
+      batch_index.clear();
+      batch_operands.clear();
+      for (; h < hits.size() && hits[h].first == fi; ++h) {
+        size_t i = hits[h].second;
+        // May have been finished by a newer file of this level
+        if (key_state[i] != kSearching) {
+          continue;
+        }
+        if (get_contexts[i].is_finished()) {
+          key_state[i] = kExhausted;
+          --num_searching;
+          continue;
+        }
+        if (get_contexts[i].sample()) {
+          sample_file_read_inc(f->file_metadata);
+        }
+        batch_keys.emplace_back(reqs[i].lkey->internal_key());
+        batch_contexts.emplace_back(&get_contexts[i]);
+        batch_index.emplace_back(i);
+        batch_operands.emplace_back(get_contexts[i].sample()
+                                        ? reqs[i].merge_context->GetNumOperands()
+                                        : 0);
+      }
+      if (batch_keys.empty()) {
+        continue;
+      }
+      batch_status.assign(batch_keys.size(), Status::OK());
+
+      bool timer_enabled =
+          GetPerfLevel() >= PerfLevel::kEnableTimeExceptForMutex &&
+          get_perf_context()->per_level_perf_context_enabled;
+      StopWatchNano timer(env_, timer_enabled /* auto_start */);
+      table_cache_->MultiGet(
+          read_options, *f->file_metadata, storage_info_.dependence_map(),
+          batch_keys.size(), batch_keys.data(), batch_contexts.data(),
+          batch_status.data(), mutable_cf_options_.prefix_extractor.get(),
+          cfd_->internal_stats()->GetFileReadHist(level),
+          IsFilterSkipped(level, fi == file_level.num_files - 1), level);
+      if (timer_enabled) {
+        PERF_COUNTER_BY_LEVEL_ADD(get_from_table_nanos, timer.ElapsedNanos(),
+                                  level);
+      }
+
+      for (size_t b = 0; b < batch_index.size(); ++b) {
+        size_t i = batch_index[b];
+        GetContext& get_context = get_contexts[i];
+        Status* status = reqs[i].status;
+        *status = std::move(batch_status[b]);
+        if (!status->ok()) {
+          key_state[i] = kDone;
+          --num_searching;
+          continue;
+        }
+        if (get_context.sample()) {
+          cfd_->internal_stats()->RecordLevelLookup(
+              level, get_context.State() == GetContext::kMerge
+                         ? reqs[i].merge_context->GetNumOperands() >
+                               batch_operands[b]
+                         : get_context.State() != GetContext::kNotFound);
+        }
+        if (get_context.State() != GetContext::kNotFound &&
+            get_context.State() != GetContext::kMerge &&
+            db_statistics_ != nullptr) {
+          get_context.ReportCounters();
+        }
+        switch (get_context.State()) {
+          case GetContext::kNotFound:
+          case GetContext::kMerge:
+            // Keep searching in other files
+            continue;
+          case GetContext::kFound:
+            if (level == 0) {
+              RecordTick(db_statistics_, GET_HIT_L0);
+            } else if (level == 1) {
+              RecordTick(db_statistics_, GET_HIT_L1);
+            } else {
+              RecordTick(db_statistics_, GET_HIT_L2_AND_UP);
+            }
+            PERF_COUNTER_BY_LEVEL_ADD(user_key_return_count, 1, level);
+            break;
+          case GetContext::kDeleted:
+            // Use empty error message for speed
+            *status = Status::NotFound();
+            break;
+          case GetContext::kCorrupt:
+            *status = std::move(get_context).CorruptReason();
+            break;
+        }
+        key_state[i] = kDone;
+        --num_searching;
+      }
+    }
+  }
+
+  for (size_t i = 0; i < num_keys; ++i) {
+    if (key_state[i] == kDone) {
+      continue;
+    }
+    GetContext& get_context = get_contexts[i];
+    GetRequest& req = reqs[i];
+    if (db_statistics_ != nullptr) {
+      get_context.ReportCounters();
+    }
+    if (GetContext::kMerge == get_context.State()) {
+      if (!merge_operator_) {
+        *req.status = Status::InvalidArgument(
+            "merge_operator is not properly initialized.");
+        continue;
+      }
+      // merge_operands are in saver and we hit the beginning of the key
+      // history do a final merge of nullptr and operands;
+      if (req.value != nullptr) {
+        *req.status = MergeHelper::TimedFullMerge(
+            merge_operator_, req.user_key, nullptr,
+            req.merge_context->GetOperands(), req.value, info_log_,
+            db_statistics_, env_, true);
+        if (req.status->ok()) {
+          req.value->pin(LazyBufferPinLevel::Internal);
+        }
+      }
+    } else {
+      *req.status = Status::NotFound();  // Use an empty error message for speed
+    }
+  }
+
+  // Separated values are left unfetched by the GetContexts, issue their blob
+  // reads together and then fetch them in key order
+  std::vector<LazyBuffer*> separated;
+  for (auto& req : reqs) {
+    if (req.status->ok() && req.value != nullptr && !req.value->valid() &&
+        get_state(req.value) == this) {
+      separated.emplace_back(req.value);
+    }
+  }
+  PrefetchCombined(separated.data(), separated.size());
+  for (auto& req : reqs) {
+    if (req.status->ok() && req.value != nullptr && !req.value->valid() &&
+        get_state(req.value) == this) {
+      *req.status = req.value->fetch();
+    }
+  }
+}
+
 void Version::GetKey(const Slice& user_key, const Slice& ikey, Status* status,
                      ValueType* type, SequenceNumber* seq, LazyBuffer* value,
                      const FileMetaData& blob) {
@@ -3727,6 +4130,150 @@ Status VersionSet::ApplyOneVersionEdit(
   return Status::OK();
 }
 
+namespace {
+// Reads and decodes the manifest records in a background thread, so that
+// decoding the next edits, which may carry large dependence and inheritance
+// vectors, overlaps with applying the previous ones to the version builders.
+// Decoded edits are handed over in batches through a bounded queue, in
+// manifest order.
+class ManifestEditReader {
+ public:
+  ManifestEditReader(std::unique_ptr<SequentialFileReader>&& file, Env* env)
+      : file_(std::move(file)), env_(env), cv_(&mutex_) {}
+
+  ~ManifestEditReader() {
+    {
+      MutexLock l(&mutex_);
+      stopped_ = true;
+      cv_.SignalAll();
+    }
+    if (thread_.joinable()) {
+      thread_.join();
+    }
+  }
+
+  void Start() { thread_ = port::Thread(&ManifestEditReader::Run, this); }
+
+  // Move the next edit into *edit. Return false at the end of the manifest or
+  // on a read error, then Finish() returns the read status.
+  bool Next(VersionEdit* edit) {
+    if (pos_ == batch_.size()) {
+      batch_.clear();
+      pos_ = 0;
+      MutexLock l(&mutex_);
+      if (queue_.empty() && !done_) {
+        uint64_t start_micros = env_->NowMicros();
+        while (queue_.empty() && !done_) {
+          cv_.Wait();
+        }
+        wait_micros_ += env_->NowMicros() - start_micros;
+      }
+      if (queue_.empty()) {
+        return false;
+      }
+      batch_ = std::move(queue_.front());
+      queue_.pop_front();
+      cv_.SignalAll();
+    }
+    *edit = std::move(batch_[pos_++]);
+    return true;
+  }
+
+  // Must be called after Next() returned false
+  Status Finish(uint64_t* read_micros) {
+    MutexLock l(&mutex_);
+    assert(done_);
+    *read_micros = read_micros_;
+    return status_;
+  }
+
+  // Time Next() spent waiting for the reader thread
+  uint64_t wait_micros() const { return wait_micros_; }
+
+ private:
+  static const size_t kBatchSize = 64;
+  static const size_t kMaxQueuedBatches = 16;
+
+  struct LogReporter : public log::Reader::Reporter {
+    Status* status;
+    virtual void Corruption(size_t /*bytes*/, const Status& s) override {
+      if (this->status->ok()) *this->status = s;
+    }
+  };
+
+  void Run() {
+    Status s;
+    LogReporter reporter;
+    reporter.status = &s;
+    log::Reader reader(nullptr, std::move(file_), &reporter,
+                       true /* checksum */, 0 /* log_number */,
+                       false /* retry_after_eof */);
+    Slice record;
+    std::string scratch;
+    std::vector<VersionEdit> batch;
+    uint64_t read_micros = 0;
+    uint64_t start_micros = env_->NowMicros();
+    bool stopped = false;
+    while (!stopped && reader.ReadRecord(&record, &scratch) && s.ok()) {
+      batch.emplace_back();
+      s = batch.back().DecodeFrom(record);
+      if (!s.ok()) {
+        batch.pop_back();
+        break;
+      }
+      if (batch.size() >= kBatchSize) {
+        uint64_t now_micros = env_->NowMicros();
+        read_micros += now_micros - start_micros;
+        stopped = !Push(&batch);
+        start_micros = env_->NowMicros();
+      }
+    }
+    read_micros += env_->NowMicros() - start_micros;
+
+    MutexLock l(&mutex_);
+    if (!batch.empty()) {
+      queue_.emplace_back(std::move(batch));
+    }
+    status_ = s;
+    read_micros_ = read_micros;
+    done_ = true;
+    cv_.SignalAll();
+  }
+
+  // Return false if the consumer has gone away
+  bool Push(std::vector<VersionEdit>* batch) {
+    MutexLock l(&mutex_);
+    while (queue_.size() >= kMaxQueuedBatches && !stopped_) {
+      cv_.Wait();
+    }
+    if (stopped_) {
+      return false;
+    }
+    queue_.emplace_back(std::move(*batch));
+    batch->clear();
+    cv_.SignalAll();
+    return true;
+  }
+
+  std::unique_ptr<SequentialFileReader> file_;
+  Env* env_;
+  port::Thread thread_;
+
+  // Consumer side, only accessed by the thread calling Next()
+  std::vector<VersionEdit> batch_;
+  size_t pos_ = 0;
+  uint64_t wait_micros_ = 0;
+
+  port::Mutex mutex_;
+  port::CondVar cv_;
+  std::deque<std::vector<VersionEdit>> queue_;
+  Status status_;
+  uint64_t read_micros_ = 0;
+  bool done_ = false;
+  bool stopped_ = false;
+};
+}  // namespace
+
 Status VersionSet::Recover(
     const std::vector<ColumnFamilyDescriptor>& column_families,
     bool read_only) {
@@ -3807,22 +4354,15 @@ Status VersionSet::Recover(
   default_cfd->set_initialized();
   builders.insert({0, new BaseReferencedVersionBuilder(default_cfd)});
 
+  recovery_stats_ = RecoveryStats();
   {
-    VersionSet::LogReporter reporter;
-    reporter.status = &s;
-    log::Reader reader(nullptr, std::move(manifest_file_reader), &reporter,
-                       true /* checksum */, 0 /* log_number */,
-                       false /* retry_after_eof */);
-    Slice record;
-    std::string scratch;
+    uint64_t apply_start_micros = env_->NowMicros();
+    ManifestEditReader edit_reader(std::move(manifest_file_reader), env_);
+    edit_reader.Start();
     std::vector<VersionEdit> replay_buffer;
     size_t num_entries_decoded = 0;
-    while (reader.ReadRecord(&record, &scratch) && s.ok()) {
-      VersionEdit edit;
-      s = edit.DecodeFrom(record);
-      if (!s.ok()) {
-        break;
-      }
+    VersionEdit edit;
+    while (edit_reader.Next(&edit)) {
       ++current_manifest_edit_count;
 
       if (edit.is_in_atomic_group_) {
@@ -3878,6 +4418,12 @@ Status VersionSet::Recover(
         break;
       }
     }
+    if (s.ok()) {
+      s = edit_reader.Finish(&recovery_stats_.read_micros);
+    }
+    recovery_stats_.num_edits = current_manifest_edit_count;
+    recovery_stats_.apply_micros = env_->NowMicros() - apply_start_micros -
+                                   edit_reader.wait_micros();
   }
 
   if (s.ok()) {
@@ -3928,6 +4474,13 @@ Status VersionSet::Recover(
   }
 
   if (s.ok()) {
+    struct RecoveredVersion {
+      ColumnFamilyData* cfd;
+      VersionBuilder* builder;
+      Version* v;
+    };
+    std::vector<RecoveredVersion> recovered;
+    uint64_t load_table_start_micros = env_->NowMicros();
     for (auto cfd : *column_family_set_) {
       if (cfd->IsDropped()) {
         continue;
@@ -3958,11 +4511,42 @@ Status VersionSet::Recover(
       Version* v = new Version(cfd, this, env_options_,
                                *cfd->GetLatestMutableCFOptions(),
                                current_version_number_++);
-      builder->SaveTo(v->storage_info(), 0);
+      recovered.push_back({cfd, builder, v});
+    }
+    uint64_t save_to_start_micros = env_->NowMicros();
+    recovery_stats_.load_table_micros =
+        save_to_start_micros - load_table_start_micros;
+
+    // Each builder only touches its own column family, so the dependence
+    // calculation of different column families runs in parallel.
+    int max_threads = std::max(1, db_options_->max_file_opening_threads);
+    int num_cf_threads =
+        static_cast<int>(std::min<size_t>(max_threads, recovered.size()));
+    std::atomic<size_t> next_recovered_idx(0);
+    std::function<void()> save_to_func([&]() {
+      while (true) {
+        size_t idx = next_recovered_idx.fetch_add(1);
+        if (idx >= recovered.size()) {
+          break;
+        }
+        auto& r = recovered[idx];
+        r.builder->SaveTo(r.v->storage_info(), 0);
+      }
+    });
+    std::vector<port::Thread> threads;
+    for (int i = 1; i < num_cf_threads; i++) {
+      threads.emplace_back(save_to_func);
+    }
+    save_to_func();
+    for (auto& t : threads) {
+      t.join();
+    }
+    recovery_stats_.save_to_micros = env_->NowMicros() - save_to_start_micros;
 
+    for (auto& r : recovered) {
       // Install recovered version
-      v->PrepareApply(*cfd->GetLatestMutableCFOptions());
-      AppendVersion(cfd, v);
+      r.v->PrepareApply(*r.cfd->GetLatestMutableCFOptions());
+      AppendVersion(r.cfd, r.v);
     }
 
     manifest_file_size_ = current_manifest_file_size;
@@ -692,6 +692,25 @@ class Version : public SeparateHelper, private LazyBufferState {
            bool* value_found = nullptr, bool* key_exists = nullptr,
            SequenceNumber* seq = nullptr, ReadCallback* callback = nullptr);
 
+  // One key of a MultiGet() batch, the fields have the same meaning as the
+  // arguments of Get()
+  struct GetRequest {
+    Slice user_key;
+    const LookupKey* lkey;
+    LazyBuffer* value;
+    Status* status;
+    MergeContext* merge_context;
+    SequenceNumber* max_covering_tombstone_seq;
+  };
+
+  // Same as calling Get() for each request, but the keys are sorted and
+  // looked up level by level: each file is asked once for all the keys that
+  // fall into it, so the file lookup, filter and index work is shared by the
+  // batch. The requests are reordered.
+  //
+  // REQUIRES: lock is not held
+  void MultiGet(const ReadOptions&, std::vector<GetRequest>* requests);
+
   void GetKey(const Slice& user_key, const Slice& ikey, Status* status,
               ValueType* type, SequenceNumber* seq, LazyBuffer* value,
               const FileMetaData& blob);
@@ -747,6 +766,9 @@ class Version : public SeparateHelper, private LazyBufferState {
 
   size_t GetMemoryUsageByTableReaders();
 
+  // Memory pinned by FileMetaData::map_index
+  size_t GetMemoryUsageByMapSstIndexes() const;
+
   // REQUIRES: lock is held
   double GetCompactionLoad() const;
 
@@ -840,6 +862,8 @@ class Version : public SeparateHelper, private LazyBufferState {
   LazyBuffer TransToCombined(const Slice& user_key, uint64_t sequence,
                              const LazyBuffer& value) const override;
 
+  void PrefetchCombined(LazyBuffer* const* values, size_t n) const override;
+
   // No copying allowed
   Version(const Version&);
   void operator=(const Version&);
@@ -1095,6 +1119,20 @@ class VersionSet {
   // Return the size of the current manifest file
   uint64_t manifest_file_size() const { return manifest_file_size_; }
 
+  // Time spent in each phase of the last Recover()
+  struct RecoveryStats {
+    uint64_t num_edits = 0;
+    // Reading and decoding the manifest records, overlapped with apply
+    uint64_t read_micros = 0;
+    // Applying the decoded edits to the version builders
+    uint64_t apply_micros = 0;
+    // Opening table readers and upgrading file metadata
+    uint64_t load_table_micros = 0;
+    // Calculating dependence and building the recovered versions
+    uint64_t save_to_micros = 0;
+  };
+  const RecoveryStats& recovery_stats() const { return recovery_stats_; }
+
   // verify that the files that we started with for a compaction
   // still exist in the current version and in the same original level.
   // This ensures that a concurrent compaction did not erroneously
@@ -1216,6 +1254,8 @@ class VersionSet {
   // VersionEdit count of manifest file
   uint64_t manifest_edit_count_;
 
+  RecoveryStats recovery_stats_;
+
   std::vector<ObsoleteFileInfo> obsolete_files_;
   std::vector<std::string> obsolete_manifests_;
 
@@ -764,6 +764,54 @@ TEST_F(VersionSetTest, SameColumnFamilyGroupCommit) {
   EXPECT_EQ(kGroupSize - 1, count);
 }
 
+TEST_F(VersionSetTest, RecoverManyEditsAcrossColumnFamilies) {
+  std::vector<ColumnFamilyDescriptor> column_families;
+  SequenceNumber last_seqno;
+  std::unique_ptr<log::Writer> log_writer;
+  PrepareManifest(&column_families, &last_seqno, &log_writer);
+
+  // More edits than the manifest reader queues at once, spread over all the
+  // column families
+  const uint32_t kNumEdits = 3000;
+  const uint32_t kNumCfs = static_cast<uint32_t>(column_families.size());
+  uint64_t file_number = 10;
+  Status s;
+  for (uint32_t i = 0; i != kNumEdits; ++i) {
+    VersionEdit edit;
+    edit.SetColumnFamily(i % kNumCfs);
+    char key[16];
+    snprintf(key, sizeof(key), "%08u", i);
+    edit.AddFile(1, file_number++, 0, 1024, InternalKey(key, 1, kTypeValue),
+                 InternalKey(key, 1, kTypeValue), 1, 1, 0, {});
+    edit.SetLastSequence(last_seqno++);
+    std::string record;
+    edit.EncodeTo(&record);
+    s = log_writer->AddRecord(record);
+    ASSERT_OK(s);
+  }
+  VersionEdit last_edit;
+  last_edit.SetLogNumber(0);
+  last_edit.SetNextFile(file_number);
+  last_edit.SetLastSequence(last_seqno);
+  std::string record;
+  last_edit.EncodeTo(&record);
+  ASSERT_OK(log_writer->AddRecord(record));
+  log_writer.reset();
+
+  s = SetCurrentFile(env_, dbname_, 1, nullptr);
+  ASSERT_OK(s);
+
+  EXPECT_OK(versions_->Recover(column_families, false));
+  EXPECT_EQ(column_families.size(),
+            versions_->GetColumnFamilySet()->NumberOfColumnFamilies());
+  EXPECT_EQ(kNumCfs + kNumEdits, versions_->recovery_stats().num_edits);
+  EXPECT_EQ(last_seqno, versions_->LastSequence());
+  for (auto cfd : *versions_->GetColumnFamilySet()) {
+    EXPECT_EQ(static_cast<int>(kNumEdits / kNumCfs),
+              cfd->current()->storage_info()->NumLevelFiles(1));
+  }
+}
+
 TEST_F(VersionSetTest, HandleValidAtomicGroup) {
   std::vector<ColumnFamilyDescriptor> column_families;
   SequenceNumber last_seqno;
@@ -0,0 +1,66 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#include "db/wal_stream_sequencer.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "rocksdb/terark_namespace.h"
+
+namespace TERARKDB_NAMESPACE {
+
+SequenceNumber WalStreamSequencer::Allocate(uint64_t count,
+                                            uint64_t* ticket) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (next_ticket_ == next_publish_ticket_) {
+    last_allocated_ = std::max(last_allocated_, get_last_sequence_());
+  }
+  *ticket = next_ticket_++;
+  SequenceNumber last_sequence = last_allocated_;
+  last_allocated_ += count;
+  return last_sequence;
+}
+
+void WalStreamSequencer::Publish(uint64_t ticket,
+                                 SequenceNumber last_sequence) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  assert(ticket < next_ticket_);
+  cv_.wait(lock, [&] { return next_publish_ticket_ == ticket; });
+  set_last_sequence_(last_sequence);
+  ++next_publish_ticket_;
+  MarkLoggedLocked(ticket);
+  cv_.notify_all();
+}
+
+void WalStreamSequencer::MarkLogged(uint64_t ticket) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  assert(ticket < next_ticket_);
+  MarkLoggedLocked(ticket);
+  cv_.notify_all();
+}
+
+void WalStreamSequencer::WaitLogged(uint64_t ticket) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  cv_.wait(lock, [&] { return next_logged_ticket_ >= ticket; });
+}
+
+void WalStreamSequencer::MarkLoggedLocked(uint64_t ticket) {
+  if (ticket < next_logged_ticket_) {
+    return;
+  }
+  if (ticket > next_logged_ticket_) {
+    logged_ahead_.insert(ticket);
+    return;
+  }
+  ++next_logged_ticket_;
+  while (!logged_ahead_.empty() &&
+         *logged_ahead_.begin() == next_logged_ticket_) {
+    logged_ahead_.erase(logged_ahead_.begin());
+    ++next_logged_ticket_;
+  }
+}
+
+}  // namespace TERARKDB_NAMESPACE
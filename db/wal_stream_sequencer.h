@@ -0,0 +1,69 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <set>
+
+#include "rocksdb/terark_namespace.h"
+#include "rocksdb/types.h"
+
+namespace TERARKDB_NAMESPACE {
+
+// Hands out sequence ranges to the write group leaders of the WAL streams
+// and publishes them as LastSequence in allocation order, so that a reader
+// never sees a sequence while an earlier one is still being written by
+// another stream.
+//
+// A sync write also waits with WaitLogged until the earlier tickets are in
+// the logs of their streams, before it syncs all the streams.
+//
+// Every Allocate must be followed by a Publish of its ticket, also if the
+// write failed, otherwise all later tickets wait forever.
+class WalStreamSequencer {
+ public:
+  WalStreamSequencer(std::function<SequenceNumber()> get_last_sequence,
+                     std::function<void(SequenceNumber)> set_last_sequence)
+      : get_last_sequence_(std::move(get_last_sequence)),
+        set_last_sequence_(std::move(set_last_sequence)) {}
+
+  // Reserves count sequences and returns the one before the first of them.
+  // If no ticket is outstanding, LastSequence is read again first, so that
+  // it may be advanced externally while all the streams are stopped.
+  SequenceNumber Allocate(uint64_t count, uint64_t* ticket);
+
+  // Waits until all earlier tickets are published, then publishes
+  // last_sequence.
+  void Publish(uint64_t ticket, SequenceNumber last_sequence);
+
+  // Notes that the batch of ticket was appended to its log, or that it
+  // won't be. Publish implies it.
+  void MarkLogged(uint64_t ticket);
+
+  // Waits until all tickets before ticket are logged.
+  void WaitLogged(uint64_t ticket);
+
+ private:
+  // REQUIRES: mutex_ held
+  void MarkLoggedLocked(uint64_t ticket);
+
+  std::function<SequenceNumber()> get_last_sequence_;
+  std::function<void(SequenceNumber)> set_last_sequence_;
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  SequenceNumber last_allocated_ = 0;
+  uint64_t next_ticket_ = 0;
+  // All tickets before are published
+  uint64_t next_publish_ticket_ = 0;
+  // All tickets before are logged, and those of logged_ahead_
+  uint64_t next_logged_ticket_ = 0;
+  std::set<uint64_t> logged_ahead_;
+};
+
+}  // namespace TERARKDB_NAMESPACE
@@ -0,0 +1,136 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#include "db/wal_stream_sequencer.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "rocksdb/terark_namespace.h"
+#include "util/testharness.h"
+
+namespace TERARKDB_NAMESPACE {
+
+class WalStreamSequencerTest : public testing::Test {
+ public:
+  WalStreamSequencerTest()
+      : sequencer_([this] { return last_sequence_.load(); },
+                   [this](SequenceNumber s) {
+                     ASSERT_GE(s, last_sequence_.load());
+                     last_sequence_.store(s);
+                   }) {}
+
+  std::atomic<SequenceNumber> last_sequence_{0};
+  WalStreamSequencer sequencer_;
+};
+
+TEST_F(WalStreamSequencerTest, PublishInOrder) {
+  uint64_t t0, t1, t2;
+  ASSERT_EQ(0U, sequencer_.Allocate(3, &t0));
+  ASSERT_EQ(3U, sequencer_.Allocate(0, &t1));
+  ASSERT_EQ(3U, sequencer_.Allocate(2, &t2));
+
+  std::atomic<int> published{0};
+  std::thread later([&] {
+    sequencer_.Publish(t2, 5);
+    ++published;
+  });
+  std::thread middle([&] {
+    sequencer_.Publish(t1, 3);
+    ++published;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  ASSERT_EQ(0, published.load());
+  ASSERT_EQ(0U, last_sequence_.load());
+  sequencer_.Publish(t0, 3);
+  later.join();
+  middle.join();
+  ASSERT_EQ(2, published.load());
+  ASSERT_EQ(5U, last_sequence_.load());
+}
+
+TEST_F(WalStreamSequencerTest, ReadsLastSequenceWhenIdle) {
+  uint64_t ticket;
+  ASSERT_EQ(0U, sequencer_.Allocate(4, &ticket));
+  // Not seen while a ticket is outstanding
+  last_sequence_ = 2;
+  uint64_t ticket2;
+  ASSERT_EQ(4U, sequencer_.Allocate(1, &ticket2));
+  sequencer_.Publish(ticket, 4);
+  sequencer_.Publish(ticket2, 5);
+
+  // E.g. a file ingestion
+  last_sequence_ = 10;
+  ASSERT_EQ(10U, sequencer_.Allocate(1, &ticket));
+  sequencer_.Publish(ticket, 11);
+  ASSERT_EQ(11U, last_sequence_.load());
+}
+
+TEST_F(WalStreamSequencerTest, WaitLogged) {
+  uint64_t t0, t1, t2;
+  sequencer_.Allocate(1, &t0);
+  sequencer_.Allocate(1, &t1);
+  sequencer_.Allocate(1, &t2);
+  // Nothing before the first ticket
+  sequencer_.WaitLogged(t0);
+
+  std::atomic<bool> logged{false};
+  std::thread sync_writer([&] {
+    sequencer_.WaitLogged(t2);
+    logged = true;
+  });
+  sequencer_.MarkLogged(t1);
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  ASSERT_FALSE(logged.load());
+  // Not published yet, e.g. still inserting into the memtables
+  sequencer_.MarkLogged(t0);
+  sync_writer.join();
+  ASSERT_TRUE(logged.load());
+  ASSERT_EQ(0U, last_sequence_.load());
+
+  sequencer_.Publish(t0, 1);
+  sequencer_.Publish(t1, 2);
+  // Publish marks it logged too
+  sequencer_.Publish(t2, 3);
+  uint64_t t3;
+  sequencer_.Allocate(1, &t3);
+  sequencer_.WaitLogged(t3);
+  sequencer_.Publish(t3, 4);
+}
+
+TEST_F(WalStreamSequencerTest, Concurrent) {
+  const int kThreads = 8;
+  const int kWrites = 2000;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kThreads; ++i) {
+    threads.emplace_back([&, i] {
+      for (int j = 0; j < kWrites; ++j) {
+        uint64_t count = (i + j) % 3;
+        uint64_t ticket;
+        SequenceNumber last = sequencer_.Allocate(count, &ticket);
+        sequencer_.Publish(ticket, last + count);
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  uint64_t total = 0;
+  for (int i = 0; i < kThreads; ++i) {
+    for (int j = 0; j < kWrites; ++j) {
+      total += (i + j) % 3;
+    }
+  }
+  ASSERT_EQ(total, last_sequence_.load());
+}
+
+}  // namespace TERARKDB_NAMESPACE
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -1729,6 +1729,7 @@ Status WriteBatchInternal::InsertInto(
       sequence, memtables, flush_scheduler, ignore_missing_column_families,
       recovery_log_number, db, concurrent_memtable_writes,
       nullptr /*has_valid_writes*/, seq_per_batch, batch_per_txn);
+  Status s;
   for (auto w : write_group) {
     if (w->CallbackFailed()) {
       continue;
@@ -1743,12 +1744,16 @@ Status WriteBatchInternal::InsertInto(
     inserter.set_log_number_ref(w->log_ref);
     w->status = w->batch->Iterate(&inserter);
     if (!w->status.ok()) {
-      return w->status;
+      s = w->status;
+      break;
     }
     assert(!seq_per_batch || w->batch_cnt != 0);
     assert(!seq_per_batch || inserter.sequence() - w->sequence == w->batch_cnt);
   }
-  return Status::OK();
+  if (concurrent_memtable_writes) {
+    inserter.PostProcess();
+  }
+  return s;
 }
 
 Status WriteBatchInternal::InsertInto(
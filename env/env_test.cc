@@ -38,6 +38,7 @@
 #endif
 
 #include "env/env_chroot.h"
+#include "env/io_uring.h"
 #include "port/port.h"
 #include "rocksdb/env.h"
 #include "rocksdb/terark_namespace.h"
@@ -845,6 +846,97 @@ TEST_F(EnvPosixTest, PositionedAppend) {
 }
 #endif  // !ROCKSDB_LITE
 
+#ifdef OS_LINUX
+TEST_F(EnvPosixTest, IoUringRandomRead) {
+  const std::string fname = test::PerThreadDBPath(env_, "io_uring_read");
+  const size_t kFileSize = 1 << 20;
+  std::string data;
+  Random rnd(301);
+  test::RandomString(&rnd, static_cast<int>(kFileSize), &data);
+  ASSERT_OK(WriteStringToFile(env_, data, fname));
+
+  // Works no matter the kernel supports io_uring or not
+  EnvOptions options;
+  options.use_io_uring_reads = true;
+  std::unique_ptr<RandomAccessFile> file;
+  ASSERT_OK(env_->NewRandomAccessFile(fname, &file, options));
+
+  auto read_random = [&](uint32_t seed) {
+    Random r(seed);
+    std::string scratch(16 << 10, '\0');
+    for (int i = 0; i < 1000; ++i) {
+      size_t offset = r.Uniform(static_cast<int>(kFileSize));
+      size_t n = 1 + r.Uniform(static_cast<int>(scratch.size()));
+      Slice result;
+      ASSERT_OK(file->Read(offset, n, &result, &scratch[0]));
+      ASSERT_EQ(std::min(n, kFileSize - offset), result.size());
+      ASSERT_EQ(Slice(data.data() + offset, result.size()), result);
+    }
+  };
+  std::vector<port::Thread> threads;
+  for (uint32_t i = 0; i < 4; ++i) {
+    threads.emplace_back(read_random, i);
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  ASSERT_OK(env_->DeleteFile(fname));
+}
+
+TEST_F(EnvPosixTest, IoUringMultiRead) {
+  if (!IoUringSupported()) {
+    return;
+  }
+  const std::string fname =
+      test::PerThreadDBPath(env_, "io_uring_multi_read");
+  const size_t kFileSize = 1 << 20;
+  std::string data;
+  Random rnd(301);
+  test::RandomString(&rnd, static_cast<int>(kFileSize), &data);
+  ASSERT_OK(WriteStringToFile(env_, data, fname));
+
+  EnvOptions options;
+  options.use_io_uring_reads = true;
+  std::unique_ptr<RandomAccessFile> file;
+  ASSERT_OK(env_->NewRandomAccessFile(fname, &file, options));
+
+  unsigned max_to_submit = 0;
+  SyncPoint::GetInstance()->SetCallBack(
+      "IoUring::Submit:to_submit", [&](void* arg) {
+        max_to_submit = std::max(max_to_submit, *static_cast<unsigned*>(arg));
+      });
+  SyncPoint::GetInstance()->EnableProcessing();
+
+  const size_t kNumReqs = 16;
+  const size_t kReadSize = 4 << 10;
+  std::string scratch(kNumReqs * kReadSize, '\0');
+  FSReadRequest reqs[kNumReqs];
+  for (size_t i = 0; i < kNumReqs; ++i) {
+    // The last one crosses the end of the file
+    reqs[i].offset = i + 1 < kNumReqs ? i * 3 * kReadSize
+                                      : kFileSize - kReadSize / 2;
+    reqs[i].len = kReadSize;
+    reqs[i].scratch = &scratch[i * kReadSize];
+  }
+  ASSERT_OK(file->MultiRead(reqs, kNumReqs));
+  SyncPoint::GetInstance()->DisableProcessing();
+  SyncPoint::GetInstance()->ClearAllCallBacks();
+
+  for (size_t i = 0; i < kNumReqs; ++i) {
+    ASSERT_OK(reqs[i].status);
+    size_t offset = static_cast<size_t>(reqs[i].offset);
+    ASSERT_EQ(std::min(kReadSize, kFileSize - offset), reqs[i].result.size());
+    ASSERT_EQ(Slice(data.data() + offset, reqs[i].result.size()),
+              reqs[i].result);
+  }
+#ifndef NDEBUG
+  // The reads went to the kernel together
+  ASSERT_GT(max_to_submit, 1U);
+#endif
+  ASSERT_OK(env_->DeleteFile(fname));
+}
+#endif  // OS_LINUX
+
 // Only works in linux platforms
 TEST_P(EnvPosixTestWithParam, RandomAccessUniqueID) {
   // Create file.
@@ -14,6 +14,7 @@
 #include <fcntl.h>
 
 #include <algorithm>
+#include <vector>
 #if defined(OS_LINUX)
 #include <linux/fs.h>
 #endif
@@ -34,6 +35,7 @@
 #include <terark/thread/fiber_aio.hpp>
 #endif
 
+#include "env/io_uring.h"
 #include "env/posix_logger.h"
 #include "monitoring/iostats_context_imp.h"
 #include "port/port.h"
@@ -319,6 +321,8 @@ PosixRandomAccessFile::PosixRandomAccessFile(const std::string& fname, int fd,
       fd_(fd),
       use_direct_io_(options.use_direct_reads),
       use_aio_reads_(options.use_aio_reads),
+      use_io_uring_reads_(options.use_io_uring_reads),
+      io_uring_sqpoll_(options.io_uring_sqpoll),
       logical_sector_size_(GetLogicalBufferSize(fd_)) {
   assert(!options.use_direct_reads || !options.use_mmap_reads);
   assert(!options.use_mmap_reads || sizeof(void*) < 8);
@@ -330,7 +334,8 @@ bool PosixRandomAccessFile::use_aio_reads() const { return use_aio_reads_; }
 
 static Status PosixFsRead(uint64_t offset, size_t n, Slice* result,
                           char* scratch, int fd_, const std::string& filename_,
-                          bool use_aio_reads_, bool use_direct_io_,
+                          bool use_aio_reads_, bool use_io_uring_reads_,
+                          bool io_uring_sqpoll_, bool use_direct_io_,
                           size_t filealign) {
   Status s;
   ssize_t r = -1;
@@ -341,7 +346,11 @@ static Status PosixFsRead(uint64_t offset, size_t n, Slice* result,
 #ifndef WITH_TERARK_ZIP
     use_aio_reads_ = false;
 #endif
-    if (use_aio_reads_) {
+    if (use_io_uring_reads_ &&
+        IoUringRead(fd_, ptr, left, static_cast<off_t>(offset),
+                    io_uring_sqpoll_, &r)) {
+      // served by io_uring
+    } else if (use_aio_reads_) {
 #ifdef WITH_TERARK_ZIP
       r = terark::fiber_aio_read(fd_, ptr, left, static_cast<off_t>(offset));
 #endif
@@ -383,7 +392,45 @@ Status PosixRandomAccessFile::Read(uint64_t offset, size_t n, Slice* result,
   }
 #endif
   return PosixFsRead(offset, n, result, scratch, fd_, filename_, use_aio_reads_,
-                     use_direct_io_, GetRequiredBufferAlignment());
+                     use_io_uring_reads_, io_uring_sqpoll_, use_direct_io_,
+                     GetRequiredBufferAlignment());
+}
+
+Status PosixRandomAccessFile::MultiRead(FSReadRequest* reqs,
+                                        size_t num_reqs) {
+  assert(reqs != nullptr);
+  if (!use_io_uring_reads_ || num_reqs <= 1) {
+    return RandomAccessFile::MultiRead(reqs, num_reqs);
+  }
+  std::vector<IoUringReadRequest> batch(num_reqs);
+  for (size_t i = 0; i < num_reqs; ++i) {
+    batch[i] = {fd_, reqs[i].scratch, reqs[i].len,
+                static_cast<off_t>(reqs[i].offset), 0};
+  }
+  if (!IoUringReadBatch(batch.data(), num_reqs, io_uring_sqpoll_)) {
+    return RandomAccessFile::MultiRead(reqs, num_reqs);
+  }
+  for (size_t i = 0; i < num_reqs; ++i) {
+    FSReadRequest& req = reqs[i];
+    ssize_t r = batch[i].result;
+    if (r < 0) {
+      req.status = IOError("While pread offset " + ToString(req.offset) +
+                               " len " + ToString(req.len),
+                           filename_, static_cast<int>(-r));
+      req.result = Slice(req.scratch, 0);
+    } else if (static_cast<size_t>(r) < req.len && r > 0 &&
+               (!use_direct_io_ ||
+                r % static_cast<ssize_t>(GetRequiredBufferAlignment()) == 0)) {
+      // A short read, the rest is read one by one, as Read() would
+      Slice rest;
+      req.status = Read(req.offset + r, req.len - r, &rest, req.scratch + r);
+      req.result = Slice(req.scratch, r + rest.size());
+    } else {
+      req.status = Status::OK();
+      req.result = Slice(req.scratch, static_cast<size_t>(r));
+    }
+  }
+  return Status::OK();
 }
 
 Status PosixRandomAccessFile::Prefetch(uint64_t offset, size_t n) {
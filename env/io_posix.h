@@ -85,6 +85,8 @@ class PosixRandomAccessFile : public RandomAccessFile {
   int fd_;
   bool use_direct_io_;
   bool use_aio_reads_;
+  bool use_io_uring_reads_;
+  bool io_uring_sqpoll_;
   size_t logical_sector_size_;
 
  public:
@@ -95,6 +97,9 @@ class PosixRandomAccessFile : public RandomAccessFile {
   virtual Status Read(uint64_t offset, size_t n, Slice* result,
                       char* scratch) const final;
 
+  // With io_uring reads, all of reqs go to the kernel in one submission
+  virtual Status MultiRead(FSReadRequest* reqs, size_t num_reqs) override;
+
   virtual Status Prefetch(uint64_t offset, size_t n) override;
 
 #if defined(OS_LINUX) || defined(OS_MACOSX) || defined(OS_AIX)
@@ -0,0 +1,504 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#include "env/io_uring.h"
+
+#include <errno.h>
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+#if defined(OS_LINUX) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define ROCKSDB_IOURING_PRESENT
+#endif
+#endif
+
+#ifdef ROCKSDB_IOURING_PRESENT
+#include <linux/io_uring.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#ifdef WITH_BOOSTLIB
+#include <boost/fiber/operations.hpp>
+#endif
+
+#include "rocksdb/terark_namespace.h"
+#include "util/sync_point.h"
+
+namespace TERARKDB_NAMESPACE {
+
+#ifdef ROCKSDB_IOURING_PRESENT
+
+// The uapi headers of kernels 5.1 to 5.10 lack some of what is used here,
+// each use is checked on its macro. IORING_OP_READ and IORING_REGISTER_PROBE
+// are enumerators, they came along with IO_URING_OP_SUPPORTED in 5.6.
+
+namespace {
+
+// Set once io_uring_setup failed for a reason other than resource limits,
+// e.g. ENOSYS on old kernels or EPERM under seccomp
+std::atomic<bool> io_uring_disabled{false};
+
+const unsigned kRingEntries = 64;
+// Idle time before the SQPOLL kernel thread goes to sleep
+const unsigned kSqThreadIdleMs = 50;
+
+int SysIoUringSetup(unsigned entries, io_uring_params* p) {
+  return static_cast<int>(syscall(__NR_io_uring_setup, entries, p));
+}
+
+int SysIoUringEnter(int fd, unsigned to_submit, unsigned min_complete,
+                    unsigned flags) {
+  return static_cast<int>(syscall(__NR_io_uring_enter, fd, to_submit,
+                                  min_complete, flags, nullptr, 0));
+}
+
+int SysIoUringRegister(int fd, unsigned opcode, void* arg, unsigned nr_args) {
+  return static_cast<int>(
+      syscall(__NR_io_uring_register, fd, opcode, arg, nr_args));
+}
+
+// Errors of io_uring_enter which go away once completions are reaped
+bool IsTransientEnterError(int err) { return err == EAGAIN || err == EBUSY; }
+
+struct IoUringRequest {
+  int fd = -1;
+  char* buf = nullptr;
+  size_t n = 0;
+  off_t offset = 0;
+  ssize_t res = 0;
+  bool done = false;
+};
+
+class IoUring {
+ public:
+  IoUring() = default;
+  IoUring(const IoUring&) = delete;
+  IoUring& operator=(const IoUring&) = delete;
+  ~IoUring() { Close(); }
+
+  bool valid() const { return fd_ >= 0; }
+  bool sqpoll() const { return sqpoll_; }
+  int fd() const { return fd_; }
+
+  // A SQPOLL ring shares the kernel submission thread of the ring attach_fd
+  // if it is not negative
+  bool Open(bool sqpoll, int attach_fd) {
+    io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    if (sqpoll) {
+      p.flags |= IORING_SETUP_SQPOLL;
+      p.sq_thread_idle = kSqThreadIdleMs;
+#ifdef IORING_SETUP_ATTACH_WQ
+      if (attach_fd >= 0) {
+        p.flags |= IORING_SETUP_ATTACH_WQ;
+        p.wq_fd = static_cast<unsigned>(attach_fd);
+      }
+#else
+      (void)attach_fd;
+#endif
+    }
+    fd_ = SysIoUringSetup(kRingEntries, &p);
+    if (fd_ < 0) {
+      if (sqpoll) {
+        return Open(false, -1);
+      }
+      if (errno != ENOMEM && errno != EMFILE && errno != ENFILE) {
+        io_uring_disabled.store(true, std::memory_order_relaxed);
+      }
+      return false;
+    }
+    // SQPOLL on kernels before 5.11 only works with registered files
+#ifdef IORING_FEAT_SQPOLL_NONFIXED
+    if (sqpoll && !(p.features & IORING_FEAT_SQPOLL_NONFIXED)) {
+#else
+    if (sqpoll) {
+#endif
+      Close();
+      return Open(false, -1);
+    }
+    sqpoll_ = sqpoll;
+
+    sq_len_ = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    cq_len_ = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+#ifdef IORING_FEAT_SINGLE_MMAP
+    bool single_mmap = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+#else
+    bool single_mmap = false;
+#endif
+    if (single_mmap) {
+      sq_len_ = cq_len_ = std::max(sq_len_, cq_len_);
+    }
+    sq_ptr_ = mmap(nullptr, sq_len_, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQ_RING);
+    if (sq_ptr_ == MAP_FAILED) {
+      sq_ptr_ = nullptr;
+      Close();
+      return false;
+    }
+    if (single_mmap) {
+      cq_ptr_ = sq_ptr_;
+    } else {
+      cq_ptr_ = mmap(nullptr, cq_len_, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_CQ_RING);
+      if (cq_ptr_ == MAP_FAILED) {
+        cq_ptr_ = nullptr;
+        Close();
+        return false;
+      }
+    }
+    sqes_len_ = p.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = mmap(nullptr, sqes_len_, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+      Close();
+      return false;
+    }
+    sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+    char* sq = static_cast<char*>(sq_ptr_);
+    sq_head_ = reinterpret_cast<unsigned*>(sq + p.sq_off.head);
+    sq_tail_ = reinterpret_cast<unsigned*>(sq + p.sq_off.tail);
+    sq_mask_ = *reinterpret_cast<unsigned*>(sq + p.sq_off.ring_mask);
+    sq_entries_ = p.sq_entries;
+    sq_flags_ = reinterpret_cast<unsigned*>(sq + p.sq_off.flags);
+    sq_array_ = reinterpret_cast<unsigned*>(sq + p.sq_off.array);
+    char* cq = static_cast<char*>(cq_ptr_);
+    cq_head_ = reinterpret_cast<unsigned*>(cq + p.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned*>(cq + p.cq_off.tail);
+    cq_mask_ = *reinterpret_cast<unsigned*>(cq + p.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe*>(cq + p.cq_off.cqes);
+
+    if (!ReadSupported()) {
+      // Kernels 5.1 to 5.5 set up rings, but have neither IORING_OP_READ nor
+      // the probe
+      io_uring_disabled.store(true, std::memory_order_relaxed);
+      Close();
+      return false;
+    }
+    return true;
+  }
+
+  // Queue a read, it is not visible to the kernel until Submit(). Returns
+  // false if the submission queue is full.
+  bool Push(IoUringRequest* req) {
+    unsigned tail = *sq_tail_;
+    if (tail - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) >= sq_entries_) {
+      return false;
+    }
+    unsigned index = tail & sq_mask_;
+    io_uring_sqe* sqe = &sqes_[index];
+    memset(sqe, 0, sizeof(*sqe));
+#ifdef IO_URING_OP_SUPPORTED
+    sqe->opcode = IORING_OP_READ;
+#endif
+    sqe->fd = req->fd;
+    sqe->off = static_cast<uint64_t>(req->offset);
+    sqe->addr = reinterpret_cast<uint64_t>(req->buf);
+    sqe->len = static_cast<uint32_t>(req->n);
+    sqe->user_data = reinterpret_cast<uint64_t>(req);
+    sq_array_[index] = index;
+    __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+    ++pending_;
+    ++epoch_;
+    return true;
+  }
+
+  // Hand all queued reads to the kernel, and wait for at least min_complete
+  // completions
+  int Submit(unsigned min_complete) {
+    unsigned to_submit = pending_;
+    unsigned flags = min_complete > 0 ? IORING_ENTER_GETEVENTS : 0;
+    if (sqpoll_) {
+      // The kernel thread picks up the queue by itself, it only has to be
+      // woken up after it went idle
+      to_submit = 0;
+      if (__atomic_load_n(sq_flags_, __ATOMIC_ACQUIRE) &
+          IORING_SQ_NEED_WAKEUP) {
+        flags |= IORING_ENTER_SQ_WAKEUP;
+      }
+    }
+    if (to_submit == 0 && flags == 0) {
+      pending_ = 0;
+      return 0;
+    }
+    TEST_SYNC_POINT_CALLBACK("IoUring::Submit:to_submit", &to_submit);
+    int ret;
+    do {
+      ret = SysIoUringEnter(fd_, to_submit, min_complete, flags);
+    } while (ret < 0 && errno == EINTR);
+    if (sqpoll_) {
+      pending_ = 0;
+    } else if (ret > 0) {
+      // The rest stays queued if the kernel took only part of them
+      pending_ -= std::min(pending_, static_cast<unsigned>(ret));
+    }
+    return ret;
+  }
+
+  // Dispatch completions to their requests
+  void Reap() {
+    unsigned head = *cq_head_;
+    unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+    if (head == tail) {
+      return;
+    }
+    for (; head != tail; ++head) {
+      io_uring_cqe* cqe = &cqes_[head & cq_mask_];
+      auto req = reinterpret_cast<IoUringRequest*>(cqe->user_data);
+      if (cqe->res == -EAGAIN && Push(req)) {
+        // The kernel could not serve it without blocking, e.g. the io-wq was
+        // at its limit. Queued again for the next Submit()
+        continue;
+      }
+      req->res = cqe->res;
+      req->done = true;
+    }
+    __atomic_store_n(cq_head_, tail, __ATOMIC_RELEASE);
+    ++epoch_;
+  }
+
+  unsigned pending() const { return pending_; }
+  uint64_t epoch() const { return epoch_; }
+
+  void Close() {
+    if (sqes_ != nullptr) {
+      munmap(sqes_, sqes_len_);
+      sqes_ = nullptr;
+    }
+    if (cq_ptr_ != nullptr && cq_ptr_ != sq_ptr_) {
+      munmap(cq_ptr_, cq_len_);
+    }
+    cq_ptr_ = nullptr;
+    if (sq_ptr_ != nullptr) {
+      munmap(sq_ptr_, sq_len_);
+      sq_ptr_ = nullptr;
+    }
+    if (fd_ >= 0) {
+      close(fd_);
+      fd_ = -1;
+    }
+  }
+
+ private:
+  bool ReadSupported() {
+#ifdef IO_URING_OP_SUPPORTED
+    const unsigned kMaxOps = 256;
+    std::vector<char> buf(sizeof(io_uring_probe) +
+                          kMaxOps * sizeof(io_uring_probe_op));
+    auto probe = reinterpret_cast<io_uring_probe*>(buf.data());
+    if (SysIoUringRegister(fd_, IORING_REGISTER_PROBE, probe, kMaxOps) < 0) {
+      return false;
+    }
+    return probe->last_op >= IORING_OP_READ &&
+           (probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED) != 0;
+#else
+    // Built without IORING_OP_READ, no ring is ever used
+    return false;
+#endif
+  }
+
+  int fd_ = -1;
+  bool sqpoll_ = false;
+  void* sq_ptr_ = nullptr;
+  size_t sq_len_ = 0;
+  void* cq_ptr_ = nullptr;
+  size_t cq_len_ = 0;
+  io_uring_sqe* sqes_ = nullptr;
+  size_t sqes_len_ = 0;
+
+  unsigned* sq_head_ = nullptr;
+  unsigned* sq_tail_ = nullptr;
+  unsigned* sq_flags_ = nullptr;
+  unsigned* sq_array_ = nullptr;
+  unsigned sq_mask_ = 0;
+  unsigned sq_entries_ = 0;
+  unsigned* cq_head_ = nullptr;
+  unsigned* cq_tail_ = nullptr;
+  unsigned cq_mask_ = 0;
+  io_uring_cqe* cqes_ = nullptr;
+
+  // Reads queued since the last Submit()
+  unsigned pending_ = 0;
+  // Bumped whenever a read is queued or completed, used to detect whether
+  // the other fibers made progress while this one yielded
+  uint64_t epoch_ = 0;
+};
+
+// The SQPOLL rings of all threads attach to this ring, which is never
+// closed, so that the process has a single kernel submission thread instead
+// of one per thread. Returns -1 if SQPOLL is not available.
+int SqPollAnchorFd() {
+#ifdef IORING_SETUP_ATTACH_WQ
+  static IoUring* anchor = [] {
+    IoUring* ring = new IoUring;
+    ring->Open(true /* sqpoll */, -1);
+    return ring;
+  }();
+  return anchor->valid() && anchor->sqpoll() ? anchor->fd() : -1;
+#else
+  return -1;
+#endif
+}
+
+IoUring* GetThreadLocalIoUring(bool sqpoll) {
+  // Rings are never shared between threads, fibers of a thread never run
+  // concurrently, so the rings need no locking
+  static thread_local IoUring rings[2];
+  static thread_local bool tried[2] = {false, false};
+  IoUring* ring = &rings[sqpoll];
+  if (!ring->valid()) {
+    if (tried[sqpoll] || io_uring_disabled.load(std::memory_order_relaxed)) {
+      return nullptr;
+    }
+    tried[sqpoll] = true;
+    int anchor_fd = sqpoll ? SqPollAnchorFd() : -1;
+    // Without the anchor, a SQPOLL ring of its own would start a kernel
+    // thread per thread
+    if (!ring->Open(anchor_fd >= 0, anchor_fd)) {
+      return nullptr;
+    }
+  }
+  return ring;
+}
+
+// Let the other fibers of this thread run. Returns true if they queued or
+// completed reads meanwhile.
+bool YieldToOtherFibers(IoUring* ring) {
+#ifdef WITH_BOOSTLIB
+  uint64_t epoch = ring->epoch();
+  boost::this_fiber::yield();
+  return ring->epoch() != epoch;
+#else
+  (void)ring;
+  return false;
+#endif
+}
+
+}  // anonymous namespace
+
+bool IoUringSupported() {
+  return GetThreadLocalIoUring(false) != nullptr;
+}
+
+namespace {
+
+// Queue reqs and wait until all of them are done. Returns false with errno
+// set if io_uring_enter failed for good, the ring is closed then, which
+// cancels the reads still in flight.
+bool RunRequests(IoUring* ring, IoUringRequest* reqs, size_t num) {
+  size_t queued = 0;
+  size_t done = 0;
+  auto push = [&] {
+    while (queued < num && ring->Push(&reqs[queued])) {
+      ++queued;
+    }
+  };
+  auto all_done = [&] {
+    while (done < num && reqs[done].done) {
+      ++done;
+    }
+    return done == num;
+  };
+  auto submit = [&](unsigned min_complete) {
+    if (ring->Submit(min_complete) < 0 && !IsTransientEnterError(errno)) {
+      int err = errno;
+      ring->Close();
+      errno = err;
+      return false;
+    }
+    return true;
+  };
+  push();
+  // Give sibling fibers a chance to queue their reads into the same batch
+  YieldToOtherFibers(ring);
+  while (!all_done()) {
+    if (!ring->valid()) {
+      // Closed by a sibling fiber, its reads in flight were cancelled
+      errno = ECANCELED;
+      return false;
+    }
+    push();
+    if (ring->pending() > 0 && !submit(0)) {
+      return false;
+    }
+    ring->Reap();
+    if (all_done() || YieldToOtherFibers(ring) || all_done()) {
+      continue;
+    }
+    // Nobody made progress, block until something completes. The requests
+    // which didn't fit the queue before go along, or nothing may be in flight
+    push();
+    if (!submit(1)) {
+      return false;
+    }
+    ring->Reap();
+  }
+  return true;
+}
+
+}  // anonymous namespace
+
+bool IoUringRead(int fd, char* buf, size_t n, off_t offset, bool sqpoll,
+                 ssize_t* result) {
+  IoUringReadRequest req = {fd, buf, n, offset, 0};
+  if (!IoUringReadBatch(&req, 1, sqpoll)) {
+    return false;
+  }
+  if (req.result < 0) {
+    errno = static_cast<int>(-req.result);
+    *result = -1;
+  } else {
+    *result = req.result;
+  }
+  return true;
+}
+
+bool IoUringReadBatch(IoUringReadRequest* reqs, size_t num, bool sqpoll) {
+  IoUring* ring = GetThreadLocalIoUring(sqpoll);
+  if (ring == nullptr) {
+    return false;
+  }
+  std::vector<IoUringRequest> ring_reqs(num);
+  for (size_t i = 0; i < num; ++i) {
+    ring_reqs[i].fd = reqs[i].fd;
+    ring_reqs[i].buf = reqs[i].buf;
+    ring_reqs[i].n = reqs[i].n;
+    ring_reqs[i].offset = reqs[i].offset;
+  }
+  if (!RunRequests(ring, ring_reqs.data(), num)) {
+    int err = errno;
+    for (size_t i = 0; i < num; ++i) {
+      reqs[i].result = ring_reqs[i].done ? ring_reqs[i].res : -err;
+    }
+    return true;
+  }
+  for (size_t i = 0; i < num; ++i) {
+    reqs[i].result = ring_reqs[i].res;
+  }
+  return true;
+}
+
+#else  // ROCKSDB_IOURING_PRESENT
+
+bool IoUringSupported() { return false; }
+
+bool IoUringRead(int /*fd*/, char* /*buf*/, size_t /*n*/, off_t /*offset*/,
+                 bool /*sqpoll*/, ssize_t* /*result*/) {
+  return false;
+}
+
+bool IoUringReadBatch(IoUringReadRequest* /*reqs*/, size_t /*num*/,
+                      bool /*sqpoll*/) {
+  return false;
+}
+
+#endif  // ROCKSDB_IOURING_PRESENT
+
+}  // namespace TERARKDB_NAMESPACE
@@ -0,0 +1,58 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+//
+// io_uring based positional read, implemented by raw syscalls so that
+// liburing is not required.
+//
+#pragma once
+
+#include <sys/types.h>
+
+#include <cstddef>
+
+#include "rocksdb/terark_namespace.h"
+
+namespace TERARKDB_NAMESPACE {
+
+// Read up to n bytes at offset of fd through the io_uring of the calling
+// thread. Returns false if io_uring is not available, the caller should fall
+// back to another read path then. Otherwise *result is the number of bytes
+// read, or -1 with errno set.
+//
+// Reads issued by fibers of the same thread are queued in the ring and
+// submitted together by a single io_uring_enter: after queueing its read, a
+// fiber yields so that its siblings get the chance to queue theirs, and only
+// blocks in the kernel once no fiber makes progress.
+//
+// If sqpoll is true, the ring of the calling thread is polled by a kernel
+// submission thread, which is shared by all the threads of the process. It
+// silently falls back to a normal ring if the kernel or the privileges of the
+// process don't allow that.
+//
+// A read which completes with EAGAIN is submitted again. Kernels without
+// IORING_OP_READ (before 5.6) are detected by IORING_REGISTER_PROBE, the
+// caller falls back then.
+extern bool IoUringRead(int fd, char* buf, size_t n, off_t offset, bool sqpoll,
+                        ssize_t* result);
+
+struct IoUringReadRequest {
+  int fd;
+  char* buf;
+  size_t n;
+  off_t offset;
+  // Output, the number of bytes read or -errno
+  ssize_t result;
+};
+
+// IoUringRead for all of reqs at once. They are queued together and handed
+// to the kernel by a single io_uring_enter, as far as the submission queue
+// holds them. Returns false if io_uring is not available.
+extern bool IoUringReadBatch(IoUringReadRequest* reqs, size_t num,
+                             bool sqpoll);
+
+// Returns true if io_uring can be used by this process
+extern bool IoUringSupported();
+
+}  // namespace TERARKDB_NAMESPACE
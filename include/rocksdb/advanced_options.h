@@ -630,6 +630,19 @@ struct AdvancedColumnFamilyOptions {
   // Default: false
   bool optimize_filters_for_hits = false;
 
+  // The adaptive form of optimize_filters_for_hits. Compactions skip the
+  // filters of their output files if at least this ratio of the sampled
+  // Gets that reached the output level found their key there, so that the
+  // filters of the level rarely saved a read. The statistics are kept per
+  // level since the DB was opened, with the older samples decaying.
+  //
+  // 0 disables it, otherwise e.g. 0.9. Sanitized to [0, 1].
+  //
+  // Default: 0
+  //
+  // Dynamically changeable through SetOptions() API
+  double adaptive_filter_skip_hit_ratio = 0;
+
   // It is recommended to disabled when RangeDeletion writes frequently
   //
   // Default: false
@@ -92,15 +92,22 @@ struct LIRSCacheOptions {
   bool strict_capacity_limit = false;
   double irr_ratio = 0.9;
   std::shared_ptr<MemoryAllocator> memory_allocator;
+  // If true, Lookup doesn't take the shard mutex. Hits are recorded in small
+  // per-shard buffers and applied to the LIRS stack and queue in batches,
+  // which reduces lock contention on hot shards at the cost of slightly
+  // approximate recency.
+  bool buffered_access = false;
   LIRSCacheOptions() {}
   LIRSCacheOptions(size_t _capacity, int _num_shard_bits,
                    bool _strict_capacity_limit, double _irr_ratio,
-                   std::shared_ptr<MemoryAllocator> _memory_allocator = nullptr)
+                   std::shared_ptr<MemoryAllocator> _memory_allocator = nullptr,
+                   bool _buffered_access = false)
       : capacity(_capacity),
         num_shard_bits(_num_shard_bits),
         strict_capacity_limit(_strict_capacity_limit),
         irr_ratio(_irr_ratio),
-        memory_allocator(std::move(_memory_allocator)) {}
+        memory_allocator(std::move(_memory_allocator)),
+        buffered_access(_buffered_access) {}
 };
 
 // Create a new cache with a fixed size capacity. The cache is sharded
@@ -129,7 +136,8 @@ std::shared_ptr<Cache> NewDiagnosableLRUCache(
 extern std::shared_ptr<Cache> NewLIRSCache(
     size_t capacity, int num_shard_bits = -1,
     bool strict_capacity_limit = false, double irr_ratio = 0.9,
-    std::shared_ptr<MemoryAllocator> memory_allocator = nullptr);
+    std::shared_ptr<MemoryAllocator> memory_allocator = nullptr,
+    bool buffered_access = false);
 
 extern std::shared_ptr<Cache> NewLIRSCache(const LIRSCacheOptions& cache_opts);
 
@@ -13,6 +13,7 @@
 #include <string>
 
 #include "rocksdb/env.h"
+#include "rocksdb/status.h"
 #include "rocksdb/terark_namespace.h"
 #include "utilities/util/terark_boost.hpp"
 
@@ -21,6 +22,18 @@ namespace TERARKDB_NAMESPACE {
 struct CompactionWorkerContext;
 struct CompactionWorkerResult;
 
+// What CompactionJob knows about a key-value compaction before placing it
+struct CompactionJobEstimate {
+  // Total size of the input files
+  uint64_t input_bytes = 0;
+  int level = 0;
+  int output_level = 0;
+  // SeparationType of the compaction, rebuilding or combining blobs costs
+  // more than the input size tells
+  uint32_t separation_type = 0;
+  bool is_manual_compaction = false;
+};
+
 class CompactionDispatcher : boost::noncopyable {
  public:
   virtual ~CompactionDispatcher() = default;
@@ -29,31 +42,133 @@ class CompactionDispatcher : boost::noncopyable {
       const CompactionWorkerContext& context) = 0;
 
   virtual const char* Name() const = 0;
+
+  // Fail the jobs of owner (see CompactionWorkerContext::owner) which are
+  // queued or running, so that the compactions waiting for them can finish.
+  // Called on DB shutdown, a null owner cancels the jobs of every DB.
+  virtual void CancelCompactions(const void* /*owner*/) {}
+
+  // Called before a key-value compaction is handed to StartCompaction.
+  // Returning false runs it on the local background thread instead.
+  virtual bool ShouldDispatch(const CompactionJobEstimate& /*estimate*/) {
+    return true;
+  }
+
+  // Called once the compaction placed by ShouldDispatch has finished with
+  // status, after elapsed_micros.
+  virtual void OnCompactionFinished(const CompactionJobEstimate& /*estimate*/,
+                                    bool /*dispatched*/,
+                                    const Status& /*status*/,
+                                    uint64_t /*elapsed_micros*/) {}
+
+  // Called around the background work which is never dispatched but takes
+  // a local thread all the same, i.e. flushes and garbage collection.
+  virtual void OnLocalJobStarted(uint64_t /*input_bytes*/) {}
+  virtual void OnLocalJobFinished(uint64_t /*input_bytes*/) {}
+
+  // Whether the placed compactions are falling behind. Writes are slowed
+  // down sooner while it holds.
+  virtual bool IsOverloaded() const { return false; }
 };
 
 class RemoteCompactionDispatcher : public CompactionDispatcher {
  public:
+  // Encoding of the jobs sent to the workers. A worker answers in the
+  // encoding of the job it received.
+  enum WireFormat : unsigned char {
+    // DataIO with terark-zip, ajson otherwise
+    kDefaultWireFormat,
+    // Versioned varint coded binary, see db/compaction_worker_codec.h
+    kBinaryWireFormat,
+  };
+  void set_wire_format(WireFormat wire_format) { wire_format_ = wire_format; }
+  WireFormat wire_format() const { return wire_format_; }
+
   virtual std::function<CompactionWorkerResult()> StartCompaction(
       const CompactionWorkerContext& context) override;
 
   virtual const char* Name() const override;
 
   virtual std::future<std::string> DoCompaction(std::string data) = 0;
+
+  // Runs the job of owner, dispatchers which can cancel the jobs of one DB
+  // override it. Calls DoCompaction by default.
+  virtual std::future<std::string> DoCompactionFor(const void* /*owner*/,
+                                                   std::string data) {
+    return DoCompaction(std::move(data));
+  }
+
   class Worker : boost::noncopyable {
    public:
     Worker(EnvOptions env_options, Env* env);
     virtual ~Worker();
     virtual std::string GenerateOutputFileName(size_t file_index) = 0;
     std::string DoCompaction(Slice data);
+    // Serve the jobs of a worker pool dispatcher on the connected socket fd,
+    // one at a time, until the dispatcher closes it.
+    Status Serve(int fd);
     static void DebugSerializeCheckResult(Slice data);
 
    protected:
     struct Rep;
     Rep* rep_;
+
+   private:
+    CompactionWorkerResult RunCompaction(CompactionWorkerContext* context);
   };
+
+ private:
+  WireFormat wire_format_ = kDefaultWireFormat;
 };
 
 extern std::shared_ptr<CompactionDispatcher> NewCommandLineCompactionDispatcher(
     std::string cmd);
 
+// Keeps num_workers long-lived worker processes instead of starting one per
+// job. Each worker is started by running cmd through /bin/sh, with the
+// environment variable TerarkDB_compactionWorkerFd set to its end of a Unix
+// domain socket (always fd 3), on which it should call Worker::Serve(). A
+// worker which exits is restarted on its next job.
+extern std::shared_ptr<CompactionDispatcher> NewWorkerPoolCompactionDispatcher(
+    std::string cmd, int num_workers);
+
+struct HybridCompactionDispatcherOptions {
+  // Compactions which may run locally at once, usually
+  // max_background_compactions. Flushes and garbage collection running
+  // locally take their share of these.
+  int local_slots = 1;
+
+  // Compactions which the remote dispatcher runs at once, e.g. the number of
+  // workers of a worker pool dispatcher.
+  int remote_slots = 1;
+
+  // L0 compactions up to this size always run locally, they are latency
+  // critical and small enough not to be worth shipping.
+  uint64_t local_only_bytes = 64ull << 20;
+
+  // Startup and transfer time of a remote compaction, on top of the time
+  // spent compacting.
+  uint64_t remote_overhead_micros = 200000;
+
+  // Compaction throughput of a single slot, before any compaction finished
+  // and refined from the finished compactions afterwards.
+  uint64_t initial_bytes_per_second = 32ull << 20;
+
+  // How much more a compaction which rebuilds or combines blobs costs than
+  // its input size.
+  double blob_rebuild_cost_ratio = 2.0;
+
+  // The dispatcher is overloaded once the queued compactions of both local
+  // slots and remote slots would take longer than this to drain.
+  uint64_t max_backlog_micros = 60 * 1000000ull;
+};
+
+// Places each compaction either on the local background thread or on
+// remote, whichever is expected to finish it sooner, given the cost of the
+// compaction, the compactions already placed and the throughput observed
+// on each side.
+extern std::shared_ptr<CompactionDispatcher> NewHybridCompactionDispatcher(
+    std::shared_ptr<CompactionDispatcher> remote,
+    const HybridCompactionDispatcherOptions& options);
+
 }  // namespace TERARKDB_NAMESPACE
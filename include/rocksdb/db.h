@@ -622,6 +622,11 @@ class DB {
     //      filter and index blocks).
     static const std::string kEstimateTableReadersMem;
 
+    //  "rocksdb.estimate-map-sst-index-mem" - returns estimated memory used by
+    //      the pre-decoded elements of map SSTs, which are pinned outside of
+    //      the block cache.
+    static const std::string kEstimateMapSstIndexMem;
+
     //  "rocksdb.is-file-deletions-enabled" - returns 0 if deletion of obsolete
     //      files is enabled; otherwise, returns a non-zero number.
     static const std::string kIsFileDeletionsEnabled;
@@ -744,6 +749,7 @@ class DB {
   //  "rocksdb.num-deletes-imm-mem-tables"
   //  "rocksdb.estimate-num-keys"
   //  "rocksdb.estimate-table-readers-mem"
+  //  "rocksdb.estimate-map-sst-index-mem"
   //  "rocksdb.is-file-deletions-enabled"
   //  "rocksdb.num-snapshots"
   //  "rocksdb.oldest-snapshot-time"
@@ -101,6 +101,12 @@ struct EnvOptions {
 
   bool use_aio_reads = false;
 
+  // If true, read through io_uring, see DBOptions::use_io_uring_reads
+  bool use_io_uring_reads = false;
+
+  // If true, use SQPOLL io_uring rings, see DBOptions::io_uring_sqpoll
+  bool io_uring_sqpoll = false;
+
   // Allows OS to incrementally sync files to disk while they are being
   // written, in the background. Issue one request for every bytes_per_sync
   // written. 0 turns it off.
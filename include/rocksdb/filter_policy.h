@@ -73,6 +73,21 @@ class FilterBitsReader {
 
   // Check if the entry match the bits in filter
   virtual bool MayMatch(const Slice& entry) = 0;
+
+  // Check a batch of entries, may_match[i] receives MayMatch(keys[i]).
+  // Implementations may hash the whole batch first, so that the memory
+  // accesses of different keys overlap.
+  virtual void KeysMayMatch(int num_keys, const Slice* keys, bool* may_match);
+};
+
+// Information about the SST file a full filter is built for
+struct FilterBuildingContext {
+  // Level of the file, -1 if unknown, e.g. for SstFileWriter
+  int level_at_creation = -1;
+  // Bits per key the filter should use instead of the configured ones, e.g.
+  // from BlockBasedTableOptions::filter_bits_per_level, -1 to keep them.
+  // Only the built-in policies honor it.
+  int bits_per_key = -1;
 };
 
 // We add a new format of filter block called full filter block
@@ -119,6 +134,13 @@ class FilterPolicy {
   // It contains interface to take individual key, then generate filter
   virtual FilterBitsBuilder* GetFilterBitsBuilder() const { return nullptr; }
 
+  // Same as GetFilterBitsBuilder(), but the policy may pick a builder for
+  // the file being built. This is the one called by the table builder.
+  virtual FilterBitsBuilder* GetBuilderWithContext(
+      const FilterBuildingContext& /*context*/) const {
+    return GetFilterBitsBuilder();
+  }
+
   // Get the FilterBitsReader, which is ONLY used for full filter block
   // It contains interface to tell if key can be in filter
   // The input slice should NOT be deleted by FilterPolicy
@@ -148,4 +170,25 @@ class FilterPolicy {
 // trailing spaces in keys.
 extern const FilterPolicy* NewBloomFilterPolicy(
     int bits_per_key, bool use_block_based_builder = false);
+
+// Same as NewBloomFilterPolicy(bits_per_key, false), but the full filters
+// keep all the probes of a key inside one 64-byte block, which are tested
+// together with AVX2 when available. This costs a slightly higher false
+// positive rate for one cache miss per query.
+//
+// Filters of both formats can be read by either policy, older versions
+// treat a blocked filter as always matching.
+extern const FilterPolicy* NewBlockedBloomFilterPolicy(int bits_per_key);
+
+// Return a new filter policy that builds Ribbon filters with about the false
+// positive rate of a bloom filter of bloom_equivalent_bits_per_key, in ~25%
+// less space, but slower to build. Levels below bloom_before_level get bloom
+// filters, e.g. set it to num_levels - 1 to save the space where most keys
+// are and keep fast flushes and compactions above. -1 builds Ribbon filters
+// for all the files, also those of unknown level.
+//
+// Filters of this policy can be read by NewBloomFilterPolicy() and vice
+// versa, older versions treat a Ribbon filter as always matching.
+extern const FilterPolicy* NewRibbonFilterPolicy(
+    int bloom_equivalent_bits_per_key, int bloom_before_level = 0);
 }  // namespace TERARKDB_NAMESPACE
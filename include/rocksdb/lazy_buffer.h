@@ -97,6 +97,9 @@ class LazyBufferState {
 
   // Get &buffer->context_
   static LazyBufferContext* get_context(LazyBuffer* buffer);
+
+  // Get buffer->state_
+  static const LazyBufferState* get_state(const LazyBuffer* buffer);
 };
 
 class LazyBuffer {
@@ -352,6 +355,11 @@ inline LazyBufferContext* LazyBufferState::get_context(LazyBuffer* buffer) {
   return &buffer->context_;
 }
 
+inline const LazyBufferState* LazyBufferState::get_state(
+    const LazyBuffer* buffer) {
+  return buffer->state_;
+}
+
 #ifdef __GNUC__
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wmissing-field-initializers"
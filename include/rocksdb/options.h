@@ -18,6 +18,7 @@
 #include <vector>
 
 #include "rocksdb/advanced_options.h"
+#include "rocksdb/cache.h"
 #include "rocksdb/compaction_dispatcher.h"
 #include "rocksdb/comparator.h"
 #include "rocksdb/env.h"
@@ -316,6 +317,25 @@ struct ColumnFamilyOptions : public AdvancedColumnFamilyOptions {
   // valid [0 , 0.5]
   double blob_gc_ratio = 0.05;
 
+  // Key Value separation gc liveness check mode
+  // GC checks whether blob records are still referenced by streaming a
+  // merge-join between the blob inputs and the key SSTs overlapping them,
+  // when the estimated key SST entries in that range are no more than
+  // blob_gc_merge_join_ratio times the blob input entries. Otherwise (small
+  // blob ranges inside a large LSM) it falls back to point lookups.
+  // 0 to always use point lookups
+  double blob_gc_merge_join_ratio = 16;
+
+  // Key Value separation value addressing
+  // If true, each separated value is written to its own blob data block and
+  // the value index records that block's (offset, size), so reading the value
+  // costs one block read without searching the blob SST index. Blob files
+  // rewritten by GC fall back to the key lookup. Only values addressed by
+  // offset are read ahead by ReadOptions::separated_value_readahead and
+  // MultiGet.
+  // Only supported by BlockBasedTable, other formats ignore it
+  bool blob_offset_addressing = false;
+
   // Blob file size
   // Default : same as bottommost level sst file size
   uint64_t target_blob_file_size = 0;
@@ -328,6 +348,20 @@ struct ColumnFamilyOptions : public AdvancedColumnFamilyOptions {
   // 0 to unlimited
   size_t max_dependence_blob_overlap = 1024;
 
+  // A cache for separated values, keyed by blob file and the value's
+  // location inside it. If set, blob SST reads don't fill the block cache,
+  // so values are cached with their own capacity instead of evicting the
+  // blocks of key SSTs.
+  // Default: nullptr (disabled)
+  std::shared_ptr<Cache> blob_cache = nullptr;
+
+  // Priority of the values inserted into blob_cache. Keep LOW when the
+  // cache is shared with a block cache that puts index and filter blocks in
+  // its high priority pool, or use HIGH to keep hot values resident ahead of
+  // data blocks.
+  // Default: LOW
+  Cache::Priority blob_cache_priority = Cache::Priority::LOW;
+
   // Maintainer job ratio
   // 0 to 1
   double maintainer_job_ratio = 0.1;
@@ -740,6 +774,20 @@ struct DBOptions {
   // since aio on non-direct-io is really synchronous on linux
   bool use_aio_reads = false;
 
+  // If true, random access reads are submitted through a per-thread
+  // io_uring instead of pread or libaio. Reads issued by fibers of the same
+  // thread (e.g. MultiGet with aio_concurrency) are batched into a single
+  // submission, and unlike libaio, buffered reads are asynchronous as well.
+  // Falls back to the other read paths if the kernel lacks io_uring.
+  bool use_io_uring_reads = false;
+
+  // If true, io_uring rings are created with a kernel submission polling
+  // thread, which saves the submission syscall. The rings of all reading
+  // threads share one polling thread per process. Requires
+  // use_io_uring_reads. Falls back to normal rings if it is not permitted,
+  // or on kernels before 5.11, which lack IORING_FEAT_SQPOLL_NONFIXED.
+  bool io_uring_sqpoll = false;
+
   // if not zero, dump rocksdb.stats to LOG every stats_dump_period_sec
   //
   // Default: 600 (10 min)
@@ -945,6 +993,18 @@ struct DBOptions {
   // Default: false
   bool enable_pipelined_write = false;
 
+  // If true, the WAL of sync writes is synced by a dedicated thread instead
+  // of the write group leader. The leader only appends the group to the WAL
+  // and leaves the write group, so the next groups are formed and appended
+  // while the sync is in flight, and each sync writer returns once a sync
+  // started after its append has finished. A sync write is visible to
+  // readers before it is durable, like with manual_wal_flush.
+  // Not supported with enable_pipelined_write, two_write_queues,
+  // manual_wal_flush, allow_mmap_writes or wal_streams > 1.
+  //
+  // Default: false
+  bool enable_async_wal_sync = false;
+
   // If true, allow multi-writers to update mem tables in parallel.
   // Only some memtable_factory-s support concurrent writes; currently it
   // is implemented only for SkipListFactory.  Concurrent memtable writes
@@ -989,6 +1049,39 @@ struct DBOptions {
   // Default: kPointInTimeRecovery
   WALRecoveryMode wal_recovery_mode = WALRecoveryMode::kPointInTimeRecovery;
 
+  // Number of threads inserting WAL records into the memtables while the
+  // WAL is replayed on DB::Open(). With a value greater than 1, one thread
+  // reads and checksums the log records while the worker threads insert the
+  // previously read batches. It requires allow_concurrent_memtable_write,
+  // and batches with merge operands, transactions or a wal_filter are still
+  // replayed one at a time.
+  //
+  // Default: 1
+  int wal_recovery_threads = 1;
+
+  // Number of WAL files written at the same time. With a value greater than
+  // 1, writers are spread over the streams by CPU core and each stream has
+  // its own write group leader and file. Sequence numbers stay global and
+  // become visible in order, and recovery replays the batches of all the
+  // streams in sequence order.
+  //
+  // A sync write also syncs the other streams once all the writes with a
+  // lower sequence are in their files, so recovery stays point in time.
+  // Writes without sync are recovered as far as they were synced by a
+  // later sync write, by SyncWAL() or by the OS, so a later unsynced write
+  // of one stream may be recovered while an earlier one of another stream
+  // is lost. Writes with merge operands or callbacks, writes without WAL and
+  // writes during a stall go through the main write queue. It requires
+  // allow_concurrent_memtable_write and is not supported with
+  // enable_pipelined_write, two_write_queues, manual_wal_flush, allow_2pc,
+  // allow_mmap_writes or a wal_filter, nor by GetUpdatesSince(). Log files
+  // are not recycled and prepare_log_writer_num is ignored. DB::Open() with
+  // wal_streams = 1 fails with InvalidArgument while the DB has WAL files
+  // written by several streams.
+  //
+  // Default: 1
+  int wal_streams = 1;
+
   // if set to false then recovery will fail when a prepared
   // transaction is encountered in the WAL
   bool allow_2pc = false;
@@ -1249,6 +1342,18 @@ struct ReadOptions {
   // now only used by MultiGet
   int aio_concurrency;
 
+  // If non-zero, forward iteration over a KV separated column family reads
+  // up to this many entries ahead of the current one, and reads ahead the
+  // blob blocks of their separated values together. Not applied to tailing
+  // iterators or iter_start_seqnum > 0.
+  //
+  // This is a kernel readahead hint over the merged blocks, not a batch of
+  // reads: it has no effect with use_direct_reads. Only values addressed by
+  // offset (blob_offset_addressing, and not rewritten by GC) are read
+  // ahead, values addressed by key still cost one blob read each.
+  // Default: 0
+  size_t separated_value_readahead;
+
   // A callback to determine whether relevant keys for this scan exist in a
   // given table based on the table's properties. The callback is passed the
   // properties of each table during iteration. If the callback returns false,
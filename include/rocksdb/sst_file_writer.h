@@ -39,7 +39,10 @@ struct ExternalSstFileInfo {
         file_size(0),
         num_entries(0),
         num_range_del_entries(0),
-        version(0) {}
+        version(0),
+        blob_file_path(""),
+        blob_file_size(0),
+        blob_num_entries(0) {}
 
   ExternalSstFileInfo(const std::string& _file_path,
                       const std::string& _smallest_key,
@@ -55,7 +58,10 @@ struct ExternalSstFileInfo {
         file_size(_file_size),
         num_entries(_num_entries),
         num_range_del_entries(0),
-        version(_version) {}
+        version(_version),
+        blob_file_path(""),
+        blob_file_size(0),
+        blob_num_entries(0) {}
 
   std::string file_path;     // external sst file path
   std::string smallest_key;  // smallest user key in file
@@ -68,6 +74,11 @@ struct ExternalSstFileInfo {
   uint64_t num_entries;               // number of entries in file
   uint64_t num_range_del_entries;  // number of range deletion entries in file
   int32_t version;                 // file version
+  // blob sst holding the separated values of the file, empty if none. It has
+  // to be ingested together with the file.
+  std::string blob_file_path;
+  uint64_t blob_file_size;    // blob file size in bytes
+  uint64_t blob_num_entries;  // number of values in blob file
 };
 
 // SstFileWriter is used to create sst files that can be added to database later
@@ -102,6 +113,15 @@ class SstFileWriter {
   // Prepare SstFileWriter to write into file located at "file_path".
   Status Open(const std::string& file_path);
 
+  // Same as above, but values are separated into a blob sst located at
+  // "blob_file_path" according to blob_size and blob_large_key_ratio, the
+  // same way as flush and compaction do. Both files have to be passed to the
+  // same IngestExternalFile call, see ExternalSstFileInfo::blob_file_path.
+  // The blob file is removed by Finish() if no value was separated.
+  // Returns NotSupported if the table factory builds in two passes, e.g.
+  // TerarkZipTable.
+  Status Open(const std::string& file_path, const std::string& blob_file_path);
+
   // Add a Put key with value to currently opened file (deprecated)
   // REQUIRES: key is after any previously added key according to comparator.
   ROCKSDB_DEPRECATED_FUNC Status Add(const Slice& user_key, const Slice& value);
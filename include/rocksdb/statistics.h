@@ -258,9 +258,26 @@ enum Tickers : uint32_t {
   GC_TOUCH_FILES,
   GC_SKIP_GET_BY_SEQ,
   GC_SKIP_GET_BY_FILE,
+  // # of blob records whose liveness was checked by GC merge-join
+  GC_MERGE_JOIN_KEYS,
+  // # of key SST seeks issued by GC merge-join
+  GC_MERGE_JOIN_SEEKS,
 
   READ_BLOB_VALID,
   READ_BLOB_INVALID,
+  // # of separated values read through the blob offset handle
+  READ_BLOB_BY_HANDLE,
+
+  // # of separated values found / missing in ColumnFamilyOptions::blob_cache
+  BLOB_CACHE_HIT,
+  BLOB_CACHE_MISS,
+  // # of separated values added to the blob cache
+  BLOB_CACHE_ADD,
+  // # of failures when adding separated values to the blob cache
+  BLOB_CACHE_ADD_FAILURES,
+  // # of bytes read from / written into the blob cache
+  BLOB_CACHE_BYTES_READ,
+  BLOB_CACHE_BYTES_WRITE,
 
   TICKER_ENUM_MAX
 };
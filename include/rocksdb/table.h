@@ -20,6 +20,7 @@
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "rocksdb/cache.h"
 #include "rocksdb/env.h"
@@ -199,6 +200,18 @@ struct BlockBasedTableOptions {
   // This must generally be true for gets to be efficient.
   bool whole_key_filtering = true;
 
+  // Bits per key of the full filters built for files of each level, the last
+  // entry applies to all the levels after it. 0 builds no filter for the
+  // level, e.g. {10, 10, 10, 0} builds no filters on L3 and below, where
+  // most Gets find their key anyway. Empty, or a file of unknown level such
+  // as from SstFileWriter, uses filter_policy as configured.
+  //
+  // Other bits per key are only honored by the built-in full filter
+  // policies, a block based filter always uses its configured ones.
+  //
+  // Default: empty
+  std::vector<int> filter_bits_per_level;
+
   // Verify that decompressing the compressed block gives back the input. This
   // is a verification mode that we use to detect bugs in compression
   // algorithms.
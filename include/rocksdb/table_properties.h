@@ -71,6 +71,8 @@ struct TablePropertiesNames {
   static const std::string kInheritanceTree;
   static const std::string kEarliestTimeBeginCompact;
   static const std::string kLatestTimeEndCompact;
+  static const std::string kEarliestExpireTime;
+  static const std::string kLatestExpireTime;
 };
 
 extern const std::string kPropertiesBlock;
@@ -287,5 +289,10 @@ extern uint64_t GetMergeOperands(const UserCollectedProperties& props,
 extern void GetCompactionTimePoint(const UserCollectedProperties& props,
                                    uint64_t* earliest_time_begin_compact,
                                    uint64_t* latest_time_end_compact);
+// Expiration time points of the entries of a blob sst, port::kMaxUint64 if
+// absent. The latest one is only present if all the entries have a ttl.
+extern void GetExpireTimeRange(const UserCollectedProperties& props,
+                               uint64_t* earliest_expire_time,
+                               uint64_t* latest_expire_time);
 
 }  // namespace TERARKDB_NAMESPACE
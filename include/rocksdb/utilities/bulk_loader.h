@@ -0,0 +1,97 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+//
+// A bulk loader sorts unordered key/value streams into non-overlapping
+// external SST files and ingests all of them at once.
+
+#pragma once
+#ifndef ROCKSDB_LITE
+
+#include <memory>
+#include <string>
+
+#include "rocksdb/options.h"
+#include "rocksdb/slice.h"
+#include "rocksdb/status.h"
+#include "rocksdb/terark_namespace.h"
+
+namespace TERARKDB_NAMESPACE {
+
+class ColumnFamilyHandle;
+class DB;
+
+struct BulkLoaderOptions {
+  // Number of merges run at once by Finish, on its calling thread and on
+  // num_threads - 1 tasks in the LOW priority thread pool of the DB's Env
+  int num_threads = 4;
+
+  // A merge reads at most this many runs at once, each with its own file
+  // and read buffer. With more runs, groups of them are first merged into
+  // longer runs, in as many passes as needed. At least 2.
+  size_t max_merge_width = 64;
+
+  // Memory of every stream to sort records in, a full buffer is sorted and
+  // spilled to a run file in work_dir. Already sorted buffers are not sorted
+  // again, so partially sorted input is cheap.
+  size_t sort_buffer_size = 64 << 20;
+
+  // The merged output is cut into SST files of about this size
+  uint64_t target_file_size = 64 << 20;
+
+  // Directory for the run files and the SST files, which is created if
+  // missing. Defaults to "<db name>/bulk_load". Concurrent loaders need
+  // different directories.
+  std::string work_dir;
+
+  // Write large values into blob SSTs, see SstFileWriter::Open, according to
+  // blob_size of the column family
+  bool separate_values = false;
+
+  // Used to ingest the SST files. Since the files are private to the loader
+  // they are moved by default.
+  IngestExternalFileOptions ingest_options;
+
+  BulkLoaderOptions() { ingest_options.move_files = true; }
+};
+
+class BulkLoader {
+ public:
+  // Feeds records into the loader, records are in any order. A stream must
+  // not be used by more than one thread at a time, use one stream per
+  // thread to load in parallel. A stream which is destroyed without a
+  // successful Close is discarded, with all its records, and must be
+  // destroyed before the loader.
+  class Stream {
+   public:
+    virtual ~Stream() {}
+
+    // Keys must be unique across all the streams of a loader, duplicates
+    // fail Put or BulkLoader::Finish with InvalidArgument
+    virtual Status Put(const Slice& key, const Slice& value) = 0;
+
+    // Spills the remaining records, must be called before
+    // BulkLoader::Finish. The stream can't be used afterwards.
+    virtual Status Close() = 0;
+  };
+
+  // Creates a loader into column_family of db, which must outlive it
+  static Status Create(DB* db, ColumnFamilyHandle* column_family,
+                       const BulkLoaderOptions& options,
+                       std::unique_ptr<BulkLoader>* loader);
+
+  virtual ~BulkLoader() {}
+
+  // Thread safe
+  virtual Status NewStream(std::unique_ptr<Stream>* stream) = 0;
+
+  // Merges the runs of all the closed streams in parallel into SST files
+  // with disjoint key ranges and ingests them with one IngestExternalFile
+  // call, which places them in the bottommost level that has no overlapping
+  // data. The temporary files are deleted, also on error.
+  virtual Status Finish() = 0;
+};
+
+}  // namespace TERARKDB_NAMESPACE
+#endif  // !ROCKSDB_LITE
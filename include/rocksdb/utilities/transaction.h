@@ -269,6 +269,28 @@ class Transaction {
       const ReadOptions& options, const std::vector<Slice>& keys,
       std::vector<std::string>* values) = 0;
 
+  // Locks the user keys of [start, end) for exclusive access until this
+  // transaction ends, so that other transactions can neither lock nor write
+  // any key of the range, also not keys that don't exist yet. Locking keys of
+  // the range afterwards doesn't take any more lock entries.
+  //
+  // Limits: range locks are exclusive only. Point locks are escalated into a
+  // range only by an explicit GetRangeLock() covering them, never on their
+  // own. TransactionDB::GetLockStatusData() reports the point locks only,
+  // not the ranges. The ranges are released when the transaction ends, not
+  // on RollbackToSavePoint().
+  //
+  // Only supported by transactions of a TransactionDB. Returns
+  // Status::OK() on success,
+  // Status::TimedOut() if the range or a key of it is locked by another
+  // transaction until the lock timeout,
+  // Status::Busy() if waiting for the lock would deadlock,
+  // Status::InvalidArgument() if the range is empty.
+  virtual Status GetRangeLock(ColumnFamilyHandle* /*column_family*/,
+                              const Slice& /*start*/, const Slice& /*end*/) {
+    return Status::NotSupported("Range locks not supported");
+  }
+
   // Returns an iterator that will iterate on all keys in the default
   // column family including both keys in the DB and uncommitted keys in this
   // transaction.
@@ -3480,8 +3480,26 @@ class TickerTypeJni {
         return 0x65;
       case TERARKDB_NAMESPACE::Tickers::READ_BLOB_INVALID:
         return 0x66;
-      case TERARKDB_NAMESPACE::Tickers::TICKER_ENUM_MAX:
+      case TERARKDB_NAMESPACE::Tickers::GC_MERGE_JOIN_KEYS:
         return 0x67;
+      case TERARKDB_NAMESPACE::Tickers::GC_MERGE_JOIN_SEEKS:
+        return 0x68;
+      case TERARKDB_NAMESPACE::Tickers::READ_BLOB_BY_HANDLE:
+        return 0x69;
+      case TERARKDB_NAMESPACE::Tickers::BLOB_CACHE_HIT:
+        return 0x6A;
+      case TERARKDB_NAMESPACE::Tickers::BLOB_CACHE_MISS:
+        return 0x6B;
+      case TERARKDB_NAMESPACE::Tickers::BLOB_CACHE_ADD:
+        return 0x6C;
+      case TERARKDB_NAMESPACE::Tickers::BLOB_CACHE_ADD_FAILURES:
+        return 0x6D;
+      case TERARKDB_NAMESPACE::Tickers::BLOB_CACHE_BYTES_READ:
+        return 0x6E;
+      case TERARKDB_NAMESPACE::Tickers::BLOB_CACHE_BYTES_WRITE:
+        return 0x6F;
+      case TERARKDB_NAMESPACE::Tickers::TICKER_ENUM_MAX:
+        return 0x70;
       default:
         // undefined/default
         return 0x0;
@@ -3699,6 +3717,24 @@ class TickerTypeJni {
       case 0x66:
         return TERARKDB_NAMESPACE::Tickers::READ_BLOB_INVALID;
       case 0x67:
+        return TERARKDB_NAMESPACE::Tickers::GC_MERGE_JOIN_KEYS;
+      case 0x68:
+        return TERARKDB_NAMESPACE::Tickers::GC_MERGE_JOIN_SEEKS;
+      case 0x69:
+        return TERARKDB_NAMESPACE::Tickers::READ_BLOB_BY_HANDLE;
+      case 0x6A:
+        return TERARKDB_NAMESPACE::Tickers::BLOB_CACHE_HIT;
+      case 0x6B:
+        return TERARKDB_NAMESPACE::Tickers::BLOB_CACHE_MISS;
+      case 0x6C:
+        return TERARKDB_NAMESPACE::Tickers::BLOB_CACHE_ADD;
+      case 0x6D:
+        return TERARKDB_NAMESPACE::Tickers::BLOB_CACHE_ADD_FAILURES;
+      case 0x6E:
+        return TERARKDB_NAMESPACE::Tickers::BLOB_CACHE_BYTES_READ;
+      case 0x6F:
+        return TERARKDB_NAMESPACE::Tickers::BLOB_CACHE_BYTES_WRITE;
+      case 0x70:
         return TERARKDB_NAMESPACE::Tickers::TICKER_ENUM_MAX;
 
       default:
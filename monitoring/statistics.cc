@@ -139,8 +139,17 @@ const std::vector<std::pair<Tickers, std::string>> TickersNameMap = {
     {GC_TOUCH_FILES, "rocksdb.num.gc.touch_files"},
     {GC_SKIP_GET_BY_SEQ, "rocksdb.num.gc.skip_by_seqno"},
     {GC_SKIP_GET_BY_FILE, "rocksdb.num.gc.skip_by_file_meta"},
+    {GC_MERGE_JOIN_KEYS, "rocksdb.num.gc.merge_join_keys"},
+    {GC_MERGE_JOIN_SEEKS, "rocksdb.num.gc.merge_join_seeks"},
     {READ_BLOB_VALID, "rocksdb.num.read.blob_valid"},
     {READ_BLOB_INVALID, "rocksdb.num.read.blob_invalid"},
+    {READ_BLOB_BY_HANDLE, "rocksdb.num.read.blob_by_handle"},
+    {BLOB_CACHE_HIT, "rocksdb.blob.cache.hit"},
+    {BLOB_CACHE_MISS, "rocksdb.blob.cache.miss"},
+    {BLOB_CACHE_ADD, "rocksdb.blob.cache.add"},
+    {BLOB_CACHE_ADD_FAILURES, "rocksdb.blob.cache.add.failures"},
+    {BLOB_CACHE_BYTES_READ, "rocksdb.blob.cache.bytes.read"},
+    {BLOB_CACHE_BYTES_WRITE, "rocksdb.blob.cache.bytes.write"},
 };
 
 const std::vector<std::pair<Histograms, std::string>> HistogramsNameMap = {
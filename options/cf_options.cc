@@ -82,6 +82,8 @@ ImmutableCFOptions::ImmutableCFOptions(const ImmutableDBOptions& db_options,
       preserve_deletes(db_options.preserve_deletes),
       listeners(db_options.listeners),
       row_cache(db_options.row_cache),
+      blob_cache(cf_options.blob_cache),
+      blob_cache_priority(cf_options.blob_cache_priority),
       memtable_insert_with_hint_prefix_extractor(
           cf_options.memtable_insert_with_hint_prefix_extractor.get()),
       cf_paths(cf_options.cf_paths) {
@@ -92,6 +94,8 @@ ImmutableCFOptions::ImmutableCFOptions(const ImmutableDBOptions& db_options,
       int_tbl_prop_collector_factories_for_blob->emplace_back(
           new UserKeyTablePropertiesCollectorFactory(f));
     }
+    int_tbl_prop_collector_factories_for_blob->emplace_back(
+        NewTtlExpireIntTblPropCollectorFactory(ttl_extractor_factory));
   }
 }
 
@@ -200,6 +204,10 @@ void MutableCFOptions::Dump(Logger* log) const {
                  blob_large_key_ratio);
   ROCKS_LOG_INFO(log, "                            blob_gc_ratio: %f",
                  blob_gc_ratio);
+  ROCKS_LOG_INFO(log, "                 blob_gc_merge_join_ratio: %f",
+                 blob_gc_merge_join_ratio);
+  ROCKS_LOG_INFO(log, "                   blob_offset_addressing: %d",
+                 blob_offset_addressing);
   ROCKS_LOG_INFO(log, "                    target_blob_file_size: %" PRIu64,
                  target_blob_file_size);
   ROCKS_LOG_INFO(log, "                blob_file_defragment_size: %" PRIu64,
@@ -254,6 +262,8 @@ void MutableCFOptions::Dump(Logger* log) const {
                  report_bg_io_stats);
   ROCKS_LOG_INFO(log, "                optimize_filters_for_hits: %d",
                  optimize_filters_for_hits);
+  ROCKS_LOG_INFO(log, "           adaptive_filter_skip_hit_ratio: %f",
+                 adaptive_filter_skip_hit_ratio);
   ROCKS_LOG_INFO(log, "                  optimize_range_deletion: %d",
                  optimize_range_deletion);
   ROCKS_LOG_INFO(log, "                              compression: %d",
@@ -295,6 +305,8 @@ MutableCFOptions::MutableCFOptions(const ColumnFamilyOptions& options, Env* env)
       blob_size(options.blob_size),
       blob_large_key_ratio(options.blob_large_key_ratio),
       blob_gc_ratio(options.blob_gc_ratio),
+      blob_gc_merge_join_ratio(options.blob_gc_merge_join_ratio),
+      blob_offset_addressing(options.blob_offset_addressing),
       target_blob_file_size(options.target_blob_file_size),
       blob_file_defragment_size(options.blob_file_defragment_size),
       max_dependence_blob_overlap(options.max_dependence_blob_overlap),
@@ -320,6 +332,7 @@ MutableCFOptions::MutableCFOptions(const ColumnFamilyOptions& options, Env* env)
       paranoid_file_checks(options.paranoid_file_checks),
       report_bg_io_stats(options.report_bg_io_stats),
       optimize_filters_for_hits(options.optimize_filters_for_hits),
+      adaptive_filter_skip_hit_ratio(options.adaptive_filter_skip_hit_ratio),
       optimize_range_deletion(options.optimize_range_deletion),
       compression(options.compression),
       ttl_gc_ratio(options.ttl_gc_ratio),
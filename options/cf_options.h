@@ -129,6 +129,10 @@ struct ImmutableCFOptions {
 
   std::shared_ptr<Cache> row_cache;
 
+  std::shared_ptr<Cache> blob_cache;
+
+  Cache::Priority blob_cache_priority;
+
   const SliceTransform* memtable_insert_with_hint_prefix_extractor;
 
   std::vector<DbPath> cf_paths;
@@ -159,6 +163,8 @@ struct MutableCFOptions {
         blob_size(0),
         blob_large_key_ratio(0),
         blob_gc_ratio(0),
+        blob_gc_merge_join_ratio(0),
+        blob_offset_addressing(false),
         target_blob_file_size(0),
         blob_file_defragment_size(0),
         max_dependence_blob_overlap(0),
@@ -177,6 +183,7 @@ struct MutableCFOptions {
         paranoid_file_checks(false),
         report_bg_io_stats(false),
         optimize_filters_for_hits(false),
+        adaptive_filter_skip_hit_ratio(0),
         optimize_range_deletion(false),
         compression(Snappy_Supported() ? kSnappyCompression : kNoCompression),
         ttl_gc_ratio(1.000),
@@ -220,6 +227,8 @@ struct MutableCFOptions {
   size_t blob_size;
   double blob_large_key_ratio;
   double blob_gc_ratio;
+  double blob_gc_merge_join_ratio;
+  bool blob_offset_addressing;
   uint64_t target_blob_file_size;
   uint64_t blob_file_defragment_size;
   size_t max_dependence_blob_overlap;
@@ -243,6 +252,7 @@ struct MutableCFOptions {
   bool report_bg_io_stats;
 
   bool optimize_filters_for_hits;
+  double adaptive_filter_skip_hit_ratio;
   bool optimize_range_deletion;
   CompressionType compression;
 
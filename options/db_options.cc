@@ -58,6 +58,8 @@ ImmutableDBOptions::ImmutableDBOptions(const DBOptions& options)
       use_direct_io_for_flush_and_compaction(
           options.use_direct_io_for_flush_and_compaction),
       use_aio_reads(options.use_aio_reads),
+      use_io_uring_reads(options.use_io_uring_reads),
+      io_uring_sqpoll(options.io_uring_sqpoll),
       allow_fallocate(options.allow_fallocate),
       is_fd_close_on_exec(options.is_fd_close_on_exec),
       advise_random_on_open(options.advise_random_on_open),
@@ -73,6 +75,7 @@ ImmutableDBOptions::ImmutableDBOptions(const DBOptions& options)
       listeners(options.listeners),
       enable_thread_tracking(options.enable_thread_tracking),
       enable_pipelined_write(options.enable_pipelined_write),
+      enable_async_wal_sync(options.enable_async_wal_sync),
       allow_concurrent_memtable_write(options.allow_concurrent_memtable_write),
       enable_write_thread_adaptive_yield(
           options.enable_write_thread_adaptive_yield),
@@ -80,6 +83,8 @@ ImmutableDBOptions::ImmutableDBOptions(const DBOptions& options)
       write_thread_slow_yield_usec(options.write_thread_slow_yield_usec),
       skip_stats_update_on_db_open(options.skip_stats_update_on_db_open),
       wal_recovery_mode(options.wal_recovery_mode),
+      wal_recovery_threads(options.wal_recovery_threads),
+      wal_streams(options.wal_streams),
       allow_2pc(options.allow_2pc),
       row_cache(options.row_cache),
 #ifndef ROCKSDB_LITE
@@ -148,6 +153,10 @@ void ImmutableDBOptions::Dump(Logger* log) const {
                    use_direct_io_for_flush_and_compaction);
   ROCKS_LOG_HEADER(log, "                          Options.use_aio_reads: %d",
                    use_aio_reads);
+  ROCKS_LOG_HEADER(log, "                     Options.use_io_uring_reads: %d",
+                   use_io_uring_reads);
+  ROCKS_LOG_HEADER(log, "                        Options.io_uring_sqpoll: %d",
+                   io_uring_sqpoll);
   ROCKS_LOG_HEADER(log, "         Options.create_missing_column_families: %d",
                    create_missing_column_families);
   ROCKS_LOG_HEADER(log, "                             Options.db_log_dir: %s",
@@ -206,10 +215,16 @@ void ImmutableDBOptions::Dump(Logger* log) const {
       sst_file_manager ? sst_file_manager->GetDeleteRateBytesPerSecond() : 0);
   ROCKS_LOG_HEADER(log, "                      Options.wal_recovery_mode: %d",
                    int(wal_recovery_mode));
+  ROCKS_LOG_HEADER(log, "                   Options.wal_recovery_threads: %d",
+                   wal_recovery_threads);
+  ROCKS_LOG_HEADER(log, "                            Options.wal_streams: %d",
+                   wal_streams);
   ROCKS_LOG_HEADER(log, "                 Options.enable_thread_tracking: %d",
                    enable_thread_tracking);
   ROCKS_LOG_HEADER(log, "                 Options.enable_pipelined_write: %d",
                    enable_pipelined_write);
+  ROCKS_LOG_HEADER(log, "                  Options.enable_async_wal_sync: %d",
+                   enable_async_wal_sync);
   ROCKS_LOG_HEADER(log, "        Options.allow_concurrent_memtable_write: %d",
                    allow_concurrent_memtable_write);
   ROCKS_LOG_HEADER(log, "     Options.enable_write_thread_adaptive_yield: %d",
@@ -53,6 +53,8 @@ struct ImmutableDBOptions {
   bool use_direct_reads;
   bool use_direct_io_for_flush_and_compaction;
   bool use_aio_reads;
+  bool use_io_uring_reads;
+  bool io_uring_sqpoll;
   bool allow_fallocate;
   bool is_fd_close_on_exec;
   bool advise_random_on_open;
@@ -67,12 +69,15 @@ struct ImmutableDBOptions {
   std::vector<std::shared_ptr<EventListener>> listeners;
   bool enable_thread_tracking;
   bool enable_pipelined_write;
+  bool enable_async_wal_sync;
   bool allow_concurrent_memtable_write;
   bool enable_write_thread_adaptive_yield;
   uint64_t write_thread_max_yield_usec;
   uint64_t write_thread_slow_yield_usec;
   bool skip_stats_update_on_db_open;
   WALRecoveryMode wal_recovery_mode;
+  int wal_recovery_threads;
+  int wal_streams;
   bool allow_2pc;
   std::shared_ptr<Cache> row_cache;
 #ifndef ROCKSDB_LITE
@@ -99,6 +99,7 @@ AdvancedColumnFamilyOptions::AdvancedColumnFamilyOptions(const Options& options)
           options.table_properties_collector_factories),
       max_successive_merges(options.max_successive_merges),
       optimize_filters_for_hits(options.optimize_filters_for_hits),
+      adaptive_filter_skip_hit_ratio(options.adaptive_filter_skip_hit_ratio),
       optimize_range_deletion(options.optimize_range_deletion),
       paranoid_file_checks(options.paranoid_file_checks),
       force_consistency_checks(options.force_consistency_checks),
@@ -269,6 +270,10 @@ void ColumnFamilyOptions::Dump(Logger* log) const {
                    blob_large_key_ratio);
   ROCKS_LOG_HEADER(log, "                          Options.blob_gc_ratio: %f",
                    blob_gc_ratio);
+  ROCKS_LOG_HEADER(log, "               Options.blob_gc_merge_join_ratio: %f",
+                   blob_gc_merge_join_ratio);
+  ROCKS_LOG_HEADER(log, "                 Options.blob_offset_addressing: %d",
+                   blob_offset_addressing);
   ROCKS_LOG_HEADER(log,
                    "                  Options.target_blob_file_size: %" PRIu64,
                    target_blob_file_size);
@@ -277,6 +282,17 @@ void ColumnFamilyOptions::Dump(Logger* log) const {
                    blob_file_defragment_size);
   ROCKS_LOG_HEADER(log, "            Options.max_dependence_blob_overlap: %zu",
                    max_dependence_blob_overlap);
+  if (blob_cache) {
+    ROCKS_LOG_HEADER(log,
+                     "                             Options.blob_cache: %zu",
+                     blob_cache->GetCapacity());
+  } else {
+    ROCKS_LOG_HEADER(log,
+                     "                             Options.blob_cache: None");
+  }
+  ROCKS_LOG_HEADER(log, "                    Options.blob_cache_priority: %s",
+                   blob_cache_priority == Cache::Priority::HIGH ? "HIGH"
+                                                                : "LOW");
   ROCKS_LOG_HEADER(log, "                   Options.maintainer_job_ratio: %f",
                    maintainer_job_ratio);
   ROCKS_LOG_HEADER(log, "                           Options.ttl_gc_ratio: %f",
@@ -364,6 +380,8 @@ void ColumnFamilyOptions::Dump(Logger* log) const {
       max_successive_merges);
   ROCKS_LOG_HEADER(log, "              Options.optimize_filters_for_hits: %d",
                    optimize_filters_for_hits);
+  ROCKS_LOG_HEADER(log, "         Options.adaptive_filter_skip_hit_ratio: %f",
+                   adaptive_filter_skip_hit_ratio);
   ROCKS_LOG_HEADER(log, "                Options.optimize_range_deletion: %d",
                    optimize_range_deletion);
   ROCKS_LOG_HEADER(log, "                   Options.paranoid_file_checks: %d",
@@ -584,6 +602,7 @@ ReadOptions::ReadOptions()
       background_purge_on_iterator_cleanup(false),
       ignore_range_deletions(false),
       aio_concurrency(32),
+      separated_value_readahead(0),
       iter_start_seqnum(0) {}
 
 ReadOptions::ReadOptions(bool cksum, bool cache)
@@ -602,6 +621,7 @@ ReadOptions::ReadOptions(bool cksum, bool cache)
       background_purge_on_iterator_cleanup(false),
       ignore_range_deletions(false),
       aio_concurrency(32),
+      separated_value_readahead(0),
       iter_start_seqnum(0) {}
 
 }  // namespace TERARKDB_NAMESPACE
@@ -85,6 +85,8 @@ DBOptions BuildDBOptions(const ImmutableDBOptions& immutable_db_options,
   options.use_direct_io_for_flush_and_compaction =
       immutable_db_options.use_direct_io_for_flush_and_compaction;
   options.use_aio_reads = immutable_db_options.use_aio_reads;
+  options.use_io_uring_reads = immutable_db_options.use_io_uring_reads;
+  options.io_uring_sqpoll = immutable_db_options.io_uring_sqpoll;
   options.allow_fallocate = immutable_db_options.allow_fallocate;
   options.is_fd_close_on_exec = immutable_db_options.is_fd_close_on_exec;
   options.stats_dump_period_sec = mutable_db_options.stats_dump_period_sec;
@@ -116,6 +118,7 @@ DBOptions BuildDBOptions(const ImmutableDBOptions& immutable_db_options,
   options.enable_thread_tracking = immutable_db_options.enable_thread_tracking;
   options.delayed_write_rate = mutable_db_options.delayed_write_rate;
   options.enable_pipelined_write = immutable_db_options.enable_pipelined_write;
+  options.enable_async_wal_sync = immutable_db_options.enable_async_wal_sync;
   options.allow_concurrent_memtable_write =
       immutable_db_options.allow_concurrent_memtable_write;
   options.enable_write_thread_adaptive_yield =
@@ -127,6 +130,8 @@ DBOptions BuildDBOptions(const ImmutableDBOptions& immutable_db_options,
   options.skip_stats_update_on_db_open =
       immutable_db_options.skip_stats_update_on_db_open;
   options.wal_recovery_mode = immutable_db_options.wal_recovery_mode;
+  options.wal_recovery_threads = immutable_db_options.wal_recovery_threads;
+  options.wal_streams = immutable_db_options.wal_streams;
   options.allow_2pc = immutable_db_options.allow_2pc;
   options.row_cache = immutable_db_options.row_cache;
 #ifndef ROCKSDB_LITE
@@ -171,6 +176,9 @@ ColumnFamilyOptions BuildColumnFamilyOptions(
   cf_opts.blob_size = mutable_cf_options.blob_size;
   cf_opts.blob_large_key_ratio = mutable_cf_options.blob_large_key_ratio;
   cf_opts.blob_gc_ratio = mutable_cf_options.blob_gc_ratio;
+  cf_opts.blob_gc_merge_join_ratio =
+      mutable_cf_options.blob_gc_merge_join_ratio;
+  cf_opts.blob_offset_addressing = mutable_cf_options.blob_offset_addressing;
   cf_opts.target_blob_file_size = mutable_cf_options.target_blob_file_size;
   cf_opts.blob_file_defragment_size =
       mutable_cf_options.blob_file_defragment_size;
@@ -179,6 +187,8 @@ ColumnFamilyOptions BuildColumnFamilyOptions(
   cf_opts.maintainer_job_ratio = mutable_cf_options.maintainer_job_ratio;
   cf_opts.optimize_filters_for_hits =
       mutable_cf_options.optimize_filters_for_hits;
+  cf_opts.adaptive_filter_skip_hit_ratio =
+      mutable_cf_options.adaptive_filter_skip_hit_ratio;
   cf_opts.optimize_range_deletion = mutable_cf_options.optimize_range_deletion;
   cf_opts.soft_pending_compaction_bytes_limit =
       mutable_cf_options.soft_pending_compaction_bytes_limit;
@@ -560,6 +570,10 @@ bool ParseOptionHelper(char* opt_address, const OptionType& opt_type,
       return ParseEnum<InfoLogLevel>(
           info_log_level_string_map, value,
           reinterpret_cast<InfoLogLevel*>(opt_address));
+    case OptionType::kCachePriority:
+      return ParseEnum<Cache::Priority>(
+          cache_priority_string_map, value,
+          reinterpret_cast<Cache::Priority*>(opt_address));
     case OptionType::kLRUCacheOptions: {
       return ParseStructOptions<LRUCacheOptions>(
           value, reinterpret_cast<LRUCacheOptions*>(opt_address),
@@ -755,6 +769,10 @@ bool SerializeSingleOptionHelper(const char* opt_address,
       return SerializeEnum<InfoLogLevel>(
           info_log_level_string_map,
           *reinterpret_cast<const InfoLogLevel*>(opt_address), value);
+    case OptionType::kCachePriority:
+      return SerializeEnum<Cache::Priority>(
+          cache_priority_string_map,
+          *reinterpret_cast<const Cache::Priority*>(opt_address), value);
     case OptionType::kCompactionOptionsUniversal:
       return SerializeStruct<CompactionOptionsUniversal>(
           *reinterpret_cast<const CompactionOptionsUniversal*>(opt_address),
@@ -1549,6 +1567,12 @@ std::unordered_map<std::string, OptionTypeInfo>
         {"use_aio_reads",
          {offsetof(struct DBOptions, use_aio_reads), OptionType::kBoolean,
           OptionVerificationType::kNormal, false, 0}},
+        {"use_io_uring_reads",
+         {offsetof(struct DBOptions, use_io_uring_reads), OptionType::kBoolean,
+          OptionVerificationType::kNormal, false, 0}},
+        {"io_uring_sqpoll",
+         {offsetof(struct DBOptions, io_uring_sqpoll), OptionType::kBoolean,
+          OptionVerificationType::kNormal, false, 0}},
         {"allow_2pc",
          {offsetof(struct DBOptions, allow_2pc), OptionType::kBoolean,
           OptionVerificationType::kNormal, false, 0}},
@@ -1720,6 +1744,9 @@ std::unordered_map<std::string, OptionTypeInfo>
         {"enable_pipelined_write",
          {offsetof(struct DBOptions, enable_pipelined_write),
           OptionType::kBoolean, OptionVerificationType::kNormal, false, 0}},
+        {"enable_async_wal_sync",
+         {offsetof(struct DBOptions, enable_async_wal_sync),
+          OptionType::kBoolean, OptionVerificationType::kNormal, false, 0}},
         {"allow_concurrent_memtable_write",
          {offsetof(struct DBOptions, allow_concurrent_memtable_write),
           OptionType::kBoolean, OptionVerificationType::kNormal, false, 0}},
@@ -1727,6 +1754,12 @@ std::unordered_map<std::string, OptionTypeInfo>
          {offsetof(struct DBOptions, wal_recovery_mode),
           OptionType::kWALRecoveryMode, OptionVerificationType::kNormal, false,
           0}},
+        {"wal_recovery_threads",
+         {offsetof(struct DBOptions, wal_recovery_threads), OptionType::kInt,
+          OptionVerificationType::kNormal, false, 0}},
+        {"wal_streams",
+         {offsetof(struct DBOptions, wal_streams), OptionType::kInt,
+          OptionVerificationType::kNormal, false, 0}},
         {"enable_write_thread_adaptive_yield",
          {offsetof(struct DBOptions, enable_write_thread_adaptive_yield),
           OptionType::kBoolean, OptionVerificationType::kNormal, false, 0}},
@@ -1855,6 +1888,10 @@ std::unordered_map<std::string, InfoLogLevel>
         {"FATAL_LEVEL", InfoLogLevel::FATAL_LEVEL},
         {"HEADER_LEVEL", InfoLogLevel::HEADER_LEVEL}};
 
+std::unordered_map<std::string, Cache::Priority>
+    OptionsHelper::cache_priority_string_map = {
+        {"HIGH", Cache::Priority::HIGH}, {"LOW", Cache::Priority::LOW}};
+
 ColumnFamilyOptions OptionsHelper::dummy_cf_options;
 CompactionOptionsFIFO OptionsHelper::dummy_comp_options;
 LRUCacheOptions OptionsHelper::dummy_lru_cache_options;
@@ -1935,6 +1972,18 @@ std::unordered_map<std::string, OptionTypeInfo>
          {offset_of(&ColumnFamilyOptions::blob_gc_ratio), OptionType::kDouble,
           OptionVerificationType::kNormal, true,
           offsetof(struct MutableCFOptions, blob_gc_ratio)}},
+        {"blob_gc_merge_join_ratio",
+         {offset_of(&ColumnFamilyOptions::blob_gc_merge_join_ratio),
+          OptionType::kDouble, OptionVerificationType::kNormal, true,
+          offsetof(struct MutableCFOptions, blob_gc_merge_join_ratio)}},
+        {"blob_offset_addressing",
+         {offset_of(&ColumnFamilyOptions::blob_offset_addressing),
+          OptionType::kBoolean, OptionVerificationType::kNormal, true,
+          offsetof(struct MutableCFOptions, blob_offset_addressing)}},
+        {"blob_cache_priority",
+         {offset_of(&ColumnFamilyOptions::blob_cache_priority),
+          OptionType::kCachePriority, OptionVerificationType::kNormal, false,
+          0}},
         {"target_blob_file_size",
          {offset_of(&ColumnFamilyOptions::target_blob_file_size),
           OptionType::kUInt64T, OptionVerificationType::kNormal, true,
@@ -1970,6 +2019,10 @@ std::unordered_map<std::string, OptionTypeInfo>
          {offset_of(&ColumnFamilyOptions::optimize_filters_for_hits),
           OptionType::kBoolean, OptionVerificationType::kNormal, true,
           offsetof(struct MutableCFOptions, optimize_filters_for_hits)}},
+        {"adaptive_filter_skip_hit_ratio",
+         {offset_of(&ColumnFamilyOptions::adaptive_filter_skip_hit_ratio),
+          OptionType::kDouble, OptionVerificationType::kNormal, true,
+          offsetof(struct MutableCFOptions, adaptive_filter_skip_hit_ratio)}},
         {"optimize_range_deletion",
          {offset_of(&ColumnFamilyOptions::optimize_range_deletion),
           OptionType::kBoolean, OptionVerificationType::kNormal, true,
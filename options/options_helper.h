@@ -78,6 +78,7 @@ enum class OptionType {
   kWALRecoveryMode,
   kAccessHint,
   kInfoLogLevel,
+  kCachePriority,
   kLRUCacheOptions,
   kEntropyAlgo,
   kWriteBufferFlushPri,
@@ -188,6 +189,8 @@ struct OptionsHelper {
       access_hint_string_map;
   static std::unordered_map<std::string, InfoLogLevel>
       info_log_level_string_map;
+  static std::unordered_map<std::string, Cache::Priority>
+      cache_priority_string_map;
   static ColumnFamilyOptions dummy_cf_options;
   static CompactionOptionsFIFO dummy_comp_options;
   static LRUCacheOptions dummy_lru_cache_options;
@@ -232,6 +235,8 @@ static auto& wal_recovery_mode_string_map =
 static auto& access_hint_string_map = OptionsHelper::access_hint_string_map;
 static auto& info_log_level_string_map =
     OptionsHelper::info_log_level_string_map;
+static auto& cache_priority_string_map =
+    OptionsHelper::cache_priority_string_map;
 #endif  // !ROCKSDB_LITE
 
 }  // namespace TERARKDB_NAMESPACE
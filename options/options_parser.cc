@@ -565,6 +565,9 @@ bool AreEqualOptions(
     case OptionType::kInfoLogLevel:
       return (*reinterpret_cast<const InfoLogLevel*>(offset1) ==
               *reinterpret_cast<const InfoLogLevel*>(offset2));
+    case OptionType::kCachePriority:
+      return (*reinterpret_cast<const Cache::Priority*>(offset1) ==
+              *reinterpret_cast<const Cache::Priority*>(offset2));
     case OptionType::kCompactionOptionsUniversal: {
       CompactionOptionsUniversal lhs =
           *reinterpret_cast<const CompactionOptionsUniversal*>(offset1);
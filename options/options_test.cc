@@ -579,6 +579,18 @@ TEST_F(OptionsTest, GetBlockBasedTableOptionsFromString) {
             new_opt.cache_index_and_filter_blocks);
   ASSERT_EQ(table_opt.filter_policy, new_opt.filter_policy);
 
+  // blocked bloom filter
+  ASSERT_OK(GetBlockBasedTableOptionsFromString(
+      table_opt, "filter_policy=blockedbloomfilter:10", &new_opt));
+  ASSERT_TRUE(new_opt.filter_policy != nullptr);
+  ASSERT_STREQ("rocksdb.BuiltinBloomFilter", new_opt.filter_policy->Name());
+
+  // ribbon filter
+  ASSERT_OK(GetBlockBasedTableOptionsFromString(
+      table_opt, "filter_policy=ribbonfilter:10:3", &new_opt));
+  ASSERT_TRUE(new_opt.filter_policy != nullptr);
+  ASSERT_STREQ("rocksdb.BuiltinBloomFilter", new_opt.filter_policy->Name());
+
   // Check block cache options are overwritten when specified
   // in new format as a struct.
   ASSERT_OK(GetBlockBasedTableOptionsFromString(
@@ -14,6 +14,7 @@ LIB_SOURCES =                                                   \
   db/compaction_picker.cc                                       \
   db/compaction_picker_universal.cc                             \
   db/compaction_dispatcher.cc                                   \
+  db/compaction_worker_codec.cc                                 \
   db/convenience.cc                                             \
   db/db_filesnapshot.cc                                         \
   db/db_impl.cc                                                 \
@@ -34,6 +35,7 @@ LIB_SOURCES =                                                   \
   db/file_indexer.cc                                            \
   db/flush_job.cc                                               \
   db/flush_scheduler.cc                                         \
+  db/hybrid_compaction_dispatcher.cc                            \
   db/forward_iterator.cc                                        \
   db/internal_stats.cc                                          \
   db/logs_with_prep_tracker.cc                                  \
@@ -41,6 +43,7 @@ LIB_SOURCES =                                                   \
   db/log_writer.cc                                              \
   db/malloc_stats.cc                                            \
   db/map_builder.cc                                             \
+  db/map_sst_index.cc                                           \
   db/memtable.cc                                                \
   db/memtablerep.cc                                             \
   db/memtable_list.cc                                           \
@@ -58,6 +61,7 @@ LIB_SOURCES =                                                   \
   db/version_edit.cc                                            \
   db/version_set.cc                                             \
   db/wal_manager.cc                                             \
+  db/wal_stream_sequencer.cc                                    \
   db/write_batch.cc                                             \
   db/write_batch_base.cc                                        \
   db/write_controller.cc                                        \
@@ -69,6 +73,7 @@ LIB_SOURCES =                                                   \
   env/env_io_prof.cc                                            \
   env/env_posix.cc                                              \
   env/io_posix.cc                                               \
+  env/io_uring.cc                                               \
   env/mock_env.cc                                               \
   memtable/alloc_tracker.cc                                     \
   memtable/concurrent_hashduallist_rep.cc                       \
@@ -172,6 +177,7 @@ LIB_SOURCES =                                                   \
   util/murmurhash.cc                                            \
   util/random.cc                                                \
   util/rate_limiter.cc                                          \
+  util/ribbon_filter.cc                                         \
   util/slice.cc                                                 \
   util/sst_file_manager_impl.cc                                 \
   util/status.cc                                                \
@@ -184,6 +190,7 @@ LIB_SOURCES =                                                   \
   util/transaction_test_util.cc                                 \
   util/xxhash.cc                                                \
   utilities/backupable/backupable_db.cc                         \
+  utilities/bulk_load/bulk_loader.cc                            \
   utilities/cassandra/cassandra_compaction_filter.cc            \
   utilities/cassandra/format.cc                                 \
   utilities/cassandra/merge_operator.cc                         \
@@ -293,6 +300,8 @@ MAIN_SOURCES =                                                          \
   db/compaction_job_stats_test.cc                                       \
   db/compaction_job_test.cc                                             \
   db/compaction_picker_test.cc                                          \
+  db/compaction_worker_codec_bench.cc                                   \
+  db/compaction_worker_codec_test.cc                                    \
   db/comparator_db_test.cc                                              \
   db/corruption_test.cc                                                 \
   db/cuckoo_table_db_test.cc                                            \
@@ -335,6 +344,7 @@ MAIN_SOURCES =                                                          \
   db/file_reader_writer_test.cc                                         \
   db/filename_test.cc                                                   \
   db/flush_job_test.cc                                                  \
+  db/hybrid_compaction_dispatcher_test.cc                               \
   db/hash_table_test.cc                                                 \
   db/hash_test.cc                                                       \
   db/heap_test.cc                                                       \
@@ -342,6 +352,7 @@ MAIN_SOURCES =                                                          \
   db/log_test.cc                                                        \
   db/lru_cache_test.cc                                                  \
   db/manual_compaction_test.cc                                          \
+  db/map_sst_index_test.cc                                              \
   db/memtable_list_test.cc                                              \
   db/merge_helper_test.cc                                               \
   db/merge_test.cc                                                      \
@@ -365,6 +376,7 @@ MAIN_SOURCES =                                                          \
   db/version_edit_test.cc                                               \
   db/version_set_test.cc                                                \
   db/wal_manager_test.cc                                                \
+  db/wal_stream_sequencer_test.cc                                       \
   db/write_batch_test.cc                                                \
   db/write_callback_test.cc                                             \
   db/write_controller_test.cc                                           \
@@ -423,6 +435,7 @@ MAIN_SOURCES =                                                          \
   util/thread_list_test.cc                                              \
   util/thread_local_test.cc                                             \
   utilities/backupable/backupable_db_test.cc                            \
+  utilities/bulk_load/bulk_loader_test.cc                               \
   utilities/cassandra/cassandra_format_test.cc                          \
   utilities/cassandra/cassandra_functional_test.cc                      \
   utilities/cassandra/cassandra_row_merge_test.cc                       \
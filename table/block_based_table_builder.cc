@@ -58,13 +58,23 @@ namespace {
 // Create a filter block builder based on its type.
 FilterBlockBuilder* CreateFilterBlockBuilder(
     const ImmutableCFOptions& /*opt*/, const MutableCFOptions& mopt,
-    const BlockBasedTableOptions& table_opt,
+    const BlockBasedTableOptions& table_opt, int level,
     const bool use_delta_encoding_for_index_values,
     PartitionedIndexBuilder* const p_index_builder) {
   if (table_opt.filter_policy == nullptr) return nullptr;
 
+  FilterBuildingContext context;
+  context.level_at_creation = level;
+  if (!table_opt.filter_bits_per_level.empty() && level >= 0) {
+    size_t i = std::min(static_cast<size_t>(level),
+                        table_opt.filter_bits_per_level.size() - 1);
+    context.bits_per_key = table_opt.filter_bits_per_level[i];
+    if (context.bits_per_key <= 0) {
+      return nullptr;
+    }
+  }
   FilterBitsBuilder* filter_bits_builder =
-      table_opt.filter_policy->GetFilterBitsBuilder();
+      table_opt.filter_policy->GetBuilderWithContext(context);
   if (filter_bits_builder == nullptr) {
     return new BlockBasedFilterBlockBuilder(mopt.prefix_extractor.get(),
                                             table_opt);
@@ -271,6 +281,9 @@ struct BlockBasedTableBuilder::Rep {
   size_t compressed_cache_key_prefix_size;
 
   BlockHandle pending_handle;  // Handle to add to index block
+  // pending_handle is flushed by AddWithHandle() and waiting for the first key
+  // of the next data block
+  bool pending_index_entry = false;
 
   std::string compressed_output;
   std::unique_ptr<FlushBlockPolicy> flush_block_policy;
@@ -332,7 +345,8 @@ struct BlockBasedTableBuilder::Rep {
     } else {
       filter_builder.reset(CreateFilterBlockBuilder(
           builder_opt.ioptions, builder_opt.moptions, table_options,
-          use_delta_encoding_for_index_values, p_index_builder_));
+          builder_opt.level, use_delta_encoding_for_index_values,
+          p_index_builder_));
     }
 
     builder_opt.PushIntTblPropCollectors(&table_properties_collectors,
@@ -404,6 +418,12 @@ Status BlockBasedTableBuilder::Add(const Slice& key,
     return Status::Corruption("BlockBasedTableBuilder::Add: overlapping key");
   }
 
+  if (r->pending_index_entry) {
+    assert(r->data_block.empty());
+    r->index_builder->AddIndexEntry(&r->last_key, &key, r->pending_handle);
+    r->pending_index_entry = false;
+  }
+
   auto should_flush = r->flush_block_policy->Update(key, value);
   if (should_flush) {
     assert(!r->data_block.empty());
@@ -446,6 +466,34 @@ Status BlockBasedTableBuilder::Add(const Slice& key,
   return r->status;
 }  // namespace TERARKDB_NAMESPACE
 
+Status BlockBasedTableBuilder::AddWithHandle(const Slice& key,
+                                             const LazyBuffer& value,
+                                             uint64_t* offset,
+                                             uint64_t* size) {
+  Rep* r = rep_;
+  *offset = 0;
+  *size = 0;
+  if (!r->data_block.empty()) {
+    Flush();
+    if (!ok()) {
+      return r->status;
+    }
+    r->pending_index_entry = true;
+  }
+  auto s = Add(key, value);
+  if (!s.ok()) {
+    return s;
+  }
+  Flush();
+  if (ok()) {
+    assert(!r->pending_index_entry);
+    r->pending_index_entry = true;
+    *offset = r->pending_handle.offset();
+    *size = r->pending_handle.size();
+  }
+  return r->status;
+}
+
 Status BlockBasedTableBuilder::AddTombstone(const Slice& key,
                                             const LazyBuffer& lazy_value) {
   Rep* r = rep_;
@@ -900,7 +948,7 @@ Status BlockBasedTableBuilder::Finish(
 
   // To make sure properties block is able to keep the accurate size of index
   // block, we will finish writing all index entries first.
-  if (ok() && !empty_data_block) {
+  if (ok() && (!empty_data_block || r->pending_index_entry)) {
     r->index_builder->AddIndexEntry(
         &r->last_key, nullptr /* no next data block */, r->pending_handle);
   }
@@ -57,6 +57,11 @@ class BlockBasedTableBuilder : public TableBuilder {
   // REQUIRES: Finish(), Abandon() have not been called
   Status Add(const Slice& key, const LazyBuffer& value) override;
 
+  // Add key,value into a data block of its own, the handle of the data block
+  // is returned through offset & size.
+  Status AddWithHandle(const Slice& key, const LazyBuffer& value,
+                       uint64_t* offset, uint64_t* size) override;
+
   Status AddTombstone(const Slice& key, const LazyBuffer& value) override;
 
   // Finish building the table.  Stops using the file passed to the
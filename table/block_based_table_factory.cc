@@ -361,6 +361,12 @@ std::string BlockBasedTableFactory::GetPrintableTableOptions() const {
   snprintf(buffer, kBufferSize, "  whole_key_filtering: %d\n",
            table_options_.whole_key_filtering);
   ret.append(buffer);
+  ret.append("  filter_bits_per_level: ");
+  for (size_t i = 0; i < table_options_.filter_bits_per_level.size(); ++i) {
+    ret.append(i == 0 ? "" : ":");
+    ret.append(ToString(table_options_.filter_bits_per_level[i]));
+  }
+  ret.append("\n");
   snprintf(buffer, kBufferSize, "  verify_compression: %d\n",
            table_options_.verify_compression);
   ret.append(buffer);
@@ -473,6 +479,30 @@ std::string ParseBlockBasedTableOption(const std::string& name,
     } else if (name == "filter_policy") {
       // Expect the following format
       // bloomfilter:int:bool
+      // blockedbloomfilter:int
+      // ribbonfilter:int[:int]
+      const std::string kRibbonName = "ribbonfilter:";
+      if (value.compare(0, kRibbonName.size(), kRibbonName) == 0) {
+        size_t pos = value.find(':', kRibbonName.size());
+        int bloom_before_level = 0;
+        if (pos != std::string::npos) {
+          bloom_before_level = ParseInt(trim(value.substr(pos + 1)));
+        } else {
+          pos = value.size();
+        }
+        int bits_per_key = ParseInt(
+            trim(value.substr(kRibbonName.size(), pos - kRibbonName.size())));
+        new_options->filter_policy.reset(
+            NewRibbonFilterPolicy(bits_per_key, bloom_before_level));
+        return "";
+      }
+      const std::string kBlockedName = "blockedbloomfilter:";
+      if (value.compare(0, kBlockedName.size(), kBlockedName) == 0) {
+        int bits_per_key = ParseInt(trim(value.substr(kBlockedName.size())));
+        new_options->filter_policy.reset(
+            NewBlockedBloomFilterPolicy(bits_per_key));
+        return "";
+      }
       const std::string kName = "bloomfilter:";
       if (value.compare(0, kName.size(), kName) != 0) {
         return "Invalid filter policy name";
@@ -167,6 +167,9 @@ static std::unordered_map<std::string, OptionTypeInfo>
         {"whole_key_filtering",
          {offsetof(struct BlockBasedTableOptions, whole_key_filtering),
           OptionType::kBoolean, OptionVerificationType::kNormal, false, 0}},
+        {"filter_bits_per_level",
+         {offsetof(struct BlockBasedTableOptions, filter_bits_per_level),
+          OptionType::kVectorInt, OptionVerificationType::kNormal, false, 0}},
         {"skip_table_builder_flush",
          {0, OptionType::kBoolean, OptionVerificationType::kDeprecated, false,
           0}},
@@ -42,6 +42,7 @@
 #include "table/persistent_cache_helper.h"
 #include "table/sst_file_writer_collectors.h"
 #include "table/two_level_iterator.h"
+#include "util/autovector.h"
 #include "util/coding.h"
 #include "util/file_reader_writer.h"
 #include "util/stop_watch.h"
@@ -2401,6 +2402,87 @@ bool BlockBasedTable::FullFilterKeyMayMatch(
   return may_match;
 }
 
+void BlockBasedTable::FullFilterKeysMayMatch(
+    const ReadOptions& read_options, FilterBlockReader* filter,
+    size_t num_keys, const Slice* keys, const bool no_io,
+    const SliceTransform* prefix_extractor, bool* may_match) const {
+  if (filter == nullptr || filter->IsBlockBased() ||
+      !filter->whole_key_filtering()) {
+    for (size_t i = 0; i < num_keys; ++i) {
+      may_match[i] = FullFilterKeyMayMatch(read_options, filter, keys[i],
+                                           no_io, prefix_extractor);
+    }
+    return;
+  }
+  std::vector<Slice> user_keys(num_keys);
+  for (size_t i = 0; i < num_keys; ++i) {
+    user_keys[i] = ExtractUserKey(keys[i]);
+  }
+  filter->KeysMayMatch(num_keys, user_keys.data(), prefix_extractor, no_io,
+                       keys, may_match);
+  for (size_t i = 0; i < num_keys; ++i) {
+    if (may_match[i]) {
+      RecordTick(rep_->ioptions.statistics, BLOOM_FILTER_FULL_POSITIVE);
+      PERF_COUNTER_BY_LEVEL_ADD(bloom_filter_full_positive, 1, rep_->level);
+    }
+  }
+}
+
+namespace {
+// Refer value inside a DataBlockIter, pin it by holding the data block
+class DataBlockLazyBufferState : public LazyBufferState {
+ public:
+  virtual void destroy(LazyBuffer* /*buffer*/) const override {}
+
+  virtual Status pin_buffer(LazyBuffer* buffer) const override {
+    if (buffer->size() <= sizeof(LazyBufferContext)) {
+      buffer->reset(buffer->slice(), true, buffer->file_number());
+      return Status::OK();
+    }
+    auto context = get_context(buffer);
+    DataBlockIter* iter = reinterpret_cast<DataBlockIter*>(context->data[0]);
+    assert(iter != nullptr);
+    Cleanable release_cached_entry = iter->RefCache();
+    if (release_cached_entry.Empty()) {
+      return Status::NotSupported();
+    }
+    buffer->reset(buffer->slice(), std::move(release_cached_entry),
+                  buffer->file_number());
+    return Status::OK();
+  }
+
+  Status fetch_buffer(LazyBuffer* /*buffer*/) const override {
+    return Status::OK();
+  }
+};
+}  // namespace
+
+// Call the *saver function on each entry of the block until it returns false,
+// return true if get_context is done
+bool BlockBasedTable::SaveDataBlockValues(DataBlockIter* biter,
+                                          GetContext* get_context,
+                                          bool* matched, Status* s) const {
+  static DataBlockLazyBufferState static_state;
+  bool done = false;
+  for (; biter->Valid(); biter->Next()) {
+    ParsedInternalKey parsed_key;
+    if (!ParseInternalKey(biter->key(), &parsed_key)) {
+      *s = Status::Corruption(Slice());
+    }
+
+    if (!get_context->SaveValue(
+            parsed_key,
+            LazyBuffer(&static_state, {reinterpret_cast<uint64_t>(biter)},
+                       biter->value(), rep_->file_number),
+            matched)) {
+      done = true;
+      break;
+    }
+  }
+  *s = biter->status();
+  return done;
+}
+
 Status BlockBasedTable::Get(const ReadOptions& read_options, const Slice& key,
                             GetContext* get_context,
                             const SliceTransform* prefix_extractor,
@@ -2484,52 +2566,7 @@ Status BlockBasedTable::Get(const ReadOptions& read_options, const Slice& key,
           break;
         }
 
-        class LazyBufferStateImpl : public LazyBufferState {
-         public:
-          virtual void destroy(LazyBuffer* /*buffer*/) const override {}
-
-          virtual Status pin_buffer(LazyBuffer* buffer) const override {
-            if (buffer->size() <= sizeof(LazyBufferContext)) {
-              buffer->reset(buffer->slice(), true, buffer->file_number());
-              return Status::OK();
-            }
-            auto context = get_context(buffer);
-            DataBlockIter* iter =
-                reinterpret_cast<DataBlockIter*>(context->data[0]);
-            assert(iter != nullptr);
-            Cleanable release_cached_entry = iter->RefCache();
-            if (release_cached_entry.Empty()) {
-              return Status::NotSupported();
-            }
-            buffer->reset(buffer->slice(), std::move(release_cached_entry),
-                          buffer->file_number());
-            return Status::OK();
-          }
-
-          Status fetch_buffer(LazyBuffer* /*buffer*/) const override {
-            return Status::OK();
-          }
-        };
-        static LazyBufferStateImpl static_state;
-
-        // Call the *saver function on each entry/block until it returns false
-        for (; biter.Valid(); biter.Next()) {
-          ParsedInternalKey parsed_key;
-          if (!ParseInternalKey(biter.key(), &parsed_key)) {
-            s = Status::Corruption(Slice());
-          }
-
-          if (!get_context->SaveValue(
-                  parsed_key,
-                  LazyBuffer(&static_state,
-                             {reinterpret_cast<uint64_t>(&biter)},
-                             biter.value(), rep_->file_number),
-                  &matched)) {
-            done = true;
-            break;
-          }
-        }
-        s = biter.status();
+        done = SaveDataBlockValues(&biter, get_context, &matched, &s);
       }
       if (done) {
         // Avoid the extra Next which is expensive in two-level indexes
@@ -2555,6 +2592,163 @@ Status BlockBasedTable::Get(const ReadOptions& read_options, const Slice& key,
   return s;
 }
 
+Status BlockBasedTable::GetFromHandle(const ReadOptions& read_options,
+                                      const Slice& key, uint64_t offset,
+                                      uint64_t size, GetContext* get_context) {
+  assert(key.size() >= 8);  // key must be internal key
+  if (offset + size + kBlockTrailerSize >
+      rep_->footer.metaindex_handle().offset()) {
+    return Status::Corruption("BlockBasedTable::GetFromHandle: bad handle");
+  }
+  DataBlockIter biter;
+  NewDataBlockIterator<DataBlockIter>(
+      rep_, read_options, BlockHandle(offset, size), &biter,
+      false /* is_index */, true /* key_includes_seq */,
+      true /* index_key_is_full */, get_context);
+  if (read_options.read_tier == kBlockCacheTier &&
+      biter.status().IsIncomplete()) {
+    get_context->MarkKeyMayExist();
+    return Status::OK();
+  }
+  if (!biter.status().ok()) {
+    return biter.status();
+  }
+  Status s;
+  bool matched = false;
+  if (biter.SeekForGet(key)) {
+    SaveDataBlockValues(&biter, get_context, &matched, &s);
+  }
+  return s;
+}
+
+void BlockBasedTable::PrefetchFromHandle(uint64_t offset, uint64_t size) {
+  if (offset + size + kBlockTrailerSize >
+      rep_->footer.metaindex_handle().offset()) {
+    return;
+  }
+  // Hint only, errors are reported by the following read
+  rep_->file->Prefetch(offset, static_cast<size_t>(size + kBlockTrailerSize))
+      .PermitUncheckedError();
+}
+
+void BlockBasedTable::MultiGet(const ReadOptions& read_options,
+                               size_t num_keys, const Slice* keys,
+                               GetContext** get_contexts, Status* statuses,
+                               const SliceTransform* prefix_extractor,
+                               bool skip_filters) {
+  if (num_keys < 2) {
+    TableReader::MultiGet(read_options, num_keys, keys, get_contexts, statuses,
+                          prefix_extractor, skip_filters);
+    return;
+  }
+  const bool no_io = read_options.read_tier == kBlockCacheTier;
+  CachableEntry<FilterBlockReader> filter_entry;
+  if (!skip_filters) {
+    filter_entry = GetFilter(prefix_extractor, /*prefetch_buffer*/ nullptr,
+                             no_io, get_contexts[0]);
+  }
+  FilterBlockReader* filter = filter_entry.value;
+
+  // Probe the full filter for the whole batch before touching the index
+  autovector<size_t> candidates;
+  std::unique_ptr<bool[]> may_match(new bool[num_keys]);
+  FullFilterKeysMayMatch(read_options, filter, num_keys, keys, no_io,
+                         prefix_extractor, may_match.get());
+  for (size_t i = 0; i < num_keys; ++i) {
+    assert(keys[i].size() >= 8);  // key must be internal key
+    assert(i == 0 || rep_->internal_comparator.Compare(keys[i - 1], keys[i]) <=
+                         0);
+    statuses[i] = Status::OK();
+    if (may_match[i]) {
+      candidates.push_back(i);
+    } else {
+      RecordTick(rep_->ioptions.statistics, BLOOM_FILTER_USEFUL);
+      PERF_COUNTER_BY_LEVEL_ADD(bloom_filter_useful, 1, rep_->level);
+    }
+  }
+
+  if (!candidates.empty()) {
+    IndexBlockIter iiter_on_stack;
+    bool need_upper_bound_check = false;
+    if (rep_->index_type == BlockBasedTableOptions::kHashSearch) {
+      need_upper_bound_check = PrefixExtractorChanged(
+          &rep_->table_properties_base, prefix_extractor);
+    }
+    auto iiter = NewIndexIterator(read_options, need_upper_bound_check,
+                                  &iiter_on_stack, /* index_entry */ nullptr,
+                                  get_contexts[candidates.front()]);
+    std::unique_ptr<InternalIteratorBase<BlockHandle>> iiter_unique_ptr;
+    if (iiter != &iiter_on_stack) {
+      iiter_unique_ptr.reset(iiter);
+    }
+
+    // Keys come in order, so consecutive keys living in the same data block
+    // share one block read. Values are pinned by GetContext::SaveValue(), so
+    // moving biter to another block doesn't invalidate them.
+    DataBlockIter biter;
+    bool biter_loaded = false;
+    uint64_t biter_offset = 0;
+    for (size_t i : candidates) {
+      const Slice& key = keys[i];
+      GetContext* get_context = get_contexts[i];
+      Status& s = statuses[i];
+      bool matched = false;  // if such user key mathced a key in SST
+      bool done = false;
+      for (iiter->Seek(key); iiter->Valid() && !done; iiter->Next()) {
+        BlockHandle handle = iiter->value();
+
+        if (filter != nullptr && filter->IsBlockBased() == true &&
+            !filter->KeyMayMatch(ExtractUserKey(key), prefix_extractor,
+                                 handle.offset(), no_io)) {
+          RecordTick(rep_->ioptions.statistics, BLOOM_FILTER_USEFUL);
+          PERF_COUNTER_BY_LEVEL_ADD(bloom_filter_useful, 1, rep_->level);
+          break;
+        }
+        if (!biter_loaded || biter_offset != handle.offset() ||
+            !biter.status().ok()) {
+          if (biter_loaded) {
+            biter.Invalidate(Status::OK());
+          }
+          NewDataBlockIterator<DataBlockIter>(
+              rep_, read_options, handle, &biter, false /* is_index */,
+              true /* key_includes_seq */, true /* index_key_is_full */,
+              get_context);
+          biter_loaded = true;
+          biter_offset = handle.offset();
+        }
+        if (no_io && biter.status().IsIncomplete()) {
+          // couldn't get block from block_cache
+          get_context->MarkKeyMayExist();
+          break;
+        }
+        if (!biter.status().ok()) {
+          s = biter.status();
+          break;
+        }
+        if (!biter.SeekForGet(key)) {
+          break;
+        }
+        done = SaveDataBlockValues(&biter, get_context, &matched, &s);
+        if (done) {
+          break;
+        }
+      }
+      if (matched && filter != nullptr && !filter->IsBlockBased()) {
+        RecordTick(rep_->ioptions.statistics, BLOOM_FILTER_FULL_TRUE_POSITIVE);
+        PERF_COUNTER_BY_LEVEL_ADD(bloom_filter_full_true_positive, 1,
+                                  rep_->level);
+      }
+      if (s.ok()) {
+        s = iiter->status();
+      }
+    }
+  }
+
+  if (!rep_->filter_entry.IsSet()) {
+    filter_entry.Release(rep_->table_options.block_cache.get());
+  }
+}
+
 Status BlockBasedTable::Prefetch(const Slice* const begin,
                                  const Slice* const end) {
   auto& comparator = rep_->internal_comparator;
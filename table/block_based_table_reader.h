@@ -124,6 +124,21 @@ class BlockBasedTable : public TableReader {
              GetContext* get_context, const SliceTransform* prefix_extractor,
              bool skip_filters = false) override;
 
+  // Probes the full filter for all keys first, then walks the index once in
+  // key order, reading each data block only once for all the keys it holds.
+  void MultiGet(const ReadOptions& readOptions, size_t num_keys,
+                const Slice* keys, GetContext** get_contexts, Status* statuses,
+                const SliceTransform* prefix_extractor,
+                bool skip_filters = false) override;
+
+  Status GetFromHandle(const ReadOptions& readOptions, const Slice& key,
+                       uint64_t offset, uint64_t size,
+                       GetContext* get_context) override;
+
+  // Readahead the data block addressed by (offset, size), only effective
+  // with buffered reads
+  void PrefetchFromHandle(uint64_t offset, uint64_t size) override;
+
   // Pre-fetch the disk blocks that correspond to the key range specified by
   // (kbegin, kend). The call will return error status in the event of
   // IO or iteration error.
@@ -252,6 +267,11 @@ class BlockBasedTable : public TableReader {
   friend class MockedBlockBasedTable;
   static std::atomic<uint64_t> next_cache_key_id_;
 
+  // Feeds the entries of biter to get_context until it is done, returns true
+  // if it is
+  bool SaveDataBlockValues(DataBlockIter* biter, GetContext* get_context,
+                           bool* matched, Status* s) const;
+
   // If block cache enabled (compressed or uncompressed), looks for the block
   // identified by handle in (1) uncompressed cache, (2) compressed cache, and
   // then (3) file. If found, inserts into the cache(s) that were searched
@@ -356,6 +376,13 @@ class BlockBasedTable : public TableReader {
       const Slice& user_key, const bool no_io,
       const SliceTransform* prefix_extractor = nullptr) const;
 
+  // Batched FullFilterKeyMayMatch(), keys are InternalKeys
+  void FullFilterKeysMayMatch(const ReadOptions& read_options,
+                              FilterBlockReader* filter, size_t num_keys,
+                              const Slice* keys, const bool no_io,
+                              const SliceTransform* prefix_extractor,
+                              bool* may_match) const;
+
   // Read the meta block from sst.
   static Status ReadMetaBlock(
       Rep* rep, FilePrefetchBuffer* prefetch_buffer,
@@ -145,6 +145,71 @@ TEST_F(BlockBasedTableBuilderTest, FunctionTest) {
   delete options.env;
 }
 
+TEST_F(BlockBasedTableBuilderTest, ExpireTimeRange) {
+  BlockBasedTableOptions blockbasedtableoptions;
+  BlockBasedTableFactory factory(blockbasedtableoptions);
+  Options options;
+  options.ttl_extractor_factory.reset(
+      new test::TestTtlExtractorFactory(options.env));
+  const ImmutableCFOptions ioptions(options);
+  const MutableCFOptions moptions(options);
+  InternalKeyComparator ikc(options.comparator);
+  std::vector<std::unique_ptr<IntTblPropCollectorFactory>>
+      int_tbl_prop_collector_factories;
+  int_tbl_prop_collector_factories.emplace_back(
+      NewTtlExpireIntTblPropCollectorFactory(
+          options.ttl_extractor_factory.get()));
+  std::string column_family_name;
+  int unknown_level = -1;
+
+  auto build = [&](bool with_delete, uint64_t* earliest, uint64_t* latest) {
+    std::unique_ptr<WritableFileWriter> file_writer(test::GetWritableFileWriter(
+        new test::StringSink(), "" /* don't care */));
+    std::unique_ptr<TableBuilder> builder(factory.NewTableBuilder(
+        TableBuilderOptions(ioptions, moptions, ikc,
+                            &int_tbl_prop_collector_factories, kNoCompression,
+                            CompressionOptions(), nullptr /* compression_dict */,
+                            false /* skip_filters */, column_family_name,
+                            unknown_level, 0 /* compaction_load */),
+        TablePropertiesCollectorFactory::Context::kUnknownColumnFamily,
+        file_writer.get()));
+    for (char c = 'a'; c <= 'z'; ++c) {
+      std::string key(8, c);
+      key.push_back(with_delete && c == 'z' ? kTypeDeletion : kTypeValue);
+      key.append(7, ' ');
+      std::string value(28, c + 42);
+      char ts_string[sizeof(uint64_t)];
+      EncodeFixed64(ts_string, 1000 + (c - 'a') * 7 % 26);
+      value.append(ts_string, sizeof(uint64_t));
+      ASSERT_OK(builder->Add(key, LazyBuffer(value)));
+    }
+    ASSERT_OK(builder->Finish(nullptr, nullptr));
+    file_writer->Flush();
+
+    test::StringSink* ss =
+        static_cast<test::StringSink*>(file_writer->writable_file());
+    std::unique_ptr<RandomAccessFileReader> file_reader(
+        test::GetRandomAccessFileReader(
+            new test::StringSource(ss->contents(), 72242, true)));
+    TableProperties* props = nullptr;
+    ASSERT_OK(ReadTableProperties(file_reader.get(), ss->contents().size(),
+                                  kBlockBasedTableMagicNumber, ioptions,
+                                  &props, true /* compression_type_missing */));
+    std::unique_ptr<TableProperties> props_guard(props);
+    GetExpireTimeRange(props->user_collected_properties, earliest, latest);
+  };
+
+  uint64_t earliest, latest;
+  build(false /* with_delete */, &earliest, &latest);
+  ASSERT_EQ(1000u, earliest);
+  ASSERT_EQ(1025u, latest);
+
+  // A deletion never expires
+  build(true /* with_delete */, &earliest, &latest);
+  ASSERT_EQ(1000u, earliest);
+  ASSERT_EQ(port::kMaxUint64, latest);
+}
+
 TEST_P(BlockBasedTableBuilderTest, BoundaryTest) {
   BlockBasedTableOptions blockbasedtableoptions;
   BlockBasedTableFactory factory(blockbasedtableoptions);
@@ -102,6 +102,22 @@ class FilterBlockReader {
                            const bool no_io = false,
                            const Slice* const const_ikey_ptr = nullptr) = 0;
 
+  /**
+   * Batched KeyMayMatch() without block_offset, may_match[i] receives the
+   * result for keys[i]. const_ikeys, if not nullptr, holds the InternalKey
+   * of each entry of keys.
+   */
+  virtual void KeysMayMatch(size_t num_keys, const Slice* keys,
+                            const SliceTransform* prefix_extractor,
+                            const bool no_io, const Slice* const_ikeys,
+                            bool* may_match) {
+    for (size_t i = 0; i < num_keys; ++i) {
+      may_match[i] =
+          KeyMayMatch(keys[i], prefix_extractor, kNotValid, no_io,
+                      const_ikeys == nullptr ? nullptr : &const_ikeys[i]);
+    }
+  }
+
   /**
    * no_io and const_ikey_ptr here means the same as in KeyMayMatch
    */
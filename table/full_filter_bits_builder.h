@@ -19,6 +19,15 @@ namespace TERARKDB_NAMESPACE {
 
 class Slice;
 
+// Full filters of the built-in policies other than the legacy bloom filter
+// keep its 5 bytes of metadata, with 0 as num_probes followed by one of
+// these. Legacy readers regard num_probes 0 as a broken filter, which always
+// matches.
+enum FullFilterFormat : char {
+  kBlockedBloomFilterFormat = 1,
+  kRibbonFilterFormat = 2,
+};
+
 class FullFilterBitsBuilder : public FilterBitsBuilder {
  public:
   explicit FullFilterBitsBuilder(const size_t bits_per_key,
@@ -5,6 +5,8 @@
 
 #include "table/full_filter_block.h"
 
+#include <algorithm>
+
 #ifdef ROCKSDB_MALLOC_USABLE_SIZE
 #ifdef OS_FREEBSD
 #include <malloc_np.h>
@@ -136,6 +138,21 @@ bool FullFilterBlockReader::KeyMayMatch(
   return MayMatch(key);
 }
 
+void FullFilterBlockReader::KeysMayMatch(
+    size_t num_keys, const Slice* keys,
+    const SliceTransform* /*prefix_extractor*/, const bool /*no_io*/,
+    const Slice* /*const_ikeys*/, bool* may_match) {
+  if (!whole_key_filtering_ || contents_.size() == 0) {
+    std::fill(may_match, may_match + num_keys, true);
+    return;
+  }
+  filter_bits_reader_->KeysMayMatch(static_cast<int>(num_keys), keys,
+                                    may_match);
+  size_t hit = std::count(may_match, may_match + num_keys, true);
+  PERF_COUNTER_ADD(bloom_sst_hit_count, hit);
+  PERF_COUNTER_ADD(bloom_sst_miss_count, num_keys - hit);
+}
+
 bool FullFilterBlockReader::PrefixMayMatch(
     const Slice& prefix, const SliceTransform* /* prefix_extractor */,
     uint64_t block_offset, const bool /*no_io*/,
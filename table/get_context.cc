@@ -57,7 +57,8 @@ GetContext::GetContext(const Comparator* ucmp,
       min_seq_type_(0),
       callback_(callback),
       is_index_(false),
-      is_finished_(false) {
+      is_finished_(false),
+      defer_separated_fetch_(false) {
   if (seq_) {
     *seq_ = kMaxSequenceNumber;
   }
@@ -218,7 +219,11 @@ bool GetContext::SaveValue(const ParsedInternalKey& parsed_key,
         if (kNotFound == state_) {
           state_ = kFound;
           if (LIKELY(lazy_val_ != nullptr)) {
-            OK(std::move(value).dump(*lazy_val_));
+            if (type == kTypeValueIndex && defer_separated_fetch_) {
+              *lazy_val_ = std::move(value);
+            } else {
+              OK(std::move(value).dump(*lazy_val_));
+            }
           }
         } else if (kMerge == state_) {
           assert(merge_operator_ != nullptr);
@@ -58,6 +58,10 @@ class GetContext {
 
   void MarkKeyMayExist();
 
+  // Leave a found separated value combined but unfetched in *value, the
+  // caller is responsible for fetching it. See Version::MultiGet()
+  void DeferSeparatedFetch() { defer_separated_fetch_ = true; }
+
   // Records this key, value, and any meta-data (such as sequence number and
   // state) into this GetContext.
   //
@@ -125,6 +129,7 @@ class GetContext {
   bool sample_;
   bool is_index_;
   bool is_finished_;
+  bool defer_separated_fetch_;
 };
 
 }  // namespace TERARKDB_NAMESPACE
@@ -124,10 +124,15 @@ LazyBuffer CombinedInternalIterator::value() const {
 }
 
 LazyBuffer CombinedInternalIterator::value(const Slice& user_key,
-                                           std::string* meta) const {
+                                           std::string* meta,
+                                           uint64_t* handle_offset,
+                                           uint64_t* handle_size) const {
   if (meta != nullptr) {
     meta->clear();
   }
+  if (handle_size != nullptr) {
+    *handle_size = 0;
+  }
   if (separate_helper_ == nullptr) {
     return iter_->value();
   }
@@ -145,6 +150,16 @@ LazyBuffer CombinedInternalIterator::value(const Slice& user_key,
     auto meta_slice = SeparateHelper::DecodeValueMeta(value_index.slice());
     meta->assign(meta_slice.data(), meta_slice.size());
   }
+  // The handle is only valid while the value is read from the blob file it
+  // was written to, not from the output of a GC of that file
+  uint64_t offset, size;
+  if (handle_size != nullptr && value_index.valid() &&
+      SeparateHelper::DecodeFileNumber(value_index.slice()) ==
+          v.file_number() &&
+      SeparateHelper::DecodeValueHandle(value_index.slice(), &offset, &size)) {
+    *handle_offset = offset;
+    *handle_size = size;
+  }
   return v;
 }
 
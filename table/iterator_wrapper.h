@@ -130,7 +130,11 @@ class CombinedInternalIterator : public InternalIterator {
   bool Valid() const override { return iter_->Valid(); }
   Slice key() const override { return iter_->key(); }
   LazyBuffer value() const override;
-  LazyBuffer value(const Slice& user_key, std::string* meta) const;
+  // Also returns the value meta and the handle of the value in its blob
+  // file of a value index, *handle_size is 0 if the value has no handle
+  LazyBuffer value(const Slice& user_key, std::string* meta,
+                   uint64_t* handle_offset = nullptr,
+                   uint64_t* handle_size = nullptr) const;
   Status status() const override { return iter_->status(); }
   void Next() override { iter_->Next(); }
   void Prev() override { iter_->Prev(); }
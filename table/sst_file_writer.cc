@@ -8,12 +8,15 @@
 #include <vector>
 
 #include "db/dbformat.h"
+#include "db/version_edit.h"
 #include "rocksdb/table.h"
 #include "rocksdb/terark_namespace.h"
+#include "rocksdb/value_extractor.h"
 #include "table/block_based_table_builder.h"
 #include "table/sst_file_writer_collectors.h"
 #include "util/file_reader_writer.h"
 #include "util/sync_point.h"
+#include "util/xxhash.h"
 
 namespace TERARKDB_NAMESPACE {
 
@@ -26,6 +29,11 @@ const std::string ExternalSstFilePropertyNames::kGlobalSeqno =
 
 const size_t kFadviseTrigger = 1024 * 1024;  // 1MB
 
+// The key sst refers to its blob sst by a random number of this range, which
+// is inherited by the blob sst at ingestion like a blob rewritten by GC. It
+// never collides with the file numbers of a DB.
+const uint64_t kExternalBlobNumberFlag = 1ULL << 62;
+
 struct SstFileWriter::Rep {
   Rep(const EnvOptions& _env_options, const Options& options,
       Env::IOPriority _io_priority, const Comparator* _user_comparator,
@@ -38,10 +46,16 @@ struct SstFileWriter::Rep {
         cfh(_cfh),
         invalidate_page_cache(_invalidate_page_cache),
         last_fadvise_size(0),
-        skip_filters(_skip_filters) {}
+        skip_filters(_skip_filters),
+        blob_config(mutable_cf_options.get_blob_config()),
+        blob_number(0) {}
 
   std::unique_ptr<WritableFileWriter> file_writer;
   std::unique_ptr<TableBuilder> builder;
+  // Large values are separated into the blob sst if opened with a blob path
+  std::unique_ptr<WritableFileWriter> blob_file_writer;
+  std::unique_ptr<TableBuilder> blob_builder;
+  std::unique_ptr<ValueExtractor> value_meta_extractor;
   EnvOptions env_options;
   ImmutableCFOptions ioptions;
   MutableCFOptions mutable_cf_options;
@@ -58,6 +72,74 @@ struct SstFileWriter::Rep {
   // cached pages from page cache.
   uint64_t last_fadvise_size;
   bool skip_filters;
+  BlobConfig blob_config;
+  uint64_t blob_number;
+
+  Status NewBuilder(const std::string& file_path, bool is_blob,
+                    CompressionType compression_type,
+                    const CompressionOptions& compression_opts,
+                    std::unique_ptr<WritableFileWriter>* _file_writer,
+                    std::unique_ptr<TableBuilder>* _builder) {
+    std::unique_ptr<WritableFile> sst_file;
+    Status s = ioptions.env->NewWritableFile(file_path, &sst_file, env_options);
+    if (!s.ok()) {
+      return s;
+    }
+
+    sst_file->SetIOPriority(io_priority);
+
+    std::vector<std::unique_ptr<IntTblPropCollectorFactory>>
+        int_tbl_prop_collector_factories;
+
+    // SstFileWriter properties collector to add SstFileWriter version.
+    int_tbl_prop_collector_factories.emplace_back(
+        new SstFileWriterPropertiesCollectorFactory(2 /* version */,
+                                                    0 /* global_seqno*/));
+
+    // User collector factories
+    auto user_collector_factories =
+        ioptions.table_properties_collector_factories;
+    for (size_t i = 0; i < user_collector_factories.size(); i++) {
+      int_tbl_prop_collector_factories.emplace_back(
+          new UserKeyTablePropertiesCollectorFactory(
+              user_collector_factories[i]));
+    }
+    int unknown_level = -1;
+    uint32_t cf_id;
+
+    if (cfh != nullptr) {
+      // user explicitly specified that this file will be ingested into cfh,
+      // we can persist this information in the file.
+      cf_id = cfh->GetID();
+      column_family_name = cfh->GetName();
+    } else {
+      column_family_name = "";
+      cf_id = TablePropertiesCollectorFactory::Context::kUnknownColumnFamily;
+    }
+
+    TableBuilderOptions table_builder_options(
+        ioptions, mutable_cf_options, internal_comparator,
+        &int_tbl_prop_collector_factories, compression_type, compression_opts,
+        nullptr /* compression_dict */, is_blob || skip_filters,
+        column_family_name, unknown_level, 0);
+    _file_writer->reset(new WritableFileWriter(std::move(sst_file), file_path,
+                                               env_options, nullptr /* stats */,
+                                               ioptions.listeners));
+
+    // TODO(tec) : If table_factory is using compressed block cache, we will
+    // be adding the external sst file blocks into it, which is wasteful.
+    _builder->reset(ioptions.table_factory->NewTableBuilder(
+        table_builder_options, cf_id, _file_writer->get()));
+    return s;
+  }
+
+  // Same rule as the separation of flush and compaction
+  bool NeedSeparate(const Slice& user_key, const Slice& value) const {
+    return blob_builder != nullptr && value.size() >= blob_config.blob_size &&
+           (uint64_t(user_key.size()) << 16) <=
+               value.size() * uint64_t(blob_config.large_key_ratio * 65536);
+  }
+
   Status Add(const Slice& user_key, const Slice& value,
              const ValueType value_type) {
     if (!builder) {
@@ -91,7 +173,26 @@ struct SstFileWriter::Rep {
       default:
         return Status::InvalidArgument("Value type is not supported");
     }
-    builder->Add(ikey.Encode(), LazyBuffer(value));
+    LazyBuffer lazy_value(value);
+    if (value_type != ValueType::kTypeDeletion &&
+        NeedSeparate(user_key, value)) {
+      Status s = blob_builder->Add(ikey.Encode(), lazy_value);
+      if (s.ok()) {
+        s = SeparateHelper::TransToSeparate(
+            ikey.Encode(), lazy_value, blob_number, Slice(),
+            value_type == ValueType::kTypeMerge, false /* is_index */,
+            value_meta_extractor.get());
+      }
+      if (!s.ok()) {
+        return s;
+      }
+      ikey.Set(user_key, 0 /* Sequence Number */,
+               value_type == ValueType::kTypeValue ? kTypeValueIndex
+                                                   : kTypeMergeIndex);
+      file_info.blob_num_entries++;
+      file_info.blob_file_size = blob_builder->FileSize();
+    }
+    builder->Add(ikey.Encode(), lazy_value);
 
     // update file info
     file_info.num_entries++;
@@ -154,6 +255,35 @@ struct SstFileWriter::Rep {
       last_fadvise_size = builder->FileSize();
     }
   }
+
+  Status FinishBlob(TablePropertyCache* prop) {
+    Status s;
+    if (file_info.blob_num_entries == 0) {
+      // No value is large enough, the key sst is self contained
+      blob_builder->Abandon();
+      blob_builder.reset();
+      blob_file_writer.reset();
+      s = ioptions.env->DeleteFile(file_info.blob_file_path);
+      file_info.blob_file_path.clear();
+      return s;
+    }
+    std::vector<uint64_t> inheritance_tree = {blob_number, blob_number};
+    s = blob_builder->Finish(nullptr, nullptr, &inheritance_tree);
+    file_info.blob_file_size = blob_builder->FileSize();
+    if (s.ok()) {
+      s = blob_file_writer->Sync(ioptions.use_fsync);
+      if (invalidate_page_cache) {
+        blob_file_writer->InvalidateCache(0, 0);
+      }
+      if (s.ok()) {
+        s = blob_file_writer->Close();
+      }
+    }
+    blob_builder.reset();
+    prop->dependence.emplace_back(
+        Dependence{blob_number, file_info.blob_num_entries});
+    return s;
+  }
 };
 
 SstFileWriter::SstFileWriter(const EnvOptions& env_options,
@@ -173,18 +303,27 @@ SstFileWriter::~SstFileWriter() {
     // abandon the builder.
     rep_->builder->Abandon();
   }
+  if (rep_->blob_builder) {
+    rep_->blob_builder->Abandon();
+  }
 }
 
 Status SstFileWriter::Open(const std::string& file_path) {
+  return Open(file_path, std::string());
+}
+
+Status SstFileWriter::Open(const std::string& file_path,
+                           const std::string& blob_file_path) {
   Rep* r = rep_.get();
   Status s;
-  std::unique_ptr<WritableFile> sst_file;
-  s = r->ioptions.env->NewWritableFile(file_path, &sst_file, r->env_options);
-  if (!s.ok()) {
-    return s;
-  }
 
-  sst_file->SetIOPriority(r->io_priority);
+  // Tables which build in two passes can't separate values on the fly
+  if (!blob_file_path.empty() &&
+      r->ioptions.table_factory->IsBuilderNeedSecondPass()) {
+    return Status::NotSupported(
+        "Table factory doesn't support value separation by SstFileWriter",
+        r->ioptions.table_factory->Name());
+  }
 
   CompressionType compression_type;
   CompressionOptions compression_opts;
@@ -204,52 +343,40 @@ Status SstFileWriter::Open(const std::string& file_path) {
     compression_opts = r->ioptions.compression_opts;
   }
 
-  std::vector<std::unique_ptr<IntTblPropCollectorFactory>>
-      int_tbl_prop_collector_factories;
-
-  // SstFileWriter properties collector to add SstFileWriter version.
-  int_tbl_prop_collector_factories.emplace_back(
-      new SstFileWriterPropertiesCollectorFactory(2 /* version */,
-                                                  0 /* global_seqno*/));
-
-  // User collector factories
-  auto user_collector_factories =
-      r->ioptions.table_properties_collector_factories;
-  for (size_t i = 0; i < user_collector_factories.size(); i++) {
-    int_tbl_prop_collector_factories.emplace_back(
-        new UserKeyTablePropertiesCollectorFactory(
-            user_collector_factories[i]));
-  }
-  int unknown_level = -1;
-  uint32_t cf_id;
-
-  if (r->cfh != nullptr) {
-    // user explicitly specified that this file will be ingested into cfh,
-    // we can persist this information in the file.
-    cf_id = r->cfh->GetID();
-    r->column_family_name = r->cfh->GetName();
-  } else {
-    r->column_family_name = "";
-    cf_id = TablePropertiesCollectorFactory::Context::kUnknownColumnFamily;
+  s = r->NewBuilder(file_path, false /* is_blob */, compression_type,
+                    compression_opts, &r->file_writer, &r->builder);
+  if (!s.ok()) {
+    return s;
   }
-
-  TableBuilderOptions table_builder_options(
-      r->ioptions, r->mutable_cf_options, r->internal_comparator,
-      &int_tbl_prop_collector_factories, compression_type, compression_opts,
-      nullptr /* compression_dict */, r->skip_filters, r->column_family_name,
-      unknown_level, 0);
-  r->file_writer.reset(
-      new WritableFileWriter(std::move(sst_file), file_path, r->env_options,
-                             nullptr /* stats */, r->ioptions.listeners));
-
-  // TODO(tec) : If table_factory is using compressed block cache, we will
-  // be adding the external sst file blocks into it, which is wasteful.
-  r->builder.reset(r->ioptions.table_factory->NewTableBuilder(
-      table_builder_options, cf_id, r->file_writer.get()));
-
   r->file_info = ExternalSstFileInfo();
   r->file_info.file_path = file_path;
   r->file_info.version = 2;
+
+  if (!blob_file_path.empty()) {
+    s = r->NewBuilder(blob_file_path, true /* is_blob */, compression_type,
+                      compression_opts, &r->blob_file_writer,
+                      &r->blob_builder);
+    if (!s.ok()) {
+      r->builder->Abandon();
+      r->builder.reset();
+      return s;
+    }
+    std::string unique_id = r->ioptions.env->GenerateUniqueId() + file_path;
+    uint64_t hash = XXH64(unique_id.data(), unique_id.size(),
+                          r->ioptions.env->NowMicros());
+    r->blob_number =
+        kExternalBlobNumberFlag | (hash & (kExternalBlobNumberFlag - 1));
+    if (r->ioptions.value_meta_extractor_factory != nullptr) {
+      ValueExtractorContext context = {
+          r->cfh != nullptr
+              ? r->cfh->GetID()
+              : TablePropertiesCollectorFactory::Context::kUnknownColumnFamily};
+      r->value_meta_extractor =
+          r->ioptions.value_meta_extractor_factory->CreateValueExtractor(
+              context);
+    }
+    r->file_info.blob_file_path = blob_file_path;
+  }
   return s;
 }
 
@@ -284,7 +411,18 @@ Status SstFileWriter::Finish(ExternalSstFileInfo* file_info) {
     return Status::InvalidArgument("Cannot create sst file with no entries");
   }
 
-  Status s = r->builder->Finish(nullptr, nullptr);
+  Status s;
+  TablePropertyCache prop;
+  bool has_blob = r->blob_builder != nullptr;
+  if (has_blob) {
+    s = r->FinishBlob(&prop);
+    has_blob = !r->file_info.blob_file_path.empty();
+  }
+  if (s.ok()) {
+    s = r->builder->Finish(has_blob ? &prop : nullptr, nullptr);
+  } else {
+    r->builder->Abandon();
+  }
   r->file_info.file_size = r->builder->FileSize();
 
   if (s.ok()) {
@@ -296,6 +434,9 @@ Status SstFileWriter::Finish(ExternalSstFileInfo* file_info) {
   }
   if (!s.ok()) {
     r->ioptions.env->DeleteFile(r->file_info.file_path);
+    if (has_blob) {
+      r->ioptions.env->DeleteFile(r->file_info.blob_file_path);
+    }
   }
 
   if (file_info != nullptr) {
@@ -235,6 +235,10 @@ const std::string TablePropertiesNames::kEarliestTimeBeginCompact =
     "rocksdb.compact.earliest-time-begin";
 const std::string TablePropertiesNames::kLatestTimeEndCompact =
     "rocksdb.compact.latest-time-end";
+const std::string TablePropertiesNames::kEarliestExpireTime =
+    "rocksdb.ttl.earliest-expire-time";
+const std::string TablePropertiesNames::kLatestExpireTime =
+    "rocksdb.ttl.latest-expire-time";
 
 extern const std::string kPropertiesBlock = "rocksdb.properties";
 // Old property block name for backward compatibility
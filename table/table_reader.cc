@@ -30,6 +30,17 @@ void TableReader::RangeScan(const Slice* begin,
   }
 }
 
+void TableReader::MultiGet(const ReadOptions& readOptions, size_t num_keys,
+                           const Slice* keys, GetContext** get_contexts,
+                           Status* statuses,
+                           const SliceTransform* prefix_extractor,
+                           bool skip_filters) {
+  for (size_t i = 0; i < num_keys; ++i) {
+    statuses[i] = Get(readOptions, keys[i], get_contexts[i], prefix_extractor,
+                      skip_filters);
+  }
+}
+
 void TableReader::UpdateMaxCoveringTombstoneSeq(
     const TERARKDB_NAMESPACE::ReadOptions& readOptions,
     const TERARKDB_NAMESPACE::Slice& user_key,
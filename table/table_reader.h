@@ -92,6 +92,31 @@ class TableReader {
                      const SliceTransform* prefix_extractor,
                      bool skip_filters = false) = 0;
 
+  // Batched Get(), statuses[i] receives the result of looking up keys[i]
+  // into get_contexts[i]. keys must be sorted by the internal key comparator.
+  // The default implementation calls Get() for each key.
+  virtual void MultiGet(const ReadOptions& readOptions, size_t num_keys,
+                        const Slice* keys, GetContext** get_contexts,
+                        Status* statuses,
+                        const SliceTransform* prefix_extractor,
+                        bool skip_filters = false);
+
+  // Same as Get(), but only search the data addressed by (offset, size),
+  // which was reported by TableBuilder::AddWithHandle(). Index and filters
+  // are bypassed. Returns NotSupported if the table format doesn't support
+  // value handles.
+  virtual Status GetFromHandle(const ReadOptions& /*readOptions*/,
+                               const Slice& /*key*/, uint64_t /*offset*/,
+                               uint64_t /*size*/,
+                               GetContext* /*get_context*/) {
+    return Status::NotSupported("GetFromHandle() not supported");
+  }
+
+  // Hint that the data addressed by (offset, size), which was reported by
+  // TableBuilder::AddWithHandle(), will be read soon. Default implementation
+  // is NOOP.
+  virtual void PrefetchFromHandle(uint64_t /*offset*/, uint64_t /*size*/) {}
+
   // Logic same as for(it->Seek(begin); it->Valid() && callback(*it); ++it) {}
   // Specialization for performance
   virtual void RangeScan(const Slice* begin,
@@ -27,6 +27,7 @@
 #include "util/async_task.h"
 #include "util/c_style_callback.h"
 #include "util/string_util.h"
+#include "util/sync_point.h"
 #include "util/xxhash.h"
 
 namespace TERARKDB_NAMESPACE {
@@ -180,6 +181,7 @@ TerarkZipTableBuilder::TerarkZipTableBuilder(
     singleIndexMaxSize_ = std::min(table_options_.softZipWorkingMemLimit,
                                    table_options_.singleIndexMaxSize);
     level_ = tbo.level;
+    isFlush_ = tbo.reason == TableFileCreationReason::kFlush;
     if (tbo.compaction_load > 0) {
       double load =
           tbo.compaction_load * tbo.ioptions.num_levels -
@@ -513,10 +515,14 @@ Status TerarkZipTableBuilder::Add(const Slice& key,
     tmpSampleFile_.writer << fstringOf(value);
     sampleLenSum_ += value.size();
   }
+  // Memtable values are in memory already, copying them to the temp value
+  // file only costs flush latency
   if (filePair_->isFullValue && second_pass_iter_ &&
-      table_options_.debugLevel != 2 && valueDataSize_ > (1ull << 20) &&
-      valueDataSize_ > keyDataSize_ * 2) {
+      table_options_.debugLevel != 2 &&
+      (isFlush_ ||
+       (valueDataSize_ > (1ull << 20) && valueDataSize_ > keyDataSize_ * 2))) {
     filePair_->isFullValue = false;
+    TEST_SYNC_POINT("TerarkZipTableBuilder::Add:SecondPassValues");
   }
   assert(filePair_->value.fp);
   filePair_->value.writer << seqType
@@ -261,6 +261,9 @@ class TerarkZipTableBuilder : public TableBuilder, boost::noncopyable {
   bool waitInited_ = false;
   bool closed_ = false;  // Either Finish() or Abandon() has been called.
   bool isReverseBytewiseOrder_;
+  // Building from a memtable, values are re-read by second_pass_iter_
+  // instead of being copied to the temp value file
+  bool isFlush_;
   int level_;
 
   long long t0 = 0;
@@ -564,6 +564,43 @@ class TerarkZipReaderTest : public DBTestBase {
   }
 };
 
+TEST_F(TerarkZipReaderTest, FlushReadsValuesFromMemtable) {
+  Options options = CurrentOptions();
+  TerarkZipTableOptions tzto;
+  tzto.disableSecondPassIter = false;
+  tzto.localTempDir = dbname_;
+  options.allow_mmap_reads = true;
+  options.disable_auto_compactions = true;
+  options.table_factory.reset(NewTerarkZipTableFactory(tzto, nullptr));
+  DestroyAndReopen(options);
+
+  int second_pass_builds = 0;
+  SyncPoint::GetInstance()->SetCallBack(
+      "TerarkZipTableBuilder::Add:SecondPassValues",
+      [&](void* /*arg*/) { ++second_pass_builds; });
+  SyncPoint::GetInstance()->EnableProcessing();
+
+  // Every flush reads its values back from the memtable instead of copying
+  // them to the temp value file
+  for (size_t i = 0; i < 100; ++i) {
+    ASSERT_OK(Put(get_key(i), get_value(i)));
+  }
+  ASSERT_OK(Flush());
+  ASSERT_EQ(second_pass_builds, 1);
+  ASSERT_OK(Put(get_key(100), get_value(100)));
+  ASSERT_OK(Flush());
+  ASSERT_EQ(second_pass_builds, 2);
+  // Small values of a compaction are copied to the temp value file
+  ASSERT_OK(db_->CompactRange(CompactRangeOptions(), nullptr, nullptr));
+  ASSERT_EQ(second_pass_builds, 2);
+
+  SyncPoint::GetInstance()->DisableProcessing();
+  SyncPoint::GetInstance()->ClearAllCallBacks();
+  for (size_t i = 0; i <= 100; ++i) {
+    ASSERT_EQ(Get(get_key(i)), get_value(i));
+  }
+}
+
 TEST_F(TerarkZipReaderTest, BasicTest) { BasicTest(false, 1000, 0, 0, 0); }
 TEST_F(TerarkZipReaderTest, BasicTestRev) { BasicTest(true, 1000, 0, 0, 0); }
 TEST_F(TerarkZipReaderTest, BasicTestMulti) { BasicTest(false, 1000, 1, 0, 0); }
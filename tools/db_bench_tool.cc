@@ -26,6 +26,7 @@
 #include <sys/types.h>
 
 #include <atomic>
+#include <cmath>
 #include <condition_variable>
 #include <cstddef>
 #include <memory>
@@ -127,6 +128,7 @@ DEFINE_string(
     "acquireload,"
     "fillseekseq,"
     "randomtransaction,"
+    "zipftransaction,"
     "randomreplacekeys,"
     "timeseries",
 
@@ -181,11 +183,16 @@ DEFINE_string(
     "merge\n"
     "\tcrc32c        -- repeated crc32c of 4K of data\n"
     "\txxhash        -- repeated xxHash of 4K of data\n"
+    "\tfilterbench   -- build a full filter of N keys with --bloom_bits "
+    "and --filter_type, then query it --reads times, half of them for "
+    "added keys, --batch_size at once\n"
     "\tacquireload   -- load N*1000 times\n"
     "\tfillseekseq   -- write N values in sequential key, then read "
     "them by seeking to each key\n"
     "\trandomtransaction     -- execute N random transactions and "
     "verify correctness\n"
+    "\tzipftransaction       -- execute N transactions locking "
+    "--transaction_sets keys of a Zipfian distribution each\n"
     "\trandomreplacekeys     -- randomly replaces N keys by deleting "
     "the old version and putting the new version\n\n"
     "\ttimeseries            -- 1 writer generates time series data "
@@ -677,6 +684,10 @@ DEFINE_bool(optimize_filters_for_hits, false,
             "a value. For now this doesn't create bloom filters for the max "
             "level of the LSM to reduce metadata that should fit in RAM. ");
 
+DEFINE_double(adaptive_filter_skip_hit_ratio, 0,
+              "Skip the filters of a level when at least this ratio of the "
+              "sampled Gets reaching it find their key there, 0 disables");
+
 DEFINE_bool(optimize_range_deletion, false,
             "Optimizes RangeDeletion when use lazy level compaction");
 
@@ -710,7 +721,8 @@ DEFINE_bool(transaction_db, false,
 
 DEFINE_uint64(transaction_sets, 2,
               "Number of keys each transaction will "
-              "modify (use in RandomTransaction only).  Max: 9999");
+              "modify (use in RandomTransaction and ZipfTransaction only).  "
+              "Max: 9999");
 
 DEFINE_bool(transaction_set_snapshot, false,
             "Setting to true will have each transaction call SetSnapshot()"
@@ -723,6 +735,10 @@ DEFINE_int32(transaction_sleep, 0,
 DEFINE_uint64(transaction_lock_timeout, 100,
               "If using a transaction_db, specifies the lock wait timeout in"
               " milliseconds before failing a transaction waiting on a lock");
+
+DEFINE_double(transaction_zipf_theta, 0.99,
+              "Skew of the keys of ZipfTransaction, in (0, 1). Higher values "
+              "make the hot keys hotter");
 DEFINE_string(
     options_file, "",
     "The path to a RocksDB options file.  If specified, then db_bench will "
@@ -977,6 +993,9 @@ DEFINE_double(blob_large_key_ratio, 1, "Key Value Separate large key ratio");
 
 DEFINE_double(blob_gc_ratio, 0.2, "Blob SST gc ratio");
 
+DEFINE_bool(blob_offset_addressing, false,
+            "Address separated values by blob block handle");
+
 DEFINE_uint64(target_blob_file_size, 0, "Blob file size");
 
 DEFINE_uint64(blob_file_defragment_size, 0, "Blob file defragment threshold");
@@ -1008,6 +1027,13 @@ DEFINE_bool(
 DEFINE_bool(use_aio_reads, TERARKDB_NAMESPACE::Options().use_aio_reads,
             "Use aio_read+fiber for reading data");
 
+DEFINE_bool(use_io_uring_reads,
+            TERARKDB_NAMESPACE::Options().use_io_uring_reads,
+            "Read data through io_uring, batched across fibers");
+
+DEFINE_bool(io_uring_sqpoll, TERARKDB_NAMESPACE::Options().io_uring_sqpoll,
+            "Use a kernel submission polling thread for io_uring reads");
+
 DEFINE_bool(advise_random_on_open,
             TERARKDB_NAMESPACE::Options().advise_random_on_open,
             "Advise random access on table file open");
@@ -1160,6 +1186,34 @@ DEFINE_bool(use_block_based_filter, false,
             "if use kBlockBasedFilter "
             "instead of kFullFilter for filter block. "
             "This is valid if only we use BlockTable");
+DEFINE_string(filter_type, "bloom",
+              "Full filter built with --bloom_bits: bloom, blockedbloom or "
+              "ribbon. This is valid if only we use BlockTable");
+DEFINE_int32(ribbon_bloom_before_level, 0,
+             "With --filter_type=ribbon, levels below this one get bloom "
+             "filters, -1 for none");
+DEFINE_string(filter_bits_per_level, "",
+              "Comma separated bits per key of the filters of each level, "
+              "the last one for all the levels after it, 0 for no filter");
+
+static const TERARKDB_NAMESPACE::FilterPolicy* NewFilterPolicyFromFlags() {
+  if (FLAGS_bloom_bits < 0) {
+    return nullptr;
+  }
+  if (FLAGS_filter_type == "blockedbloom") {
+    return TERARKDB_NAMESPACE::NewBlockedBloomFilterPolicy(FLAGS_bloom_bits);
+  }
+  if (FLAGS_filter_type == "ribbon") {
+    return TERARKDB_NAMESPACE::NewRibbonFilterPolicy(
+        FLAGS_bloom_bits, FLAGS_ribbon_bloom_before_level);
+  }
+  if (FLAGS_filter_type != "bloom") {
+    fprintf(stderr, "Unknown filter_type %s\n", FLAGS_filter_type.c_str());
+    exit(1);
+  }
+  return TERARKDB_NAMESPACE::NewBloomFilterPolicy(FLAGS_bloom_bits,
+                                                  FLAGS_use_block_based_filter);
+}
 DEFINE_string(merge_operator, "",
               "The merge operator to use with the database."
               "If a new merge operator is specified, be sure to use fresh"
@@ -2053,6 +2107,46 @@ class Duration {
   uint64_t start_at_;
 };
 
+// Draws integers of [0, n) with a Zipfian distribution, 0 is the most
+// frequent. From Gray et al., "Quickly Generating Billion-Record Synthetic
+// Databases", like YCSB. Thread safe.
+class ZipfianGenerator {
+ public:
+  // REQUIRES: n > 1, 0 < theta < 1
+  ZipfianGenerator(uint64_t n, double theta)
+      : n_(n), theta_(theta), alpha_(1.0 / (1.0 - theta)), zetan_(Zeta(n)) {
+    eta_ = (1.0 - std::pow(2.0 / n, 1.0 - theta)) / (1.0 - Zeta(2) / zetan_);
+  }
+
+  uint64_t Next(Random64* rand) const {
+    double u = static_cast<double>(rand->Next() >> 11) / (1ULL << 53);
+    double uz = u * zetan_;
+    if (uz < 1.0) {
+      return 0;
+    }
+    if (uz < 1.0 + std::pow(0.5, theta_)) {
+      return 1;
+    }
+    return std::min(n_ - 1, static_cast<uint64_t>(
+                                n_ * std::pow(eta_ * u - eta_ + 1.0, alpha_)));
+  }
+
+ private:
+  double Zeta(uint64_t n) const {
+    double sum = 0;
+    for (uint64_t i = 1; i <= n; ++i) {
+      sum += 1.0 / std::pow(static_cast<double>(i), theta_);
+    }
+    return sum;
+  }
+
+  const uint64_t n_;
+  const double theta_;
+  const double alpha_;
+  const double zetan_;
+  double eta_;
+};
+
 class Benchmark {
  private:
   std::shared_ptr<Cache> cache_;
@@ -2061,6 +2155,8 @@ class Benchmark {
   const SliceTransform* prefix_extractor_;
   DBWithColumnFamilies db_;
   std::vector<DBWithColumnFamilies> multi_dbs_;
+  // Keys of ZipfTransaction
+  std::unique_ptr<ZipfianGenerator> zipf_;
   int64_t num_;
   int value_size_;
   int key_size_;
@@ -2390,10 +2486,7 @@ class Benchmark {
   Benchmark()
       : cache_(NewCache(FLAGS_cache_size)),
         compressed_cache_(NewCache(FLAGS_compressed_cache_size)),
-        filter_policy_(FLAGS_bloom_bits >= 0
-                           ? NewBloomFilterPolicy(FLAGS_bloom_bits,
-                                                  FLAGS_use_block_based_filter)
-                           : nullptr),
+        filter_policy_(NewFilterPolicyFromFlags()),
         prefix_extractor_(NewFixedPrefixTransform(FLAGS_prefix_size)),
         num_(FLAGS_num),
         value_size_(FLAGS_value_size),
@@ -2791,6 +2884,8 @@ class Benchmark {
         method = &Benchmark::Crc32c;
       } else if (name == "xxhash") {
         method = &Benchmark::xxHash;
+      } else if (name == "filterbench") {
+        method = &Benchmark::FilterBench;
       } else if (name == "acquireload") {
         method = &Benchmark::AcquireLoad;
       } else if (name == "compress") {
@@ -2801,6 +2896,18 @@ class Benchmark {
       } else if (name == "randomtransaction") {
         method = &Benchmark::RandomTransaction;
         post_process_method = &Benchmark::RandomTransactionVerify;
+      } else if (name == "zipftransaction") {
+        if (!FLAGS_transaction_db || FLAGS_num < 2 ||
+            !(FLAGS_transaction_zipf_theta > 0 &&
+              FLAGS_transaction_zipf_theta < 1)) {
+          fprintf(stderr,
+                  "zipftransaction needs --transaction_db, --num > 1 and "
+                  "0 < --transaction_zipf_theta < 1\n");
+          exit(1);
+        }
+        zipf_.reset(
+            new ZipfianGenerator(FLAGS_num, FLAGS_transaction_zipf_theta));
+        method = &Benchmark::ZipfTransaction;
 #endif  // ROCKSDB_LITE
       } else if (name == "randomreplacekeys") {
         fresh_db = true;
@@ -3094,6 +3201,77 @@ class Benchmark {
     thread->stats.AddMessage(label);
   }
 
+  void FilterBench(ThreadState* thread) {
+    std::unique_ptr<const FilterPolicy> policy(NewFilterPolicyFromFlags());
+    // As if for the bottommost level
+    FilterBuildingContext context;
+    context.level_at_creation = FLAGS_num_levels - 1;
+    std::unique_ptr<FilterBitsBuilder> builder(
+        policy == nullptr ? nullptr : policy->GetBuilderWithContext(context));
+    if (builder == nullptr) {
+      fprintf(stderr, "filterbench needs --bloom_bits and a full filter\n");
+      exit(1);
+    }
+
+    std::unique_ptr<const char[]> key_guard;
+    Slice key = AllocateKey(&key_guard);
+    uint64_t start = FLAGS_env->NowNanos();
+    for (int64_t i = 0; i < num_; ++i) {
+      GenerateKeyFromInt(i, num_, &key, thread->tid);
+      builder->AddKey(key);
+    }
+    std::unique_ptr<const char[]> filter_guard;
+    Slice filter = builder->Finish(&filter_guard);
+    double build_nanos = static_cast<double>(FLAGS_env->NowNanos() - start);
+    std::unique_ptr<FilterBitsReader> reader(
+        policy->GetFilterBitsReader(filter));
+
+    // Only the queries are timed
+    thread->stats.Start(thread->tid);
+    const int64_t batch = std::max<int64_t>(entries_per_batch_, 1);
+    std::vector<std::unique_ptr<const char[]>> key_guards(batch);
+    std::vector<Slice> keys(batch);
+    std::vector<uint64_t> key_ints(batch);
+    std::unique_ptr<bool[]> may_match(new bool[batch]);
+    for (int64_t i = 0; i < batch; ++i) {
+      keys[i] = AllocateKey(&key_guards[i]);
+    }
+    int64_t reads = 0;
+    int64_t negatives = 0;
+    int64_t false_positives = 0;
+    while (reads < reads_) {
+      int n = static_cast<int>(std::min(batch, reads_ - reads));
+      for (int i = 0; i < n; ++i) {
+        // Keys [num_, 2 * num_) are not in the filter
+        key_ints[i] = thread->rand.Next() % (num_ * 2);
+        GenerateKeyFromInt(key_ints[i], num_, &keys[i], thread->tid);
+      }
+      if (n == 1) {
+        may_match[0] = reader->MayMatch(keys[0]);
+      } else {
+        reader->KeysMayMatch(n, keys.data(), may_match.get());
+      }
+      for (int i = 0; i < n; ++i) {
+        if (key_ints[i] < static_cast<uint64_t>(num_)) {
+          assert(may_match[i]);
+        } else {
+          ++negatives;
+          false_positives += may_match[i] ? 1 : 0;
+        }
+      }
+      reads += n;
+      thread->stats.FinishedOps(nullptr, nullptr, n, kRead);
+    }
+
+    char msg[200];
+    snprintf(msg, sizeof(msg),
+             "(build %.1f ns/key, %.2f bits/key, %.3f%% false positives)",
+             build_nanos / std::max<int64_t>(num_, 1),
+             filter.size() * 8.0 / std::max<int64_t>(num_, 1),
+             false_positives * 100.0 / std::max<int64_t>(negatives, 1));
+    thread->stats.AddMessage(msg);
+  }
+
   void AcquireLoad(ThreadState* thread) {
     int dummy;
     std::atomic<void*> ap(&dummy);
@@ -3270,6 +3448,8 @@ class Benchmark {
     options.use_direct_io_for_flush_and_compaction =
         FLAGS_use_direct_io_for_flush_and_compaction;
     options.use_aio_reads = FLAGS_use_aio_reads;
+    options.use_io_uring_reads = FLAGS_use_io_uring_reads;
+    options.io_uring_sqpoll = FLAGS_io_uring_sqpoll;
     options.zenfs_low_gc_ratio = FLAGS_zenfs_low_gc_ratio;
     options.zenfs_high_gc_ratio = FLAGS_zenfs_high_gc_ratio;
     options.zenfs_force_gc_ratio = FLAGS_zenfs_force_gc_ratio;
@@ -3571,11 +3751,14 @@ class Benchmark {
     options.blob_size = FLAGS_blob_size;
     options.blob_large_key_ratio = FLAGS_blob_large_key_ratio;
     options.blob_gc_ratio = FLAGS_blob_gc_ratio;
+    options.blob_offset_addressing = FLAGS_blob_offset_addressing;
     options.target_blob_file_size = FLAGS_target_blob_file_size;
     options.blob_file_defragment_size = FLAGS_blob_file_defragment_size;
     options.max_dependence_blob_overlap = FLAGS_max_dependence_blob_overlap;
     options.maintainer_job_ratio = FLAGS_maintainer_job_ratio;
     options.optimize_filters_for_hits = FLAGS_optimize_filters_for_hits;
+    options.adaptive_filter_skip_hit_ratio =
+        FLAGS_adaptive_filter_skip_hit_ratio;
     options.optimize_range_deletion = FLAGS_optimize_range_deletion;
 
     // fill storage options
@@ -3661,8 +3844,10 @@ class Benchmark {
         table_options->block_cache = cache_;
       }
       if (FLAGS_bloom_bits >= 0) {
-        table_options->filter_policy.reset(NewBloomFilterPolicy(
-            FLAGS_bloom_bits, FLAGS_use_block_based_filter));
+        table_options->filter_policy.reset(NewFilterPolicyFromFlags());
+      }
+      for (auto& bits : StringSplit(FLAGS_filter_bits_per_level, ',')) {
+        table_options->filter_bits_per_level.push_back(std::stoi(bits));
       }
     }
     if (FLAGS_row_cache_size) {
@@ -5499,6 +5684,60 @@ class Benchmark {
     thread->stats.AddBytes(static_cast<int64_t>(inserter.GetBytesInserted()));
   }
 
+  // Each transaction locks FLAGS_transaction_sets keys of a Zipfian
+  // distribution with GetForUpdate and overwrites them, in random order, so
+  // the hot keys contend and transactions may deadlock. This measures how
+  // the lock manager scales with --threads. Transactions that fail to lock
+  // are rolled back and counted as aborts.
+  void ZipfTransaction(ThreadState* thread) {
+    TransactionDB* txn_db = reinterpret_cast<TransactionDB*>(db_.db);
+    ReadOptions read_options(FLAGS_verify_checksum, true);
+    TransactionOptions txn_options;
+    txn_options.lock_timeout = FLAGS_transaction_lock_timeout;
+    txn_options.deadlock_detect = true;
+    std::unique_ptr<const char[]> key_guard;
+    Slice key = AllocateKey(&key_guard);
+    std::string value;
+    RandomGenerator gen;
+    Duration duration(FLAGS_duration, readwrites_);
+    Transaction* txn = nullptr;
+    uint64_t transactions_done = 0;
+    uint64_t aborts = 0;
+    int64_t bytes = 0;
+
+    while (!duration.Done(1)) {
+      txn = txn_db->BeginTransaction(write_options_, txn_options, txn);
+      Status s;
+      for (uint64_t i = 0; s.ok() && i < FLAGS_transaction_sets; ++i) {
+        GenerateKeyFromInt(zipf_->Next(&thread->rand), FLAGS_num, &key, -1);
+        s = txn->GetForUpdate(read_options, key, &value);
+        if (s.ok() || s.IsNotFound()) {
+          s = txn->Put(key, gen.Generate(value_size_));
+          bytes += key.size() + value_size_;
+        }
+      }
+      if (s.ok()) {
+        s = txn->Commit();
+      }
+      if (s.IsBusy() || s.IsTimedOut()) {
+        txn->Rollback();
+        ++aborts;
+      } else if (!s.ok()) {
+        fprintf(stderr, "Unexpected error: %s\n", s.ToString().c_str());
+        abort();
+      }
+      thread->stats.FinishedOps(nullptr, db_.db, 1, kOthers);
+      transactions_done++;
+    }
+    delete txn;
+
+    char msg[100];
+    snprintf(msg, sizeof(msg), "( transactions:%" PRIu64 " aborts:%" PRIu64 ")",
+             transactions_done, aborts);
+    thread->stats.AddMessage(msg);
+    thread->stats.AddBytes(bytes);
+  }
+
   // Verifies consistency of data after RandomTransaction() has been run.
   // Since each iteration of RandomTransaction() incremented a key in each set
   // by the same value, the sum of the keys in each set should be the same.
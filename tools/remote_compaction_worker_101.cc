@@ -35,6 +35,12 @@ int main() {
   // worker.RegistTablePropertiesCollectorFactory(
   //    std::shared_ptr<TablePropertiesCollectorFactory>);
 
+  // started by NewWorkerPoolCompactionDispatcher, serve jobs until the
+  // dispatcher closes the socket
+  if (const char* fd = getenv("TerarkDB_compactionWorkerFd")) {
+    return worker.Serve(atoi(fd)).ok() ? 0 : 1;
+  }
+
   terark::LineBuf buf;
   buf.read_all(stdin);
   std::cout << worker.DoCompaction(TERARKDB_NAMESPACE::Slice(buf.p, buf.n));
@@ -45,3 +51,5 @@ int main() {
 // ----------------------------------------------
 // env TerarkZipTable_localTempDir=/tmp remote_compaction_worker_101
 // ----------------------------------------------
+// with TerarkDB_compactionWorkerPoolSize=N set in the db process, N workers
+// are kept running and each one serves many jobs
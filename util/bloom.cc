@@ -7,6 +7,12 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file. See the AUTHORS file for names of contributors.
 
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+#include <algorithm>
+
 #include "rocksdb/filter_policy.h"
 #include "rocksdb/slice.h"
 #include "rocksdb/terark_namespace.h"
@@ -15,6 +21,7 @@
 #include "table/full_filter_block.h"
 #include "util/coding.h"
 #include "util/hash.h"
+#include "util/ribbon_filter.h"
 
 namespace TERARKDB_NAMESPACE {
 
@@ -185,6 +192,30 @@ class FullFilterBitsReader : public FilterBitsReader {
     return HashMayMatch(hash, Slice(data_, data_len_), num_probes_, num_lines_);
   }
 
+  virtual void KeysMayMatch(int num_keys, const Slice* keys,
+                            bool* may_match) override {
+    if (data_len_ <= 5 || num_probes_ == 0 || num_lines_ == 0) {
+      std::fill(may_match, may_match + num_keys, data_len_ > 5);
+      return;
+    }
+    // HashMayMatch() prefetches the cache line before probing it, so hash
+    // the whole batch first to overlap the memory accesses.
+    const int kBatchSize = 32;
+    uint32_t hashes[kBatchSize];
+    for (int i = 0; i < num_keys; i += kBatchSize) {
+      int n = std::min(kBatchSize, num_keys - i);
+      for (int j = 0; j < n; ++j) {
+        hashes[j] = BloomHash(keys[i + j]);
+        uint32_t b = (hashes[j] % num_lines_) << log2_cache_line_size_;
+        PREFETCH(&data_[b], 0 /* rw */, 1 /* locality */);
+      }
+      for (int j = 0; j < n; ++j) {
+        may_match[i + j] = HashMayMatch(hashes[j], Slice(data_, data_len_),
+                                        num_probes_, num_lines_);
+      }
+    }
+  }
+
  private:
   // Filter meta data
   char* data_;
@@ -267,13 +298,221 @@ bool FullFilterBitsReader::HashMayMatch(const uint32_t& hash,
   return true;
 }
 
+// Blocked bloom filter, all the probes of a key land in one 64-byte block,
+// so a query costs at most one cache miss and all its probes are tested
+// together with AVX2.
+//
+// The block is chosen by the upper bits of the hash, the i-th probe is the
+// top 9 bits of hash * kGoldenRatio^(i+1). See FullFilterFormat for the
+// metadata.
+// +----------------------------------------------------------------+
+// |               filter data, num_blocks * 64 bytes               |
+// +----------------------------------------------------------------+
+// | 0 : 1 byte | format : 1 byte | num_probes : 1 byte | 0 : 2 bytes |
+// +----------------------------------------------------------------+
+const uint32_t kBlockedBloomBlockBytes = 64;
+const uint32_t kFilterMetadataBytes = 5;
+const uint32_t kGoldenRatio = 0x9e3779b9;
+
+inline const char* BlockedBloomBlock(const char* data, uint32_t num_blocks,
+                                     uint32_t hash) {
+  uint32_t block = static_cast<uint32_t>((uint64_t{hash} * num_blocks) >> 32);
+  return data + block * kBlockedBloomBlockBytes;
+}
+
+inline void BlockedBloomAddHash(uint32_t h, char* block, int num_probes) {
+  for (int i = 0; i < num_probes; ++i) {
+    h *= kGoldenRatio;
+    const uint32_t bitpos = h >> 23;
+    block[bitpos / 8] |= static_cast<char>(1 << (bitpos % 8));
+  }
+}
+
+inline bool BlockedBloomHashMayMatch(uint32_t h, const char* block,
+                                     int num_probes) {
+#ifdef __AVX2__
+  // Lane i of a round tests probe 8 * round + i, i.e. the same bits as the
+  // scalar loop below. A 32-bit little-endian word holds bit (bitpos & 31)
+  // of word (bitpos >> 5) at byte bitpos / 8, bit bitpos % 8.
+  const __m256i multipliers = _mm256_setr_epi32(
+      0x9e3779b9, 0xe35e67b1, 0x734297e9, 0x35fbe861, 0xdeb7c719, 0x0448b211,
+      0x3459b749, static_cast<int>(0xab25f4c1));
+  const uint32_t kGoldenRatioPow8 = 0xab25f4c1;
+  const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  const __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+  const __m256i hi =
+      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 32));
+  for (;;) {
+    __m256i hash = _mm256_mullo_epi32(_mm256_set1_epi32(h), multipliers);
+    __m256i bitpos = _mm256_srli_epi32(hash, 23);
+    __m256i word_index = _mm256_srli_epi32(bitpos, 5);
+    // permutevar8x32 only uses the low 3 bits of the index, bit 3 picks the
+    // half of the block
+    __m256i word = _mm256_castps_si256(_mm256_blendv_ps(
+        _mm256_castsi256_ps(_mm256_permutevar8x32_epi32(lo, word_index)),
+        _mm256_castsi256_ps(_mm256_permutevar8x32_epi32(hi, word_index)),
+        _mm256_castsi256_ps(_mm256_slli_epi32(word_index, 28))));
+    __m256i bit = _mm256_sllv_epi32(
+        _mm256_set1_epi32(1), _mm256_and_si256(bitpos, _mm256_set1_epi32(31)));
+    __m256i active = _mm256_cmpgt_epi32(_mm256_set1_epi32(num_probes), lanes);
+    __m256i missing = _mm256_and_si256(_mm256_andnot_si256(word, bit), active);
+    if (!_mm256_testz_si256(missing, missing)) {
+      return false;
+    }
+    if (num_probes <= 8) {
+      return true;
+    }
+    num_probes -= 8;
+    h *= kGoldenRatioPow8;
+  }
+#else
+  for (int i = 0; i < num_probes; ++i) {
+    h *= kGoldenRatio;
+    const uint32_t bitpos = h >> 23;
+    if ((block[bitpos / 8] & (1 << (bitpos % 8))) == 0) {
+      return false;
+    }
+  }
+  return true;
+#endif
+}
+
+bool IsBlockedBloomFilter(const Slice& contents) {
+  size_t len = contents.size();
+  return len > kFilterMetadataBytes && contents[len - 5] == 0 &&
+         contents[len - 4] == kBlockedBloomFilterFormat;
+}
+
+class BlockedBloomBitsBuilder : public FilterBitsBuilder {
+ public:
+  BlockedBloomBitsBuilder(size_t bits_per_key, size_t num_probes)
+      : bits_per_key_(bits_per_key), num_probes_(static_cast<int>(num_probes)) {
+    assert(bits_per_key_);
+  }
+
+  virtual void AddKey(const Slice& key) override {
+    uint32_t hash = BloomHash(key);
+    if (hash_entries_.empty() || hash != hash_entries_.back()) {
+      hash_entries_.push_back(hash);
+    }
+  }
+
+  virtual Slice Finish(std::unique_ptr<const char[]>* buf) override {
+    uint32_t num_blocks = NumBlocks(hash_entries_.size());
+    uint32_t len = num_blocks * kBlockedBloomBlockBytes + kFilterMetadataBytes;
+    char* data = new char[len];
+    memset(data, 0, len);
+    buf->reset(data);
+    if (num_blocks != 0) {
+      for (auto h : hash_entries_) {
+        BlockedBloomAddHash(
+            h, const_cast<char*>(BlockedBloomBlock(data, num_blocks, h)),
+            num_probes_);
+      }
+      // An empty filter keeps the legacy format, which never matches
+      data[len - 4] = kBlockedBloomFilterFormat;
+      data[len - 3] = static_cast<char>(num_probes_);
+    }
+    hash_entries_.clear();
+    return Slice(data, len);
+  }
+
+  virtual int CalculateNumEntry(const uint32_t space) override {
+    assert(space > 0);
+    if (space <= kFilterMetadataBytes) {
+      return 0;
+    }
+    uint64_t num_blocks =
+        (space - kFilterMetadataBytes) / kBlockedBloomBlockBytes;
+    return static_cast<int>(num_blocks * kBlockedBloomBlockBytes * 8 /
+                            bits_per_key_);
+  }
+
+ private:
+  uint32_t NumBlocks(size_t num_entry) const {
+    const uint64_t kBlockBits = kBlockedBloomBlockBytes * 8;
+    return static_cast<uint32_t>((num_entry * bits_per_key_ + kBlockBits - 1) /
+                                 kBlockBits);
+  }
+
+  size_t bits_per_key_;
+  int num_probes_;
+  std::vector<uint32_t> hash_entries_;
+};
+
+class BlockedBloomBitsReader : public FilterBitsReader {
+ public:
+  // REQUIRES: IsBlockedBloomFilter(contents)
+  explicit BlockedBloomBitsReader(const Slice& contents)
+      : data_(contents.data()),
+        num_blocks_(0),
+        num_probes_(static_cast<unsigned char>(contents[contents.size() - 3])) {
+    assert(IsBlockedBloomFilter(contents));
+    uint32_t len = static_cast<uint32_t>(contents.size()) - kFilterMetadataBytes;
+    // A broken filter matches everything
+    if (len % kBlockedBloomBlockBytes == 0 && num_probes_ > 0) {
+      num_blocks_ = len / kBlockedBloomBlockBytes;
+    }
+  }
+
+  virtual bool MayMatch(const Slice& entry) override {
+    if (num_blocks_ == 0) {
+      return true;
+    }
+    uint32_t hash = BloomHash(entry);
+    return BlockedBloomHashMayMatch(
+        hash, BlockedBloomBlock(data_, num_blocks_, hash), num_probes_);
+  }
+
+  virtual void KeysMayMatch(int num_keys, const Slice* keys,
+                            bool* may_match) override {
+    if (num_blocks_ == 0) {
+      std::fill(may_match, may_match + num_keys, true);
+      return;
+    }
+    // Locate and prefetch the blocks of the whole batch before probing
+    const int kBatchSize = 32;
+    uint32_t hashes[kBatchSize];
+    const char* blocks[kBatchSize];
+    for (int i = 0; i < num_keys; i += kBatchSize) {
+      int n = std::min(kBatchSize, num_keys - i);
+      for (int j = 0; j < n; ++j) {
+        hashes[j] = BloomHash(keys[i + j]);
+        blocks[j] = BlockedBloomBlock(data_, num_blocks_, hashes[j]);
+        PREFETCH(blocks[j], 0 /* rw */, 1 /* locality */);
+      }
+      for (int j = 0; j < n; ++j) {
+        may_match[i + j] =
+            BlockedBloomHashMayMatch(hashes[j], blocks[j], num_probes_);
+      }
+    }
+  }
+
+ private:
+  const char* data_;
+  uint32_t num_blocks_;
+  int num_probes_;
+};
+
 // An implementation of filter policy
 class BloomFilterPolicy : public FilterPolicy {
  public:
-  explicit BloomFilterPolicy(int bits_per_key, bool use_block_based_builder)
+  // Format of the full filters built, all of them can be read
+  enum Mode {
+    kLegacyBloom,
+    kBlockedBloom,
+    // Bloom for files below bloom_before_level
+    kRibbon,
+  };
+
+  explicit BloomFilterPolicy(int bits_per_key, bool use_block_based_builder,
+                             Mode mode = kLegacyBloom,
+                             int bloom_before_level = 0)
       : bits_per_key_(bits_per_key),
         hash_func_(BloomHash),
-        use_block_based_builder_(use_block_based_builder) {
+        use_block_based_builder_(use_block_based_builder),
+        mode_(mode),
+        bloom_before_level_(bloom_before_level) {
     initialize();
   }
 
@@ -340,15 +579,45 @@ class BloomFilterPolicy : public FilterPolicy {
   }
 
   virtual FilterBitsBuilder* GetFilterBitsBuilder() const override {
+    return GetBuilderWithContext(FilterBuildingContext());
+  }
+
+  virtual FilterBitsBuilder* GetBuilderWithContext(
+      const FilterBuildingContext& context) const override {
     if (use_block_based_builder_) {
       return nullptr;
     }
+    size_t bits_per_key = bits_per_key_;
+    size_t num_probes = num_probes_;
+    int num_result_bits = num_result_bits_;
+    if (context.bits_per_key > 0) {
+      bits_per_key = static_cast<size_t>(context.bits_per_key);
+      num_probes = NumProbes(bits_per_key);
+      num_result_bits = NumResultBits(bits_per_key);
+    }
+    switch (mode_) {
+      case kBlockedBloom:
+        return new BlockedBloomBitsBuilder(bits_per_key, num_probes);
+      case kRibbon:
+        if (context.level_at_creation >= bloom_before_level_) {
+          return new RibbonBitsBuilder(num_result_bits);
+        }
+        break;
+      case kLegacyBloom:
+        break;
+    }
 
-    return new FullFilterBitsBuilder(bits_per_key_, num_probes_);
+    return new FullFilterBitsBuilder(bits_per_key, num_probes);
   }
 
   virtual FilterBitsReader* GetFilterBitsReader(
       const Slice& contents) const override {
+    if (IsBlockedBloomFilter(contents)) {
+      return new BlockedBloomBitsReader(contents);
+    }
+    if (RibbonBitsReader::IsRibbonFilter(contents)) {
+      return new RibbonBitsReader(contents);
+    }
     return new FullFilterBitsReader(contents);
   }
 
@@ -361,12 +630,27 @@ class BloomFilterPolicy : public FilterPolicy {
   uint32_t (*hash_func_)(const Slice& key);
 
   const bool use_block_based_builder_;
+  const Mode mode_;
+  const int bloom_before_level_;
+  // Ribbon filter with about the false positive rate of the bloom filter
+  int num_result_bits_;
 
-  void initialize() {
+  static size_t NumProbes(size_t bits_per_key) {
     // We intentionally round down to reduce probing cost a little bit
-    num_probes_ = static_cast<size_t>(bits_per_key_ * 0.69);  // 0.69 =~ ln(2)
-    if (num_probes_ < 1) num_probes_ = 1;
-    if (num_probes_ > 30) num_probes_ = 30;
+    size_t num_probes =
+        static_cast<size_t>(bits_per_key * 0.69);  // 0.69 =~ ln(2)
+    return std::min<size_t>(std::max<size_t>(num_probes, 1), 30);
+  }
+
+  static int NumResultBits(size_t bits_per_key) {
+    // A bloom filter has a false positive rate of about 0.6185^bits_per_key,
+    // i.e. 2^(-0.69 * bits_per_key)
+    return static_cast<int>(bits_per_key * 0.69 + 0.5);
+  }
+
+  void initialize() {
+    num_probes_ = NumProbes(bits_per_key_);
+    num_result_bits_ = NumResultBits(bits_per_key_);
   }
 };
 
@@ -377,4 +661,16 @@ const FilterPolicy* NewBloomFilterPolicy(int bits_per_key,
   return new BloomFilterPolicy(bits_per_key, use_block_based_builder);
 }
 
+const FilterPolicy* NewBlockedBloomFilterPolicy(int bits_per_key) {
+  return new BloomFilterPolicy(bits_per_key, false /* use_block_based_builder */,
+                               BloomFilterPolicy::kBlockedBloom);
+}
+
+const FilterPolicy* NewRibbonFilterPolicy(int bloom_equivalent_bits_per_key,
+                                          int bloom_before_level) {
+  return new BloomFilterPolicy(bloom_equivalent_bits_per_key,
+                               false /* use_block_based_builder */,
+                               BloomFilterPolicy::kRibbon, bloom_before_level);
+}
+
 }  // namespace TERARKDB_NAMESPACE
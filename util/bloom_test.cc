@@ -23,6 +23,7 @@ int main() {
 #include "util/arena.h"
 #include "util/gflags_compat.h"
 #include "util/logging.h"
+#include "util/ribbon_filter.h"
 #include "util/testharness.h"
 #include "util/testutil.h"
 
@@ -182,9 +183,10 @@ class FullBloomTest : public testing::Test {
   size_t filter_size_;
 
  public:
-  FullBloomTest()
-      : policy_(NewBloomFilterPolicy(FLAGS_bits_per_key, false)),
-        filter_size_(0) {
+  explicit FullBloomTest(
+      const FilterPolicy* policy = NewBloomFilterPolicy(FLAGS_bits_per_key,
+                                                        false))
+      : policy_(policy), filter_size_(0) {
     Reset();
   }
 
@@ -218,6 +220,32 @@ class FullBloomTest : public testing::Test {
     return bits_reader_->MayMatch(s);
   }
 
+  // Checks KeysMayMatch() against MayMatch() for keys [begin, end)
+  void CheckKeysMayMatch(int begin, int end) {
+    if (bits_reader_ == nullptr) {
+      Build();
+    }
+    int n = end - begin;
+    std::vector<std::string> buffers(n, std::string(sizeof(int), '\0'));
+    std::vector<Slice> keys;
+    for (int i = 0; i < n; i++) {
+      keys.push_back(Key(begin + i, &buffers[i][0]));
+    }
+    std::unique_ptr<bool[]> may_match(new bool[n]);
+    bits_reader_->KeysMayMatch(n, keys.data(), may_match.get());
+    for (int i = 0; i < n; i++) {
+      ASSERT_EQ(bits_reader_->MayMatch(keys[i]), may_match[i]) << i;
+    }
+  }
+
+  // Reads the last built filter with another policy
+  std::unique_ptr<FilterBitsReader> NewReader(const FilterPolicy* policy) {
+    return std::unique_ptr<FilterBitsReader>(
+        policy->GetFilterBitsReader(Slice(buf_.get(), filter_size_)));
+  }
+
+  FilterBitsBuilder* bits_builder() { return bits_builder_.get(); }
+
   double FalsePositiveRate() {
     char buffer[sizeof(int)];
     int result = 0;
@@ -299,6 +327,212 @@ TEST_F(FullBloomTest, FullVaryingLengths) {
   ASSERT_LE(mediocre_filters, good_filters / 5);
 }
 
+enum FullFilterType {
+  kLegacyBloom,
+  kBlockedBloom,
+  kRibbon,
+};
+
+// The tests every full filter policy must pass, with the size and false
+// positive rate limits of each
+class FullFilterTest : public FullBloomTest,
+                       public testing::WithParamInterface<FullFilterType> {
+ public:
+  FullFilterTest() : FullBloomTest(NewPolicy(GetParam())) {}
+
+  static const FilterPolicy* NewPolicy(FullFilterType type) {
+    switch (type) {
+      case kBlockedBloom:
+        return NewBlockedBloomFilterPolicy(FLAGS_bits_per_key);
+      case kRibbon:
+        return NewRibbonFilterPolicy(FLAGS_bits_per_key,
+                                     -1 /* bloom_before_level */);
+      default:
+        return NewBloomFilterPolicy(FLAGS_bits_per_key, false);
+    }
+  }
+
+  // Of a filter for the keys that fit into space
+  size_t MaxSizeForSpace(uint32_t space) const {
+    // Unless the banding had to grow the filter
+    return GetParam() == kRibbon ? std::max<uint32_t>(space, 8 * 8 + 5) * 9 / 8
+                                 : space;
+  }
+
+  // Of a filter for length keys
+  size_t MaxSizeForLength(int length) const {
+    switch (GetParam()) {
+      case kBlockedBloom:
+        return (length * 10 / 8) + 64 + 5;
+      case kRibbon:
+        // A bloom filter of the same false positive rate takes
+        // length * 10 / 8
+        return length >= 1000 ? static_cast<size_t>(length * 10 / 8 * 0.8)
+                              : port::kMaxSizet;
+      default:
+        return (length * 10 / 8) + 128 + 5;
+    }
+  }
+
+  // Probes of a key share one block, so the false positive rate of the
+  // blocked bloom filter is a bit higher than the legacy one
+  double MaxFalsePositiveRate() const {
+    return GetParam() == kBlockedBloom ? 0.03 : 0.02;
+  }
+  double MediocreFalsePositiveRate() const {
+    return GetParam() == kBlockedBloom ? 0.015 : 0.0125;
+  }
+};
+
+TEST_P(FullFilterTest, EmptyFilter) {
+  // Empty filter is not match, at this level
+  ASSERT_TRUE(!Matches("hello"));
+  ASSERT_TRUE(!Matches("world"));
+}
+
+TEST_P(FullFilterTest, Small) {
+  Add("hello");
+  Add("world");
+  ASSERT_TRUE(Matches("hello"));
+  ASSERT_TRUE(Matches("world"));
+  ASSERT_TRUE(!Matches("x"));
+  ASSERT_TRUE(!Matches("foo"));
+}
+
+TEST_P(FullFilterTest, FilterSize) {
+  char buffer[sizeof(int)];
+  for (uint32_t space = 64 + 5; space < 4000; space += 37) {
+    int n = bits_builder()->CalculateNumEntry(space);
+    ASSERT_GT(n, 0);
+    Reset();
+    for (int i = 0; i < n; i++) {
+      Add(Key(i, buffer));
+    }
+    Build();
+    ASSERT_LE(FilterSize(), MaxSizeForSpace(space)) << space;
+  }
+}
+
+TEST_P(FullFilterTest, VaryingLengths) {
+  char buffer[sizeof(int)];
+
+  // Count number of filters that significantly exceed the false positive rate
+  int mediocre_filters = 0;
+  int good_filters = 0;
+
+  for (int length = 1; length <= 10000; length = NextLength(length)) {
+    Reset();
+    for (int i = 0; i < length; i++) {
+      Add(Key(i, buffer));
+    }
+    Build();
+
+    ASSERT_LE(FilterSize(), MaxSizeForLength(length)) << length;
+
+    // All added keys must match
+    for (int i = 0; i < length; i++) {
+      ASSERT_TRUE(Matches(Key(i, buffer)))
+          << "Length " << length << "; key " << i;
+    }
+
+    // Check false positive rate
+    double rate = FalsePositiveRate();
+    if (kVerbose >= 1) {
+      fprintf(stderr, "False positives: %5.2f%% @ length = %6d ; bytes = %6d\n",
+              rate * 100.0, length, static_cast<int>(FilterSize()));
+    }
+    ASSERT_LE(rate, MaxFalsePositiveRate());
+    if (rate > MediocreFalsePositiveRate())
+      mediocre_filters++;  // Allowed, but not too often
+    else
+      good_filters++;
+  }
+  if (kVerbose >= 1) {
+    fprintf(stderr, "Filters: %d good, %d mediocre\n", good_filters,
+            mediocre_filters);
+  }
+  ASSERT_LE(mediocre_filters, good_filters / 5);
+}
+
+TEST_P(FullFilterTest, KeysMayMatch) {
+  char buffer[sizeof(int)];
+  for (int i = 0; i < 1000; i++) {
+    Add(Key(i, buffer));
+  }
+  CheckKeysMayMatch(500, 1500);
+  CheckKeysMayMatch(1000000000, 1000000100);
+}
+
+TEST_P(FullFilterTest, ReadByLegacyPolicy) {
+  char buffer[sizeof(int)];
+  for (int i = 0; i < 1000; i++) {
+    Add(Key(i, buffer));
+  }
+  Build();
+  std::unique_ptr<const FilterPolicy> legacy(
+      NewBloomFilterPolicy(FLAGS_bits_per_key, false));
+  auto reader = NewReader(legacy.get());
+  int false_positives = 0;
+  for (int i = 0; i < 1000; i++) {
+    ASSERT_TRUE(reader->MayMatch(Key(i, buffer)));
+    ASSERT_EQ(Matches(Key(i + 1000000000, buffer)),
+              reader->MayMatch(Key(i + 1000000000, buffer)));
+    false_positives += reader->MayMatch(Key(i + 1000000000, buffer));
+  }
+  ASSERT_LT(false_positives, 1000);
+}
+
+INSTANTIATE_TEST_CASE_P(FullFilterTest, FullFilterTest,
+                        testing::Values(kLegacyBloom, kBlockedBloom, kRibbon));
+
+TEST(RibbonFilterPolicyTest, BloomBeforeLevel) {
+  std::unique_ptr<const FilterPolicy> policy(
+      NewRibbonFilterPolicy(FLAGS_bits_per_key, 2 /* bloom_before_level */));
+  FilterBuildingContext context;
+  for (int level = -1; level < 4; level++) {
+    context.level_at_creation = level;
+    std::unique_ptr<FilterBitsBuilder> builder(
+        policy->GetBuilderWithContext(context));
+    if (level < 2) {
+      ASSERT_TRUE(dynamic_cast<FullFilterBitsBuilder*>(builder.get()));
+    } else {
+      ASSERT_TRUE(dynamic_cast<RibbonBitsBuilder*>(builder.get()));
+    }
+  }
+}
+
+TEST(FilterBuildingContextTest, BitsPerKey) {
+  std::unique_ptr<const FilterPolicy> policies[] = {
+      std::unique_ptr<const FilterPolicy>(NewBloomFilterPolicy(10, false)),
+      std::unique_ptr<const FilterPolicy>(NewBlockedBloomFilterPolicy(10)),
+      std::unique_ptr<const FilterPolicy>(NewRibbonFilterPolicy(10)),
+  };
+  char buffer[sizeof(int)];
+  for (auto& policy : policies) {
+    size_t sizes[2];
+    int bits_per_key[2] = {-1, 20};
+    for (int i = 0; i < 2; i++) {
+      FilterBuildingContext context;
+      context.level_at_creation = 1;
+      context.bits_per_key = bits_per_key[i];
+      std::unique_ptr<FilterBitsBuilder> builder(
+          policy->GetBuilderWithContext(context));
+      for (int k = 0; k < 10000; k++) {
+        builder->AddKey(Key(k, buffer));
+      }
+      std::unique_ptr<const char[]> buf;
+      Slice filter = builder->Finish(&buf);
+      sizes[i] = filter.size();
+      std::unique_ptr<FilterBitsReader> reader(
+          policy->GetFilterBitsReader(filter));
+      for (int k = 0; k < 10000; k++) {
+        ASSERT_TRUE(reader->MayMatch(Key(k, buffer)));
+      }
+    }
+    ASSERT_GT(sizes[1], sizes[0] * 3 / 2);
+  }
+}
+
 }  // namespace TERARKDB_NAMESPACE
 
 int main(int argc, char** argv) {
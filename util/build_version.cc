@@ -0,0 +1,4 @@
+#include "build_version.h"
+const char* rocksdb_build_git_sha = "rocksdb_build_git_sha:@838eaa91354c161e7999cdf25c3727789edf1145@";
+const char* rocksdb_build_git_date = "rocksdb_build_git_date:@2026/10/17 00:45:37@";
+const char* rocksdb_build_compile_date = __DATE__;
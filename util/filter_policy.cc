@@ -9,10 +9,18 @@
 
 #include "rocksdb/filter_policy.h"
 
+#include "rocksdb/slice.h"
 #include "rocksdb/terark_namespace.h"
 
 namespace TERARKDB_NAMESPACE {
 
 FilterPolicy::~FilterPolicy() {}
 
+void FilterBitsReader::KeysMayMatch(int num_keys, const Slice* keys,
+                                    bool* may_match) {
+  for (int i = 0; i < num_keys; ++i) {
+    may_match[i] = MayMatch(keys[i]);
+  }
+}
+
 }  // namespace TERARKDB_NAMESPACE
@@ -0,0 +1,317 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#include "util/ribbon_filter.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+#include "port/port.h"
+#include "rocksdb/slice.h"
+#include "rocksdb/terark_namespace.h"
+#include "table/full_filter_bits_builder.h"
+#include "util/coding.h"
+#include "util/xxhash.h"
+
+namespace TERARKDB_NAMESPACE {
+
+namespace {
+
+const uint32_t kSlotsPerBlock = 64;
+const uint32_t kFilterMetadataBytes = 5;
+const int kMaxResultBits = 16;
+const uint32_t kMaxSeed = 255;
+// Grow the filter after this many failed seeds
+const uint32_t kSeedsPerSize = 4;
+
+inline int CountTrailingZeroBits(uint64_t v) {
+  assert(v != 0);
+#ifdef _MSC_VER
+  unsigned long index;
+  _BitScanForward64(&index, v);
+  return static_cast<int>(index);
+#else
+  return __builtin_ctzll(v);
+#endif
+}
+
+inline uint64_t BitParity(uint64_t v) {
+#ifdef _MSC_VER
+  return __popcnt64(v) & 1;
+#else
+  return static_cast<uint64_t>(__builtin_parityll(v));
+#endif
+}
+
+inline uint64_t RibbonHash(const Slice& key) {
+  return XXH64(key.data(), key.size(), 0);
+}
+
+// Remixes the key hash for a seed, see murmur3 fmix64
+inline uint64_t RibbonRehash(uint64_t h, uint32_t seed) {
+  h += seed * 0x9e3779b97f4a7c15ULL;
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+inline uint32_t RibbonStart(uint64_t h, uint32_t num_starts) {
+  return static_cast<uint32_t>(((h >> 32) * num_starts) >> 32);
+}
+
+// The first coefficient is always 1, so every key has a pivot
+inline uint64_t RibbonCoeff(uint64_t h) {
+  return (h * 0x9e3779b97f4a7c15ULL) | 1;
+}
+
+inline uint16_t RibbonResult(uint64_t h, int num_result_bits) {
+  return static_cast<uint16_t>((static_cast<uint32_t>(h) * 0x9e3779b9U) >>
+                               (32 - num_result_bits));
+}
+
+// The banding with 64-bit coefficients needs more slack for more keys, 1%
+// of the slots per doubling of the key count keeps retries rare
+double SlotsPerKey(size_t num_entry) {
+  return 1.0 + std::max(0.06, 0.01 * std::log2(num_entry + 1.0) - 0.08);
+}
+
+uint32_t NumSlots(size_t num_entry) {
+  uint64_t num_slots = std::max<uint64_t>(
+      static_cast<uint64_t>(num_entry * SlotsPerKey(num_entry)),
+      kSlotsPerBlock);
+  return static_cast<uint32_t>((num_slots + kSlotsPerBlock - 1) /
+                               kSlotsPerBlock * kSlotsPerBlock);
+}
+
+}  // namespace
+
+RibbonBitsBuilder::RibbonBitsBuilder(int num_result_bits)
+    : num_result_bits_(
+          std::max(1, std::min(kMaxResultBits, num_result_bits))) {}
+
+void RibbonBitsBuilder::AddKey(const Slice& key) {
+  uint64_t hash = RibbonHash(key);
+  if (hash_entries_.empty() || hash != hash_entries_.back()) {
+    hash_entries_.push_back(hash);
+  }
+}
+
+bool RibbonBitsBuilder::Band(uint32_t num_slots, uint32_t seed,
+                             std::vector<uint64_t>* coeffs,
+                             std::vector<uint16_t>* results) const {
+  uint32_t num_starts = num_slots - kSlotsPerBlock + 1;
+  coeffs->assign(num_slots, 0);
+  results->assign(num_slots, 0);
+  uint64_t* c_data = coeffs->data();
+  uint16_t* r_data = results->data();
+  for (auto hash : hash_entries_) {
+    uint64_t h = RibbonRehash(hash, seed);
+    uint32_t i = RibbonStart(h, num_starts);
+    uint64_t c = RibbonCoeff(h);
+    uint16_t r = RibbonResult(h, num_result_bits_);
+    // The band of c stays inside [start, start + 64) of the first row
+    for (;;) {
+      if (c_data[i] == 0) {
+        c_data[i] = c;
+        r_data[i] = r;
+        break;
+      }
+      c ^= c_data[i];
+      r ^= r_data[i];
+      if (c == 0) {
+        if (r != 0) {
+          return false;
+        }
+        break;  // Same equation as a previous key
+      }
+      int shift = CountTrailingZeroBits(c);
+      i += shift;
+      c >>= shift;
+    }
+  }
+  return true;
+}
+
+Slice RibbonBitsBuilder::Finish(std::unique_ptr<const char[]>* buf) {
+  const int r = num_result_bits_;
+  uint32_t num_slots = NumSlots(hash_entries_.size());
+  std::vector<uint64_t> coeffs;
+  std::vector<uint16_t> results;
+  uint32_t seed = 0;
+  bool ok = hash_entries_.empty();
+  for (; !ok && seed <= kMaxSeed; ++seed) {
+    if (seed > 0 && seed % kSeedsPerSize == 0) {
+      num_slots += (num_slots / 8 + kSlotsPerBlock - 1) / kSlotsPerBlock *
+                   kSlotsPerBlock;
+    }
+    ok = Band(num_slots, seed, &coeffs, &results);
+  }
+
+  char* data;
+  uint32_t len;
+  if (hash_entries_.empty()) {
+    // Legacy empty filter, which never matches
+    len = kFilterMetadataBytes;
+    data = new char[len];
+    memset(data, 0, len);
+  } else if (!ok) {
+    // Practically unreachable, e.g. two keys of the same band with different
+    // fingerprints. Zero result bits match everything.
+    len = 8 + kFilterMetadataBytes;
+    data = new char[len];
+    memset(data, 0, len);
+    data[len - 4] = kRibbonFilterFormat;
+  } else {
+    --seed;
+    uint32_t num_blocks = num_slots / kSlotsPerBlock;
+    len = num_blocks * r * 8 + kFilterMetadataBytes;
+    data = new char[len];
+    memset(data, 0, len);
+
+    // Back substitution, from the last slot. Bit k of state[b] is bit b of
+    // the solution of slot i + k, so solution i is the result of row i xor
+    // the parity of the other coefficients of the row.
+    uint64_t state[kMaxResultBits] = {0};
+    std::vector<uint64_t> words(r);
+    for (uint32_t block = num_blocks; block-- > 0;) {
+      std::fill(words.begin(), words.end(), 0);
+      for (uint32_t j = kSlotsPerBlock; j-- > 0;) {
+        uint32_t i = block * kSlotsPerBlock + j;
+        uint64_t c = coeffs[i];
+        uint32_t result = results[i];
+        if (c == 0) {
+          // Free slot, any solution will do
+          result = static_cast<uint32_t>(RibbonRehash(i, seed));
+        }
+        for (int b = 0; b < r; ++b) {
+          state[b] <<= 1;
+          uint64_t bit = ((result >> b) & 1) ^ BitParity(c & state[b]);
+          state[b] |= bit;
+          words[b] |= bit << j;
+        }
+      }
+      for (int b = 0; b < r; ++b) {
+        EncodeFixed64(data + (block * r + b) * 8, words[b]);
+      }
+    }
+    data[len - 4] = kRibbonFilterFormat;
+    data[len - 3] = static_cast<char>(r);
+    data[len - 2] = static_cast<char>(seed);
+  }
+  buf->reset(data);
+  hash_entries_.clear();
+  return Slice(data, len);
+}
+
+uint32_t RibbonBitsBuilder::CalculateSpace(size_t num_entry) const {
+  if (num_entry == 0) {
+    return kFilterMetadataBytes;
+  }
+  return NumSlots(num_entry) / kSlotsPerBlock * num_result_bits_ * 8 +
+         kFilterMetadataBytes;
+}
+
+int RibbonBitsBuilder::CalculateNumEntry(const uint32_t space) {
+  assert(space > 0);
+  uint32_t block_bytes = num_result_bits_ * 8;
+  if (space < block_bytes + kFilterMetadataBytes) {
+    return 1;
+  }
+  uint64_t num_slots =
+      uint64_t{(space - kFilterMetadataBytes) / block_bytes} * kSlotsPerBlock;
+  int n = static_cast<int>(num_slots /
+                           SlotsPerKey(static_cast<size_t>(num_slots)));
+  while (n > 1 && CalculateSpace(n) > space) {
+    --n;
+  }
+  return n;
+}
+
+RibbonBitsReader::RibbonBitsReader(const Slice& contents)
+    : data_(contents.data()),
+      num_starts_(0),
+      num_result_bits_(
+          static_cast<unsigned char>(contents[contents.size() - 3])),
+      seed_(static_cast<unsigned char>(contents[contents.size() - 2])) {
+  assert(IsRibbonFilter(contents));
+  uint32_t len =
+      static_cast<uint32_t>(contents.size()) - kFilterMetadataBytes;
+  uint32_t block_bytes = num_result_bits_ * 8;
+  // A broken filter matches everything
+  if (num_result_bits_ > 0 && num_result_bits_ <= kMaxResultBits &&
+      len % block_bytes == 0 && len > 0) {
+    num_starts_ = len / block_bytes * kSlotsPerBlock - kSlotsPerBlock + 1;
+  }
+}
+
+bool RibbonBitsReader::IsRibbonFilter(const Slice& contents) {
+  size_t len = contents.size();
+  return len > kFilterMetadataBytes && contents[len - 5] == 0 &&
+         contents[len - 4] == kRibbonFilterFormat;
+}
+
+inline bool RibbonBitsReader::HashMayMatch(uint64_t hash) const {
+  const int r = num_result_bits_;
+  uint64_t h = RibbonRehash(hash, seed_);
+  uint32_t start = RibbonStart(h, num_starts_);
+  uint64_t c = RibbonCoeff(h);
+  uint32_t expected = RibbonResult(h, r);
+  uint32_t shift = start % kSlotsPerBlock;
+  const char* words = data_ + start / kSlotsPerBlock * r * 8;
+  for (int b = 0; b < r; ++b) {
+    uint64_t window = DecodeFixed64(words + b * 8) >> shift;
+    if (shift != 0) {
+      window |= DecodeFixed64(words + (r + b) * 8) << (kSlotsPerBlock - shift);
+    }
+    if (BitParity(c & window) != ((expected >> b) & 1)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool RibbonBitsReader::MayMatch(const Slice& entry) {
+  if (num_starts_ == 0) {
+    return true;
+  }
+  return HashMayMatch(RibbonHash(entry));
+}
+
+void RibbonBitsReader::KeysMayMatch(int num_keys, const Slice* keys,
+                                    bool* may_match) {
+  if (num_starts_ == 0) {
+    std::fill(may_match, may_match + num_keys, true);
+    return;
+  }
+  // Prefetch the two blocks of every key of the batch before probing
+  const int kBatchSize = 32;
+  const uint32_t block_bytes = num_result_bits_ * 8;
+  uint64_t hashes[kBatchSize];
+  for (int i = 0; i < num_keys; i += kBatchSize) {
+    int n = std::min(kBatchSize, num_keys - i);
+    for (int j = 0; j < n; ++j) {
+      hashes[j] = RibbonHash(keys[i + j]);
+      uint64_t h = RibbonRehash(hashes[j], seed_);
+      const char* words =
+          data_ + RibbonStart(h, num_starts_) / kSlotsPerBlock * block_bytes;
+      PREFETCH(words, 0 /* rw */, 1 /* locality */);
+      PREFETCH(words + block_bytes * 2 - 1, 0 /* rw */, 1 /* locality */);
+    }
+    for (int j = 0; j < n; ++j) {
+      may_match[i + j] = HashMayMatch(hashes[j]);
+    }
+  }
+}
+
+}  // namespace TERARKDB_NAMESPACE
@@ -0,0 +1,89 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "rocksdb/filter_policy.h"
+#include "rocksdb/terark_namespace.h"
+
+namespace TERARKDB_NAMESPACE {
+
+class Slice;
+
+// Standard Ribbon filter (Dillinger & Walzer, "Ribbon filter: practically
+// smaller than Bloom and Xor"). Every key is an equation over GF(2) with a
+// random 64-bit band of coefficients and an r-bit fingerprint, the filter is
+// a solution of the system. A query recomputes the fingerprint from the 64
+// slots of its band, so the false positive rate is about 2^-r at ~r * 1.07
+// bits per key, against ~1.44 * r bits per key for a bloom filter.
+//
+// Building needs ~10 bytes of temporary memory per slot and fails for an
+// unlucky hash seed, in which case it retries with another seed and grows
+// the filter every few retries.
+//
+// Slots are stored in blocks of 64, as r words of one bit of the solution
+// each, so a query reads the r words of two adjacent blocks.
+// +----------------------------------------------------------------+
+// |               filter data, num_blocks * r * 8 bytes            |
+// +----------------------------------------------------------------+
+// | 0 : 1 byte | format : 1 byte | r : 1 byte | seed : 1 byte | 0 |
+// +----------------------------------------------------------------+
+class RibbonBitsBuilder : public FilterBitsBuilder {
+ public:
+  // The false positive rate is about 2^-num_result_bits, 1 to 16
+  explicit RibbonBitsBuilder(int num_result_bits);
+
+  virtual void AddKey(const Slice& key) override;
+
+  virtual Slice Finish(std::unique_ptr<const char[]>* buf) override;
+
+  virtual int CalculateNumEntry(const uint32_t space) override;
+
+  // Size of the filter of num_entry keys, if the first seed succeeds
+  uint32_t CalculateSpace(size_t num_entry) const;
+
+ private:
+  // Gaussian elimination of the keys into coeffs and results, returns false
+  // if the keys are not linear independent with this seed
+  bool Band(uint32_t num_slots, uint32_t seed, std::vector<uint64_t>* coeffs,
+            std::vector<uint16_t>* results) const;
+
+  int num_result_bits_;
+  std::vector<uint64_t> hash_entries_;
+
+  // No Copy allowed
+  RibbonBitsBuilder(const RibbonBitsBuilder&);
+  void operator=(const RibbonBitsBuilder&);
+};
+
+class RibbonBitsReader : public FilterBitsReader {
+ public:
+  // REQUIRES: IsRibbonFilter(contents)
+  explicit RibbonBitsReader(const Slice& contents);
+
+  static bool IsRibbonFilter(const Slice& contents);
+
+  virtual bool MayMatch(const Slice& entry) override;
+
+  virtual void KeysMayMatch(int num_keys, const Slice* keys,
+                            bool* may_match) override;
+
+ private:
+  bool HashMayMatch(uint64_t hash) const;
+
+  const char* data_;
+  uint32_t num_starts_;
+  int num_result_bits_;
+  uint32_t seed_;
+
+  // No Copy allowed
+  RibbonBitsReader(const RibbonBitsReader&);
+  void operator=(const RibbonBitsReader&);
+};
+
+}  // namespace TERARKDB_NAMESPACE
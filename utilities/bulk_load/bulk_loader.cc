@@ -0,0 +1,832 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#ifndef ROCKSDB_LITE
+
+#include "rocksdb/utilities/bulk_loader.h"
+
+#ifndef __STDC_FORMAT_MACROS
+#define __STDC_FORMAT_MACROS
+#endif
+
+#include <inttypes.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "port/port.h"
+#include "rocksdb/comparator.h"
+#include "rocksdb/db.h"
+#include "rocksdb/env.h"
+#include "rocksdb/sst_file_writer.h"
+#include "rocksdb/terark_namespace.h"
+#include "util/coding.h"
+#include "util/heap.h"
+#include "util/logging.h"
+#include "util/string_util.h"
+
+namespace TERARKDB_NAMESPACE {
+
+namespace {
+
+// A run file is indexed by the first key of every kIndexInterval bytes, the
+// index entries are the samples the key space is partitioned by
+const uint64_t kIndexInterval = 64 << 10;
+const size_t kWriteBufferSize = 1 << 20;
+const size_t kReadBufferSize = 256 << 10;
+
+// A sorted run file is a sequence of records:
+// key size : varint32, value size : varint32, key, value
+struct SortedRun {
+  std::string file_name;
+  uint64_t file_size = 0;
+  // First key and offset of every kIndexInterval bytes
+  std::vector<std::pair<std::string, uint64_t>> index;
+};
+
+// Returns the size of the record at p
+size_t DecodeRecord(const char* p, Slice* key, Slice* value) {
+  uint32_t key_size = 0;
+  uint32_t value_size = 0;
+  const char* data = GetVarint32Ptr(p, p + 5, &key_size);
+  data = GetVarint32Ptr(data, data + 5, &value_size);
+  *key = Slice(data, key_size);
+  *value = Slice(data + key_size, value_size);
+  return data - p + key_size + value_size;
+}
+
+Status DuplicateKey(const Slice& key) {
+  return Status::InvalidArgument("Duplicate key", key.ToString(true));
+}
+
+// Writes the records of a run in order and indexes them
+class RunWriter {
+ public:
+  RunWriter(std::string&& file_name, std::unique_ptr<WritableFile>&& file)
+      : file_(std::move(file)) {
+    run_.file_name = std::move(file_name);
+  }
+
+  Status Add(const Slice& key, const Slice& value) {
+    if (run_.index.empty() ||
+        run_.file_size >= run_.index.back().second + kIndexInterval) {
+      run_.index.emplace_back(key.ToString(), run_.file_size);
+    }
+    size_t size = buffer_.size();
+    PutVarint32Varint32(&buffer_, static_cast<uint32_t>(key.size()),
+                        static_cast<uint32_t>(value.size()));
+    buffer_.append(key.data(), key.size());
+    buffer_.append(value.data(), value.size());
+    run_.file_size += buffer_.size() - size;
+    if (buffer_.size() >= kWriteBufferSize) {
+      Status s = file_->Append(buffer_);
+      buffer_.clear();
+      return s;
+    }
+    return Status::OK();
+  }
+
+  Status Finish(SortedRun* run) {
+    Status s;
+    if (!buffer_.empty()) {
+      s = file_->Append(buffer_);
+    }
+    if (s.ok()) {
+      s = file_->Close();
+    }
+    if (s.ok()) {
+      *run = std::move(run_);
+    }
+    return s;
+  }
+
+ private:
+  std::unique_ptr<WritableFile> file_;
+  std::string buffer_;
+  SortedRun run_;
+};
+
+// Reads the records of a run from a lower bound on
+class RunReader {
+ public:
+  explicit RunReader(const SortedRun* run)
+      : run_(run), offset_(0), pos_(0), valid_(false) {}
+
+  Status Open(Env* env, const EnvOptions& env_options,
+              const Comparator* ucmp, const Slice* lower) {
+    Status s = env->NewRandomAccessFile(run_->file_name, &file_, env_options);
+    if (!s.ok()) {
+      return s;
+    }
+    if (lower != nullptr) {
+      // Records of an index entry are not less than its key
+      auto it = std::upper_bound(
+          run_->index.begin(), run_->index.end(), *lower,
+          [ucmp](const Slice& k, const std::pair<std::string, uint64_t>& e) {
+            return ucmp->Compare(k, e.first) < 0;
+          });
+      if (it != run_->index.begin()) {
+        offset_ = (it - 1)->second;
+      }
+    }
+    s = Next();
+    while (s.ok() && valid_ && lower != nullptr &&
+           ucmp->Compare(key_, *lower) < 0) {
+      s = Next();
+    }
+    return s;
+  }
+
+  bool Valid() const { return valid_; }
+  const Slice& key() const { return key_; }
+  const Slice& value() const { return value_; }
+
+  Status Next() {
+    if (pos_ == buf_.size() && offset_ == run_->file_size) {
+      valid_ = false;
+      return Status::OK();
+    }
+    Status s = Fill(10);
+    if (!s.ok()) {
+      return s;
+    }
+    const char* p = buf_.data() + pos_;
+    const char* limit = buf_.data() + buf_.size();
+    uint32_t key_size = 0;
+    uint32_t value_size = 0;
+    const char* data = GetVarint32Ptr(p, limit, &key_size);
+    if (data != nullptr) {
+      data = GetVarint32Ptr(data, limit, &value_size);
+    }
+    if (data == nullptr) {
+      return Status::Corruption("Bad record", run_->file_name);
+    }
+    size_t header_size = data - p;
+    size_t record_size = header_size + key_size + value_size;
+    s = Fill(record_size);
+    if (!s.ok()) {
+      return s;
+    }
+    if (buf_.size() - pos_ < record_size) {
+      return Status::Corruption("Truncated record", run_->file_name);
+    }
+    data = buf_.data() + pos_ + header_size;
+    key_ = Slice(data, key_size);
+    value_ = Slice(data + key_size, value_size);
+    pos_ += record_size;
+    valid_ = true;
+    return Status::OK();
+  }
+
+ private:
+  // Makes n bytes available from pos_, unless the file ends before
+  Status Fill(size_t n) {
+    if (buf_.size() - pos_ >= n || offset_ == run_->file_size) {
+      return Status::OK();
+    }
+    buf_.erase(0, pos_);
+    pos_ = 0;
+    size_t size = static_cast<size_t>(
+        std::min<uint64_t>(std::max(n - buf_.size(), kReadBufferSize),
+                           run_->file_size - offset_));
+    scratch_.resize(size);
+    Slice result;
+    Status s = file_->Read(offset_, size, &result, &scratch_[0]);
+    if (!s.ok()) {
+      return s;
+    }
+    if (result.size() != size) {
+      return Status::Corruption("Unexpected end of file", run_->file_name);
+    }
+    buf_.append(result.data(), result.size());
+    offset_ += size;
+    return Status::OK();
+  }
+
+  const SortedRun* run_;
+  std::unique_ptr<RandomAccessFile> file_;
+  uint64_t offset_;
+  std::string buf_;
+  std::string scratch_;
+  size_t pos_;
+  Slice key_;
+  Slice value_;
+  bool valid_;
+};
+
+struct RunReaderGreater {
+  const Comparator* ucmp;
+  bool operator()(const RunReader* a, const RunReader* b) const {
+    return ucmp->Compare(a->key(), b->key()) > 0;
+  }
+};
+
+// Merges the records of runs in [lower, upper) into key order, a key found
+// in more than one run fails Next
+class RunMerger {
+ public:
+  explicit RunMerger(const Comparator* ucmp)
+      : ucmp_(ucmp), heap_(RunReaderGreater{ucmp}) {}
+
+  // lower and upper are not bounds if null
+  Status Open(Env* env, const EnvOptions& env_options,
+              const std::vector<const SortedRun*>& runs, const Slice* lower,
+              const Slice* upper) {
+    upper_ = upper;
+    for (auto run : runs) {
+      readers_.emplace_back(new RunReader(run));
+      RunReader* reader = readers_.back().get();
+      Status s = reader->Open(env, env_options, ucmp_, lower);
+      if (!s.ok()) {
+        return s;
+      }
+      if (InRange(reader)) {
+        heap_.push(reader);
+      }
+    }
+    return Status::OK();
+  }
+
+  bool Valid() const { return !heap_.empty(); }
+  const Slice& key() const { return heap_.top()->key(); }
+  const Slice& value() const { return heap_.top()->value(); }
+
+  Status Next() {
+    RunReader* reader = heap_.top();
+    prev_key_.assign(reader->key().data(), reader->key().size());
+    Status s = reader->Next();
+    if (!s.ok()) {
+      return s;
+    }
+    if (InRange(reader)) {
+      heap_.replace_top(reader);
+    } else {
+      heap_.pop();
+    }
+    if (Valid() && ucmp_->Compare(prev_key_, key()) == 0) {
+      return DuplicateKey(key());
+    }
+    return Status::OK();
+  }
+
+ private:
+  bool InRange(const RunReader* reader) const {
+    return reader->Valid() &&
+           (upper_ == nullptr || ucmp_->Compare(reader->key(), *upper_) < 0);
+  }
+
+  const Comparator* ucmp_;
+  const Slice* upper_ = nullptr;
+  std::vector<std::unique_ptr<RunReader>> readers_;
+  BinaryHeap<RunReader*, RunReaderGreater> heap_;
+  std::string prev_key_;
+};
+
+class BulkLoaderImpl : public BulkLoader {
+ public:
+  BulkLoaderImpl(DB* db, ColumnFamilyHandle* column_family,
+                 const BulkLoaderOptions& options)
+      : db_(db),
+        column_family_(column_family),
+        options_(options),
+        cf_options_(db->GetOptions(column_family)),
+        env_options_(db->GetDBOptions()),
+        env_(db->GetEnv()),
+        open_streams_(0),
+        next_file_number_(0),
+        finished_(false) {
+    if (options_.work_dir.empty()) {
+      options_.work_dir = db->GetName() + "/bulk_load";
+    }
+  }
+
+  ~BulkLoaderImpl() {
+    if (!finished_) {
+      DeleteWorkFiles();
+    }
+  }
+
+  Status Init() { return env_->CreateDirIfMissing(options_.work_dir); }
+
+  Status NewStream(std::unique_ptr<Stream>* stream) override;
+
+  Status Finish() override;
+
+  const Comparator* ucmp() const { return cf_options_.comparator; }
+
+  size_t sort_buffer_size() const { return options_.sort_buffer_size; }
+
+  Status NewRunFile(std::string* file_name,
+                    std::unique_ptr<WritableFile>* file) {
+    *file_name = NewFileName(".run");
+    return env_->NewWritableFile(*file_name, file, env_options_);
+  }
+
+  // Takes over the runs of a closed stream
+  void CloseStream(std::vector<SortedRun>* runs) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& run : *runs) {
+      runs_.emplace_back(std::move(run));
+    }
+    --open_streams_;
+  }
+
+  // Deletes the runs of a stream which is not loaded
+  void DiscardStream(std::vector<SortedRun>* runs) {
+    for (auto& run : *runs) {
+      env_->DeleteFile(run.file_name);
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    --open_streams_;
+  }
+
+ private:
+  struct Partition {
+    // Not bounded if null
+    const std::string* lower = nullptr;
+    const std::string* upper = nullptr;
+    std::vector<std::string> files;
+    Status status;
+  };
+
+  std::string NewFileName(const char* suffix) {
+    std::string file_name = options_.work_dir + "/" +
+                            ToString(next_file_number_.fetch_add(1)) + suffix;
+    std::lock_guard<std::mutex> lock(mutex_);
+    work_files_.push_back(file_name);
+    return file_name;
+  }
+
+  // Calls work(i) for i in [0, n) on the calling thread and on up to
+  // num_threads - 1 tasks in the LOW priority pool of env_
+  void RunInParallel(size_t n, const std::function<void(size_t)>& work);
+
+  // Merges groups of runs until at most max_merge_width are left
+  Status ReduceRuns();
+
+  Status MergeRuns(const std::vector<const SortedRun*>& runs,
+                   SortedRun* output);
+
+  // Splits the key space into about equal byte sizes of the runs
+  void ChooseBoundaries(std::vector<std::string>* boundaries) const;
+
+  void MergePartition(Partition* partition);
+
+  Status OpenWriter(SstFileWriter* writer);
+
+  Status FinishWriter(SstFileWriter* writer, Partition* partition);
+
+  void DeleteWorkFiles();
+
+  DB* db_;
+  ColumnFamilyHandle* column_family_;
+  BulkLoaderOptions options_;
+  const Options cf_options_;
+  const EnvOptions env_options_;
+  Env* env_;
+
+  std::mutex mutex_;
+  std::vector<SortedRun> runs_;
+  std::vector<std::string> work_files_;
+  int open_streams_;
+  std::atomic<uint64_t> next_file_number_;
+  bool finished_;
+};
+
+class StreamImpl : public BulkLoader::Stream {
+ public:
+  explicit StreamImpl(BulkLoaderImpl* loader)
+      : loader_(loader), sorted_(true), closed_(false) {}
+
+  ~StreamImpl() override {
+    if (!closed_) {
+      loader_->DiscardStream(&runs_);
+    }
+  }
+
+  Status Put(const Slice& key, const Slice& value) override {
+    if (closed_) {
+      return Status::InvalidArgument("Stream is closed");
+    }
+    if (!status_.ok()) {
+      return status_;
+    }
+    size_t record_size = key.size() + value.size() + 10;
+    if (!offsets_.empty() &&
+        data_.size() + offsets_.size() * sizeof(size_t) + record_size >
+            loader_->sort_buffer_size()) {
+      status_ = Spill();
+      if (!status_.ok()) {
+        return status_;
+      }
+    }
+    if (sorted_ && !offsets_.empty()) {
+      Slice last_key, last_value;
+      DecodeRecord(data_.data() + offsets_.back(), &last_key, &last_value);
+      int c = loader_->ucmp()->Compare(last_key, key);
+      if (c == 0) {
+        return DuplicateKey(key);
+      }
+      sorted_ = c < 0;
+    }
+    offsets_.push_back(data_.size());
+    PutVarint32Varint32(&data_, static_cast<uint32_t>(key.size()),
+                        static_cast<uint32_t>(value.size()));
+    data_.append(key.data(), key.size());
+    data_.append(value.data(), value.size());
+    return Status::OK();
+  }
+
+  Status Close() override {
+    if (closed_) {
+      return Status::InvalidArgument("Stream is closed");
+    }
+    if (status_.ok() && !offsets_.empty()) {
+      status_ = Spill();
+    }
+    closed_ = true;
+    if (status_.ok()) {
+      loader_->CloseStream(&runs_);
+    } else {
+      loader_->DiscardStream(&runs_);
+    }
+    return status_;
+  }
+
+ private:
+  Slice KeyAt(size_t offset) const {
+    Slice key, value;
+    DecodeRecord(data_.data() + offset, &key, &value);
+    return key;
+  }
+
+  // Sorts the buffer into a new run file
+  Status Spill() {
+    const Comparator* ucmp = loader_->ucmp();
+    if (!sorted_) {
+      std::sort(offsets_.begin(), offsets_.end(), [&](size_t a, size_t b) {
+        return ucmp->Compare(KeyAt(a), KeyAt(b)) < 0;
+      });
+    }
+    std::string file_name;
+    std::unique_ptr<WritableFile> file;
+    Status s = loader_->NewRunFile(&file_name, &file);
+    if (s.ok()) {
+      RunWriter writer(std::move(file_name), std::move(file));
+      Slice prev_key;
+      for (size_t i = 0; s.ok() && i < offsets_.size(); ++i) {
+        Slice key, value;
+        DecodeRecord(data_.data() + offsets_[i], &key, &value);
+        if (i > 0 && ucmp->Compare(prev_key, key) == 0) {
+          s = DuplicateKey(key);
+          break;
+        }
+        s = writer.Add(key, value);
+        prev_key = key;
+      }
+      SortedRun run;
+      if (s.ok()) {
+        s = writer.Finish(&run);
+      }
+      if (s.ok()) {
+        runs_.emplace_back(std::move(run));
+      }
+    }
+    data_.clear();
+    offsets_.clear();
+    sorted_ = true;
+    return s;
+  }
+
+  BulkLoaderImpl* loader_;
+  // Encoded like the records of a run file
+  std::string data_;
+  std::vector<size_t> offsets_;
+  // Handed over to the loader on Close
+  std::vector<SortedRun> runs_;
+  bool sorted_;
+  bool closed_;
+  Status status_;
+};
+
+Status BulkLoaderImpl::NewStream(std::unique_ptr<Stream>* stream) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (finished_) {
+    return Status::InvalidArgument("BulkLoader is finished");
+  }
+  ++open_streams_;
+  stream->reset(new StreamImpl(this));
+  return Status::OK();
+}
+
+void BulkLoaderImpl::ChooseBoundaries(
+    std::vector<std::string>* boundaries) const {
+  struct Sample {
+    Slice key;
+    uint64_t size;
+  };
+  std::vector<Sample> samples;
+  uint64_t total_size = 0;
+  for (auto& run : runs_) {
+    for (size_t i = 0; i < run.index.size(); ++i) {
+      uint64_t end = i + 1 < run.index.size() ? run.index[i + 1].second
+                                              : run.file_size;
+      samples.push_back({run.index[i].first, end - run.index[i].second});
+      total_size += samples.back().size;
+    }
+  }
+  const Comparator* cmp = ucmp();
+  std::sort(samples.begin(), samples.end(),
+            [cmp](const Sample& a, const Sample& b) {
+              return cmp->Compare(a.key, b.key) < 0;
+            });
+  // A few partitions per thread even out the skew of the samples
+  uint64_t num_partitions = std::min<uint64_t>(
+      uint64_t(options_.num_threads) * 4, samples.size());
+  uint64_t partition_size =
+      std::max<uint64_t>(1, total_size / std::max<uint64_t>(1, num_partitions));
+  uint64_t size = 0;
+  for (auto& sample : samples) {
+    if (size >= partition_size * (boundaries->size() + 1) &&
+        (boundaries->empty() ||
+         cmp->Compare(boundaries->back(), sample.key) < 0)) {
+      boundaries->push_back(sample.key.ToString());
+    }
+    size += sample.size;
+  }
+}
+
+Status BulkLoaderImpl::OpenWriter(SstFileWriter* writer) {
+  std::string file_name = NewFileName(".sst");
+  if (options_.separate_values) {
+    return writer->Open(file_name, NewFileName(".sst"));
+  }
+  return writer->Open(file_name);
+}
+
+Status BulkLoaderImpl::FinishWriter(SstFileWriter* writer,
+                                    Partition* partition) {
+  ExternalSstFileInfo file_info;
+  Status s = writer->Finish(&file_info);
+  if (s.ok()) {
+    partition->files.push_back(file_info.file_path);
+    if (!file_info.blob_file_path.empty()) {
+      partition->files.push_back(file_info.blob_file_path);
+    }
+  }
+  return s;
+}
+
+void BulkLoaderImpl::MergePartition(Partition* partition) {
+  Slice lower, upper;
+  if (partition->lower != nullptr) {
+    lower = *partition->lower;
+  }
+  if (partition->upper != nullptr) {
+    upper = *partition->upper;
+  }
+  std::vector<const SortedRun*> runs;
+  for (auto& run : runs_) {
+    runs.push_back(&run);
+  }
+  RunMerger merger(ucmp());
+  Status s = merger.Open(env_, env_options_, runs,
+                         partition->lower != nullptr ? &lower : nullptr,
+                         partition->upper != nullptr ? &upper : nullptr);
+
+  SstFileWriter writer(env_options_, cf_options_, column_family_);
+  bool writer_open = false;
+  for (; s.ok() && merger.Valid(); s = merger.Next()) {
+    if (!writer_open) {
+      s = OpenWriter(&writer);
+      if (!s.ok()) {
+        break;
+      }
+      writer_open = true;
+    }
+    s = writer.Put(merger.key(), merger.value());
+    if (!s.ok()) {
+      break;
+    }
+    if (writer.FileSize() >= options_.target_file_size) {
+      s = FinishWriter(&writer, partition);
+      writer_open = false;
+      if (!s.ok()) {
+        break;
+      }
+    }
+  }
+  if (s.ok() && writer_open) {
+    s = FinishWriter(&writer, partition);
+  }
+  partition->status = s;
+}
+
+void BulkLoaderImpl::RunInParallel(size_t n,
+                                   const std::function<void(size_t)>& work) {
+  if (n == 0) {
+    return;
+  }
+  struct Context {
+    const std::function<void(size_t)>* work;
+    size_t n;
+    std::atomic<size_t> next;
+    std::mutex mutex;
+    std::condition_variable cv;
+    size_t pending_tasks;
+
+    void Run() {
+      for (size_t i; (i = next.fetch_add(1)) < n;) {
+        (*work)(i);
+      }
+    }
+    void Done() {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (--pending_tasks == 0) {
+        cv.notify_all();
+      }
+    }
+    static void BGWork(void* arg) {
+      Context* ctx = static_cast<Context*>(arg);
+      ctx->Run();
+      ctx->Done();
+    }
+    static void UnscheduleWork(void* arg) {
+      static_cast<Context*>(arg)->Done();
+    }
+  };
+  Context ctx;
+  ctx.work = &work;
+  ctx.n = n;
+  ctx.next = 0;
+  ctx.pending_tasks =
+      std::min<size_t>(std::max(options_.num_threads, 1), n) - 1;
+  for (size_t i = 0; i < ctx.pending_tasks; ++i) {
+    env_->Schedule(&Context::BGWork, &ctx, Env::Priority::LOW, &ctx,
+                   &Context::UnscheduleWork);
+  }
+  ctx.Run();
+  // Tasks which have not started yet would find nothing left to do, don't
+  // wait for the pool to get to them
+  env_->UnSchedule(&ctx, Env::Priority::LOW);
+  std::unique_lock<std::mutex> lock(ctx.mutex);
+  ctx.cv.wait(lock, [&ctx] { return ctx.pending_tasks == 0; });
+}
+
+Status BulkLoaderImpl::MergeRuns(const std::vector<const SortedRun*>& runs,
+                                 SortedRun* output) {
+  std::string file_name;
+  std::unique_ptr<WritableFile> file;
+  Status s = NewRunFile(&file_name, &file);
+  if (!s.ok()) {
+    return s;
+  }
+  RunWriter writer(std::move(file_name), std::move(file));
+  RunMerger merger(ucmp());
+  s = merger.Open(env_, env_options_, runs, nullptr, nullptr);
+  for (; s.ok() && merger.Valid(); s = merger.Next()) {
+    s = writer.Add(merger.key(), merger.value());
+    if (!s.ok()) {
+      break;
+    }
+  }
+  if (s.ok()) {
+    s = writer.Finish(output);
+  }
+  return s;
+}
+
+Status BulkLoaderImpl::ReduceRuns() {
+  const size_t width = std::max<size_t>(options_.max_merge_width, 2);
+  while (runs_.size() > width) {
+    size_t num_groups = (runs_.size() + width - 1) / width;
+    std::vector<SortedRun> merged(num_groups);
+    std::vector<Status> statuses(num_groups);
+    RunInParallel(num_groups, [&](size_t i) {
+      size_t begin = i * width;
+      size_t end = std::min(begin + width, runs_.size());
+      if (end - begin == 1) {
+        merged[i] = std::move(runs_[begin]);
+        runs_[begin].file_name.clear();
+        return;
+      }
+      std::vector<const SortedRun*> group;
+      for (size_t j = begin; j < end; ++j) {
+        group.push_back(&runs_[j]);
+      }
+      statuses[i] = MergeRuns(group, &merged[i]);
+    });
+    for (auto& s : statuses) {
+      if (!s.ok()) {
+        return s;
+      }
+    }
+    for (auto& run : runs_) {
+      if (!run.file_name.empty()) {
+        env_->DeleteFile(run.file_name);
+      }
+    }
+    runs_.swap(merged);
+  }
+  return Status::OK();
+}
+
+Status BulkLoaderImpl::Finish() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (finished_) {
+      return Status::InvalidArgument("BulkLoader is finished");
+    }
+    if (open_streams_ > 0) {
+      return Status::InvalidArgument("Not all streams are closed");
+    }
+    finished_ = true;
+  }
+  uint64_t start_micros = env_->NowMicros();
+  size_t num_runs = runs_.size();
+
+  Status s = ReduceRuns();
+  std::vector<std::string> boundaries;
+  if (s.ok()) {
+    ChooseBoundaries(&boundaries);
+  }
+  std::vector<Partition> partitions(!s.ok() || runs_.empty()
+                                        ? 0
+                                        : boundaries.size() + 1);
+  for (size_t i = 0; i < partitions.size(); ++i) {
+    if (i > 0) {
+      partitions[i].lower = &boundaries[i - 1];
+    }
+    if (i < boundaries.size()) {
+      partitions[i].upper = &boundaries[i];
+    }
+  }
+
+  RunInParallel(partitions.size(),
+                [&](size_t i) { MergePartition(&partitions[i]); });
+
+  std::vector<std::string> files;
+  for (auto& partition : partitions) {
+    if (!partition.status.ok()) {
+      s = partition.status;
+      break;
+    }
+    files.insert(files.end(), partition.files.begin(), partition.files.end());
+  }
+  if (s.ok() && !files.empty()) {
+    s = db_->IngestExternalFile(column_family_, files,
+                                options_.ingest_options);
+  }
+  ROCKS_LOG_INFO(cf_options_.info_log,
+                 "[BulkLoader] %" ROCKSDB_PRIszt " runs, %" ROCKSDB_PRIszt
+                 " partitions, %" ROCKSDB_PRIszt
+                 " files ingested in %" PRIu64 " us: %s",
+                 num_runs, partitions.size(), files.size(),
+                 env_->NowMicros() - start_micros, s.ToString().c_str());
+  DeleteWorkFiles();
+  return s;
+}
+
+void BulkLoaderImpl::DeleteWorkFiles() {
+  // Moved files are gone already
+  for (auto& file_name : work_files_) {
+    env_->DeleteFile(file_name);
+  }
+  work_files_.clear();
+  runs_.clear();
+  // Fails if the directory is shared with other files
+  env_->DeleteDir(options_.work_dir);
+}
+
+}  // namespace
+
+Status BulkLoader::Create(DB* db, ColumnFamilyHandle* column_family,
+                          const BulkLoaderOptions& options,
+                          std::unique_ptr<BulkLoader>* loader) {
+  if (options.sort_buffer_size == 0 || options.target_file_size == 0) {
+    return Status::InvalidArgument(
+        "sort_buffer_size and target_file_size must be positive");
+  }
+  if (column_family == nullptr) {
+    column_family = db->DefaultColumnFamily();
+  }
+  std::unique_ptr<BulkLoaderImpl> impl(
+      new BulkLoaderImpl(db, column_family, options));
+  Status s = impl->Init();
+  if (s.ok()) {
+    loader->reset(impl.release());
+  }
+  return s;
+}
+
+}  // namespace TERARKDB_NAMESPACE
+
+#endif  // !ROCKSDB_LITE
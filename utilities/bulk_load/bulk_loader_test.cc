@@ -0,0 +1,225 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#ifndef ROCKSDB_LITE
+
+#include "rocksdb/utilities/bulk_loader.h"
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "port/stack_trace.h"
+#include "rocksdb/db.h"
+#include "rocksdb/env.h"
+#include "rocksdb/metadata.h"
+#include "rocksdb/terark_namespace.h"
+#include "util/testharness.h"
+#include "util/testutil.h"
+
+namespace TERARKDB_NAMESPACE {
+
+class BulkLoaderTest : public testing::Test {
+ public:
+  BulkLoaderTest() : env_(Env::Default()), db_(nullptr) {
+    dbname_ = test::PerThreadDBPath(env_, "bulk_loader_test");
+    options_.env = env_;
+    options_.create_if_missing = true;
+    EXPECT_OK(DestroyDB(dbname_, options_));
+    EXPECT_OK(DB::Open(options_, dbname_, &db_));
+    loader_options_.sort_buffer_size = 16 << 10;
+    loader_options_.target_file_size = 32 << 10;
+    loader_options_.work_dir = dbname_ + "_work";
+  }
+
+  ~BulkLoaderTest() {
+    delete db_;
+    EXPECT_OK(DestroyDB(dbname_, options_));
+  }
+
+  static std::string Key(int i) {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "key%08d", i);
+    return buf;
+  }
+
+  static std::string Value(int i) { return Key(i) + std::string(50, 'v'); }
+
+  // Feeds keys [0, num_keys) in random order through num_streams streams
+  void Load(BulkLoader* loader, int num_keys, int num_streams) {
+    std::vector<int> keys(num_keys);
+    for (int i = 0; i < num_keys; ++i) {
+      keys[i] = i;
+    }
+    std::shuffle(keys.begin(), keys.end(), std::mt19937(301));
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_streams; ++t) {
+      threads.emplace_back([&, t] {
+        std::unique_ptr<BulkLoader::Stream> stream;
+        ASSERT_OK(loader->NewStream(&stream));
+        for (int i = t; i < num_keys; i += num_streams) {
+          ASSERT_OK(stream->Put(Key(keys[i]), Value(keys[i])));
+        }
+        ASSERT_OK(stream->Close());
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+
+  std::string Get(const std::string& key) {
+    std::string value;
+    Status s = db_->Get(ReadOptions(), key, &value);
+    return s.ok() ? value : s.ToString();
+  }
+
+  Env* env_;
+  std::string dbname_;
+  Options options_;
+  BulkLoaderOptions loader_options_;
+  DB* db_;
+};
+
+TEST_F(BulkLoaderTest, LoadUnsortedStreams) {
+  const int kNumKeys = 20000;
+  std::unique_ptr<BulkLoader> loader;
+  ASSERT_OK(BulkLoader::Create(db_, nullptr, loader_options_, &loader));
+  Load(loader.get(), kNumKeys, 4);
+  ASSERT_OK(loader->Finish());
+  loader.reset();
+
+  for (int i = 0; i < kNumKeys; ++i) {
+    ASSERT_EQ(Value(i), Get(Key(i)));
+  }
+  // Only the bottommost level has files, which don't overlap
+  ColumnFamilyMetaData meta;
+  db_->GetColumnFamilyMetaData(&meta);
+  size_t num_files = 0;
+  for (auto& level : meta.levels) {
+    if (level.level + 1 < options_.num_levels) {
+      ASSERT_EQ(0U, level.files.size());
+    } else {
+      num_files = level.files.size();
+    }
+  }
+  ASSERT_GT(num_files, 1U);
+  ASSERT_TRUE(env_->FileExists(loader_options_.work_dir).IsNotFound());
+}
+
+TEST_F(BulkLoaderTest, LoadSortedStream) {
+  const int kNumKeys = 5000;
+  std::unique_ptr<BulkLoader> loader;
+  ASSERT_OK(BulkLoader::Create(db_, nullptr, loader_options_, &loader));
+  std::unique_ptr<BulkLoader::Stream> stream;
+  ASSERT_OK(loader->NewStream(&stream));
+  for (int i = 0; i < kNumKeys; ++i) {
+    ASSERT_OK(stream->Put(Key(i), Value(i)));
+  }
+  // Detected without sorting
+  ASSERT_TRUE(stream->Put(Key(kNumKeys - 1), "dup").IsInvalidArgument());
+  ASSERT_OK(stream->Close());
+  ASSERT_OK(loader->Finish());
+  for (int i = 0; i < kNumKeys; ++i) {
+    ASSERT_EQ(Value(i), Get(Key(i)));
+  }
+}
+
+TEST_F(BulkLoaderTest, DuplicateKey) {
+  std::unique_ptr<BulkLoader> loader;
+  ASSERT_OK(BulkLoader::Create(db_, nullptr, loader_options_, &loader));
+  Load(loader.get(), 1000, 2);
+  std::unique_ptr<BulkLoader::Stream> stream;
+  ASSERT_OK(loader->NewStream(&stream));
+  ASSERT_OK(stream->Put(Key(500), "dup"));
+  ASSERT_TRUE(loader->Finish().IsInvalidArgument());
+  ASSERT_OK(stream->Close());
+  ASSERT_TRUE(loader->Finish().IsInvalidArgument());
+  loader.reset();
+
+  ASSERT_EQ("NotFound: ", Get(Key(0)));
+  ASSERT_TRUE(env_->FileExists(loader_options_.work_dir).IsNotFound());
+}
+
+TEST_F(BulkLoaderTest, MoreRunsThanMergeWidth) {
+  const int kNumKeys = 20000;
+  // About 80 runs of 16KB, merged 3 at a time in several passes
+  loader_options_.max_merge_width = 3;
+  std::unique_ptr<BulkLoader> loader;
+  ASSERT_OK(BulkLoader::Create(db_, nullptr, loader_options_, &loader));
+  Load(loader.get(), kNumKeys, 4);
+  ASSERT_OK(loader->Finish());
+  loader.reset();
+
+  for (int i = 0; i < kNumKeys; ++i) {
+    ASSERT_EQ(Value(i), Get(Key(i)));
+  }
+  ASSERT_TRUE(env_->FileExists(loader_options_.work_dir).IsNotFound());
+}
+
+TEST_F(BulkLoaderTest, DuplicateKeyAcrossMergePasses) {
+  loader_options_.max_merge_width = 2;
+  std::unique_ptr<BulkLoader> loader;
+  ASSERT_OK(BulkLoader::Create(db_, nullptr, loader_options_, &loader));
+  Load(loader.get(), 5000, 4);
+  std::unique_ptr<BulkLoader::Stream> stream;
+  ASSERT_OK(loader->NewStream(&stream));
+  ASSERT_OK(stream->Put(Key(10), "dup"));
+  ASSERT_OK(stream->Close());
+  ASSERT_TRUE(loader->Finish().IsInvalidArgument());
+  loader.reset();
+
+  ASSERT_EQ("NotFound: ", Get(Key(0)));
+  ASSERT_TRUE(env_->FileExists(loader_options_.work_dir).IsNotFound());
+}
+
+TEST_F(BulkLoaderTest, StreamNotClosed) {
+  std::unique_ptr<BulkLoader> loader;
+  ASSERT_OK(BulkLoader::Create(db_, nullptr, loader_options_, &loader));
+  std::unique_ptr<BulkLoader::Stream> stream;
+  ASSERT_OK(loader->NewStream(&stream));
+  // Spills a few runs before it is dropped
+  for (int i = 0; i < 2000; ++i) {
+    ASSERT_OK(stream->Put(Key(i), Value(i)));
+  }
+  ASSERT_TRUE(loader->Finish().IsInvalidArgument());
+  stream.reset();
+
+  ASSERT_OK(loader->NewStream(&stream));
+  for (int i = 2000; i < 3000; ++i) {
+    ASSERT_OK(stream->Put(Key(i), Value(i)));
+  }
+  ASSERT_OK(stream->Close());
+  ASSERT_OK(loader->Finish());
+  loader.reset();
+
+  ASSERT_EQ("NotFound: ", Get(Key(0)));
+  ASSERT_EQ("NotFound: ", Get(Key(1999)));
+  for (int i = 2000; i < 3000; ++i) {
+    ASSERT_EQ(Value(i), Get(Key(i)));
+  }
+  ASSERT_TRUE(env_->FileExists(loader_options_.work_dir).IsNotFound());
+}
+
+}  // namespace TERARKDB_NAMESPACE
+
+int main(int argc, char** argv) {
+  TERARKDB_NAMESPACE::port::InstallStackTraceHandler();
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
+
+#else
+#include <stdio.h>
+
+int main(int /*argc*/, char** /*argv*/) {
+  fprintf(stderr, "SKIPPED as BulkLoader is not supported in ROCKSDB_LITE\n");
+  return 0;
+}
+
+#endif  // !ROCKSDB_LITE
@@ -92,6 +92,7 @@ void PessimisticTransaction::Initialize(const TransactionOptions& txn_options) {
 
 PessimisticTransaction::~PessimisticTransaction() {
   txn_db_impl_->UnLock(this, &GetTrackedKeys());
+  UnLockRanges();
   if (expiration_time_ > 0) {
     txn_db_impl_->RemoveExpirableTransaction(txn_id_);
   }
@@ -102,9 +103,17 @@ PessimisticTransaction::~PessimisticTransaction() {
 
 void PessimisticTransaction::Clear() {
   txn_db_impl_->UnLock(this, &GetTrackedKeys());
+  UnLockRanges();
   TransactionBaseImpl::Clear();
 }
 
+void PessimisticTransaction::UnLockRanges() {
+  for (auto cfh_id : range_lock_cfs_) {
+    txn_db_impl_->UnLockRanges(this, cfh_id);
+  }
+  range_lock_cfs_.clear();
+}
+
 void PessimisticTransaction::Reinitialize(
     TransactionDB* txn_db, const WriteOptions& write_options,
     const TransactionOptions& txn_options) {
@@ -611,6 +620,22 @@ Status PessimisticTransaction::TryLock(ColumnFamilyHandle* column_family,
   return s;
 }
 
+Status PessimisticTransaction::GetRangeLock(ColumnFamilyHandle* column_family,
+                                            const Slice& start,
+                                            const Slice& end) {
+  if (UNLIKELY(skip_concurrency_control_)) {
+    return Status::OK();
+  }
+  uint32_t cfh_id = GetColumnFamilyID(column_family);
+  Status s = txn_db_impl_->TryRangeLock(this, cfh_id, start.ToString(),
+                                        end.ToString());
+  if (s.ok() && std::find(range_lock_cfs_.begin(), range_lock_cfs_.end(),
+                          cfh_id) == range_lock_cfs_.end()) {
+    range_lock_cfs_.push_back(cfh_id);
+  }
+  return s;
+}
+
 // Return OK() if this key has not been modified more recently than the
 // transaction snapshot_.
 // tracked_at_seq is the global seq at which we either locked the key or already
@@ -61,6 +61,9 @@ class PessimisticTransaction : public TransactionBaseImpl {
 
   Status SetName(const TransactionName& name) override;
 
+  Status GetRangeLock(ColumnFamilyHandle* column_family, const Slice& start,
+                      const Slice& end) override;
+
   // Generate a new unique transaction identifier
   static TransactionID GenTxnID();
 
@@ -187,6 +190,12 @@ class PessimisticTransaction : public TransactionBaseImpl {
   // Refer to TransactionOptions::skip_concurrency_control
   bool skip_concurrency_control_;
 
+  // Column families this transaction holds range locks of
+  autovector<uint32_t> range_lock_cfs_;
+
+  // Releases the range locks, after the keys are unlocked
+  void UnLockRanges();
+
   virtual Status ValidateSnapshot(ColumnFamilyHandle* column_family,
                                   const Slice& key,
                                   SequenceNumber* tracked_at_seq);
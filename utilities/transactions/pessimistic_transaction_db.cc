@@ -345,7 +345,7 @@ Status TransactionDB::WrapStackableDB(
 // allocate a LockMap for it.
 void PessimisticTransactionDB::AddColumnFamily(
     const ColumnFamilyHandle* handle) {
-  lock_mgr_.AddColumnFamily(handle->GetID());
+  lock_mgr_.AddColumnFamily(handle);
 }
 
 Status PessimisticTransactionDB::CreateColumnFamily(
@@ -359,7 +359,7 @@ Status PessimisticTransactionDB::CreateColumnFamily(
 
   s = db_->CreateColumnFamily(options, column_family_name, handle);
   if (s.ok()) {
-    lock_mgr_.AddColumnFamily((*handle)->GetID());
+    lock_mgr_.AddColumnFamily(*handle);
     UpdateCFComparatorMap(*handle);
   }
 
@@ -397,6 +397,18 @@ void PessimisticTransactionDB::UnLock(PessimisticTransaction* txn,
   lock_mgr_.UnLock(txn, cfh_id, key, GetEnv());
 }
 
+Status PessimisticTransactionDB::TryRangeLock(PessimisticTransaction* txn,
+                                              uint32_t cfh_id,
+                                              const std::string& start,
+                                              const std::string& end) {
+  return lock_mgr_.TryRangeLock(txn, cfh_id, start, end, GetEnv());
+}
+
+void PessimisticTransactionDB::UnLockRanges(PessimisticTransaction* txn,
+                                            uint32_t cfh_id) {
+  lock_mgr_.UnLockRanges(txn, cfh_id);
+}
+
 // Used when wrapping DB write operations in a transaction
 Transaction* PessimisticTransactionDB::BeginInternalTransaction(
     const WriteOptions& options) {
@@ -84,6 +84,11 @@ class PessimisticTransactionDB : public TransactionDB {
   void UnLock(PessimisticTransaction* txn, uint32_t cfh_id,
               const std::string& key);
 
+  Status TryRangeLock(PessimisticTransaction* txn, uint32_t cfh_id,
+                      const std::string& start, const std::string& end);
+
+  void UnLockRanges(PessimisticTransaction* txn, uint32_t cfh_id);
+
   void AddColumnFamily(const ColumnFamilyHandle* handle);
 
   static TransactionDBOptions ValidateTxnDBOptions(
@@ -16,11 +16,15 @@
 #include <algorithm>
 #include <condition_variable>
 #include <functional>
+#include <map>
 #include <mutex>
+#include <set>
 #include <string>
 #include <vector>
 
 #include "monitoring/perf_context_imp.h"
+#include "rocksdb/comparator.h"
+#include "rocksdb/db.h"
 #include "rocksdb/slice.h"
 #include "rocksdb/terark_namespace.h"
 #include "rocksdb/utilities/transaction_db_mutex.h"
@@ -49,7 +53,33 @@ struct LockInfo {
         expiration_time(lock_info.expiration_time) {}
 };
 
-struct LockMapStripe {
+using LockedKeys = std::unordered_map<std::string, LockInfo>;
+
+// Orders the entries of LockedKeys by their user keys, also against a key
+struct LockedKeyLess {
+  using is_transparent = void;
+
+  const Comparator* ucmp;
+
+  bool operator()(const LockedKeys::value_type* a,
+                  const LockedKeys::value_type* b) const {
+    return ucmp->Compare(a->first, b->first) < 0;
+  }
+  bool operator()(const LockedKeys::value_type* a,
+                  const std::string& b) const {
+    return ucmp->Compare(a->first, b) < 0;
+  }
+  bool operator()(const std::string& a,
+                  const LockedKeys::value_type* b) const {
+    return ucmp->Compare(a, b->first) < 0;
+  }
+};
+
+// Stripes are cache aligned, so that transactions locking keys of different
+// stripes don't contend on the cache lines of the stripe latches.
+//
+// Alignment attributes expand to nothing depending on the platform
+struct ALIGN_AS(CACHE_LINE_SIZE) LockMapStripe {
   explicit LockMapStripe(std::shared_ptr<TransactionDBMutexFactory> factory) {
     stripe_mutex = factory->AllocateMutex();
     stripe_cv = factory->AllocateCondVar();
@@ -63,21 +93,78 @@ struct LockMapStripe {
   // Condition Variable per stripe for waiting on a lock
   std::shared_ptr<TransactionDBCondVar> stripe_cv;
 
+  // Number of transactions waiting on stripe_cv, unlocking a key of an
+  // uncontended stripe doesn't signal it. Guarded by stripe_mutex.
+  int num_waiters = 0;
+
   // Locked keys mapped to the info about the transactions that locked them.
   // TODO(agiardullo): Explore performance of other data structures.
-  std::unordered_map<std::string, LockInfo> keys;
+  LockedKeys keys;
+
+  // The entries of keys in key order, so that a range lock only visits the
+  // keys in its range. Built by the first range lock of the column family,
+  // point locks before don't pay for it. Guarded by stripe_mutex.
+  using OrderedKeys = std::set<const LockedKeys::value_type*, LockedKeyLess>;
+  std::unique_ptr<OrderedKeys> ordered_keys;
+
+  void IndexKeys(const Comparator* ucmp) {
+    if (ordered_keys == nullptr) {
+      ordered_keys.reset(new OrderedKeys(LockedKeyLess{ucmp}));
+      for (const auto& entry : keys) {
+        ordered_keys->insert(&entry);
+      }
+    }
+  }
+
+  void InsertKey(const std::string& key, const LockInfo& lock_info) {
+    auto inserted = keys.insert({key, lock_info});
+    if (ordered_keys != nullptr) {
+      ordered_keys->insert(&*inserted.first);
+    }
+  }
+
+  void EraseKey(LockedKeys::iterator stripe_iter) {
+    if (ordered_keys != nullptr) {
+      ordered_keys->erase(&*stripe_iter);
+    }
+    keys.erase(stripe_iter);
+  }
+
+  void* operator new(size_t s) { return port::cacheline_aligned_alloc(s); }
+  void operator delete(void* p) { port::cacheline_aligned_free(p); }
+};
+
+// Exclusive lock of the keys [start, end), start is the key of the map
+struct RangeLockInfo {
+  std::string end;
+  TransactionID txn_id;
+
+  // Transaction locks are not valid after this time in us
+  uint64_t expiration_time;
+};
+
+struct UserKeyLess {
+  const Comparator* ucmp;
+
+  bool operator()(const std::string& a, const std::string& b) const {
+    return ucmp->Compare(a, b) < 0;
+  }
 };
 
 // Map of #num_stripes LockMapStripes
 struct LockMap {
-  explicit LockMap(size_t num_stripes,
+  explicit LockMap(size_t num_stripes, const Comparator* ucmp,
                    std::shared_ptr<TransactionDBMutexFactory> factory)
-      : num_stripes_(num_stripes) {
+      : num_stripes_(num_stripes), ucmp_(ucmp), ranges(UserKeyLess{ucmp}) {
     lock_map_stripes_.reserve(num_stripes);
     for (size_t i = 0; i < num_stripes; i++) {
       LockMapStripe* stripe = new LockMapStripe(factory);
       lock_map_stripes_.push_back(stripe);
     }
+    range_mutex = factory->AllocateMutex();
+    range_cv = factory->AllocateCondVar();
+    assert(range_mutex);
+    assert(range_cv);
   }
 
   ~LockMap() {
@@ -95,6 +182,26 @@ struct LockMap {
 
   std::vector<LockMapStripe*> lock_map_stripes_;
 
+  // Orders the keys of the ranges
+  const Comparator* ucmp_;
+
+  // Mutex must be held before modifying ranges
+  std::shared_ptr<TransactionDBMutex> range_mutex;
+
+  // Condition Variable for waiting on a range lock
+  std::shared_ptr<TransactionDBCondVar> range_cv;
+
+  // Number of transactions waiting on range_cv. Guarded by range_mutex.
+  int num_range_waiters = 0;
+
+  // Locked ranges. Ranges of different transactions never overlap and the
+  // ranges of a transaction are merged, so the range containing a key is the
+  // last one starting at or before it.
+  std::map<std::string, RangeLockInfo, UserKeyLess> ranges;
+
+  // Size of ranges, point locks skip the range mutex while it is 0
+  std::atomic<size_t> num_ranges{0};
+
   size_t GetStripe(const std::string& key) const;
 };
 
@@ -156,6 +263,16 @@ std::vector<DeadlockPath> DeadlockInfoBuffer::PrepareBuffer() {
   return working;
 }
 
+struct ALIGN_AS(CACHE_LINE_SIZE) TransactionLockMgr::WaitGraphStripe {
+  // Must be held when modifying wait_txn_map and rev_wait_txn_map.
+  std::mutex mutex;
+
+  // Maps from waitee -> number of waiters.
+  HashMap<TransactionID, int, 32> rev_wait_txn_map;
+  // Maps from waiter -> waitee.
+  HashMap<TransactionID, TrackedTrxInfo, 32> wait_txn_map;
+};
+
 namespace {
 void UnrefLockMapsCache(void* ptr) {
   // Called when a thread exits or a ThreadLocalPtr gets destroyed.
@@ -178,9 +295,36 @@ TransactionLockMgr::TransactionLockMgr(
   assert(txn_db);
   txn_db_impl_ =
       static_cast_with_check<PessimisticTransactionDB, TransactionDB>(txn_db);
+  wait_graph_stripes_ =
+      reinterpret_cast<WaitGraphStripe*>(port::cacheline_aligned_alloc(
+          sizeof(WaitGraphStripe) << kWaitGraphStripeBits));
+  for (size_t i = 0; i < size_t(1) << kWaitGraphStripeBits; i++) {
+    new (&wait_graph_stripes_[i]) WaitGraphStripe();
+  }
+}
+
+TransactionLockMgr::~TransactionLockMgr() {
+  for (size_t i = 0; i < size_t(1) << kWaitGraphStripeBits; i++) {
+    wait_graph_stripes_[i].~WaitGraphStripe();
+  }
+  port::cacheline_aligned_free(wait_graph_stripes_);
+}
+
+TransactionLockMgr::WaitGraphStripe* TransactionLockMgr::GetWaitGraphStripe(
+    TransactionID id) const {
+  // Ids are sequential, spread them over the stripes and the buckets
+  return &wait_graph_stripes_[(id * 0x9e3779b97f4a7c15ULL) >>
+                              (64 - kWaitGraphStripeBits)];
 }
 
-TransactionLockMgr::~TransactionLockMgr() {}
+const TrackedTrxInfo* TransactionLockMgr::GetWaitingInfoLocked(
+    TransactionID waiter) const {
+  WaitGraphStripe* stripe = GetWaitGraphStripe(waiter);
+  if (!stripe->wait_txn_map.Contains(waiter)) {
+    return nullptr;
+  }
+  return &stripe->wait_txn_map.Get(waiter);
+}
 
 size_t LockMap::GetStripe(const std::string& key) const {
   assert(num_stripes_ > 0);
@@ -189,13 +333,16 @@ size_t LockMap::GetStripe(const std::string& key) const {
   return stripe;
 }
 
-void TransactionLockMgr::AddColumnFamily(uint32_t column_family_id) {
+void TransactionLockMgr::AddColumnFamily(
+    const ColumnFamilyHandle* column_family) {
   InstrumentedMutexLock l(&lock_map_mutex_);
 
+  uint32_t column_family_id = column_family->GetID();
   if (lock_maps_.find(column_family_id) == lock_maps_.end()) {
     lock_maps_.emplace(column_family_id,
-                       std::shared_ptr<LockMap>(
-                           new LockMap(default_num_stripes_, mutex_factory_)));
+                       std::shared_ptr<LockMap>(new LockMap(
+                           default_num_stripes_, column_family->GetComparator(),
+                           mutex_factory_)));
   } else {
     // column_family already exists in lock map
     assert(false);
@@ -354,51 +501,13 @@ Status TransactionLockMgr::AcquireWithTimeout(
     // as the timeout allows.
     bool timed_out = false;
     do {
-      // Decide how long to wait
-      int64_t cv_end_time = -1;
-
-      // Check if held lock's expiration time is sooner than our timeout
-      if (expire_time_hint > 0 &&
-          (timeout < 0 || (timeout > 0 && expire_time_hint < end_time))) {
-        // expiration time is sooner than our timeout
-        cv_end_time = expire_time_hint;
-      } else if (timeout >= 0) {
-        cv_end_time = end_time;
-      }
-
-      assert(result.IsBusy() || wait_ids.size() != 0);
-
-      // We are dependent on a transaction to finish, so perform deadlock
-      // detection.
-      if (wait_ids.size() != 0) {
-        if (txn->IsDeadlockDetect()) {
-          if (IncrementWaiters(txn, wait_ids, key, column_family_id,
-                               lock_info.exclusive, env)) {
-            result = Status::Busy(Status::SubCode::kDeadlock);
-            stripe->stripe_mutex->UnLock();
-            return result;
-          }
-        }
-        txn->SetWaitingTxn(wait_ids, column_family_id, &key);
-      }
-
-      TEST_SYNC_POINT("TransactionLockMgr::AcquireWithTimeout:WaitingTxn");
-      if (cv_end_time < 0) {
-        // Wait indefinitely
-        result = stripe->stripe_cv->Wait(stripe->stripe_mutex);
-      } else {
-        uint64_t now = env->NowMicros();
-        if (static_cast<uint64_t>(cv_end_time) > now) {
-          result = stripe->stripe_cv->WaitFor(stripe->stripe_mutex,
-                                              cv_end_time - now);
-        }
-      }
-
-      if (wait_ids.size() != 0) {
-        txn->ClearWaitingTxn();
-        if (txn->IsDeadlockDetect()) {
-          DecrementWaiters(txn, wait_ids);
-        }
+      result = WaitForLock(txn, stripe->stripe_mutex, stripe->stripe_cv.get(),
+                           &stripe->num_waiters, column_family_id, key,
+                           lock_info.exclusive, env, timeout, end_time,
+                           expire_time_hint, wait_ids);
+      if (result.IsDeadlock()) {
+        stripe->stripe_mutex->UnLock();
+        return result;
       }
 
       if (result.IsTimedOut()) {
@@ -420,24 +529,76 @@ Status TransactionLockMgr::AcquireWithTimeout(
   return result;
 }
 
-void TransactionLockMgr::DecrementWaiters(
-    const PessimisticTransaction* txn,
+Status TransactionLockMgr::WaitForLock(
+    PessimisticTransaction* txn,
+    const std::shared_ptr<TransactionDBMutex>& mutex,
+    TransactionDBCondVar* cv, int* num_waiters, uint32_t column_family_id,
+    const std::string& key, bool exclusive, Env* env, int64_t timeout,
+    uint64_t end_time, uint64_t expire_time_hint,
     const autovector<TransactionID>& wait_ids) {
-  std::lock_guard<std::mutex> lock(wait_txn_map_mutex_);
-  DecrementWaitersImpl(txn, wait_ids);
+  // Decide how long to wait
+  int64_t cv_end_time = -1;
+
+  // Check if held lock's expiration time is sooner than our timeout
+  if (expire_time_hint > 0 &&
+      (timeout < 0 || (timeout > 0 && expire_time_hint < end_time))) {
+    // expiration time is sooner than our timeout
+    cv_end_time = expire_time_hint;
+  } else if (timeout >= 0) {
+    cv_end_time = end_time;
+  }
+
+  // We are dependent on a transaction to finish, so perform deadlock
+  // detection.
+  if (wait_ids.size() != 0) {
+    if (txn->IsDeadlockDetect()) {
+      if (IncrementWaiters(txn, wait_ids, key, column_family_id, exclusive,
+                           env)) {
+        return Status::Busy(Status::SubCode::kDeadlock);
+      }
+    }
+    txn->SetWaitingTxn(wait_ids, column_family_id, &key);
+  }
+
+  TEST_SYNC_POINT("TransactionLockMgr::AcquireWithTimeout:WaitingTxn");
+  Status result = Status::TimedOut(Status::SubCode::kLockTimeout);
+  ++*num_waiters;
+  if (cv_end_time < 0) {
+    // Wait indefinitely
+    result = cv->Wait(mutex);
+  } else {
+    uint64_t now = env->NowMicros();
+    if (static_cast<uint64_t>(cv_end_time) > now) {
+      result = cv->WaitFor(mutex, cv_end_time - now);
+    }
+  }
+  --*num_waiters;
+
+  if (wait_ids.size() != 0) {
+    txn->ClearWaitingTxn();
+    if (txn->IsDeadlockDetect()) {
+      DecrementWaiters(txn, wait_ids);
+    }
+  }
+  return result;
 }
 
-void TransactionLockMgr::DecrementWaitersImpl(
+void TransactionLockMgr::DecrementWaiters(
     const PessimisticTransaction* txn,
     const autovector<TransactionID>& wait_ids) {
   auto id = txn->GetID();
-  assert(wait_txn_map_.Contains(id));
-  wait_txn_map_.Delete(id);
+  {
+    WaitGraphStripe* stripe = GetWaitGraphStripe(id);
+    std::lock_guard<std::mutex> lock(stripe->mutex);
+    assert(stripe->wait_txn_map.Contains(id));
+    stripe->wait_txn_map.Delete(id);
+  }
 
   for (auto wait_id : wait_ids) {
-    rev_wait_txn_map_.Get(wait_id)--;
-    if (rev_wait_txn_map_.Get(wait_id) == 0) {
-      rev_wait_txn_map_.Delete(wait_id);
+    WaitGraphStripe* stripe = GetWaitGraphStripe(wait_id);
+    std::lock_guard<std::mutex> lock(stripe->mutex);
+    if (--stripe->rev_wait_txn_map.Get(wait_id) == 0) {
+      stripe->rev_wait_txn_map.Delete(wait_id);
     }
   }
 }
@@ -447,36 +608,76 @@ bool TransactionLockMgr::IncrementWaiters(
     const autovector<TransactionID>& wait_ids, const std::string& key,
     const uint32_t& cf_id, const bool& exclusive, Env* const env) {
   auto id = txn->GetID();
-  std::vector<int> queue_parents(
-      static_cast<size_t>(txn->GetDeadlockDetectDepth()));
-  std::vector<TransactionID> queue_values(
-      static_cast<size_t>(txn->GetDeadlockDetectDepth()));
-  std::lock_guard<std::mutex> lock(wait_txn_map_mutex_);
-  assert(!wait_txn_map_.Contains(id));
-
-  wait_txn_map_.Insert(id, {wait_ids, cf_id, key, exclusive});
+  {
+    WaitGraphStripe* stripe = GetWaitGraphStripe(id);
+    std::lock_guard<std::mutex> lock(stripe->mutex);
+    assert(!stripe->wait_txn_map.Contains(id));
+    stripe->wait_txn_map.Insert(id, {wait_ids, cf_id, key, exclusive});
+  }
 
   for (auto wait_id : wait_ids) {
-    if (rev_wait_txn_map_.Contains(wait_id)) {
-      rev_wait_txn_map_.Get(wait_id)++;
+    WaitGraphStripe* stripe = GetWaitGraphStripe(wait_id);
+    std::lock_guard<std::mutex> lock(stripe->mutex);
+    if (stripe->rev_wait_txn_map.Contains(wait_id)) {
+      stripe->rev_wait_txn_map.Get(wait_id)++;
     } else {
-      rev_wait_txn_map_.Insert(wait_id, 1);
+      stripe->rev_wait_txn_map.Insert(wait_id, 1);
     }
   }
 
-  // No deadlock if nobody is waiting on self.
-  if (!rev_wait_txn_map_.Contains(id)) {
+  // No deadlock if nobody is waiting on self. The edges are published before
+  // this check, so of two transactions closing a cycle at the same time at
+  // least one sees the other.
+  if (!IsWaitedOn(id)) {
     return false;
   }
+  // The search runs on a consistent snapshot of the wait-for graph, with all
+  // the stripes held in ascending order, otherwise it could chain edges that
+  // never existed at the same time into a false deadlock
+  bool deadlock = false;
+  {
+    std::vector<std::unique_lock<std::mutex>> graph_locks;
+    graph_locks.reserve(size_t(1) << kWaitGraphStripeBits);
+    for (size_t i = 0; i < size_t(1) << kWaitGraphStripeBits; i++) {
+      graph_locks.emplace_back(wait_graph_stripes_[i].mutex);
+    }
+    if (GetWaitGraphStripe(id)->rev_wait_txn_map.Contains(id)) {
+      deadlock = DetectDeadlockLocked(txn, wait_ids, key, cf_id, exclusive,
+                                      env);
+    }
+  }
+  if (deadlock) {
+    DecrementWaiters(txn, wait_ids);
+  }
+  return deadlock;
+}
+
+bool TransactionLockMgr::IsWaitedOn(TransactionID id) const {
+  WaitGraphStripe* stripe = GetWaitGraphStripe(id);
+  std::lock_guard<std::mutex> lock(stripe->mutex);
+  return stripe->rev_wait_txn_map.Contains(id);
+}
+
+bool TransactionLockMgr::DetectDeadlockLocked(
+    const PessimisticTransaction* txn,
+    const autovector<TransactionID>& wait_ids, const std::string& key,
+    uint32_t cf_id, bool exclusive, Env* env) {
+  auto id = txn->GetID();
+  const int depth = txn->GetDeadlockDetectDepth();
+  std::vector<int> queue_parents(static_cast<size_t>(depth));
+  std::vector<TransactionID> queue_values(static_cast<size_t>(depth));
+  // Edges of the expanded transactions
+  std::vector<const TrackedTrxInfo*> infos;
+  std::vector<int> queue_infos(static_cast<size_t>(depth), -1);
+  infos.reserve(static_cast<size_t>(depth));
 
   const auto* next_ids = &wait_ids;
   int parent = -1;
   int64_t deadlock_time = 0;
-  for (int tail = 0, head = 0; head < txn->GetDeadlockDetectDepth(); head++) {
+  for (int tail = 0, head = 0; head < depth; head++) {
     int i = 0;
     if (next_ids) {
-      for (; i < static_cast<int>(next_ids->size()) &&
-             tail + i < txn->GetDeadlockDetectDepth();
+      for (; i < static_cast<int>(next_ids->size()) && tail + i < depth;
            i++) {
         queue_values[tail + i] = (*next_ids)[i];
         queue_parents[tail + i] = parent;
@@ -492,10 +693,12 @@ bool TransactionLockMgr::IncrementWaiters(
     auto next = queue_values[head];
     if (next == id) {
       std::vector<DeadlockInfo> path;
+      path.push_back({id, cf_id, exclusive, key});
+      head = queue_parents[head];
       while (head != -1) {
-        assert(wait_txn_map_.Contains(queue_values[head]));
+        assert(queue_infos[head] >= 0);
 
-        auto extracted_info = wait_txn_map_.Get(queue_values[head]);
+        const auto& extracted_info = *infos[queue_infos[head]];
         path.push_back({queue_values[head], extracted_info.m_cf_id,
                         extracted_info.m_exclusive,
                         extracted_info.m_waiting_key});
@@ -504,22 +707,23 @@ bool TransactionLockMgr::IncrementWaiters(
       env->GetCurrentTime(&deadlock_time);
       std::reverse(path.begin(), path.end());
       dlock_buffer_.AddNewPath(DeadlockPath(path, deadlock_time));
-      deadlock_time = 0;
-      DecrementWaitersImpl(txn, wait_ids);
       return true;
-    } else if (!wait_txn_map_.Contains(next)) {
+    }
+    const TrackedTrxInfo* info = GetWaitingInfoLocked(next);
+    if (info == nullptr) {
       next_ids = nullptr;
       continue;
     } else {
+      infos.push_back(info);
       parent = head;
-      next_ids = &(wait_txn_map_.Get(next).m_neighbors);
+      queue_infos[head] = static_cast<int>(infos.size()) - 1;
+      next_ids = &info->m_neighbors;
     }
   }
 
   // Wait cycle too big, just assume deadlock.
   env->GetCurrentTime(&deadlock_time);
   dlock_buffer_.AddNewPath(DeadlockPath(deadlock_time, true));
-  DecrementWaitersImpl(txn, wait_ids);
   return true;
 }
 
@@ -538,6 +742,20 @@ Status TransactionLockMgr::AcquireLocked(LockMap* lock_map,
   Status result;
   // Check if this key is already locked
   auto stripe_iter = stripe->keys.find(key);
+  if (lock_map->num_ranges.load(std::memory_order_acquire) > 0 &&
+      (stripe_iter == stripe->keys.end() ||
+       std::find(stripe_iter->second.txn_ids.begin(),
+                 stripe_iter->second.txn_ids.end(),
+                 txn_lock_info.txn_ids[0]) ==
+           stripe_iter->second.txn_ids.end())) {
+    // A range of this transaction needs no lock of the key
+    bool covered = false;
+    result = CheckRangeLocks(lock_map, key, env, txn_lock_info, expire_time,
+                             txn_ids, &covered);
+    if (!result.ok() || covered) {
+      return result;
+    }
+  }
   if (stripe_iter != stripe->keys.end()) {
     // Lock already held
     LockInfo& lock_info = stripe_iter->second;
@@ -582,7 +800,7 @@ Status TransactionLockMgr::AcquireLocked(LockMap* lock_map,
       result = Status::Busy(Status::SubCode::kLockLimit);
     } else {
       // acquire lock
-      stripe->keys.insert({key, txn_lock_info});
+      stripe->InsertKey(key, txn_lock_info);
 
       // Maintain lock count if there is a limit on the number of locks
       if (max_num_locks_) {
@@ -610,7 +828,7 @@ void TransactionLockMgr::UnLockKey(const PessimisticTransaction* txn,
     // Found the key we locked.  unlock it.
     if (txn_it != txns.end()) {
       if (txns.size() == 1) {
-        stripe->keys.erase(stripe_iter);
+        stripe->EraseKey(stripe_iter);
       } else {
         auto last_it = txns.end() - 1;
         if (txn_it != last_it) {
@@ -627,9 +845,11 @@ void TransactionLockMgr::UnLockKey(const PessimisticTransaction* txn,
     }
   } else {
     // This key is either not locked or locked by someone else.  This should
-    // only happen if the unlocking transaction has expired.
-    assert(txn->GetExpirationTime() > 0 &&
-           txn->GetExpirationTime() < env->NowMicros());
+    // only happen if the unlocking transaction has expired, or if the key
+    // is covered by a range lock.
+    assert(lock_map->num_ranges.load(std::memory_order_relaxed) > 0 ||
+           (txn->GetExpirationTime() > 0 &&
+            txn->GetExpirationTime() < env->NowMicros()));
   }
 }
 
@@ -650,10 +870,13 @@ void TransactionLockMgr::UnLock(PessimisticTransaction* txn,
 
   stripe->stripe_mutex->Lock();
   UnLockKey(txn, key, stripe, lock_map, env);
+  bool has_waiters = stripe->num_waiters > 0;
   stripe->stripe_mutex->UnLock();
 
   // Signal waiting threads to retry locking
-  stripe->stripe_cv->NotifyAll();
+  if (has_waiters) {
+    stripe->stripe_cv->NotifyAll();
+  }
 }
 
 void TransactionLockMgr::UnLock(const PessimisticTransaction* txn,
@@ -670,39 +893,383 @@ void TransactionLockMgr::UnLock(const PessimisticTransaction* txn,
       return;
     }
 
-    // Bucket keys by lock_map_ stripe
-    std::unordered_map<size_t, std::vector<const std::string*>> keys_by_stripe(
-        std::max(keys.size(), lock_map->num_stripes_));
-
+    // Sort keys by lock_map_ stripe, which takes a single allocation
+    std::vector<std::pair<size_t, const std::string*>> keys_by_stripe;
+    keys_by_stripe.reserve(keys.size());
     for (auto& key_iter : keys) {
       const std::string& key = key_iter.first;
-
-      size_t stripe_num = lock_map->GetStripe(key);
-      keys_by_stripe[stripe_num].push_back(&key);
+      keys_by_stripe.emplace_back(lock_map->GetStripe(key), &key);
     }
+    std::sort(keys_by_stripe.begin(), keys_by_stripe.end());
 
     // For each stripe, grab the stripe mutex and unlock all keys in this stripe
-    for (auto& stripe_iter : keys_by_stripe) {
-      size_t stripe_num = stripe_iter.first;
-      auto& stripe_keys = stripe_iter.second;
+    for (size_t i = 0; i < keys_by_stripe.size();) {
+      size_t stripe_num = keys_by_stripe[i].first;
 
       assert(lock_map->lock_map_stripes_.size() > stripe_num);
       LockMapStripe* stripe = lock_map->lock_map_stripes_.at(stripe_num);
 
       stripe->stripe_mutex->Lock();
 
-      for (const std::string* key : stripe_keys) {
-        UnLockKey(txn, *key, stripe, lock_map, env);
+      for (; i < keys_by_stripe.size() && keys_by_stripe[i].first == stripe_num;
+           ++i) {
+        UnLockKey(txn, *keys_by_stripe[i].second, stripe, lock_map, env);
       }
+      bool has_waiters = stripe->num_waiters > 0;
 
       stripe->stripe_mutex->UnLock();
 
       // Signal waiting threads to retry locking
+      if (has_waiters) {
+        stripe->stripe_cv->NotifyAll();
+      }
+    }
+  }
+}
+
+Status TransactionLockMgr::CheckRangeLocks(LockMap* lock_map,
+                                           const std::string& key, Env* env,
+                                           const LockInfo& lock_info,
+                                           uint64_t* expire_time,
+                                           autovector<TransactionID>* txn_ids,
+                                           bool* covered) {
+  Status result;
+  lock_map->range_mutex->Lock();
+  auto& ranges = lock_map->ranges;
+  auto range_iter = ranges.upper_bound(key);
+  if (range_iter != ranges.begin() &&
+      lock_map->ucmp_->Compare(key, (--range_iter)->second.end) < 0) {
+    const RangeLockInfo& range = range_iter->second;
+    if (range.txn_id == lock_info.txn_ids[0]) {
+      *covered = true;
+    } else {
+      LockInfo range_lock_info(range.txn_id, range.expiration_time, true);
+      if (IsLockExpired(lock_info.txn_ids[0], range_lock_info, env,
+                        expire_time)) {
+        // lock is expired, can steal it
+        ranges.erase(range_iter);
+        lock_map->num_ranges.store(ranges.size(), std::memory_order_release);
+      } else {
+        result = Status::TimedOut(Status::SubCode::kLockTimeout);
+        *txn_ids = range_lock_info.txn_ids;
+      }
+    }
+  }
+  lock_map->range_mutex->UnLock();
+  return result;
+}
+
+Status TransactionLockMgr::AcquireRangeLocked(
+    LockMap* lock_map, PessimisticTransaction* txn, const std::string& start,
+    const std::string& end, Env* env, uint64_t* expire_time,
+    autovector<TransactionID>* txn_ids, std::string* merged_start,
+    std::vector<std::pair<std::string, std::string>>* replaced,
+    bool* covered) {
+  const Comparator* ucmp = lock_map->ucmp_;
+  auto& ranges = lock_map->ranges;
+  TransactionID txn_id = txn->GetID();
+
+  // Ranges overlapping or adjacent to [start, end) are [first, last). Only
+  // the one before start can reach into it, since ranges are disjoint.
+  auto first = ranges.upper_bound(start);
+  if (first != ranges.begin() &&
+      ucmp->Compare(std::prev(first)->second.end, start) >= 0) {
+    --first;
+  }
+  auto last = first;
+  for (; last != ranges.end() && ucmp->Compare(last->first, end) <= 0;
+       ++last) {
+    const RangeLockInfo& range = last->second;
+    if (range.txn_id == txn_id) {
+      if (ucmp->Compare(last->first, start) <= 0 &&
+          ucmp->Compare(end, range.end) <= 0) {
+        *covered = true;
+        return Status::OK();
+      }
+    } else if (ucmp->Compare(last->first, end) < 0 &&
+               ucmp->Compare(start, range.end) < 0) {
+      LockInfo range_lock_info(range.txn_id, range.expiration_time, true);
+      if (!IsLockExpired(txn_id, range_lock_info, env, expire_time)) {
+        txn_ids->push_back(range.txn_id);
+      }
+    }
+  }
+  if (!txn_ids->empty()) {
+    return Status::TimedOut(Status::SubCode::kLockTimeout);
+  }
+
+  // Merge the ranges of txn and steal the expired ones
+  *merged_start = start;
+  std::string merged_end = end;
+  for (auto range_iter = first; range_iter != last;) {
+    const RangeLockInfo& range = range_iter->second;
+    if (range.txn_id == txn_id) {
+      if (ucmp->Compare(range_iter->first, *merged_start) < 0) {
+        *merged_start = range_iter->first;
+      }
+      if (ucmp->Compare(merged_end, range.end) < 0) {
+        merged_end = range.end;
+      }
+      replaced->emplace_back(range_iter->first, range.end);
+      range_iter = ranges.erase(range_iter);
+    } else if (ucmp->Compare(range_iter->first, end) < 0 &&
+               ucmp->Compare(start, range.end) < 0) {
+      range_iter = ranges.erase(range_iter);
+    } else {
+      ++range_iter;
+    }
+  }
+  ranges.emplace(*merged_start, RangeLockInfo{merged_end, txn_id,
+                                              txn->GetExpirationTime()});
+  lock_map->num_ranges.store(ranges.size(), std::memory_order_release);
+  return Status::OK();
+}
+
+Status TransactionLockMgr::WaitForKeysInRange(
+    PessimisticTransaction* txn, LockMap* lock_map, LockMapStripe* stripe,
+    uint32_t column_family_id, const std::string& start,
+    const std::string& end, Env* env, int64_t timeout, uint64_t end_time) {
+  TransactionID txn_id = txn->GetID();
+  Status result;
+  if (timeout < 0) {
+    result = stripe->stripe_mutex->Lock();
+  } else {
+    // Only the time left of the whole range lock
+    int64_t time_left = 0;
+    if (timeout > 0) {
+      uint64_t now = env->NowMicros();
+      if (end_time > now) {
+        time_left = static_cast<int64_t>(end_time - now);
+      }
+    }
+    result = stripe->stripe_mutex->TryLockFor(time_left);
+  }
+  if (!result.ok()) {
+    return result;
+  }
+  stripe->IndexKeys(lock_map->ucmp_);
+
+  // The range is registered already, so no other transaction locks a key of
+  // it anew and the keys before the one waited for need no second look
+  std::string scan_start = start;
+  bool timed_out = false;
+  for (;;) {
+    uint64_t expire_time_hint = 0;
+    autovector<TransactionID> wait_ids;
+    const std::string* wait_key = nullptr;
+    auto key_iter = stripe->ordered_keys->lower_bound(scan_start);
+    while (key_iter != stripe->ordered_keys->end() && wait_key == nullptr &&
+           lock_map->ucmp_->Compare((*key_iter)->first, end) < 0) {
+      const LockInfo& lock_info = (*key_iter)->second;
+      if (lock_info.txn_ids.size() == 1 && lock_info.txn_ids[0] == txn_id) {
+        ++key_iter;
+      } else if (IsLockExpired(txn_id, lock_info, env, &expire_time_hint)) {
+        // lock is expired, can steal it
+        auto stripe_iter = stripe->keys.find((*key_iter)->first);
+        ++key_iter;
+        stripe->EraseKey(stripe_iter);
+        if (max_num_locks_ > 0) {
+          lock_map->lock_cnt--;
+        }
+      } else {
+        for (auto id : lock_info.txn_ids) {
+          if (id != txn_id) {
+            wait_ids.push_back(id);
+          }
+        }
+        wait_key = &(*key_iter)->first;
+      }
+    }
+    if (wait_key == nullptr) {
+      result = Status::OK();
+      break;
+    }
+    if (timeout == 0 || timed_out) {
+      result = Status::TimedOut(Status::SubCode::kLockTimeout);
+      break;
+    }
+    // The key is copied, its entry may go away while waiting
+    scan_start = *wait_key;
+    result = WaitForLock(txn, stripe->stripe_mutex, stripe->stripe_cv.get(),
+                         &stripe->num_waiters, column_family_id, scan_start,
+                         true, env, timeout, end_time, expire_time_hint,
+                         wait_ids);
+    if (result.IsTimedOut()) {
+      // Rescan once more, the locks may have expired without a signal
+      timed_out = true;
+    } else if (!result.ok()) {
+      break;
+    }
+  }
+
+  stripe->stripe_mutex->UnLock();
+  return result;
+}
+
+Status TransactionLockMgr::TryRangeLock(PessimisticTransaction* txn,
+                                        uint32_t column_family_id,
+                                        const std::string& start,
+                                        const std::string& end, Env* env) {
+  // Lookup lock map for this column family id
+  std::shared_ptr<LockMap> lock_map_ptr = GetLockMap(column_family_id);
+  LockMap* lock_map = lock_map_ptr.get();
+  if (lock_map == nullptr) {
+    char msg[255];
+    snprintf(msg, sizeof(msg), "Column family id not found: %" PRIu32,
+             column_family_id);
+
+    return Status::InvalidArgument(msg);
+  }
+  if (lock_map->ucmp_->Compare(start, end) >= 0) {
+    return Status::InvalidArgument("Empty range");
+  }
+
+  int64_t timeout = txn->GetLockTimeout();
+  uint64_t end_time = 0;
+  if (timeout > 0) {
+    end_time = env->NowMicros() + timeout;
+  }
+
+  // First register the range, which stops new locks of its keys
+  Status result;
+  if (timeout < 0) {
+    result = lock_map->range_mutex->Lock();
+  } else {
+    result = lock_map->range_mutex->TryLockFor(timeout);
+  }
+  if (!result.ok()) {
+    return result;
+  }
+
+  uint64_t expire_time_hint = 0;
+  autovector<TransactionID> wait_ids;
+  std::string merged_start;
+  std::vector<std::pair<std::string, std::string>> replaced;
+  bool covered = false;
+  result = AcquireRangeLocked(lock_map, txn, start, end, env,
+                              &expire_time_hint, &wait_ids, &merged_start,
+                              &replaced, &covered);
+  if (!result.ok() && timeout != 0) {
+    PERF_TIMER_GUARD(key_lock_wait_time);
+    PERF_COUNTER_ADD(key_lock_wait_count, 1);
+    bool timed_out = false;
+    do {
+      result = WaitForLock(txn, lock_map->range_mutex,
+                           lock_map->range_cv.get(),
+                           &lock_map->num_range_waiters, column_family_id,
+                           start, true, env, timeout, end_time,
+                           expire_time_hint, wait_ids);
+      if (result.IsDeadlock()) {
+        break;
+      }
+      if (result.IsTimedOut()) {
+        timed_out = true;
+      }
+      if (result.ok() || result.IsTimedOut()) {
+        expire_time_hint = 0;
+        wait_ids.clear();
+        result = AcquireRangeLocked(lock_map, txn, start, end, env,
+                                    &expire_time_hint, &wait_ids,
+                                    &merged_start, &replaced, &covered);
+      }
+    } while (!result.ok() && !timed_out);
+  }
+  lock_map->range_mutex->UnLock();
+  if (!result.ok() || covered) {
+    return result;
+  }
+
+  // Then wait for the keys other transactions locked in it before
+  for (auto stripe : lock_map->lock_map_stripes_) {
+    result = WaitForKeysInRange(txn, lock_map, stripe, column_family_id, start,
+                                end, env, timeout, end_time);
+    if (!result.ok()) {
+      break;
+    }
+  }
+
+  if (!result.ok()) {
+    // Restore the ranges of txn as they were
+    lock_map->range_mutex->Lock();
+    auto& ranges = lock_map->ranges;
+    ranges.erase(merged_start);
+    for (auto& range : replaced) {
+      ranges.emplace(range.first, RangeLockInfo{range.second, txn->GetID(),
+                                                txn->GetExpirationTime()});
+    }
+    lock_map->num_ranges.store(ranges.size(), std::memory_order_release);
+    lock_map->range_mutex->UnLock();
+    NotifyRangeWaiters(lock_map);
+    return result;
+  }
+
+  // Escalate the keys txn locked alone in the range, the range holds them
+  for (auto stripe : lock_map->lock_map_stripes_) {
+    stripe->stripe_mutex->Lock();
+    for (auto key_iter = stripe->ordered_keys->lower_bound(start);
+         key_iter != stripe->ordered_keys->end() &&
+         lock_map->ucmp_->Compare((*key_iter)->first, end) < 0;) {
+      const LockInfo& lock_info = (*key_iter)->second;
+      if (lock_info.txn_ids.size() == 1 &&
+          lock_info.txn_ids[0] == txn->GetID()) {
+        auto stripe_iter = stripe->keys.find((*key_iter)->first);
+        ++key_iter;
+        stripe->EraseKey(stripe_iter);
+        if (max_num_locks_ > 0) {
+          lock_map->lock_cnt--;
+        }
+      } else {
+        ++key_iter;
+      }
+    }
+    stripe->stripe_mutex->UnLock();
+  }
+  return result;
+}
+
+void TransactionLockMgr::NotifyRangeWaiters(LockMap* lock_map) {
+  lock_map->range_mutex->Lock();
+  bool has_waiters = lock_map->num_range_waiters > 0;
+  lock_map->range_mutex->UnLock();
+  if (has_waiters) {
+    lock_map->range_cv->NotifyAll();
+  }
+
+  // Locks of the keys in the ranges wait on the cv of their stripe
+  for (auto stripe : lock_map->lock_map_stripes_) {
+    stripe->stripe_mutex->Lock();
+    has_waiters = stripe->num_waiters > 0;
+    stripe->stripe_mutex->UnLock();
+    if (has_waiters) {
       stripe->stripe_cv->NotifyAll();
     }
   }
 }
 
+void TransactionLockMgr::UnLockRanges(const PessimisticTransaction* txn,
+                                      uint32_t column_family_id) {
+  std::shared_ptr<LockMap> lock_map_ptr = GetLockMap(column_family_id);
+  LockMap* lock_map = lock_map_ptr.get();
+  if (lock_map == nullptr) {
+    // Column Family must have been dropped.
+    return;
+  }
+
+  lock_map->range_mutex->Lock();
+  auto& ranges = lock_map->ranges;
+  for (auto range_iter = ranges.begin(); range_iter != ranges.end();) {
+    if (range_iter->second.txn_id == txn->GetID()) {
+      range_iter = ranges.erase(range_iter);
+    } else {
+      ++range_iter;
+    }
+  }
+  lock_map->num_ranges.store(ranges.size(), std::memory_order_release);
+  lock_map->range_mutex->UnLock();
+
+  NotifyRangeWaiters(lock_map);
+}
+
 TransactionLockMgr::LockStatusData TransactionLockMgr::GetLockStatusData() {
   LockStatusData data;
   // Lock order here is important. The correct order is lock_map_mutex_, then
@@ -15,6 +15,7 @@
 #include "monitoring/instrumented_mutex.h"
 #include "rocksdb/terark_namespace.h"
 #include "rocksdb/utilities/transaction.h"
+#include "rocksdb/utilities/transaction_db_mutex.h"
 #include "util/autovector.h"
 #include "util/hash_map.h"
 #include "util/thread_local.h"
@@ -62,7 +63,7 @@ class TransactionLockMgr {
 
   // Creates a new LockMap for this column family.  Caller should guarantee
   // that this column family does not already exist.
-  void AddColumnFamily(uint32_t column_family_id);
+  void AddColumnFamily(const ColumnFamilyHandle* column_family);
 
   // Deletes the LockMap for this column family.  Caller should guarantee that
   // this column family is no longer in use.
@@ -80,6 +81,18 @@ class TransactionLockMgr {
   void UnLock(PessimisticTransaction* txn, uint32_t column_family_id,
               const std::string& key, Env* env);
 
+  // Attempt to lock the keys of [start, end) exclusively.  Locks of txn
+  // inside of the range are merged into it, as are the keys txn locks in it
+  // later.  If OK status is returned, the caller is responsible for calling
+  // UnLockRanges() after unlocking the keys of txn.
+  Status TryRangeLock(PessimisticTransaction* txn, uint32_t column_family_id,
+                      const std::string& start, const std::string& end,
+                      Env* env);
+
+  // Unlock all the ranges locked by txn in this column family.
+  void UnLockRanges(const PessimisticTransaction* txn,
+                    uint32_t column_family_id);
+
   using LockStatusData = std::unordered_multimap<uint32_t, KeyLockInfo>;
   LockStatusData GetLockStatusData();
   std::vector<DeadlockPath> GetDeadlockInfoBuffer();
@@ -98,7 +111,8 @@ class TransactionLockMgr {
   // ourselves.
   //   - lock_map_mutex_
   //   - stripe mutexes in ascending cf id, ascending stripe order
-  //   - wait_txn_map_mutex_
+  //   - the range mutex of a LockMap
+  //   - a single WaitGraphStripe mutex, or all of them in ascending order
   //
   // Must be held when accessing/modifying lock_maps_.
   InstrumentedMutex lock_map_mutex_;
@@ -111,13 +125,11 @@ class TransactionLockMgr {
   // to avoid acquiring a mutex in order to look up a LockMap
   std::unique_ptr<ThreadLocalPtr> lock_maps_cache_;
 
-  // Must be held when modifying wait_txn_map_ and rev_wait_txn_map_.
-  std::mutex wait_txn_map_mutex_;
-
-  // Maps from waitee -> number of waiters.
-  HashMap<TransactionID, int> rev_wait_txn_map_;
-  // Maps from waiter -> waitee.
-  HashMap<TransactionID, TrackedTrxInfo> wait_txn_map_;
+  // The wait-for graph of the deadlock detection, striped by transaction id
+  // so that waiters of unrelated keys don't serialize on one mutex
+  static const int kWaitGraphStripeBits = 4;
+  struct WaitGraphStripe;
+  WaitGraphStripe* wait_graph_stripes_;
   DeadlockInfoBuffer dlock_buffer_;
 
   // Used to allocate mutexes/condvars to use when locking keys
@@ -128,6 +140,22 @@ class TransactionLockMgr {
 
   std::shared_ptr<LockMap> GetLockMap(uint32_t column_family_id);
 
+  WaitGraphStripe* GetWaitGraphStripe(TransactionID id) const;
+
+  // Returns the edges from waiter, nullptr if it doesn't wait.
+  // REQUIRED: All the WaitGraphStripe mutexes must be held.
+  const TrackedTrxInfo* GetWaitingInfoLocked(TransactionID waiter) const;
+
+  // True if another transaction waits on id
+  bool IsWaitedOn(TransactionID id) const;
+
+  // Searches the wait-for graph for a cycle through txn, and records it.
+  // REQUIRED: All the WaitGraphStripe mutexes must be held.
+  bool DetectDeadlockLocked(const PessimisticTransaction* txn,
+                            const autovector<TransactionID>& wait_ids,
+                            const std::string& key, uint32_t cf_id,
+                            bool exclusive, Env* env);
+
   Status AcquireWithTimeout(PessimisticTransaction* txn, LockMap* lock_map,
                             LockMapStripe* stripe, uint32_t column_family_id,
                             const std::string& key, Env* env, int64_t timeout,
@@ -138,6 +166,43 @@ class TransactionLockMgr {
                        const LockInfo& lock_info, uint64_t* wait_time,
                        autovector<TransactionID>* txn_ids);
 
+  // Waits once on cv for the transactions wait_ids, until the timeout or the
+  // expiration of their lock.  REQUIRED: mutex must be held.
+  Status WaitForLock(PessimisticTransaction* txn,
+                     const std::shared_ptr<TransactionDBMutex>& mutex,
+                     TransactionDBCondVar* cv, int* num_waiters,
+                     uint32_t column_family_id, const std::string& key,
+                     bool exclusive, Env* env, int64_t timeout,
+                     uint64_t end_time, uint64_t expire_time_hint,
+                     const autovector<TransactionID>& wait_ids);
+
+  // Checks the ranges of other transactions containing key, sets *covered
+  // if a range of the locking transaction contains it.
+  // REQUIRED: Stripe mutex must be held.
+  Status CheckRangeLocks(LockMap* lock_map, const std::string& key, Env* env,
+                         const LockInfo& lock_info, uint64_t* expire_time,
+                         autovector<TransactionID>* txn_ids, bool* covered);
+
+  // Registers [start, end) merged with the adjacent and overlapping ranges
+  // of txn, which are moved into *replaced.
+  // REQUIRED: Range mutex must be held.
+  Status AcquireRangeLocked(
+      LockMap* lock_map, PessimisticTransaction* txn, const std::string& start,
+      const std::string& end, Env* env, uint64_t* expire_time,
+      autovector<TransactionID>* txn_ids, std::string* merged_start,
+      std::vector<std::pair<std::string, std::string>>* replaced,
+      bool* covered);
+
+  // Waits until no other transaction holds a key of [start, end) in stripe,
+  // at most until end_time.  Visits only the keys of the range.
+  Status WaitForKeysInRange(PessimisticTransaction* txn, LockMap* lock_map,
+                            LockMapStripe* stripe, uint32_t column_family_id,
+                            const std::string& start, const std::string& end,
+                            Env* env, int64_t timeout, uint64_t end_time);
+
+  // Wakes up the waiters of the ranges and of the keys
+  void NotifyRangeWaiters(LockMap* lock_map);
+
   void UnLockKey(const PessimisticTransaction* txn, const std::string& key,
                  LockMapStripe* stripe, LockMap* lock_map, Env* env);
 
@@ -147,8 +212,6 @@ class TransactionLockMgr {
                         const bool& exclusive, Env* const env);
   void DecrementWaiters(const PessimisticTransaction* txn,
                         const autovector<TransactionID>& wait_ids);
-  void DecrementWaitersImpl(const PessimisticTransaction* txn,
-                            const autovector<TransactionID>& wait_ids);
 
   // No copying allowed
   TransactionLockMgr(const TransactionLockMgr&);
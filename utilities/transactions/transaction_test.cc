@@ -395,6 +395,119 @@ TEST_P(TransactionTest, SharedLocks) {
   delete txn3;
 }
 
+TEST_P(TransactionTest, RangeLock) {
+  WriteOptions write_options;
+  ReadOptions read_options;
+  TransactionOptions txn_options;
+  Status s;
+
+  txn_options.lock_timeout = 1;
+  Transaction* txn1 = db->BeginTransaction(write_options, txn_options);
+  Transaction* txn2 = db->BeginTransaction(write_options, txn_options);
+  ASSERT_TRUE(txn1);
+  ASSERT_TRUE(txn2);
+
+  s = txn1->GetRangeLock(db->DefaultColumnFamily(), "b", "a");
+  ASSERT_TRUE(s.IsInvalidArgument());
+
+  // Keys txn1 locked before are escalated into the range
+  ASSERT_OK(txn1->Put("c", "1"));
+  ASSERT_OK(txn1->GetRangeLock(db->DefaultColumnFamily(), "b", "d"));
+  ASSERT_EQ(db->GetLockStatusData().size(), 0);
+
+  // Locks of other transactions inside of the range time out, the end is
+  // not part of it
+  s = txn2->Put("b", "2");
+  ASSERT_TRUE(s.IsTimedOut());
+  s = txn2->GetForUpdate(read_options, "c2", nullptr, false /* exclusive */);
+  ASSERT_TRUE(s.IsTimedOut());
+  ASSERT_OK(txn2->Put("d", "2"));
+  ASSERT_OK(txn2->Put("a", "2"));
+  s = txn2->GetRangeLock(db->DefaultColumnFamily(), "c1", "e");
+  ASSERT_TRUE(s.IsTimedOut());
+
+  // Locking inside of its own range takes no lock entries
+  ASSERT_OK(txn1->Put("b", "1"));
+  ASSERT_OK(txn1->GetRangeLock(db->DefaultColumnFamily(), "b", "c"));
+  ASSERT_EQ(db->GetLockStatusData().size(), 2);
+
+  // A range waits for the keys other transactions locked in it
+  s = txn1->GetRangeLock(db->DefaultColumnFamily(), "c", "e");
+  ASSERT_TRUE(s.IsTimedOut());
+  s = txn1->Put("d", "1");
+  ASSERT_TRUE(s.IsTimedOut());
+  ASSERT_OK(txn2->Commit());
+  ASSERT_OK(txn1->GetRangeLock(db->DefaultColumnFamily(), "c", "e"));
+  ASSERT_OK(txn1->Put("d", "1"));
+  ASSERT_EQ(db->GetLockStatusData().size(), 0);
+
+  delete txn2;
+  txn2 = db->BeginTransaction(write_options, txn_options);
+  s = txn2->Put("d", "2");
+  ASSERT_TRUE(s.IsTimedOut());
+
+  // Committing releases the ranges
+  ASSERT_OK(txn1->Commit());
+  ASSERT_OK(txn2->Put("b", "2"));
+  ASSERT_OK(txn2->Put("d", "2"));
+  ASSERT_OK(txn2->Commit());
+
+  std::string value;
+  ASSERT_OK(db->Get(read_options, "a", &value));
+  ASSERT_EQ(value, "2");
+  ASSERT_OK(db->Get(read_options, "c", &value));
+  ASSERT_EQ(value, "1");
+  ASSERT_OK(db->Get(read_options, "d", &value));
+  ASSERT_EQ(value, "2");
+
+  delete txn1;
+  delete txn2;
+}
+
+TEST_P(TransactionTest, RangeLockManyKeys) {
+  WriteOptions write_options;
+  TransactionOptions txn_options;
+  Status s;
+
+  txn_options.lock_timeout = 1;
+  Transaction* txn1 = db->BeginTransaction(write_options, txn_options);
+  Transaction* txn2 = db->BeginTransaction(write_options, txn_options);
+  ASSERT_TRUE(txn1);
+  ASSERT_TRUE(txn2);
+
+  // Keys in and around the range [120, 180), all over the lock stripes
+  for (int i = 100; i < 200; i++) {
+    ASSERT_OK((i % 2 == 0 ? txn1 : txn2)->Put(ToString(i), "v"));
+  }
+  s = txn1->GetRangeLock(db->DefaultColumnFamily(), "120", "180");
+  ASSERT_TRUE(s.IsTimedOut());
+  ASSERT_EQ(db->GetLockStatusData().size(), 100);
+
+  // The range waits until the other transaction is done with its keys
+  txn1->SetLockTimeout(10000);
+  port::Thread range_locker([&] {
+    ASSERT_OK(txn1->GetRangeLock(db->DefaultColumnFamily(), "120", "180"));
+  });
+  ASSERT_OK(txn2->Commit());
+  range_locker.join();
+  // Only the keys of txn1 outside of the range keep their lock entries
+  ASSERT_EQ(db->GetLockStatusData().size(), 20);
+
+  delete txn2;
+  txn2 = db->BeginTransaction(write_options, txn_options);
+  s = txn2->Put("121", "2");
+  ASSERT_TRUE(s.IsTimedOut());
+  s = txn2->Put("180", "2");
+  ASSERT_TRUE(s.IsTimedOut());
+  ASSERT_OK(txn2->Put("119", "2"));
+  ASSERT_OK(txn1->Commit());
+  ASSERT_OK(txn2->Put("121", "2"));
+  ASSERT_OK(txn2->Commit());
+
+  delete txn1;
+  delete txn2;
+}
+
 TEST_P(TransactionTest, DeadlockCycleShared) {
   WriteOptions write_options;
   ReadOptions read_options;
@@ -769,6 +882,93 @@ TEST_P(TransactionStressTest, DeadlockStress) {
     t.join();
   }
 }
+
+TEST_P(TransactionStressTest, DeadlockConcurrentCycles) {
+  const uint32_t kPairs = 16;
+  const uint32_t kRounds = 50;
+
+  WriteOptions write_options;
+  ReadOptions read_options;
+  TransactionOptions txn_options;
+  txn_options.lock_timeout = 1000000;
+  txn_options.deadlock_detect = true;
+
+  for (uint32_t round = 0; round < kRounds; round++) {
+    // Each pair closes a cycle of two at the same time as the others, so
+    // their edges land on all the stripes of the wait-for graph
+    std::vector<Transaction*> txns(2 * kPairs);
+    for (uint32_t i = 0; i < 2 * kPairs; i++) {
+      txns[i] = db->BeginTransaction(write_options, txn_options);
+      ASSERT_OK(txns[i]->GetForUpdate(read_options, ToString(i), nullptr));
+    }
+    std::atomic<uint32_t> ready(0);
+    std::vector<std::atomic<uint32_t>> deadlocks(kPairs);
+    std::vector<port::Thread> threads;
+    for (uint32_t i = 0; i < 2 * kPairs; i++) {
+      threads.emplace_back([&, i] {
+        ready.fetch_add(1);
+        while (ready.load() < 2 * kPairs) {
+          std::this_thread::yield();
+        }
+        auto s = txns[i]->GetForUpdate(read_options, ToString(i ^ 1), nullptr);
+        if (!s.ok()) {
+          ASSERT_TRUE(s.IsDeadlock());
+          deadlocks[i / 2].fetch_add(1);
+        }
+        txns[i]->Rollback();
+      });
+    }
+    for (auto& t : threads) {
+      t.join();
+    }
+    for (uint32_t p = 0; p < kPairs; p++) {
+      ASSERT_GE(deadlocks[p].load(), 1U);
+    }
+    for (auto txn : txns) {
+      delete txn;
+    }
+  }
+}
+
+TEST_P(TransactionStressTest, DeadlockNoFalsePositive) {
+  const uint32_t kThreads = 16;
+  const uint32_t kKeys = 8;
+  const uint32_t kIters = 2000;
+
+  WriteOptions write_options;
+  ReadOptions read_options;
+  TransactionOptions txn_options;
+  txn_options.lock_timeout = 1000000;
+  txn_options.deadlock_detect = true;
+
+  // Keys locked in ascending order never make a cycle, but the waits come
+  // and go all the time
+  std::function<void(uint32_t)> ordered_thread = [&](uint32_t seed) {
+    Random rnd(seed);
+    for (uint32_t i = 0; i < kIters; i++) {
+      Transaction* txn = db->BeginTransaction(write_options, txn_options);
+      for (uint32_t k = 0; k < kKeys; k++) {
+        if (rnd.OneIn(2)) {
+          continue;
+        }
+        auto s = txn->GetForUpdate(read_options, ToString(k), nullptr,
+                                   !rnd.OneIn(4) /* exclusive */);
+        ASSERT_OK(s);
+      }
+      txn->Rollback();
+      delete txn;
+    }
+  };
+
+  std::vector<port::Thread> threads;
+  for (uint32_t i = 0; i < kThreads; i++) {
+    threads.emplace_back(ordered_thread, 301 + i);
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  ASSERT_TRUE(db->GetDeadlockInfoBuffer().empty());
+}
 #endif  // ROCKSDB_VALGRIND_RUN
 
 TEST_P(TransactionTest, CommitTimeBatchFailTest) {